@@ -0,0 +1,90 @@
+#include "Animation.h"
+#include <chrono>
+
+namespace KroubleUI {
+
+    double SystemClock::Now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    AnimationTrack::~AnimationTrack() {
+        Stop();
+    }
+
+    void AnimationTrack::Stop() {
+        if (m_scheduler) {
+            m_scheduler->Stop(this);
+        }
+    }
+
+    AnimationScheduler::AnimationScheduler()
+        : m_clock(&m_systemClock),
+        m_ticking(false),
+        m_frameInterval(1.0 / 60.0),
+        m_frameCount(0) {
+    }
+
+    AnimationScheduler::~AnimationScheduler() {
+        for (AnimationTrack* track : m_tracks) {
+            if (track) track->m_scheduler = nullptr;
+        }
+    }
+
+    void AnimationScheduler::SetClock(AnimationClock* clock) {
+        m_clock = clock ? clock : &m_systemClock;
+    }
+
+    void AnimationScheduler::Start(AnimationTrack* track) {
+        if (track->m_scheduler == this) {
+            track->m_restarted = true;
+            return;
+        }
+        if (track->m_scheduler) {
+            track->m_scheduler->Stop(track);
+        }
+        track->m_scheduler = this;
+        m_tracks.push_back(track);
+    }
+
+    void AnimationScheduler::Stop(AnimationTrack* track) {
+        if (track->m_scheduler != this) return;
+        track->m_scheduler = nullptr;
+
+        auto it = std::find(m_tracks.begin(), m_tracks.end(), track);
+        if (it == m_tracks.end()) return;
+        // 推进过程中只置空，避免打乱正在遍历的列表
+        if (m_ticking) {
+            *it = nullptr;
+        }
+        else {
+            m_tracks.erase(it);
+        }
+    }
+
+    size_t AnimationScheduler::GetActiveCount() const {
+        return m_tracks.size() - std::count(m_tracks.begin(), m_tracks.end(), nullptr);
+    }
+
+    bool AnimationScheduler::Tick() {
+        if (m_tracks.empty()) return false;
+
+        double now = m_clock->Now();
+        m_ticking = true;
+        // 推进时新启动的动画追加在末尾，同一帧内也会被推进
+        for (size_t i = 0; i < m_tracks.size(); ++i) {
+            AnimationTrack* track = m_tracks[i];
+            if (!track) continue;
+            track->m_restarted = false;
+            // Advance 返回之前已经判定结束，但值变化的回调可能又设置了新目标
+            if (!track->Advance(now) && m_tracks[i] == track && !track->m_restarted) {
+                track->m_scheduler = nullptr;
+                m_tracks[i] = nullptr;
+            }
+        }
+        m_ticking = false;
+        m_tracks.erase(std::remove(m_tracks.begin(), m_tracks.end(), nullptr), m_tracks.end());
+        ++m_frameCount;
+        return !m_tracks.empty();
+    }
+
+} // namespace KroubleUI
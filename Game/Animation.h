@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace KroubleUI {
+
+    // 动画时间源（秒），测试时可替换为手动推进的时钟
+    class AnimationClock {
+    public:
+        virtual ~AnimationClock() = default;
+        virtual double Now() = 0;
+    };
+
+    // 基于 steady_clock 的系统时钟
+    class SystemClock : public AnimationClock {
+    public:
+        double Now() override;
+    };
+
+    // 缓动函数，输入和输出都在 [0, 1] 内
+    typedef float (*EasingFunction)(float t);
+
+    namespace Easing {
+        inline float Linear(float t) { return t; }
+        inline float EaseIn(float t) { return t * t * t; }
+        inline float EaseOut(float t) { float u = 1.0f - t; return 1.0f - u * u * u; }
+        inline float EaseInOut(float t) { return t < 0.5f ? 4.0f * t * t * t : EaseOut(2.0f * t - 1.0f) * 0.5f + 0.5f; }
+    }
+
+    // 弹簧参数（质量为 1）：刚度越大越快，阻尼比小于 1 时会回弹
+    struct SpringParams {
+        float stiffness = 300.0f;
+        float dampingRatio = 0.8f;
+    };
+
+    class AnimationScheduler;
+
+    // 由调度器逐帧推进的动画
+    class AnimationTrack {
+        friend class AnimationScheduler;
+    protected:
+        AnimationScheduler* m_scheduler;    // 进行中时指向所在的调度器，否则为空
+        bool m_restarted;                   // 推进过程中（如在值变化的回调里）被重新启动
+
+    public:
+        AnimationTrack() : m_scheduler(nullptr), m_restarted(false) {}
+        AnimationTrack(const AnimationTrack&) = delete;
+        AnimationTrack& operator=(const AnimationTrack&) = delete;
+        virtual ~AnimationTrack();
+
+        // 推进到 time 时刻（秒），返回动画是否仍在进行；推进中重新启动的动画即使返回 false 也会继续
+        virtual bool Advance(double time) = 0;
+
+        bool IsAnimating() const { return m_scheduler != nullptr; }
+        void Stop();
+    };
+
+    // 每帧调用一次回调的动画，回调返回是否仍在进行；供自己计算运动的控件使用（如平滑滚动、惯性滚动）
+    class CallbackTrack : public AnimationTrack {
+    private:
+        std::function<bool(double)> m_advance;
+
+    public:
+        explicit CallbackTrack(std::function<bool(double)> advance) : m_advance(advance) {}
+        bool Advance(double time) override { return m_advance(time); }
+    };
+
+    // 动画调度器：只在有动画进行时推进，动画全部结束后窗口不再出帧
+    class AnimationScheduler {
+    private:
+        SystemClock m_systemClock;
+        AnimationClock* m_clock;
+        std::vector<AnimationTrack*> m_tracks;  // 推进过程中停止的动画先置空，推进结束后移除
+        bool m_ticking;
+        double m_frameInterval;                 // 显示器刷新间隔（秒）
+        uint64_t m_frameCount;
+
+    public:
+        AnimationScheduler();
+        ~AnimationScheduler();
+        AnimationScheduler(const AnimationScheduler&) = delete;
+        AnimationScheduler& operator=(const AnimationScheduler&) = delete;
+
+        // clock 为空时恢复系统时钟；时钟不由调度器接管所有权
+        void SetClock(AnimationClock* clock);
+        double Now() { return m_clock->Now(); }
+
+        void SetFrameInterval(double seconds) { m_frameInterval = seconds; }
+        double GetFrameInterval() const { return m_frameInterval; }
+
+        void Start(AnimationTrack* track);
+        void Stop(AnimationTrack* track);
+        bool IsAnimating() const { return GetActiveCount() > 0; }
+        size_t GetActiveCount() const;
+
+        // 把所有进行中的动画推进到当前时刻，返回是否还有动画
+        bool Tick();
+        // 实际推进过动画的帧数
+        uint64_t GetFrameCount() const { return m_frameCount; }
+    };
+
+    // 可动画的类型拆成若干个 float 分量逐一插值
+    template<class T> struct AnimationTraits;
+
+    template<> struct AnimationTraits<float> {
+        enum { kComponents = 1 };
+        static void ToArray(const float& value, float* out) { out[0] = value; }
+        static float FromArray(const float* in) { return in[0]; }
+        static float RestThreshold() { return 0.001f; }
+    };
+
+    // 可动画的属性值
+    // AnimateTo 按时长和缓动函数插值，SpringTo 按弹簧模拟并保留当前速度；值每次变化后调用 onChanged
+    template<class T> class AnimatedValue : public AnimationTrack {
+    private:
+        typedef AnimationTraits<T> Traits;
+        enum { N = Traits::kComponents };
+
+        AnimationScheduler* m_attachedScheduler;
+        std::function<void()> m_onChanged;
+        float m_value[N];
+        float m_from[N];
+        float m_to[N];
+        float m_velocity[N];
+        double m_startTime;
+        double m_lastTime;
+        double m_duration;
+        EasingFunction m_easing;
+        bool m_useSpring;
+        SpringParams m_spring;
+
+    public:
+        explicit AnimatedValue(const T& value = T())
+            : m_attachedScheduler(nullptr), m_startTime(0.0), m_lastTime(0.0), m_duration(0.0),
+            m_easing(Easing::Linear), m_useSpring(false) {
+            Traits::ToArray(value, m_value);
+            Traits::ToArray(value, m_to);
+            std::fill(m_from, m_from + N, 0.0f);
+            std::fill(m_velocity, m_velocity + N, 0.0f);
+        }
+
+        // 没有调度器时所有动画都立即跳到目标值
+        void Attach(AnimationScheduler* scheduler, std::function<void()> onChanged) {
+            Stop();
+            m_attachedScheduler = scheduler;
+            m_onChanged = onChanged;
+        }
+
+        T Get() const { return Traits::FromArray(m_value); }
+        T GetTarget() const { return Traits::FromArray(m_to); }
+
+        // 立即设置，停止进行中的动画
+        void Set(const T& value) {
+            Stop();
+            Traits::ToArray(value, m_value);
+            Traits::ToArray(value, m_to);
+            std::fill(m_velocity, m_velocity + N, 0.0f);
+            Changed();
+        }
+
+        void AnimateTo(const T& target, double duration, EasingFunction easing = Easing::EaseOut) {
+            if (!m_attachedScheduler || duration <= 0.0) {
+                Set(target);
+                return;
+            }
+            std::copy(m_value, m_value + N, m_from);
+            Traits::ToArray(target, m_to);
+            std::fill(m_velocity, m_velocity + N, 0.0f);
+            m_startTime = m_attachedScheduler->Now();
+            m_duration = duration;
+            m_easing = easing ? easing : Easing::Linear;
+            m_useSpring = false;
+            m_attachedScheduler->Start(this);
+        }
+
+        void SpringTo(const T& target, const SpringParams& params = SpringParams()) {
+            if (!m_attachedScheduler) {
+                Set(target);
+                return;
+            }
+            Traits::ToArray(target, m_to);
+            // 已经在弹簧运动中时保留时间和速度，目标可以随时改变
+            if (!IsAnimating() || !m_useSpring) {
+                m_lastTime = m_attachedScheduler->Now();
+            }
+            m_spring = params;
+            m_useSpring = true;
+            m_attachedScheduler->Start(this);
+        }
+
+        bool Advance(double time) override {
+            bool running = m_useSpring ? StepSpring(time) : StepTween(time);
+            Changed();
+            return running;
+        }
+
+    private:
+        void Changed() {
+            if (m_onChanged) m_onChanged();
+        }
+
+        bool StepTween(double time) {
+            double t = m_duration > 0.0 ? (time - m_startTime) / m_duration : 1.0;
+            t = (std::min)((std::max)(t, 0.0), 1.0);
+            float eased = m_easing(static_cast<float>(t));
+            for (int i = 0; i < N; ++i) {
+                m_value[i] = m_from[i] + (m_to[i] - m_from[i]) * eased;
+            }
+            return t < 1.0;
+        }
+
+        bool StepSpring(double time) {
+            // 固定小步长积分保证稳定；长时间没有出帧时最多模拟 0.1 秒
+            const double kStep = 1.0 / 240.0;
+            double elapsed = (std::min)((std::max)(time - m_lastTime, 0.0), 0.1);
+            m_lastTime = time;
+
+            float stiffness = m_spring.stiffness;
+            float damping = 2.0f * m_spring.dampingRatio * std::sqrt(stiffness);
+            while (elapsed > 0.0) {
+                float h = static_cast<float>((std::min)(elapsed, kStep));
+                for (int i = 0; i < N; ++i) {
+                    float acceleration = -stiffness * (m_value[i] - m_to[i]) - damping * m_velocity[i];
+                    m_velocity[i] += acceleration * h;
+                    m_value[i] += m_velocity[i] * h;
+                }
+                elapsed -= h;
+            }
+
+            float threshold = Traits::RestThreshold();
+            for (int i = 0; i < N; ++i) {
+                if (std::fabs(m_value[i] - m_to[i]) > threshold || std::fabs(m_velocity[i]) > threshold * 10.0f) {
+                    return true;
+                }
+            }
+            std::copy(m_to, m_to + N, m_value);
+            std::fill(m_velocity, m_velocity + N, 0.0f);
+            return false;
+        }
+    };
+
+} // namespace KroubleUI
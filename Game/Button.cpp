@@ -5,6 +5,20 @@
 
 namespace KroubleUI {
 
+    namespace {
+        const double kHoverDuration = 0.15;     // 悬停颜色过渡时长（秒）
+        const double kPressDuration = 0.06;     // 按下时的过渡更快，保证点击手感
+        const float kPressedScale = 0.96f;
+
+        D2D1_COLOR_F ScaleColor(const D2D1_COLOR_F& color, float factor) {
+            return D2D1::ColorF(
+                (std::min)(color.r * factor, 1.0f),
+                (std::min)(color.g * factor, 1.0f),
+                (std::min)(color.b * factor, 1.0f),
+                color.a);
+        }
+    }
+
     Button::Button(Window* parent, const D2D1_RECT_F& rect, const std::wstring& text)
         : Control(parent, rect),
         m_text(text),
@@ -13,7 +27,11 @@ namespace KroubleUI {
         m_borderBrush(nullptr),
         m_textFormat(nullptr),
         m_isHovered(false),
-        m_isPressed(false) {
+        m_isPressed(false),
+        m_borderWidth(1.0f),
+        m_fillColor(D2D1::ColorF(D2D1::ColorF::LightGray)) {
+        m_fillColor.Attach(GetAnimationScheduler(), [this]() { Invalidate(); });
+        SetStyleName(L"Button");
     }
 
     Button::~Button() {
@@ -24,38 +42,28 @@ namespace KroubleUI {
         SafeReleaseResources();
 
         // 创建默认画笔
-        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black), &m_textBrush);
-        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::LightGray), &m_backgroundBrush);
-        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::DarkGray), &m_borderBrush);
-
-        // 创建文本格式
-        dwriteFactory->CreateTextFormat(
-            L"Microsoft YaHei",
-            nullptr,
-            DWRITE_FONT_WEIGHT_NORMAL,
-            DWRITE_FONT_STYLE_NORMAL,
-            DWRITE_FONT_STRETCH_NORMAL,
-            14.0f,
-            L"zh-cn",
-            &m_textFormat
-        );
-
-        if (m_textFormat) {
-            m_textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
-            m_textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
-        }
+        renderTarget->CreateSolidColorBrush(m_textColor, &m_textBrush);
+        renderTarget->CreateSolidColorBrush(m_fillColor.Get(), &m_backgroundBrush);
+        renderTarget->CreateSolidColorBrush(m_borderColor, &m_borderBrush);
+        TrackResource(m_textBrush);
+        TrackResource(m_backgroundBrush);
+        TrackResource(m_borderBrush);
+
+        // 从图形上下文获取共享的文本格式，字体来自样式
+        TextFormatDesc desc;
+        ApplyFont(GetStyle(), &desc);
+        desc.textAlignment = DWRITE_TEXT_ALIGNMENT_CENTER;
+        desc.paragraphAlignment = DWRITE_PARAGRAPH_ALIGNMENT_CENTER;
+        m_textFormat = m_parent->GetGraphicsContext()->GetTextFormat(desc);
+        TrackResource(m_textFormat);
+        InvalidateText();
     }
 
     void Button::SafeReleaseResources() {
-        if (m_textBrush) m_textBrush->Release();
-        if (m_backgroundBrush) m_backgroundBrush->Release();
-        if (m_borderBrush) m_borderBrush->Release();
-        if (m_textFormat) m_textFormat->Release();
-
-        m_textBrush = nullptr;
-        m_backgroundBrush = nullptr;
-        m_borderBrush = nullptr;
-        m_textFormat = nullptr;
+        ReleaseResource(&m_textBrush);
+        ReleaseResource(&m_backgroundBrush);
+        ReleaseResource(&m_borderBrush);
+        ReleaseResource(&m_textFormat);
     }
 
     void Button::Draw(ID2D1RenderTarget* renderTarget) {
@@ -69,36 +77,19 @@ namespace KroubleUI {
             }
         }
 
-        // 确定背景和边框颜色（根据状态）
-        D2D1_COLOR_F bgColor = m_backgroundBrush ? m_backgroundBrush->GetColor() : D2D1::ColorF(D2D1::ColorF::LightGray);
-        D2D1_COLOR_F borderColor = m_borderBrush ? m_borderBrush->GetColor() : D2D1::ColorF(D2D1::ColorF::DarkGray);
-
-        if (m_isPressed) {
-            bgColor.r *= 0.8f;
-            bgColor.g *= 0.8f;
-            bgColor.b *= 0.8f;
-        }
-        else if (m_isHovered) {
-            bgColor.r *= 1.1f;
-            bgColor.g *= 1.1f;
-            bgColor.b *= 1.1f;
-        }
-
-        // 绘制背景
-        ID2D1SolidColorBrush* tempBgBrush = nullptr;
-        renderTarget->CreateSolidColorBrush(bgColor, &tempBgBrush);
-        renderTarget->FillRectangle(m_rect, tempBgBrush);
-        tempBgBrush->Release();
+        if (!m_backgroundBrush || !m_borderBrush) return;
 
-        // 绘制边框
-        ID2D1SolidColorBrush* tempBorderBrush = nullptr;
-        renderTarget->CreateSolidColorBrush(borderColor, &tempBorderBrush);
-        renderTarget->DrawRectangle(m_rect, tempBorderBrush, 1.0f);
-        tempBorderBrush->Release();
+        // 背景色由状态动画给出
+        m_backgroundBrush->SetColor(m_fillColor.Get());
+        FillRectangle(renderTarget, m_rect, m_backgroundBrush);
+        DrawRectangleOutline(renderTarget, m_rect, m_borderBrush, m_borderWidth);
 
         // 绘制文本
         if (m_textBrush && m_textFormat && !m_text.empty()) {
-            renderTarget->DrawTextW(
+            m_textBrush->SetColor(IsEnabled() ? m_textColor : m_disabledTextColor);
+            DrawPreparedText(
+                renderTarget,
+                GetPreparedText(0),
                 m_text.c_str(),
                 static_cast<UINT32>(m_text.length()),
                 m_textFormat,
@@ -113,6 +104,9 @@ namespace KroubleUI {
         bool isInside = (pt.x >= m_rect.left && pt.x <= m_rect.right &&
             pt.y >= m_rect.top && pt.y <= m_rect.bottom);
 
+        bool wasHovered = m_isHovered;
+        bool wasPressed = m_isPressed;
+
         switch (message) {
         case WM_MOUSEMOVE:
             m_isHovered = isInside;
@@ -130,8 +124,8 @@ namespace KroubleUI {
                 m_isPressed = false;
                 ReleaseCapture();
 
-                if (isInside && m_onClickHandler) {
-                    m_onClickHandler();
+                if (isInside) {
+                    m_clicked.Emit();
                 }
             }
             break;
@@ -141,36 +135,113 @@ namespace KroubleUI {
             m_isPressed = false;
             break;
         }
+
+        if (m_isHovered != wasHovered || m_isPressed != wasPressed) {
+            UpdateVisualState();
+        }
+        if (m_isHovered != wasHovered) {
+            m_hoverChanged.Emit(m_isHovered);
+        }
+    }
+
+    void Button::OnCollectTextWork(std::vector<TextWork>* work) {
+        if (!m_textFormat || m_text.empty()) return;
+        work->push_back({ m_text.c_str(), static_cast<UINT32>(m_text.length()), m_textFormat,
+            m_rect.right - m_rect.left, m_rect.bottom - m_rect.top, nullptr });
+    }
+
+    void Button::OnStyleChanged() {
+        // 样式没有单独给出悬停、按下的背景时沿用原先的调亮、调暗规则
+        const ResolvedStyle& normal = GetStyle();
+        const ResolvedStyle& hover = GetStyle(StyleState::Hover);
+        const ResolvedStyle& pressed = GetStyle(StyleState::Pressed);
+        const ResolvedStyle& disabled = GetStyle(StyleState::Disabled);
+
+        m_normalColor = ToColorF(normal.background);
+        m_hoverColor = hover.IsFromState(StyleBackground) ? ToColorF(hover.background) : ScaleColor(m_normalColor, 1.1f);
+        m_pressedColor = pressed.IsFromState(StyleBackground) ? ToColorF(pressed.background) : ScaleColor(m_normalColor, 0.8f);
+        m_disabledColor = ToColorF(disabled.background);
+        m_textColor = ToColorF(normal.foreground);
+        m_disabledTextColor = ToColorF(disabled.foreground);
+        m_borderColor = ToColorF(normal.border);
+        m_borderWidth = normal.borderWidth;
+        m_fillColor.Set(GetStateColor());
+
+        // 画笔颜色和字体在下次绘制时按新样式重新创建
+        SafeReleaseResources();
+        Invalidate();
+    }
+
+    void Button::OnEnabledChanged() {
+        if (m_isPressed) {
+            ReleaseCapture();
+        }
+        m_isHovered = false;
+        m_isPressed = false;
+        UpdateVisualState();
+    }
+
+    const D2D1_COLOR_F& Button::GetStateColor() const {
+        if (!IsEnabled()) return m_disabledColor;
+        if (m_isPressed) return m_pressedColor;
+        if (m_isHovered) return m_hoverColor;
+        return m_normalColor;
+    }
+
+    void Button::UpdateVisualState() {
+        m_fillColor.AnimateTo(GetStateColor(), m_isPressed ? kPressDuration : kHoverDuration);
+
+        // 按下时略微缩小，松开时用弹簧回弹
+        float scale = m_isPressed ? kPressedScale : 1.0f;
+        SpringTransform(D2D1::Matrix3x2F::Scale(scale, scale));
+    }
+
+    size_t Button::GetCpuBytes() const {
+        return sizeof(Button) + m_text.capacity() * sizeof(wchar_t);
     }
 
     void Button::SetText(const std::wstring& text) {
         m_text = text;
+        InvalidateText();
+        Invalidate();
+        m_textChanged.Emit();
     }
 
     const std::wstring& Button::GetText() const {
         return m_text;
     }
 
-    void Button::SetOnClickHandler(std::function<void()> handler) {
-        m_onClickHandler = handler;
-    }
-
     void Button::SetTextColor(const D2D1_COLOR_F& color) {
+        m_textColor = color;
         if (m_textBrush) {
             m_textBrush->SetColor(color);
         }
+        Invalidate();
     }
 
     void Button::SetBackgroundColor(const D2D1_COLOR_F& color) {
-        if (m_backgroundBrush) {
-            m_backgroundBrush->SetColor(color);
-        }
+        m_normalColor = color;
+        m_hoverColor = ScaleColor(color, 1.1f);
+        m_pressedColor = ScaleColor(color, 0.8f);
+        m_fillColor.Set(GetStateColor());
+    }
+
+    void Button::SetHoverColor(const D2D1_COLOR_F& color) {
+        m_hoverColor = color;
+        m_fillColor.Set(GetStateColor());
+    }
+
+    void Button::SetPressedColor(const D2D1_COLOR_F& color) {
+        m_pressedColor = color;
+        m_fillColor.Set(GetStateColor());
     }
 
     void Button::SetBorderColor(const D2D1_COLOR_F& color) {
+        m_borderColor = color;
         if (m_borderBrush) {
             m_borderBrush->SetColor(color);
         }
+        Invalidate();
     }
 
 } // namespace KroubleUI
@@ -0,0 +1,279 @@
+#include "ChunkedText.h"
+#include "TaskPool.h"
+#include <algorithm>
+
+namespace KroubleUI {
+
+    void ChunkedText::Clear() {
+        m_chunks.clear();
+        m_chunkStarts.clear();
+        m_length = 0;
+    }
+
+    void ChunkedText::Assign(std::wstring text) {
+        Clear();
+        if (text.empty()) return;
+
+        size_t length = text.size();
+        // 短文本留出输入的空间，长文本原样接管
+        if (length < kChunkChars) {
+            text.reserve(kChunkChars);
+        }
+        m_chunks.push_back({ std::make_shared<std::wstring>(std::move(text)), length });
+        m_chunkStarts.push_back(0);
+        m_length = length;
+    }
+
+    void ChunkedText::Append(const wchar_t* text, size_t length) {
+        if (length == 0) return;
+
+        TextChunk* tail = m_chunks.empty() ? nullptr : &m_chunks.back();
+        if (tail && tail->length + length <= kChunkChars) {
+            if (tail->data.use_count() > 1) {
+                // 快照还在读这一块，先复制一份
+                // 只有持有本对象的线程会增加引用，计数为 1 时不会被并发地增加
+                std::shared_ptr<std::wstring> copy = std::make_shared<std::wstring>();
+                copy->reserve(kChunkChars);
+                copy->assign(tail->data->data(), tail->length);
+                tail->data = copy;
+            }
+            else {
+                // 丢掉退格删除的字符
+                tail->data->resize(tail->length);
+            }
+            tail->data->append(text, length);
+            tail->length += length;
+        }
+        else {
+            std::shared_ptr<std::wstring> data = std::make_shared<std::wstring>();
+            data->reserve((std::max)(length, kChunkChars));
+            data->assign(text, length);
+            m_chunks.push_back({ data, length });
+            m_chunkStarts.push_back(m_length);
+        }
+        m_length += length;
+    }
+
+    void ChunkedText::Append(std::wstring&& text) {
+        size_t length = text.size();
+        if (length < kChunkChars) {
+            Append(text.data(), length);
+            return;
+        }
+
+        m_chunks.push_back({ std::make_shared<std::wstring>(std::move(text)), length });
+        m_chunkStarts.push_back(m_length);
+        m_length += length;
+    }
+
+    void ChunkedText::RemoveLast() {
+        // 只缩短有效长度，不会改动快照可能正在读的字符
+        if (--m_chunks.back().length == 0) {
+            m_chunks.pop_back();
+            m_chunkStarts.pop_back();
+        }
+        --m_length;
+    }
+
+    size_t ChunkedText::GetCpuBytes() const {
+        size_t bytes = m_chunks.capacity() * sizeof(TextChunk) + m_chunkStarts.capacity() * sizeof(size_t);
+        for (const TextChunk& chunk : m_chunks) {
+            bytes += sizeof(std::wstring) + chunk.data->capacity() * sizeof(wchar_t);
+        }
+        return bytes;
+    }
+
+    void ChunkedText::CopyRange(size_t begin, size_t end, std::wstring* out) const {
+        out->clear();
+        end = (std::min)(end, m_length);
+        if (begin >= end) return;
+
+        size_t index = std::upper_bound(m_chunkStarts.begin(), m_chunkStarts.end(), begin) - m_chunkStarts.begin() - 1;
+        for (; index < m_chunks.size() && m_chunkStarts[index] < end; ++index) {
+            size_t chunkStart = m_chunkStarts[index];
+            size_t first = (std::max)(begin, chunkStart) - chunkStart;
+            size_t last = (std::min)(end - chunkStart, m_chunks[index].length);
+            out->append(m_chunks[index].data->data() + first, last - first);
+        }
+    }
+
+    void ChunkedText::Flatten(std::wstring* out) const {
+        out->clear();
+        out->reserve(m_length);
+        for (const TextChunk& chunk : m_chunks) {
+            out->append(chunk.data->data(), chunk.length);
+        }
+    }
+
+    void ChunkedText::FindNewlines(size_t begin, size_t end, std::vector<size_t>* lineStarts) const {
+        end = (std::min)(end, m_length);
+        if (begin >= end) return;
+
+        size_t index = std::upper_bound(m_chunkStarts.begin(), m_chunkStarts.end(), begin) - m_chunkStarts.begin() - 1;
+        for (; index < m_chunks.size() && m_chunkStarts[index] < end; ++index) {
+            size_t chunkStart = m_chunkStarts[index];
+            const wchar_t* data = m_chunks[index].data->data();
+            size_t first = (std::max)(begin, chunkStart) - chunkStart;
+            size_t last = (std::min)(end - chunkStart, m_chunks[index].length);
+            for (const wchar_t* p = data + first; (p = std::find(p, data + last, L'\n')) != data + last; ++p) {
+                lineStarts->push_back(chunkStart + (p - data) + 1);
+            }
+        }
+    }
+
+    void ChunkedText::FindNewlinesBackward(size_t begin, size_t end, size_t count, std::vector<size_t>* lineStarts) const {
+        end = (std::min)(end, m_length);
+        if (begin >= end || count == 0) return;
+
+        size_t found = 0;
+        size_t index = std::upper_bound(m_chunkStarts.begin(), m_chunkStarts.end(), end - 1) - m_chunkStarts.begin();
+        while (index-- > 0) {
+            size_t chunkStart = m_chunkStarts[index];
+            const wchar_t* data = m_chunks[index].data->data();
+            size_t first = (std::max)(begin, chunkStart) - chunkStart;
+            size_t last = (std::min)(end - chunkStart, m_chunks[index].length);
+            for (size_t i = last; i > first; --i) {
+                if (data[i - 1] == L'\n') {
+                    lineStarts->push_back(chunkStart + i);
+                    if (++found == count) return;
+                }
+            }
+            if (chunkStart <= begin) return;
+        }
+    }
+
+    LineIndex::LineIndex() : m_indexedLength(0) {
+        m_lineStarts.push_back(0);
+    }
+
+    void LineIndex::Clear() {
+        m_lineStarts.assign(1, 0);
+        m_indexedLength = 0;
+    }
+
+    void LineIndex::IndexTo(const ChunkedText& text, size_t end) {
+        end = (std::min)(end, text.GetLength());
+        if (end <= m_indexedLength) return;
+
+        std::vector<size_t> newlines;
+        text.FindNewlines(m_indexedLength, end, &newlines);
+        AppendLineStarts(m_lineStarts.back(), newlines, end, &m_lineStarts);
+        m_indexedLength = end;
+    }
+
+    void LineIndex::Append(const std::vector<size_t>& lineStarts, size_t end) {
+        m_lineStarts.insert(m_lineStarts.end(), lineStarts.begin(), lineStarts.end());
+        m_indexedLength = end;
+    }
+
+    void LineIndex::Truncate(const ChunkedText& text, size_t length) {
+        if (m_indexedLength <= length) return;
+
+        m_indexedLength = length;
+        while (m_lineStarts.size() > 1 && m_lineStarts.back() > length) {
+            m_lineStarts.pop_back();
+        }
+        // 只有换行之后才会有一行从末尾开始
+        if (m_lineStarts.size() > 1 && m_lineStarts.back() == length) {
+            std::wstring last;
+            text.CopyRange(length - 1, length, &last);
+            if (last[0] != L'\n') {
+                m_lineStarts.pop_back();
+            }
+        }
+    }
+
+    void LineIndex::GetLineText(const ChunkedText& text, size_t line, std::wstring* out) const {
+        size_t begin = m_lineStarts[line];
+        size_t end = line + 1 < m_lineStarts.size() ? m_lineStarts[line + 1] : text.GetLength();
+        ReadLine(text, begin, end, out);
+    }
+
+    void LineIndex::ReadLine(const ChunkedText& text, size_t begin, size_t end, std::wstring* out) {
+        // 多读两个字符，才能看到恰好在长度上限处的换行
+        text.CopyRange(begin, (std::min)(end, begin + kMaxLineChars + 2), out);
+
+        size_t newline = out->find(L'\n');
+        if (newline != std::wstring::npos) {
+            out->resize(newline);
+        }
+        if (!out->empty() && out->back() == L'\r') {
+            out->pop_back();
+        }
+        if (out->size() > kMaxLineChars) {
+            out->resize(kMaxLineChars);
+        }
+    }
+
+    void LineIndex::AppendLineStarts(size_t lastStart, const std::vector<size_t>& newlines, size_t end,
+        std::vector<size_t>* lineStarts) {
+        for (size_t start : newlines) {
+            // 行的内容不含结尾的换行
+            while (start - 1 - lastStart > kMaxLineChars) {
+                lastStart += kMaxLineChars;
+                lineStarts->push_back(lastStart);
+            }
+            lineStarts->push_back(start);
+            lastStart = start;
+        }
+        // 最后一行只会变长，其中的拆分位置已经确定
+        while (end - lastStart > kMaxLineChars) {
+            lastStart += kMaxLineChars;
+            lineStarts->push_back(lastStart);
+        }
+    }
+
+    bool LineIndex::Scan(const ChunkedText& text, size_t begin, size_t end, size_t lastStart, TaskPool& pool,
+        const std::function<bool()>& cancelled, std::vector<size_t>* lineStarts) {
+        auto isCancelled = [&cancelled]() { return cancelled && cancelled(); };
+
+        // 各块并行查找，按顺序拼接后偏移仍然递增
+        size_t blocks = end > begin ? (end - begin + kBlockChars - 1) / kBlockChars : 0;
+        std::vector<std::vector<size_t>> parts(blocks);
+        pool.ParallelFor(blocks, [&](size_t block) {
+            if (isCancelled()) return;
+            size_t first = begin + block * kBlockChars;
+            size_t last = (std::min)(end, first + kBlockChars);
+            text.FindNewlines(first, last, &parts[block]);
+        });
+        if (isCancelled()) return false;
+
+        std::vector<size_t> newlines;
+        size_t total = 0;
+        for (auto& part : parts) total += part.size();
+        newlines.reserve(total);
+        for (auto& part : parts) {
+            newlines.insert(newlines.end(), part.begin(), part.end());
+            std::vector<size_t>().swap(part);
+        }
+
+        lineStarts->reserve(lineStarts->size() + newlines.size());
+        AppendLineStarts(lastStart, newlines, end, lineStarts);
+        return !isCancelled();
+    }
+
+    void LineIndex::FindTailLines(const ChunkedText& text, size_t floor, size_t count, size_t window,
+        std::vector<size_t>* lineStarts) {
+        lineStarts->clear();
+        size_t end = text.GetLength();
+        if (count == 0) return;
+
+        size_t begin = (std::max)(floor, end > window ? end - window : 0);
+        std::vector<size_t> newlines;
+        text.FindNewlinesBackward(begin, end, count, &newlines);
+
+        // 找到了 count 个换行时，最早的一个之后就是确定的行首
+        size_t start = begin;
+        if (newlines.size() == count) {
+            start = newlines.back();
+            newlines.pop_back();
+        }
+        std::reverse(newlines.begin(), newlines.end());
+        lineStarts->push_back(start);
+        AppendLineStarts(start, newlines, end, lineStarts);
+        if (lineStarts->size() > count) {
+            lineStarts->erase(lineStarts->begin(), lineStarts->end() - count);
+        }
+    }
+
+} // namespace KroubleUI
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace KroubleUI {
+
+    class TaskPool;
+
+    // 一段连续的文本，后台任务可能同时持有 data，只有未被共享时才能原地修改
+    struct TextChunk {
+        std::shared_ptr<std::wstring> data;
+        size_t length;          // 有效字符数，退格只缩短它
+    };
+
+    // 按块存放的文本，TextBox 的内容和换行索引都建立在它上面
+    // 追加和载入都不会复制已有文本；复制对象只复制块的引用，可以作为后台任务的快照
+    class ChunkedText {
+    public:
+        static constexpr size_t kChunkChars = 65536;    // 追加的文本按这个大小打包成块
+
+    private:
+        std::vector<TextChunk> m_chunks;
+        std::vector<size_t> m_chunkStarts;          // 每块在全文中的起始偏移
+        size_t m_length;
+
+    public:
+        ChunkedText() : m_length(0) {}
+
+        void Clear();
+        // 取得 text 的所有权替换全部内容，不复制
+        void Assign(std::wstring text);
+        // 耗时只与追加的长度有关
+        void Append(const wchar_t* text, size_t length);
+        // 文本较长时直接接管而不复制
+        void Append(std::wstring&& text);
+        // 删除最后一个字符，文本不能为空
+        void RemoveLast();
+
+        size_t GetLength() const { return m_length; }
+        bool IsEmpty() const { return m_length == 0; }
+        size_t GetChunkCount() const { return m_chunks.size(); }
+        size_t GetCpuBytes() const;
+
+        // 复制 [begin, end) 到 out
+        void CopyRange(size_t begin, size_t end, std::wstring* out) const;
+        void Flatten(std::wstring* out) const;
+        // 把 [begin, end) 中每个换行之后的位置依次追加到 lineStarts
+        void FindNewlines(size_t begin, size_t end, std::vector<size_t>* lineStarts) const;
+        // 从 end 向前查找，直到找到 count 个换行或到达 begin；换行之后的位置按从后到前的顺序追加到 lineStarts
+        void FindNewlinesBackward(size_t begin, size_t end, size_t count, std::vector<size_t>* lineStarts) const;
+    };
+
+    // 文本的行索引：已找到的每行起始位置，可以分段增量建立
+    // 超过 kMaxLineChars 的行拆成多个显示行
+    class LineIndex {
+    public:
+        static constexpr size_t kMaxLineChars = 4096;
+        static constexpr size_t kBlockChars = 1 << 20;  // Scan 中每个并行任务查找的字符数
+
+    private:
+        std::vector<size_t> m_lineStarts;           // 至少有一项
+        size_t m_indexedLength;                     // 已查找过换行的字符数
+
+    public:
+        LineIndex();
+
+        void Clear();
+        size_t GetLineCount() const { return m_lineStarts.size(); }
+        size_t GetLineStart(size_t line) const { return m_lineStarts[line]; }
+        size_t GetLastLineStart() const { return m_lineStarts.back(); }
+        size_t GetIndexedLength() const { return m_indexedLength; }
+        size_t GetCpuBytes() const { return m_lineStarts.capacity() * sizeof(size_t); }
+
+        // 在当前线程查找 text 中 [GetIndexedLength(), end) 的换行
+        void IndexTo(const ChunkedText& text, size_t end);
+        // 接上 Scan 的结果，lineStarts 从 GetIndexedLength() 处开始查找
+        void Append(const std::vector<size_t>& lineStarts, size_t end);
+        // 文本被截短到 length 后丢掉失效的行
+        void Truncate(const ChunkedText& text, size_t length);
+        // 取得一行的内容，不含换行；最后一行的结尾尚未索引时只读取需要的部分
+        void GetLineText(const ChunkedText& text, size_t line, std::wstring* out) const;
+
+        // 读取从 begin 开始的一行，在 end、换行或 kMaxLineChars 处截止，去掉结尾的 \r
+        static void ReadLine(const ChunkedText& text, size_t begin, size_t end, std::wstring* out);
+
+        // 把换行位置转换为行起始位置，拆开过长的行；lastStart 是 newlines 之前最后一行的起始位置
+        static void AppendLineStarts(size_t lastStart, const std::vector<size_t>& newlines, size_t end,
+            std::vector<size_t>* lineStarts);
+        // 在线程池上分块查找 [begin, end) 的行起始位置；cancelled 返回 true 时尽快放弃并返回 false
+        static bool Scan(const ChunkedText& text, size_t begin, size_t end, size_t lastStart, TaskPool& pool,
+            const std::function<bool()>& cancelled, std::vector<size_t>* lineStarts);
+        // 不依赖索引，从末尾向前最多查找 window 个字符，得到最后 count 行的起始位置（按顺序）
+        // floor 是已知的行起始位置；窗口内找不到足够的换行时，以窗口开头作为行首近似拆分最上面的长行
+        static void FindTailLines(const ChunkedText& text, size_t floor, size_t count, size_t window,
+            std::vector<size_t>* lineStarts);
+    };
+
+} // namespace KroubleUI
@@ -0,0 +1,70 @@
+#include "DataGridModel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cwchar>
+
+namespace KroubleUI {
+
+    ColumnTable::ColumnTable() : m_rowCount(0) {
+    }
+
+    size_t ColumnTable::AddNumberColumn(const std::wstring& name, int decimals) {
+        std::unique_ptr<Column> column(new Column());
+        column->name = name;
+        column->numeric = true;
+        column->decimals = (std::max)(0, (std::min)(decimals, 9));
+        m_columns.push_back(std::move(column));
+        return m_columns.size() - 1;
+    }
+
+    size_t ColumnTable::AddTextColumn(const std::wstring& name) {
+        std::unique_ptr<Column> column(new Column());
+        column->name = name;
+        column->numeric = false;
+        column->decimals = 0;
+        m_columns.push_back(std::move(column));
+        return m_columns.size() - 1;
+    }
+
+    void ColumnTable::AppendNumber(size_t column, double value) {
+        m_columns[column]->numbers.PushBack(value);
+    }
+
+    void ColumnTable::AppendText(size_t column, const std::wstring& value) {
+        m_columns[column]->texts.PushBack(value);
+    }
+
+    void ColumnTable::CommitRows() {
+        // 以最短的列为准，只追加了一部分列的行暂不可见
+        size_t rows = SIZE_MAX;
+        for (auto& column : m_columns) {
+            rows = (std::min)(rows, column->numeric ? column->numbers.GetSize() : column->texts.GetSize());
+        }
+        if (m_columns.empty()) rows = 0;
+        m_rowCount.store(rows, std::memory_order_release);
+    }
+
+    void ColumnTable::FormatCell(size_t row, size_t column, std::wstring& text) const {
+        const Column& col = *m_columns[column];
+        if (!col.numeric) {
+            text = col.texts[row];
+            return;
+        }
+
+        wchar_t buffer[64];
+        int length = swprintf(buffer, 64, L"%.*f", col.decimals, col.numbers[row]);
+        text.assign(buffer, length > 0 ? length : 0);
+    }
+
+    int ColumnTable::CompareCells(size_t column, size_t a, size_t b) const {
+        const Column& col = *m_columns[column];
+        if (!col.numeric) {
+            return col.texts[a].compare(col.texts[b]);
+        }
+
+        double x = col.numbers[a];
+        double y = col.numbers[b];
+        return x < y ? -1 : (y < x ? 1 : 0);
+    }
+
+} // namespace KroubleUI
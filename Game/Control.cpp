@@ -0,0 +1,463 @@
+#include "KroubleUI.h"
+#include <cfloat>
+#include <cstdio>
+
+namespace KroubleUI {
+
+    namespace {
+        // 行向量约定：先应用 a 再应用 b
+        D2D1_MATRIX_3X2_F Multiply(const D2D1_MATRIX_3X2_F& a, const D2D1_MATRIX_3X2_F& b) {
+            D2D1_MATRIX_3X2_F result;
+            result._11 = a._11 * b._11 + a._12 * b._21;
+            result._12 = a._11 * b._12 + a._12 * b._22;
+            result._21 = a._21 * b._11 + a._22 * b._21;
+            result._22 = a._21 * b._12 + a._22 * b._22;
+            result._31 = a._31 * b._11 + a._32 * b._21 + b._31;
+            result._32 = a._31 * b._12 + a._32 * b._22 + b._32;
+            return result;
+        }
+
+        bool IsIdentity(const D2D1_MATRIX_3X2_F& m) {
+            return m._11 == 1.0f && m._12 == 0.0f && m._21 == 0.0f &&
+                m._22 == 1.0f && m._31 == 0.0f && m._32 == 0.0f;
+        }
+
+        bool RectEquals(const D2D1_RECT_F& a, const D2D1_RECT_F& b) {
+            return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+        }
+    }
+
+    struct Control::PropertyAnimations {
+        AnimatedValue<float> opacity;
+        AnimatedValue<D2D1_RECT_F> rect;
+        AnimatedValue<D2D1_MATRIX_3X2_F> transform;
+    };
+
+    Control::Control(Window* parent, const D2D1_RECT_F& rect)
+        : m_parent(parent),
+        m_container(nullptr),
+        m_rect(rect),
+        m_visible(true),
+        m_opacity(1.0f),
+        m_transform(D2D1::IdentityMatrix()),
+        m_styleVersion(0),
+        m_enabled(true),
+        m_textInvalid(false) {
+        m_styleVersion = GetStyleSheet()->GetVersion();
+    }
+
+    Control::~Control() {
+        if (m_textInvalid && m_parent) {
+            m_parent->CancelTextWork(this);
+        }
+
+        // 派生类析构时应已释放所有登记过的资源，剩下的视为泄漏
+        std::string leak = FormatLeakMessage("control", this, m_resources.GetUsage());
+        if (!leak.empty()) {
+            OutputDebugStringA(leak.c_str());
+        }
+    }
+
+    void Control::FillRectangle(ID2D1RenderTarget* renderTarget, const D2D1_RECT_F& rect, ID2D1SolidColorBrush* brush) {
+        renderTarget->FillRectangle(rect, brush);
+
+        if (HasDrawObservers()) {
+            D2D1_COLOR_F color = brush->GetColor();
+            color.a *= brush->GetOpacity();
+            NotifyFill(renderTarget, rect, color);
+        }
+    }
+
+    void Control::NotifyFill(ID2D1RenderTarget* renderTarget, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color) {
+        if (!m_parent) return;
+
+        for (DrawObserver* observer : m_parent->GetDrawObservers()) {
+            observer->OnFillRect(renderTarget, this, rect, color);
+        }
+    }
+
+    void Control::DrawRectangleOutline(ID2D1RenderTarget* renderTarget, const D2D1_RECT_F& rect, ID2D1SolidColorBrush* brush, float strokeWidth) {
+        renderTarget->DrawRectangle(rect, brush, strokeWidth);
+
+        if (HasDrawObservers()) {
+            D2D1_COLOR_F color = brush->GetColor();
+            color.a *= brush->GetOpacity();
+            for (DrawObserver* observer : m_parent->GetDrawObservers()) {
+                observer->OnDrawRect(renderTarget, this, rect, color, strokeWidth);
+            }
+        }
+    }
+
+    void Control::DrawLineSegment(ID2D1RenderTarget* renderTarget, D2D1_POINT_2F from, D2D1_POINT_2F to, ID2D1SolidColorBrush* brush, float strokeWidth) {
+        renderTarget->DrawLine(from, to, brush, strokeWidth);
+
+        if (HasDrawObservers()) {
+            D2D1_COLOR_F color = brush->GetColor();
+            color.a *= brush->GetOpacity();
+            for (DrawObserver* observer : m_parent->GetDrawObservers()) {
+                observer->OnDrawLine(renderTarget, this, from, to, color, strokeWidth);
+            }
+        }
+    }
+
+    void Control::DrawTextRun(ID2D1RenderTarget* renderTarget, const wchar_t* text, UINT32 length, IDWriteTextFormat* format,
+        const D2D1_RECT_F& rect, ID2D1SolidColorBrush* brush, D2D1_DRAW_TEXT_OPTIONS options) {
+        // 短文本使用进程共享的排版缓存，重复出现的标签不再重新排版
+        std::shared_ptr<const TextRun> run;
+        if (m_parent && length <= TextRunCache::kMaxTextLength) {
+            run = m_parent->GetGraphicsContext()->GetTextRunCache()->Acquire(
+                text, length, format, rect.right - rect.left, rect.bottom - rect.top);
+        }
+        IDWriteTextLayout* layout = GetTextLayout(run.get());
+        if (layout) {
+            renderTarget->DrawTextLayout(D2D1::Point2F(rect.left, rect.top), layout, brush, options);
+        }
+        else {
+            renderTarget->DrawTextW(text, length, format, rect, brush, options);
+        }
+
+        if (HasDrawObservers()) {
+            D2D1_COLOR_F color = brush->GetColor();
+            color.a *= brush->GetOpacity();
+            NotifyText(renderTarget, text, length, format, rect, color, options);
+        }
+    }
+
+    void Control::DrawPreparedText(ID2D1RenderTarget* renderTarget, const PreparedText* prepared, const wchar_t* text, UINT32 length,
+        IDWriteTextFormat* format, const D2D1_RECT_F& rect, ID2D1SolidColorBrush* brush, D2D1_DRAW_TEXT_OPTIONS options) {
+        // 文本、格式或尺寸在排版之后变了而没有重新排版时，结果已经过期
+        IDWriteTextLayout* layout = nullptr;
+        if (prepared && prepared->Matches(text, length, format, rect.right - rect.left, rect.bottom - rect.top)) {
+            layout = GetTextLayout(prepared->run.get());
+        }
+        if (!layout) {
+            DrawTextRun(renderTarget, text, length, format, rect, brush, options);
+            return;
+        }
+
+        renderTarget->DrawTextLayout(D2D1::Point2F(rect.left, rect.top), layout, brush, options);
+
+        if (HasDrawObservers()) {
+            D2D1_COLOR_F color = brush->GetColor();
+            color.a *= brush->GetOpacity();
+            NotifyText(renderTarget, text, length, format, rect, color, options);
+        }
+    }
+
+    void Control::InvalidateText() {
+        m_preparedText.clear();
+        if (!m_textInvalid && m_parent) {
+            m_textInvalid = true;
+            m_parent->QueueTextWork(this);
+        }
+    }
+
+    void Control::CollectTextWork(std::vector<TextWork>* work) {
+        m_textInvalid = false;
+
+        // 结果槽位在窗口排版期间不会移动，工作线程各自写入自己的槽位
+        // 槽位记下排版时的文本、格式和尺寸，绘制时据此判断结果是否过期
+        size_t first = work->size();
+        OnCollectTextWork(work);
+        m_preparedText.resize(work->size() - first);
+        for (size_t i = 0; i < m_preparedText.size(); ++i) {
+            TextWork& item = (*work)[first + i];
+            PreparedText& prepared = m_preparedText[i];
+            prepared.run.reset();
+            prepared.text.assign(item.text, item.length);
+            prepared.format = item.format;
+            prepared.width = item.width;
+            prepared.height = item.height;
+            item.run = &prepared.run;
+        }
+    }
+
+    void Control::NotifyText(ID2D1RenderTarget* renderTarget, const wchar_t* text, UINT32 length, IDWriteTextFormat* format,
+        const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, D2D1_DRAW_TEXT_OPTIONS options) {
+        if (!m_parent) return;
+
+        for (DrawObserver* observer : m_parent->GetDrawObservers()) {
+            observer->OnDrawText(renderTarget, this, text, length, format, rect, color, options);
+        }
+    }
+
+    void Control::PushClip(ID2D1RenderTarget* renderTarget, const D2D1_RECT_F& rect) {
+        renderTarget->PushAxisAlignedClip(rect, D2D1_ANTIALIAS_MODE_ALIASED);
+
+        if (HasDrawObservers()) {
+            for (DrawObserver* observer : m_parent->GetDrawObservers()) {
+                observer->OnPushClip(renderTarget, this, rect);
+            }
+        }
+    }
+
+    void Control::PopClip(ID2D1RenderTarget* renderTarget) {
+        renderTarget->PopAxisAlignedClip();
+
+        if (HasDrawObservers()) {
+            for (DrawObserver* observer : m_parent->GetDrawObservers()) {
+                observer->OnPopClip(renderTarget, this);
+            }
+        }
+    }
+
+    bool Control::HasDrawObservers() const {
+        return m_parent && !m_parent->GetDrawObservers().empty();
+    }
+
+    // 只在刚超出预算时警告，回到预算内后再次超出时重新警告
+    void Control::OnResourceAdded(ResourceKind kind, size_t bytes) {
+        if (m_resources.Add(kind, bytes)) {
+            ReportBudgetExceeded("control", this, m_resources.GetUsage(), m_resources.GetBudget());
+        }
+    }
+
+    void Control::OnResourceRemoved(ResourceKind kind, size_t bytes) {
+        if (m_resources.Remove(kind, bytes)) {
+            ReportBudgetExceeded("control", this, m_resources.GetUsage(), m_resources.GetBudget());
+        }
+    }
+
+    const ResourceUsage& Control::UpdateResourceUsage() {
+        if (m_resources.SetCpuBytes(GetCpuBytes())) {
+            ReportBudgetExceeded("control", this, m_resources.GetUsage(), m_resources.GetBudget());
+        }
+        return m_resources.GetUsage();
+    }
+
+    void Control::Render(ID2D1RenderTarget* renderTarget) {
+        if (!m_visible || m_opacity <= 0.0f) return;
+        RefreshStyle();
+
+        D2D1_MATRIX_3X2_F previous;
+        bool transformed = !IsIdentity(m_transform);
+        if (transformed) {
+            renderTarget->GetTransform(&previous);
+            renderTarget->SetTransform(Multiply(GetCenteredTransform(), previous));
+        }
+
+        // 半透明时先画到图层上再整体混合，避免控件内部的重叠部分叠加透明度
+        ID2D1Layer* layer = nullptr;
+        if (m_opacity < 1.0f && SUCCEEDED(renderTarget->CreateLayer(nullptr, &layer))) {
+            renderTarget->PushLayer(
+                D2D1::LayerParameters(D2D1::InfiniteRect(), nullptr, D2D1_ANTIALIAS_MODE_PER_PRIMITIVE,
+                    D2D1::IdentityMatrix(), m_opacity),
+                layer);
+            if (HasDrawObservers()) {
+                for (DrawObserver* observer : m_parent->GetDrawObservers()) {
+                    observer->OnPushLayer(renderTarget, this, m_opacity);
+                }
+            }
+        }
+
+        Draw(renderTarget);
+
+        if (layer) {
+            renderTarget->PopLayer();
+            layer->Release();
+            if (HasDrawObservers()) {
+                for (DrawObserver* observer : m_parent->GetDrawObservers()) {
+                    observer->OnPopLayer(renderTarget, this);
+                }
+            }
+        }
+        if (transformed) {
+            renderTarget->SetTransform(previous);
+        }
+    }
+
+    void Control::Invalidate() {
+        Invalidate(m_rect);
+    }
+
+    void Control::Invalidate(const D2D1_RECT_F& rect) {
+        // 换算成变换后的范围，并为跨出边缘的描边和抗锯齿留出一个像素
+        D2D1_RECT_F bounds = TransformBounds(rect);
+        bounds = D2D1::RectF(bounds.left - 1.0f, bounds.top - 1.0f, bounds.right + 1.0f, bounds.bottom + 1.0f);
+
+        if (m_container) {
+            m_container->OnChildInvalidated(bounds);
+        }
+        else if (m_parent) {
+            m_parent->Invalidate(bounds);
+        }
+    }
+
+    AnimationScheduler* Control::GetAnimationScheduler() const {
+        return m_parent ? m_parent->GetAnimationScheduler() : nullptr;
+    }
+
+    D2D1_RECT_F Control::GetBounds() const {
+        return TransformBounds(m_rect);
+    }
+
+    D2D1_RECT_F Control::TransformBounds(const D2D1_RECT_F& rect) const {
+        if (IsIdentity(m_transform)) return rect;
+
+        D2D1_MATRIX_3X2_F m = GetCenteredTransform();
+        float xs[] = { rect.left, rect.right, rect.left, rect.right };
+        float ys[] = { rect.top, rect.top, rect.bottom, rect.bottom };
+        D2D1_RECT_F bounds = D2D1::RectF(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (int i = 0; i < 4; ++i) {
+            float x = xs[i] * m._11 + ys[i] * m._21 + m._31;
+            float y = xs[i] * m._12 + ys[i] * m._22 + m._32;
+            bounds.left = (std::min)(bounds.left, x);
+            bounds.top = (std::min)(bounds.top, y);
+            bounds.right = (std::max)(bounds.right, x);
+            bounds.bottom = (std::max)(bounds.bottom, y);
+        }
+        return bounds;
+    }
+
+    D2D1_MATRIX_3X2_F Control::GetCenteredTransform() const {
+        // 先移到以控件中心为原点，变换后再移回去
+        float cx = (m_rect.left + m_rect.right) * 0.5f;
+        float cy = (m_rect.top + m_rect.bottom) * 0.5f;
+        D2D1_MATRIX_3X2_F m = m_transform;
+        m._31 += cx - (cx * m._11 + cy * m._21);
+        m._32 += cy - (cx * m._12 + cy * m._22);
+        return m;
+    }
+
+    void Control::SetRect(const D2D1_RECT_F& rect) {
+        if (m_animations) {
+            m_animations->rect.Set(rect);
+        }
+        else {
+            ApplyRect(rect);
+        }
+    }
+
+    void Control::SetEnabled(bool enabled) {
+        if (m_enabled != enabled) {
+            m_enabled = enabled;
+            Invalidate();
+            OnEnabledChanged();
+        }
+    }
+
+    void Control::SetStyleName(const std::wstring& name) {
+        m_styleName = name;
+        for (auto& style : m_styles) {
+            style.reset();
+        }
+        m_styleVersion = GetStyleSheet()->GetVersion();
+        OnStyleChanged();
+        Invalidate();
+    }
+
+    const ResolvedStyle& Control::GetStyle(StyleState state) {
+        std::shared_ptr<const ResolvedStyle>& style = m_styles[static_cast<size_t>(state)];
+        if (!style) {
+            style = GetStyleSheet()->Resolve(m_styleName, state);
+        }
+        return *style;
+    }
+
+    StyleSheet* Control::GetStyleSheet() const {
+        StyleSheet* styleSheet = m_parent ? m_parent->GetStyleSheet() : nullptr;
+        return styleSheet ? styleSheet : StyleSheet::GetDefault().get();
+    }
+
+    void Control::RefreshStyle() {
+        // 样式表在上一帧之后有变化：丢弃已取用的记录，相同样式的控件由样式表的缓存共享同一份解析结果
+        UINT64 version = GetStyleSheet()->GetVersion();
+        if (version == m_styleVersion) return;
+
+        m_styleVersion = version;
+        for (auto& style : m_styles) {
+            style.reset();
+        }
+        OnStyleChanged();
+    }
+
+    void Control::SetVisible(bool visible) {
+        if (m_visible != visible) {
+            m_visible = visible;
+            Invalidate();
+        }
+    }
+
+    void Control::SetOpacity(float opacity) {
+        if (m_animations) {
+            m_animations->opacity.Set(opacity);
+        }
+        else if (m_opacity != opacity) {
+            m_opacity = opacity;
+            Invalidate();
+        }
+    }
+
+    void Control::SetTransform(const D2D1_MATRIX_3X2_F& transform) {
+        if (m_animations) {
+            m_animations->transform.Set(transform);
+        }
+        else {
+            ApplyTransform(transform);
+        }
+    }
+
+    void Control::AnimateOpacity(float opacity, double duration, EasingFunction easing) {
+        GetAnimations().opacity.AnimateTo(opacity, duration, easing);
+    }
+
+    void Control::AnimateRect(const D2D1_RECT_F& rect, double duration, EasingFunction easing) {
+        GetAnimations().rect.AnimateTo(rect, duration, easing);
+    }
+
+    void Control::SpringRect(const D2D1_RECT_F& rect, const SpringParams& params) {
+        GetAnimations().rect.SpringTo(rect, params);
+    }
+
+    void Control::AnimateTransform(const D2D1_MATRIX_3X2_F& transform, double duration, EasingFunction easing) {
+        GetAnimations().transform.AnimateTo(transform, duration, easing);
+    }
+
+    void Control::SpringTransform(const D2D1_MATRIX_3X2_F& transform, const SpringParams& params) {
+        GetAnimations().transform.SpringTo(transform, params);
+    }
+
+    Control::PropertyAnimations& Control::GetAnimations() {
+        if (!m_animations) {
+            m_animations.reset(new PropertyAnimations());
+            PropertyAnimations& animations = *m_animations;
+
+            // 先同步当前值再绑定，之后属性只通过动画值修改
+            animations.opacity.Set(m_opacity);
+            animations.rect.Set(m_rect);
+            animations.transform.Set(m_transform);
+
+            AnimationScheduler* scheduler = GetAnimationScheduler();
+            animations.opacity.Attach(scheduler, [this]() {
+                m_opacity = m_animations->opacity.Get();
+                Invalidate();
+            });
+            animations.rect.Attach(scheduler, [this]() { ApplyRect(m_animations->rect.Get()); });
+            animations.transform.Attach(scheduler, [this]() { ApplyTransform(m_animations->transform.Get()); });
+        }
+        return *m_animations;
+    }
+
+    void Control::ApplyRect(const D2D1_RECT_F& rect) {
+        if (RectEquals(m_rect, rect)) return;
+        // 尺寸变化时文本要按新的宽高重新排版，只是移动则沿用
+        if (rect.right - rect.left != m_rect.right - m_rect.left || rect.bottom - rect.top != m_rect.bottom - m_rect.top) {
+            InvalidateText();
+        }
+        // 旧位置和新位置都需要重绘
+        Invalidate();
+        m_rect = rect;
+        Invalidate();
+
+        // 处理函数可能再次改变位置，传出副本
+        D2D1_RECT_F changed = m_rect;
+        m_rectChanged.Emit(changed);
+    }
+
+    void Control::ApplyTransform(const D2D1_MATRIX_3X2_F& transform) {
+        Invalidate();
+        m_transform = transform;
+        Invalidate();
+    }
+
+} // namespace KroubleUI
@@ -0,0 +1,422 @@
+#include "KroubleUI.h"
+#include <algorithm>
+#include <cmath>
+
+namespace KroubleUI {
+
+    namespace {
+        const float kDefaultColumnWidth = 120.0f;
+        const float kMinColumnWidth = 16.0f;
+        const float kCellPadding = 6.0f;
+        const float kRowPadding = 4.0f;
+        const int kWheelRows = 3;
+        const float kHorizontalStep = 40.0f;
+    }
+
+    // 界面线程与后台任务共享的状态
+    struct DataGrid::SharedState {
+        std::atomic<UINT64> generation;     // 每次发起更新都会递增，旧任务据此尽早退出
+        DataGrid* owner;                    // 只在界面线程上读写，控件析构时置空
+        std::mutex mutex;                   // 保护 window
+        Window* window;                     // 控件析构时置空，之后任务不再投递结果
+
+        SharedState() : generation(0), owner(nullptr), window(nullptr) {}
+    };
+
+    // 一次更新的全部参数，提交后不再修改
+    struct DataGrid::ViewRequest {
+        UINT64 generation;
+        std::shared_ptr<DataGridSource> source;
+        TaskPool* pool;                     // 执行这次任务的线程池，析构前会等任务结束，任务不持有它的引用
+        RowViewRequest rows;
+    };
+
+    DataGrid::DataGrid(Window* parent, const D2D1_RECT_F& rect)
+        : Control(parent, rect),
+        m_pool(TaskPool::GetDefault()),
+        m_shared(std::make_shared<SharedState>()),
+        m_view(std::make_shared<DataGridRowView>()),
+        m_sortColumn(-1),
+        m_sortAscending(true),
+        m_updating(false),
+        m_appendPending(false),
+        m_lastUpdateSeconds(0.0),
+        m_scrollX(0.0),
+        m_scrollY(0.0),
+        m_rowHeight(24.0f),
+        m_headerHeight(24.0f),
+        m_hasFocus(false),
+        m_textBrush(nullptr),
+        m_backgroundBrush(nullptr),
+        m_headerBrush(nullptr),
+        m_gridLineBrush(nullptr),
+        m_scrollBarBrush(nullptr),
+        m_textFormat(nullptr),
+        m_headerFormat(nullptr) {
+        m_shared->owner = this;
+        m_shared->window = parent;
+        m_columnOffsets.push_back(0.0f);
+        Initialize(parent->GetRenderTarget(), parent->GetDWriteFactory());
+    }
+
+    DataGrid::~DataGrid() {
+        // 取消进行中的任务但不等待；任务只持有共享状态和数据源，结束后丢弃结果
+        m_shared->owner = nullptr;
+        m_shared->generation.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(m_shared->mutex);
+            m_shared->window = nullptr;
+        }
+
+        ReleaseResource(&m_textBrush);
+        ReleaseResource(&m_backgroundBrush);
+        ReleaseResource(&m_headerBrush);
+        ReleaseResource(&m_gridLineBrush);
+        ReleaseResource(&m_scrollBarBrush);
+        ReleaseResource(&m_textFormat);
+        ReleaseResource(&m_headerFormat);
+    }
+
+    void DataGrid::Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory) {
+        // 创建画笔
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black), &m_textBrush);
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_backgroundBrush);
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(0.93f, 0.93f, 0.93f), &m_headerBrush);
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(0.85f, 0.85f, 0.85f), &m_gridLineBrush);
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Gray, 0.6f), &m_scrollBarBrush);
+        TrackResource(m_textBrush);
+        TrackResource(m_backgroundBrush);
+        TrackResource(m_headerBrush);
+        TrackResource(m_gridLineBrush);
+        TrackResource(m_scrollBarBrush);
+
+        // 单元格不换行，垂直居中
+        TextFormatDesc desc;
+        desc.wordWrapping = DWRITE_WORD_WRAPPING_NO_WRAP;
+        desc.paragraphAlignment = DWRITE_PARAGRAPH_ALIGNMENT_CENTER;
+        m_textFormat = m_parent->GetGraphicsContext()->GetTextFormat(desc);
+        TrackResource(m_textFormat);
+
+        desc.weight = DWRITE_FONT_WEIGHT_BOLD;
+        m_headerFormat = m_parent->GetGraphicsContext()->GetTextFormat(desc);
+        TrackResource(m_headerFormat);
+
+        if (m_textFormat) {
+            // 用一行样本文字测量行高
+            IDWriteTextLayout* probe = nullptr;
+            dwriteFactory->CreateTextLayout(L"Ag", 2, m_textFormat, 1000.0f, 1000.0f, &probe);
+            if (probe) {
+                DWRITE_TEXT_METRICS metrics;
+                if (SUCCEEDED(probe->GetMetrics(&metrics)) && metrics.height > 0) {
+                    m_rowHeight = std::ceil(metrics.height) + 2 * kRowPadding;
+                    m_headerHeight = m_rowHeight;
+                }
+                probe->Release();
+            }
+        }
+    }
+
+    void DataGrid::Draw(ID2D1RenderTarget* renderTarget) {
+        if (!m_visible) return;
+
+        FillRectangle(renderTarget, m_rect, m_backgroundBrush);
+        if (!m_source) return;
+
+        PushClip(renderTarget, m_rect);
+
+        float viewWidth = m_rect.right - m_rect.left;
+        float bodyTop = m_rect.top + m_headerHeight;
+
+        // 只处理落在可见区域内的列
+        size_t columnCount = m_columnWidths.size();
+        size_t firstColumn = std::upper_bound(m_columnOffsets.begin(), m_columnOffsets.end(),
+            static_cast<float>(m_scrollX)) - m_columnOffsets.begin();
+        firstColumn = firstColumn > 0 ? firstColumn - 1 : 0;
+        size_t lastColumn = firstColumn;
+        while (lastColumn < columnCount && m_columnOffsets[lastColumn] < m_scrollX + viewWidth) {
+            ++lastColumn;
+        }
+
+        // 表头
+        FillRectangle(renderTarget, D2D1::RectF(m_rect.left, m_rect.top, m_rect.right, bodyTop), m_headerBrush);
+        for (size_t column = firstColumn; column < lastColumn; ++column) {
+            float left = m_rect.left + static_cast<float>(m_columnOffsets[column] - m_scrollX);
+            float right = left + m_columnWidths[column];
+
+            m_cellText = m_source->GetColumnName(column);
+            if (static_cast<int>(column) == m_sortColumn) {
+                m_cellText += m_sortAscending ? L" \u25B2" : L" \u25BC";
+            }
+            DrawTextRun(renderTarget, m_cellText.c_str(), static_cast<UINT32>(m_cellText.size()), m_headerFormat,
+                D2D1::RectF(left + kCellPadding, m_rect.top, right - kCellPadding, bodyTop),
+                m_textBrush, D2D1_DRAW_TEXT_OPTIONS_CLIP);
+            DrawLineSegment(renderTarget, D2D1::Point2F(right - 0.5f, m_rect.top), D2D1::Point2F(right - 0.5f, m_rect.bottom), m_gridLineBrush);
+        }
+        DrawLineSegment(renderTarget, D2D1::Point2F(m_rect.left, bodyTop - 0.5f), D2D1::Point2F(m_rect.right, bodyTop - 0.5f), m_gridLineBrush);
+
+        // 只处理落在可见区域内的行
+        PushClip(renderTarget, D2D1::RectF(m_rect.left, bodyTop, m_rect.right, m_rect.bottom));
+        size_t rowCount = m_view->GetCount();
+        size_t first = static_cast<size_t>(m_scrollY / m_rowHeight);
+        float y = bodyTop + static_cast<float>(first * static_cast<double>(m_rowHeight) - m_scrollY);
+
+        for (size_t row = first; row < rowCount && y < m_rect.bottom; ++row, y += m_rowHeight) {
+            size_t sourceRow = m_view->GetRow(row);
+            for (size_t column = firstColumn; column < lastColumn; ++column) {
+                float left = m_rect.left + static_cast<float>(m_columnOffsets[column] - m_scrollX);
+                m_source->FormatCell(sourceRow, column, m_cellText);
+                DrawTextRun(renderTarget, m_cellText.c_str(), static_cast<UINT32>(m_cellText.size()), m_textFormat,
+                    D2D1::RectF(left + kCellPadding, y, left + m_columnWidths[column] - kCellPadding, y + m_rowHeight),
+                    m_textBrush, D2D1_DRAW_TEXT_OPTIONS_CLIP);
+            }
+            DrawLineSegment(renderTarget, D2D1::Point2F(m_rect.left, y + m_rowHeight - 0.5f),
+                D2D1::Point2F(m_rect.right, y + m_rowHeight - 0.5f), m_gridLineBrush);
+        }
+        PopClip(renderTarget);
+
+        // 滚动条
+        float bodyHeight = m_rect.bottom - bodyTop;
+        double contentHeight = rowCount * static_cast<double>(m_rowHeight);
+        if (contentHeight > bodyHeight) {
+            float thumbHeight = (std::max)(20.0f, static_cast<float>(bodyHeight * bodyHeight / contentHeight));
+            double maxScroll = contentHeight - bodyHeight;
+            float thumbTop = bodyTop + static_cast<float>((bodyHeight - thumbHeight) * (m_scrollY / maxScroll));
+            FillRectangle(renderTarget,
+                D2D1::RectF(m_rect.right - 6.0f, thumbTop, m_rect.right - 2.0f, thumbTop + thumbHeight),
+                m_scrollBarBrush);
+        }
+        double contentWidth = m_columnOffsets.back();
+        if (contentWidth > viewWidth) {
+            float thumbWidth = (std::max)(20.0f, static_cast<float>(viewWidth * viewWidth / contentWidth));
+            double maxScroll = contentWidth - viewWidth;
+            float thumbLeft = m_rect.left + static_cast<float>((viewWidth - thumbWidth) * (m_scrollX / maxScroll));
+            FillRectangle(renderTarget,
+                D2D1::RectF(thumbLeft, m_rect.bottom - 6.0f, thumbLeft + thumbWidth, m_rect.bottom - 2.0f),
+                m_scrollBarBrush);
+        }
+
+        PopClip(renderTarget);
+    }
+
+    void DataGrid::OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) {
+        switch (message) {
+        case WM_LBUTTONDOWN: {
+            float x = static_cast<float>(GET_X_LPARAM(lParam));
+            float y = static_cast<float>(GET_Y_LPARAM(lParam));
+            bool focused = HitTest(x, y);
+            if (focused != m_hasFocus) {
+                m_hasFocus = focused;
+                m_focusChanged.Emit(focused);
+            }
+            if (!m_hasFocus || y >= m_rect.top + m_headerHeight) break;
+
+            // 点击表头按该列排序，再次点击切换升降序
+            float contentX = static_cast<float>(x - m_rect.left + m_scrollX);
+            size_t column = std::upper_bound(m_columnOffsets.begin(), m_columnOffsets.end(), contentX) - m_columnOffsets.begin();
+            if (column == 0 || column > m_columnWidths.size()) break;
+            --column;
+            if (static_cast<int>(column) == m_sortColumn) {
+                SortBy(m_sortColumn, !m_sortAscending);
+            }
+            else {
+                SortBy(static_cast<int>(column), true);
+            }
+            break;
+        }
+
+        case WM_MOUSEWHEEL: {
+            double notches = GET_WHEEL_DELTA_WPARAM(wParam) / static_cast<double>(WHEEL_DELTA);
+            // 按住 Shift 时横向滚动
+            if (GET_KEYSTATE_WPARAM(wParam) & MK_SHIFT) {
+                ScrollBy(-notches * kWheelRows * kHorizontalStep, 0.0);
+            }
+            else {
+                ScrollBy(0.0, -notches * kWheelRows * m_rowHeight);
+            }
+            break;
+        }
+        }
+    }
+
+    void DataGrid::OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) {
+        if (!m_hasFocus || message != WM_KEYDOWN) return;
+
+        double page = (std::max)(static_cast<double>(m_rowHeight), m_rect.bottom - m_rect.top - m_headerHeight - static_cast<double>(m_rowHeight));
+        switch (wParam) {
+        case VK_UP:    ScrollBy(0.0, -m_rowHeight); break;
+        case VK_DOWN:  ScrollBy(0.0, m_rowHeight); break;
+        case VK_LEFT:  ScrollBy(-kHorizontalStep, 0.0); break;
+        case VK_RIGHT: ScrollBy(kHorizontalStep, 0.0); break;
+        case VK_PRIOR: ScrollBy(0.0, -page); break;
+        case VK_NEXT:  ScrollBy(0.0, page); break;
+        case VK_HOME:  ScrollToRow(0); break;
+        case VK_END:   ScrollToRow(m_view->GetCount()); break;
+        }
+    }
+
+    size_t DataGrid::GetCpuBytes() const {
+        // 数据源可能被多个控件共享，不计入
+        size_t bytes = sizeof(DataGrid) + sizeof(SharedState);
+        bytes += sizeof(DataGridRowView) + m_view->rows.capacity() * sizeof(UINT32);
+        bytes += (m_columnOffsets.capacity() + m_columnWidths.capacity()) * sizeof(float);
+        bytes += m_cellText.capacity() * sizeof(wchar_t);
+        return bytes;
+    }
+
+    void DataGrid::SetSource(std::shared_ptr<DataGridSource> source) {
+        m_source = source;
+        size_t columns = m_source ? m_source->GetColumnCount() : 0;
+        m_columnWidths.assign(columns, kDefaultColumnWidth);
+        if (m_sortColumn >= static_cast<int>(columns)) {
+            m_sortColumn = -1;
+        }
+        UpdateColumnOffsets();
+        m_scrollX = 0.0;
+        m_scrollY = 0.0;
+        m_view = std::make_shared<DataGridRowView>();
+        StartUpdate(false);
+    }
+
+    void DataGrid::SetTaskPool(std::shared_ptr<TaskPool> pool) {
+        m_pool = pool ? pool : TaskPool::GetDefault();
+    }
+
+    void DataGrid::SortBy(int column, bool ascending) {
+        m_sortColumn = column >= 0 && static_cast<size_t>(column) < m_columnWidths.size() ? column : -1;
+        m_sortAscending = ascending;
+        StartUpdate(false);
+        Invalidate();
+    }
+
+    void DataGrid::SetFilter(RowFilter filter) {
+        m_filter = filter;
+        StartUpdate(false);
+    }
+
+    void DataGrid::NotifyRowsAppended() {
+        StartUpdate(true);
+    }
+
+    void DataGrid::SetColumnWidth(size_t column, float width) {
+        if (column >= m_columnWidths.size()) return;
+        m_columnWidths[column] = (std::max)(width, kMinColumnWidth);
+        UpdateColumnOffsets();
+        ClampScroll();
+        Invalidate();
+    }
+
+    float DataGrid::GetColumnWidth(size_t column) const {
+        return column < m_columnWidths.size() ? m_columnWidths[column] : 0.0f;
+    }
+
+    void DataGrid::ScrollToRow(size_t row) {
+        m_scrollY = row * static_cast<double>(m_rowHeight);
+        ClampScroll();
+        Invalidate();
+    }
+
+    void DataGrid::StartUpdate(bool incremental) {
+        if (!m_source) {
+            m_shared->generation.fetch_add(1);
+            m_view = std::make_shared<DataGridRowView>();
+            m_updating = false;
+            m_appendPending = false;
+            ClampScroll();
+            Invalidate();
+            return;
+        }
+
+        // 进行中的任务完成后再处理新追加的行
+        if (incremental && m_updating) {
+            m_appendPending = true;
+            return;
+        }
+
+        size_t rowCount = m_source->GetRowCount();
+        if (incremental && m_view->sourceRows >= rowCount) return;
+
+        RowViewRequest rows;
+        if (incremental) {
+            rows.base = m_view;
+        }
+        rows.rowCount = rowCount;
+        rows.sortColumn = m_sortColumn;
+        rows.sortAscending = m_sortAscending;
+        rows.filter = m_filter;
+
+        // 保持原有顺序时只更新行数，追加的耗时与总行数无关，不需要后台任务
+        if (rows.IsIdentity()) {
+            m_shared->generation.fetch_add(1);
+            m_appendPending = false;
+            OnViewReady(BuildRowView(*m_source, *m_pool, rows, nullptr), 0.0);
+            return;
+        }
+
+        std::shared_ptr<ViewRequest> request = std::make_shared<ViewRequest>();
+        request->generation = m_shared->generation.fetch_add(1) + 1;
+        request->source = m_source;
+        request->pool = m_pool.get();
+        request->rows = std::move(rows);
+        m_updating = true;
+        m_appendPending = false;
+
+        std::shared_ptr<SharedState> shared = m_shared;
+        m_pool->Submit([shared, request]() { BuildView(shared, request); });
+    }
+
+    void DataGrid::OnViewReady(std::shared_ptr<const DataGridRowView> view, double seconds) {
+        m_view = view;
+        m_updating = false;
+        m_lastUpdateSeconds = seconds;
+        ClampScroll();
+        Invalidate();
+
+        if (m_appendPending) {
+            m_appendPending = false;
+            StartUpdate(true);
+        }
+    }
+
+    void DataGrid::BuildView(std::shared_ptr<SharedState> shared, std::shared_ptr<ViewRequest> request) {
+        SystemClock clock;
+        double start = clock.Now();
+        std::shared_ptr<const DataGridRowView> result = BuildRowView(*request->source, *request->pool, request->rows,
+            [&shared, &request]() { return shared->generation.load() != request->generation; });
+        if (!result) return;
+
+        double seconds = clock.Now() - start;
+        // 持有锁投递，控件（和窗口）不会在投递过程中析构
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (!shared->window) return;
+        shared->window->PostTask([shared, request, result, seconds]() {
+            // 控件已析构或有了更新的请求时丢弃结果
+            if (shared->owner && shared->generation.load() == request->generation) {
+                shared->owner->OnViewReady(result, seconds);
+            }
+        });
+    }
+
+    void DataGrid::UpdateColumnOffsets() {
+        m_columnOffsets.resize(m_columnWidths.size() + 1);
+        m_columnOffsets[0] = 0.0f;
+        for (size_t i = 0; i < m_columnWidths.size(); ++i) {
+            m_columnOffsets[i + 1] = m_columnOffsets[i] + m_columnWidths[i];
+        }
+    }
+
+    void DataGrid::ClampScroll() {
+        double bodyHeight = m_rect.bottom - m_rect.top - m_headerHeight;
+        double maxY = (std::max)(0.0, m_view->GetCount() * static_cast<double>(m_rowHeight) - bodyHeight);
+        double maxX = (std::max)(0.0, static_cast<double>(m_columnOffsets.back()) - (m_rect.right - m_rect.left));
+        m_scrollY = (std::min)((std::max)(m_scrollY, 0.0), maxY);
+        m_scrollX = (std::min)((std::max)(m_scrollX, 0.0), maxX);
+    }
+
+    void DataGrid::ScrollBy(double dx, double dy) {
+        m_scrollX += dx;
+        m_scrollY += dy;
+        ClampScroll();
+        Invalidate();
+    }
+
+} // namespace KroubleUI
@@ -0,0 +1,174 @@
+#include "DataGridModel.h"
+#include "TaskPool.h"
+#include <algorithm>
+
+namespace KroubleUI {
+
+    namespace {
+        const size_t kFilterBlockRows = 65536;  // 筛选时每个并行任务处理的行数
+        const size_t kMinSortChunk = 16384;     // 并行排序时每段的最少行数
+        const size_t kMaxSortChunk = 65536;     // 每段的最多行数，取消请求最多等一段排完
+        const size_t kMergeChunk = 65536;       // 合并时每个任务输出的行数
+
+        // 合并两段有序的行号时输出中的一段 [first, last)，各段互不重叠，可以并行且分别取消
+        struct MergeTask {
+            const uint32_t* a;
+            size_t aSize;
+            const uint32_t* b;
+            size_t bSize;
+            uint32_t* out;
+            size_t first;
+            size_t last;
+        };
+
+        // 合并结果的前 count 个元素中来自 a 的个数；两边相等时 a 在前，与 std::merge 相同
+        template<class Less>
+        size_t SplitMerge(const uint32_t* a, size_t aSize, const uint32_t* b, size_t bSize, size_t count, Less& less) {
+            size_t low = count > bSize ? count - bSize : 0;
+            size_t high = (std::min)(count, aSize);
+            while (low < high) {
+                size_t middle = low + (high - low) / 2;
+                if (!less(b[count - middle - 1], a[middle])) {
+                    low = middle + 1;
+                }
+                else {
+                    high = middle;
+                }
+            }
+            return low;
+        }
+
+        // 把合并 a 和 b 的输出按 kMergeChunk 分段；b 为空时只是复制
+        void AddMergeTasks(std::vector<MergeTask>& tasks, const uint32_t* a, size_t aSize, const uint32_t* b, size_t bSize,
+            uint32_t* out) {
+            size_t total = aSize + bSize;
+            for (size_t first = 0; first < total; first += kMergeChunk) {
+                MergeTask task = { a, aSize, b, bSize, out, first, (std::min)(first + kMergeChunk, total) };
+                tasks.push_back(task);
+            }
+        }
+
+        template<class Less, class Stop>
+        void RunMergeTasks(TaskPool& pool, const std::vector<MergeTask>& tasks, Less& less, Stop& stop) {
+            pool.ParallelFor(tasks.size(), [&](size_t index) {
+                if (stop()) return;
+                const MergeTask& task = tasks[index];
+                size_t aFirst = SplitMerge(task.a, task.aSize, task.b, task.bSize, task.first, less);
+                size_t aLast = SplitMerge(task.a, task.aSize, task.b, task.bSize, task.last, less);
+                std::merge(task.a + aFirst, task.a + aLast, task.b + (task.first - aFirst), task.b + (task.last - aLast),
+                    task.out + task.first, less);
+            });
+        }
+    }
+
+    std::shared_ptr<DataGridRowView> BuildRowView(const DataGridSource& source, TaskPool& pool,
+        const RowViewRequest& request, const std::function<bool()>& cancelled) {
+        std::shared_ptr<DataGridRowView> view = std::make_shared<DataGridRowView>();
+        view->sourceRows = request.rowCount;
+        if (request.IsIdentity()) {
+            // 保持原有顺序：追加的行直接计入行数，不需要复制或生成行号
+            return view;
+        }
+        view->identity = false;
+
+        // 原有顺序的视图没有经过这次的排序和筛选，不能在它的基础上合并，全部重新生成
+        const DataGridRowView* base = request.base.get();
+        if (base && base->identity) {
+            base = nullptr;
+        }
+
+        auto stop = [&cancelled]() { return cancelled && cancelled(); };
+        size_t begin = base ? base->sourceRows : 0;
+        size_t end = request.rowCount;
+
+        // 分块并行筛选，各块的结果按块的顺序拼接，保持行号递增
+        size_t blocks = (end - begin + kFilterBlockRows - 1) / kFilterBlockRows;
+        std::vector<std::vector<uint32_t>> parts(blocks);
+        pool.ParallelFor(blocks, [&](size_t block) {
+            if (stop()) return;
+            size_t first = begin + block * kFilterBlockRows;
+            size_t last = (std::min)(end, first + kFilterBlockRows);
+            std::vector<uint32_t>& part = parts[block];
+            part.reserve(last - first);
+            for (size_t row = first; row < last; ++row) {
+                if (!request.filter || request.filter(source, row)) {
+                    part.push_back(static_cast<uint32_t>(row));
+                }
+            }
+        });
+        if (stop()) return nullptr;
+
+        size_t total = 0;
+        for (auto& part : parts) total += part.size();
+        std::vector<uint32_t> rows;
+        rows.reserve(total);
+        for (auto& part : parts) {
+            rows.insert(rows.end(), part.begin(), part.end());
+            std::vector<uint32_t>().swap(part);
+        }
+
+        // 值相同的行按原有顺序排列，结果与数据到达的先后无关
+        int column = request.sortColumn;
+        bool ascending = request.sortAscending;
+        auto less = [&source, column, ascending](uint32_t a, uint32_t b) {
+            int result = source.CompareCells(column, a, b);
+            if (result != 0) return ascending ? result < 0 : result > 0;
+            return a < b;
+        };
+
+        if (column >= 0 && rows.size() > 1) {
+            // 分段并行排序，再逐层两两合并；每层的合并也按输出分段，取消请求在段与段之间生效
+            size_t segments = (std::min)(pool.GetThreadCount() + 1, (rows.size() + kMinSortChunk - 1) / kMinSortChunk);
+            segments = (std::max)(segments, (rows.size() + kMaxSortChunk - 1) / kMaxSortChunk);
+            segments = (std::max)(segments, size_t(1));
+            std::vector<size_t> bounds(segments + 1);
+            for (size_t i = 0; i <= segments; ++i) {
+                bounds[i] = rows.size() * i / segments;
+            }
+
+            pool.ParallelFor(segments, [&](size_t i) {
+                if (stop()) return;
+                std::sort(rows.begin() + bounds[i], rows.begin() + bounds[i + 1], less);
+            });
+
+            std::vector<uint32_t> scratch;
+            if (segments > 1) scratch.resize(rows.size());
+            std::vector<MergeTask> tasks;
+            for (size_t width = 1; width < segments && !stop(); width *= 2) {
+                tasks.clear();
+                for (size_t left = 0; left < segments; left += 2 * width) {
+                    size_t middle = (std::min)(left + width, segments);
+                    size_t right = (std::min)(middle + width, segments);
+                    AddMergeTasks(tasks, rows.data() + bounds[left], bounds[middle] - bounds[left],
+                        rows.data() + bounds[middle], bounds[right] - bounds[middle], scratch.data() + bounds[left]);
+                }
+                RunMergeTasks(pool, tasks, less, stop);
+                rows.swap(scratch);
+            }
+        }
+        if (stop()) return nullptr;
+
+        if (base && !base->rows.empty()) {
+            // 增量更新：旧行已经有序，只需与新行合并
+            const std::vector<uint32_t>& baseRows = base->rows;
+            if (column >= 0) {
+                view->rows.resize(baseRows.size() + rows.size());
+                std::vector<MergeTask> tasks;
+                AddMergeTasks(tasks, baseRows.data(), baseRows.size(), rows.data(), rows.size(), view->rows.data());
+                RunMergeTasks(pool, tasks, less, stop);
+            }
+            else {
+                // 不排序时新行的行号都比旧行大
+                view->rows.reserve(baseRows.size() + rows.size());
+                view->rows.insert(view->rows.end(), baseRows.begin(), baseRows.end());
+                view->rows.insert(view->rows.end(), rows.begin(), rows.end());
+            }
+        }
+        else {
+            view->rows.swap(rows);
+        }
+        if (stop()) return nullptr;
+        return view;
+    }
+
+} // namespace KroubleUI
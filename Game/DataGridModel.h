@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace KroubleUI {
+
+    class TaskPool;
+
+    // 数据网格的数据部分：数据源、列存储和显示顺序的生成；DataGrid 只负责绘制和在界面线程上换用新的显示顺序
+
+    // 表格数据源，按列提供数据
+    // 排序和筛选会在后台线程上读取数据：行只能追加不能修改，实现需要允许在追加新行的同时读取已有的行
+    class DataGridSource {
+    public:
+        virtual ~DataGridSource() = default;
+
+        virtual size_t GetRowCount() const = 0;
+        virtual size_t GetColumnCount() const = 0;
+        virtual std::wstring GetColumnName(size_t column) const = 0;
+        virtual void FormatCell(size_t row, size_t column, std::wstring& text) const = 0;
+        // 比较同一列中的两行，返回负数、0 或正数
+        virtual int CompareCells(size_t column, size_t a, size_t b) const = 0;
+    };
+
+    // 只追加的分块存储：追加时不移动已有元素，其他线程可以同时读取已提交的部分
+    template<class T> class ColumnStorage {
+    private:
+        static const size_t kChunkBits = 16;
+        static const size_t kChunkSize = size_t(1) << kChunkBits;
+        static const size_t kMaxChunks = 4096;     // 最多约 2.7 亿个元素
+
+        std::unique_ptr<std::unique_ptr<T[]>[]> m_chunks;   // 块目录大小固定，追加时不会重新分配
+        size_t m_size;
+
+    public:
+        ColumnStorage() : m_size(0) {}
+
+        size_t GetSize() const { return m_size; }
+        const T& operator[](size_t index) const {
+            return m_chunks[index >> kChunkBits][index & (kChunkSize - 1)];
+        }
+
+        void PushBack(const T& value) {
+            size_t chunk = m_size >> kChunkBits;
+            if (chunk >= kMaxChunks) {
+                throw std::length_error("Column storage is full");
+            }
+            if (!m_chunks) {
+                m_chunks.reset(new std::unique_ptr<T[]>[kMaxChunks]);
+            }
+            if (!m_chunks[chunk]) {
+                m_chunks[chunk].reset(new T[kChunkSize]);
+            }
+            m_chunks[chunk][m_size & (kChunkSize - 1)] = value;
+            ++m_size;
+        }
+    };
+
+    // 按列存储的数据表，支持数值列和文本列
+    // 列要在追加数据之前全部添加；追加在同一个线程上进行，CommitRows 之后新行才对读取方可见
+    class ColumnTable : public DataGridSource {
+    private:
+        struct Column {
+            std::wstring name;
+            bool numeric;
+            int decimals;
+            ColumnStorage<double> numbers;
+            ColumnStorage<std::wstring> texts;
+        };
+
+        std::vector<std::unique_ptr<Column>> m_columns;
+        std::atomic<size_t> m_rowCount;
+
+    public:
+        ColumnTable();
+
+        size_t AddNumberColumn(const std::wstring& name, int decimals = 2);
+        size_t AddTextColumn(const std::wstring& name);
+
+        void AppendNumber(size_t column, double value);
+        void AppendText(size_t column, const std::wstring& value);
+        // 提交所有列都已追加完成的行
+        void CommitRows();
+
+        size_t GetRowCount() const override { return m_rowCount.load(std::memory_order_acquire); }
+        size_t GetColumnCount() const override { return m_columns.size(); }
+        std::wstring GetColumnName(size_t column) const override { return m_columns[column]->name; }
+        void FormatCell(size_t row, size_t column, std::wstring& text) const override;
+        int CompareCells(size_t column, size_t a, size_t b) const override;
+    };
+
+    // 数据网格的显示顺序：第 i 个显示行对应的数据行
+    struct DataGridRowView {
+        std::vector<uint32_t> rows; // 排序或筛选后的数据行，identity 为 true 时为空
+        size_t sourceRows = 0;      // 生成该视图时数据源的行数
+        bool identity = true;       // 按数据源原有顺序显示全部行
+
+        size_t GetCount() const { return identity ? sourceRows : rows.size(); }
+        size_t GetRow(size_t index) const { return identity ? index : rows[index]; }
+    };
+
+    // 在后台线程上调用，需要线程安全
+    typedef std::function<bool(const DataGridSource& source, size_t row)> DataGridRowFilter;
+
+    // 生成一个显示顺序所需的参数
+    struct RowViewRequest {
+        std::shared_ptr<const DataGridRowView> base;    // 增量更新时在此基础上合并新行，全量生成时为空
+        size_t rowCount = 0;
+        int sortColumn = -1;                            // -1 表示不排序
+        bool sortAscending = true;
+        DataGridRowFilter filter;
+
+        // 不排序也不筛选：结果只是行数，不需要后台任务
+        bool IsIdentity() const { return sortColumn < 0 && !filter; }
+    };
+
+    // 生成显示顺序，排序和筛选在 pool 上并行执行
+    // 不排序也不筛选时只记录行数，耗时与行数无关；增量更新时只筛选、排序新追加的行
+    // cancelled 返回 true 时尽早结束并返回空
+    std::shared_ptr<DataGridRowView> BuildRowView(const DataGridSource& source, TaskPool& pool,
+        const RowViewRequest& request, const std::function<bool()>& cancelled);
+
+} // namespace KroubleUI
@@ -0,0 +1,594 @@
+#include "DrawCommands.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace KroubleUI {
+
+    namespace {
+        const float kCoordinateScale = 4.0f;        // 坐标量化为 1/4 像素
+        const uint64_t kMaxStringBytes = 64 << 20;  // 单个字符串定义的上限，超出视为数据错误
+
+        void WriteByte(std::string& out, uint8_t value) {
+            out.push_back(static_cast<char>(value));
+        }
+
+        void WriteOp(std::string& out, DrawOp op) {
+            WriteByte(out, static_cast<uint8_t>(op));
+        }
+
+        void WriteFloat(std::string& out, float value) {
+            char bytes[sizeof(float)];
+            memcpy(bytes, &value, sizeof(float));
+            out.append(bytes, sizeof(float));
+        }
+
+        int32_t Quantize(float value) {
+            // 无限大的裁剪区域等极端值截断到可表示的范围
+            float scaled = (std::max)(-1e9f, (std::min)(value * kCoordinateScale, 1e9f));
+            return static_cast<int32_t>(std::lround(scaled));
+        }
+
+        // wchar_t 在 Windows 上是 UTF-16，在其他平台上是 UTF-32
+        void AppendUtf8(std::string& out, const wchar_t* text, size_t length) {
+            for (size_t i = 0; i < length; ++i) {
+                uint32_t code = static_cast<uint32_t>(text[i]);
+                if (sizeof(wchar_t) == 2 && code >= 0xD800 && code < 0xDC00 && i + 1 < length) {
+                    uint32_t low = static_cast<uint32_t>(text[i + 1]);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        ++i;
+                    }
+                }
+                if ((code >= 0xD800 && code < 0xE000) || code > 0x10FFFF) {
+                    code = 0xFFFD;
+                }
+
+                if (code < 0x80) {
+                    out.push_back(static_cast<char>(code));
+                }
+                else if (code < 0x800) {
+                    out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else if (code < 0x10000) {
+                    out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else {
+                    out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+            }
+        }
+
+        // 无效的字节序列替换为 U+FFFD
+        std::wstring FromUtf8(const char* data, size_t length) {
+            std::wstring text;
+            text.reserve(length);
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+            size_t i = 0;
+            while (i < length) {
+                unsigned char lead = bytes[i++];
+                uint32_t code = 0xFFFD;     // 孤立的后续字节和无效的首字节
+                size_t count = 0;
+                uint32_t minimum = 0;
+                if (lead < 0x80) {
+                    code = lead;
+                }
+                else if (lead >= 0xC2 && lead < 0xE0) {
+                    code = lead & 0x1F;
+                    count = 1;
+                    minimum = 0x80;
+                }
+                else if (lead >= 0xE0 && lead < 0xF0) {
+                    code = lead & 0x0F;
+                    count = 2;
+                    minimum = 0x800;
+                }
+                else if (lead >= 0xF0 && lead < 0xF5) {
+                    code = lead & 0x07;
+                    count = 3;
+                    minimum = 0x10000;
+                }
+
+                size_t read = 0;
+                while (read < count && i < length && (bytes[i] & 0xC0) == 0x80) {
+                    code = (code << 6) | (bytes[i] & 0x3F);
+                    ++i;
+                    ++read;
+                }
+                // 截断、过长的编码和代理区的码位
+                if (read < count || (count > 0 && (code < minimum || code > 0x10FFFF || (code >= 0xD800 && code < 0xE000)))) {
+                    code = 0xFFFD;
+                }
+
+                if (sizeof(wchar_t) == 2 && code >= 0x10000) {
+                    text.push_back(static_cast<wchar_t>(0xD800 + ((code - 0x10000) >> 10)));
+                    text.push_back(static_cast<wchar_t>(0xDC00 + ((code - 0x10000) & 0x3FF)));
+                }
+                else {
+                    text.push_back(static_cast<wchar_t>(code));
+                }
+            }
+            return text;
+        }
+    }
+
+    void WriteVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    void WriteSigned(std::string& out, int64_t value) {
+        WriteVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    // ---- 编码 ----
+
+    DrawCommandWriter::DrawCommandWriter(const DrawFormatPolicy& policy)
+        : m_policy(policy),
+        m_needsReset(false),
+        m_transform(Transform2D::Identity()) {
+        memset(m_last, 0, sizeof(m_last));
+    }
+
+    DrawCommandWriter::~DrawCommandWriter() {
+        ClearTables();
+    }
+
+    void DrawCommandWriter::Reset() {
+        ClearTables();
+        m_needsReset = true;
+    }
+
+    void DrawCommandWriter::ClearTables() {
+        m_strings.clear();
+        m_colors.clear();
+        if (m_policy.release) {
+            for (auto& entry : m_formats) {
+                m_policy.release(entry.first);
+            }
+        }
+        m_formats.clear();
+    }
+
+    void DrawCommandWriter::BeginFrame(uint32_t width, uint32_t height, const ViewRect& damage) {
+        m_frame.clear();
+        m_stats.lastEncodeSeconds = 0.0;
+
+        if (m_needsReset) {
+            WriteOp(m_frame, DrawOp::ResetTables);
+            m_needsReset = false;
+        }
+
+        WriteOp(m_frame, DrawOp::BeginFrame);
+        WriteVarint(m_frame, width);
+        WriteVarint(m_frame, height);
+
+        memset(m_last, 0, sizeof(m_last));
+        m_transform = Transform2D::Identity();
+        WriteCoordinates(damage.left, damage.top, damage.right, damage.bottom);
+    }
+
+    void DrawCommandWriter::BeginCommand() {
+        // 一条命令最多新增三个字符串（文字、字体名、区域名）、一个颜色和一个文本格式
+        if (m_strings.size() + 3 > kMaxStrings || m_colors.size() + 1 > kMaxColors || m_formats.size() + 1 > kMaxFormats) {
+            ClearTables();
+            WriteOp(m_frame, DrawOp::ResetTables);
+        }
+    }
+
+    uint32_t DrawCommandWriter::InternString(const wchar_t* text, size_t length) {
+        std::wstring key(text, length);
+        auto it = m_strings.find(key);
+        if (it != m_strings.end()) return it->second;
+
+        uint32_t id = static_cast<uint32_t>(m_strings.size());
+        std::string utf8;
+        AppendUtf8(utf8, text, length);
+        WriteOp(m_frame, DrawOp::DefineString);
+        WriteVarint(m_frame, utf8.size());
+        m_frame += utf8;
+        m_strings.emplace(std::move(key), id);
+        return id;
+    }
+
+    uint32_t DrawCommandWriter::InternColor(uint32_t color) {
+        auto it = m_colors.find(color);
+        if (it != m_colors.end()) return it->second;
+
+        uint32_t id = static_cast<uint32_t>(m_colors.size());
+        WriteOp(m_frame, DrawOp::DefineColor);
+        WriteVarint(m_frame, color);
+        m_colors.emplace(color, id);
+        return id;
+    }
+
+    uint32_t DrawCommandWriter::InternFormat(const void* format) {
+        auto it = m_formats.find(format);
+        if (it != m_formats.end()) return it->second;
+
+        DrawTextFormat desc;
+        if (m_policy.describe) {
+            m_policy.describe(format, &desc);
+        }
+        uint32_t familyId = InternString(desc.family.c_str(), desc.family.size());
+        uint32_t localeId = InternString(desc.locale.c_str(), desc.locale.size());
+
+        uint32_t id = static_cast<uint32_t>(m_formats.size());
+        WriteOp(m_frame, DrawOp::DefineFormat);
+        WriteVarint(m_frame, familyId);
+        WriteFloat(m_frame, desc.size);
+        WriteVarint(m_frame, desc.weight);
+        WriteVarint(m_frame, desc.style);
+        WriteVarint(m_frame, desc.textAlignment);
+        WriteVarint(m_frame, desc.paragraphAlignment);
+        WriteVarint(m_frame, desc.wordWrapping);
+        WriteVarint(m_frame, localeId);
+
+        if (m_policy.retain) {
+            m_policy.retain(format);
+        }
+        m_formats.emplace(format, id);
+        return id;
+    }
+
+    void DrawCommandWriter::WriteCoordinates(float a, float b, float c, float d) {
+        int32_t values[4] = { Quantize(a), Quantize(b), Quantize(c), Quantize(d) };
+        for (int i = 0; i < 4; ++i) {
+            WriteSigned(m_frame, static_cast<int64_t>(values[i]) - m_last[i]);
+            m_last[i] = values[i];
+        }
+    }
+
+    void DrawCommandWriter::SetTransform(const Transform2D& transform) {
+        if (memcmp(&transform, &m_transform, sizeof(transform)) == 0) return;
+
+        WriteOp(m_frame, DrawOp::SetTransform);
+        WriteFloat(m_frame, transform.m11);
+        WriteFloat(m_frame, transform.m12);
+        WriteFloat(m_frame, transform.m21);
+        WriteFloat(m_frame, transform.m22);
+        WriteFloat(m_frame, transform.dx);
+        WriteFloat(m_frame, transform.dy);
+        m_transform = transform;
+    }
+
+    void DrawCommandWriter::FillRectangle(uint32_t color, const ViewRect& rect) {
+        BeginCommand();
+        uint32_t colorId = InternColor(color);
+        WriteOp(m_frame, DrawOp::FillRectangle);
+        WriteVarint(m_frame, colorId);
+        WriteCoordinates(rect.left, rect.top, rect.right, rect.bottom);
+    }
+
+    void DrawCommandWriter::DrawRectangle(uint32_t color, float strokeWidth, const ViewRect& rect) {
+        BeginCommand();
+        uint32_t colorId = InternColor(color);
+        WriteOp(m_frame, DrawOp::DrawRectangle);
+        WriteVarint(m_frame, colorId);
+        WriteVarint(m_frame, (std::max)(0, Quantize(strokeWidth)));
+        WriteCoordinates(rect.left, rect.top, rect.right, rect.bottom);
+    }
+
+    void DrawCommandWriter::DrawLine(uint32_t color, float strokeWidth, float x1, float y1, float x2, float y2) {
+        BeginCommand();
+        uint32_t colorId = InternColor(color);
+        WriteOp(m_frame, DrawOp::DrawLine);
+        WriteVarint(m_frame, colorId);
+        WriteVarint(m_frame, (std::max)(0, Quantize(strokeWidth)));
+        WriteCoordinates(x1, y1, x2, y2);
+    }
+
+    void DrawCommandWriter::DrawString(const wchar_t* text, size_t length, const void* format, uint32_t color,
+        uint32_t options, const ViewRect& rect) {
+        BeginCommand();
+        uint32_t stringId = InternString(text, length);
+        uint32_t formatId = InternFormat(format);
+        uint32_t colorId = InternColor(color);
+        WriteOp(m_frame, DrawOp::Text);
+        WriteVarint(m_frame, stringId);
+        WriteVarint(m_frame, formatId);
+        WriteVarint(m_frame, colorId);
+        WriteVarint(m_frame, options);
+        WriteCoordinates(rect.left, rect.top, rect.right, rect.bottom);
+    }
+
+    void DrawCommandWriter::PushClip(const ViewRect& rect) {
+        WriteOp(m_frame, DrawOp::PushClip);
+        WriteCoordinates(rect.left, rect.top, rect.right, rect.bottom);
+    }
+
+    void DrawCommandWriter::PopClip() {
+        WriteOp(m_frame, DrawOp::PopClip);
+    }
+
+    void DrawCommandWriter::PushLayer(float opacity) {
+        WriteOp(m_frame, DrawOp::PushLayer);
+        WriteByte(m_frame, static_cast<uint8_t>(std::lround((std::max)(0.0f, (std::min)(opacity, 1.0f)) * 255.0f)));
+    }
+
+    void DrawCommandWriter::PopLayer() {
+        WriteOp(m_frame, DrawOp::PopLayer);
+    }
+
+    std::string& DrawCommandWriter::EndFrame() {
+        WriteOp(m_frame, DrawOp::EndFrame);
+        ++m_stats.frames;
+        m_stats.totalBytes += m_frame.size();
+        m_stats.lastBytes = m_frame.size();
+        return m_frame;
+    }
+
+    void DrawCommandWriter::AddEncodeSeconds(double seconds) {
+        m_stats.totalEncodeSeconds += seconds;
+        m_stats.lastEncodeSeconds += seconds;
+    }
+
+    // ---- 解码 ----
+
+    DrawCommandReader::DrawCommandReader() : m_formatCount(0) {
+        memset(m_last, 0, sizeof(m_last));
+    }
+
+    void DrawCommandReader::Reset() {
+        m_strings.clear();
+        m_colors.clear();
+        m_formatCount = 0;
+    }
+
+    size_t DrawCommandReader::GetCpuBytes() const {
+        size_t bytes = sizeof(DrawCommandReader);
+        for (const std::wstring& text : m_strings) {
+            bytes += sizeof(std::wstring) + text.capacity() * sizeof(wchar_t);
+        }
+        return bytes + m_colors.capacity() * sizeof(uint32_t);
+    }
+
+    bool DrawCommandReader::ReadFrameSize(const std::string& frame, uint32_t* width, uint32_t* height) {
+        StreamReader in(frame.data(), frame.size());
+        uint8_t op = in.ReadByte();
+        if (op == static_cast<uint8_t>(DrawOp::ResetTables)) {
+            op = in.ReadByte();
+        }
+        if (op != static_cast<uint8_t>(DrawOp::BeginFrame)) return false;
+
+        *width = static_cast<uint32_t>(in.ReadVarint());
+        *height = static_cast<uint32_t>(in.ReadVarint());
+        return in.IsOk();
+    }
+
+    bool DrawCommandReader::Read(const std::string& frame, DrawCommandSink* sink) {
+        StreamReader in(frame.data(), frame.size());
+        // 压入的裁剪（false）和图层（true），结束或出错时按相反顺序弹出；帧的失效区域裁剪在最底层
+        std::vector<bool> stack;
+        bool begun = false;
+        bool ended = false;
+
+        auto readRect = [this, &in]() {
+            float values[4];
+            for (int i = 0; i < 4; ++i) {
+                m_last[i] += static_cast<int32_t>(in.ReadSigned());
+                values[i] = m_last[i] / kCoordinateScale;
+            }
+            ViewRect rect = { values[0], values[1], values[2], values[3] };
+            return rect;
+        };
+        auto readColor = [this, &in]() -> uint32_t {
+            uint64_t id = in.ReadVarint();
+            if (id >= m_colors.size()) {
+                in.Fail();
+                return 0;
+            }
+            return m_colors[static_cast<size_t>(id)];
+        };
+        auto readString = [this, &in]() -> const std::wstring* {
+            uint64_t id = in.ReadVarint();
+            if (id >= m_strings.size()) {
+                in.Fail();
+                return nullptr;
+            }
+            return &m_strings[static_cast<size_t>(id)];
+        };
+
+        while (in.IsOk() && !ended && !in.AtEnd()) {
+            DrawOp op = static_cast<DrawOp>(in.ReadByte());
+            // 编号表的操作可以出现在帧开始之前，绘制命令必须在帧内
+            if (!begun && op != DrawOp::BeginFrame && op != DrawOp::ResetTables) {
+                in.Fail();
+                break;
+            }
+
+            switch (op) {
+            case DrawOp::BeginFrame: {
+                if (begun) {
+                    in.Fail();
+                    break;
+                }
+                // 尺寸由调用方事先用 ReadFrameSize 读取
+                in.ReadVarint();
+                in.ReadVarint();
+                memset(m_last, 0, sizeof(m_last));
+                ViewRect damage = readRect();
+                if (!in.IsOk()) break;
+                if (sink) sink->OnBeginFrame(damage);
+                stack.push_back(false);
+                begun = true;
+                break;
+            }
+
+            case DrawOp::EndFrame:
+                ended = true;
+                break;
+
+            case DrawOp::ResetTables:
+                Reset();
+                if (sink) sink->OnResetTables();
+                break;
+
+            case DrawOp::DefineString: {
+                uint64_t length = in.ReadVarint();
+                const char* bytes = length <= kMaxStringBytes ? in.ReadBytes(static_cast<size_t>(length)) : nullptr;
+                if (!bytes) {
+                    in.Fail();
+                    break;
+                }
+                m_strings.push_back(FromUtf8(bytes, static_cast<size_t>(length)));
+                break;
+            }
+
+            case DrawOp::DefineColor: {
+                uint64_t color = in.ReadVarint();
+                if (color > 0xFFFFFFFFu) in.Fail();
+                if (in.IsOk()) m_colors.push_back(static_cast<uint32_t>(color));
+                break;
+            }
+
+            case DrawOp::DefineFormat: {
+                DrawTextFormat desc;
+                const std::wstring* family = readString();
+                desc.size = in.ReadFloat();
+                desc.weight = static_cast<uint32_t>(in.ReadVarint());
+                desc.style = static_cast<uint32_t>(in.ReadVarint());
+                desc.textAlignment = static_cast<uint32_t>(in.ReadVarint());
+                desc.paragraphAlignment = static_cast<uint32_t>(in.ReadVarint());
+                desc.wordWrapping = static_cast<uint32_t>(in.ReadVarint());
+                const std::wstring* locale = readString();
+                if (!in.IsOk()) break;
+                desc.family = *family;
+                desc.locale = *locale;
+                ++m_formatCount;
+                if (sink) sink->OnDefineFormat(desc);
+                break;
+            }
+
+            case DrawOp::SetTransform: {
+                Transform2D transform;
+                transform.m11 = in.ReadFloat();
+                transform.m12 = in.ReadFloat();
+                transform.m21 = in.ReadFloat();
+                transform.m22 = in.ReadFloat();
+                transform.dx = in.ReadFloat();
+                transform.dy = in.ReadFloat();
+                if (sink && in.IsOk()) sink->OnSetTransform(transform);
+                break;
+            }
+
+            case DrawOp::FillRectangle: {
+                uint32_t color = readColor();
+                ViewRect rect = readRect();
+                if (sink && in.IsOk()) sink->OnFillRectangle(color, rect);
+                break;
+            }
+
+            case DrawOp::DrawRectangle: {
+                uint32_t color = readColor();
+                float strokeWidth = in.ReadVarint() / kCoordinateScale;
+                ViewRect rect = readRect();
+                if (sink && in.IsOk()) sink->OnDrawRectangle(color, strokeWidth, rect);
+                break;
+            }
+
+            case DrawOp::DrawLine: {
+                uint32_t color = readColor();
+                float strokeWidth = in.ReadVarint() / kCoordinateScale;
+                ViewRect points = readRect();
+                if (sink && in.IsOk()) sink->OnDrawLine(color, strokeWidth, points.left, points.top, points.right, points.bottom);
+                break;
+            }
+
+            case DrawOp::Text: {
+                const std::wstring* text = readString();
+                uint64_t format = in.ReadVarint();
+                uint32_t color = readColor();
+                uint32_t options = static_cast<uint32_t>(in.ReadVarint());
+                ViewRect rect = readRect();
+                if (format >= m_formatCount) in.Fail();
+                if (sink && in.IsOk()) sink->OnDrawText(*text, static_cast<size_t>(format), color, options, rect);
+                break;
+            }
+
+            case DrawOp::PushClip: {
+                ViewRect rect = readRect();
+                if (!in.IsOk()) break;
+                if (sink) sink->OnPushClip(rect);
+                stack.push_back(false);
+                break;
+            }
+
+            case DrawOp::PushLayer: {
+                float opacity = in.ReadByte() / 255.0f;
+                if (!in.IsOk()) break;
+                if (sink && !sink->OnPushLayer(opacity)) {
+                    in.Fail();
+                    break;
+                }
+                stack.push_back(true);
+                break;
+            }
+
+            case DrawOp::PopClip:
+            case DrawOp::PopLayer: {
+                // 不能弹出帧本身的失效区域裁剪，且类型必须与压入时一致
+                bool isLayer = op == DrawOp::PopLayer;
+                if (stack.size() <= 1 || stack.back() != isLayer) {
+                    in.Fail();
+                    break;
+                }
+                if (sink) {
+                    if (isLayer) sink->OnPopLayer();
+                    else sink->OnPopClip();
+                }
+                stack.pop_back();
+                break;
+            }
+
+            default:
+                in.Fail();
+                break;
+            }
+        }
+
+        while (!stack.empty()) {
+            if (sink) {
+                if (stack.back()) sink->OnPopLayer();
+                else sink->OnPopClip();
+            }
+            stack.pop_back();
+        }
+        return in.IsOk() && ended;
+    }
+
+    // ---- 发送队列 ----
+
+    bool FrameSendQueue::Push(std::string message) {
+        if (!m_messages.empty() && m_bytes + message.size() > m_limit) {
+            Clear();
+            return false;
+        }
+        m_bytes += message.size();
+        m_messages.push_back(std::move(message));
+        return true;
+    }
+
+    bool FrameSendQueue::Pop(std::string* message) {
+        if (m_messages.empty()) return false;
+        message->swap(m_messages.front());
+        m_messages.pop_front();
+        m_bytes -= message->size();
+        return true;
+    }
+
+    void FrameSendQueue::Clear() {
+        m_messages.clear();
+        m_bytes = 0;
+    }
+
+} // namespace KroubleUI
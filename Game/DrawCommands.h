@@ -0,0 +1,248 @@
+#pragma once
+
+#include "Geometry.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace KroubleUI {
+
+    // 远程界面命令流的格式：操作码、写入命令的编码器和逐条读取的解码器
+    // DrawCommandEncoder 和 DrawCommandPlayer 只负责与 Direct2D 之间的转换
+
+    // 命令流中的操作码
+    enum class DrawOp : uint8_t {
+        BeginFrame = 1,     // 渲染目标尺寸和本帧的失效区域
+        EndFrame,
+        ResetTables,        // 清空双方的字符串、颜色和文本格式表
+        DefineString,
+        DefineColor,
+        DefineFormat,
+        SetTransform,
+        FillRectangle,
+        DrawRectangle,
+        DrawLine,
+        Text,
+        PushClip,
+        PopClip,
+        PushLayer,
+        PopLayer,
+    };
+
+    // 命令流编码的统计
+    struct RemoteFrameStats {
+        uint64_t frames = 0;
+        uint64_t totalBytes = 0;
+        double totalEncodeSeconds = 0.0;    // 只包括编码调用本身，不包括两次调用之间的实际绘制
+        size_t lastBytes = 0;
+        double lastEncodeSeconds = 0.0;
+
+        double GetAverageBytes() const { return frames ? static_cast<double>(totalBytes) / frames : 0.0; }
+        double GetAverageEncodeSeconds() const { return frames ? totalEncodeSeconds / frames : 0.0; }
+    };
+
+    // 文本格式的描述，第一次使用时随定义发送；枚举值与 DirectWrite 相同
+    struct DrawTextFormat {
+        std::wstring family;
+        float size = 14.0f;
+        uint32_t weight = 400;
+        uint32_t style = 0;
+        uint32_t textAlignment = 0;
+        uint32_t paragraphAlignment = 0;
+        uint32_t wordWrapping = 0;
+        std::wstring locale;
+    };
+
+    // 编码端对文本格式句柄的操作
+    // 编号表持有句柄期间增加引用，避免句柄释放后地址被新的格式复用；不需要时可以为空
+    struct DrawFormatPolicy {
+        void (*retain)(const void* format) = nullptr;
+        void (*release)(const void* format) = nullptr;
+        void (*describe)(const void* format, DrawTextFormat* desc) = nullptr;
+    };
+
+    // 变长整数：每字节 7 位，低位在前
+    void WriteVarint(std::string& out, uint64_t value);
+    // zigzag 编码，绝对值小的负数也只占一个字节
+    void WriteSigned(std::string& out, int64_t value);
+
+    // 按顺序读取命令流；越界或格式错误后 IsOk 返回 false，之后的读取都返回 0
+    class StreamReader {
+    private:
+        const char* m_data;
+        const char* m_end;
+        bool m_ok;
+
+    public:
+        StreamReader(const char* data, size_t size) : m_data(data), m_end(data + size), m_ok(true) {}
+
+        bool IsOk() const { return m_ok; }
+        bool AtEnd() const { return m_data >= m_end; }
+        void Fail() { m_ok = false; }
+
+        uint8_t ReadByte() {
+            if (!m_ok || m_data >= m_end) {
+                m_ok = false;
+                return 0;
+            }
+            return static_cast<uint8_t>(*m_data++);
+        }
+
+        uint64_t ReadVarint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64 && m_ok; shift += 7) {
+                uint8_t byte = ReadByte();
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) return m_ok ? value : 0;
+            }
+            m_ok = false;
+            return 0;
+        }
+
+        int64_t ReadSigned() {
+            uint64_t value = ReadVarint();
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        float ReadFloat() {
+            float value = 0.0f;
+            const char* bytes = ReadBytes(sizeof(float));
+            if (bytes) memcpy(&value, bytes, sizeof(float));
+            return value;
+        }
+
+        const char* ReadBytes(size_t size) {
+            if (!m_ok || static_cast<size_t>(m_end - m_data) < size) {
+                m_ok = false;
+                return nullptr;
+            }
+            const char* bytes = m_data;
+            m_data += size;
+            return bytes;
+        }
+    };
+
+    // 把绘制调用编码为紧凑的命令流
+    // 字符串、颜色和文本格式第一次出现时发送定义，之后只发编号；坐标按 1/4 像素量化，与上一条命令的坐标做差后变长编码
+    // 颜色为 RGBA8（r 在最低字节）；文本格式用不透明的句柄表示，由 DrawFormatPolicy 描述
+    class DrawCommandWriter {
+    public:
+        static const size_t kMaxStrings = 4096;     // 编号表的上限，超出后双方一起清空重来
+        static const size_t kMaxColors = 1024;
+        static const size_t kMaxFormats = 256;
+
+    private:
+        DrawFormatPolicy m_policy;
+        std::string m_frame;
+        std::unordered_map<std::wstring, uint32_t> m_strings;
+        std::unordered_map<uint32_t, uint32_t> m_colors;
+        std::unordered_map<const void*, uint32_t> m_formats;
+        bool m_needsReset;
+        Transform2D m_transform;
+        int32_t m_last[4];                  // 上一条命令的量化坐标
+        RemoteFrameStats m_stats;
+
+        void BeginCommand();
+        void ClearTables();
+        uint32_t InternString(const wchar_t* text, size_t length);
+        uint32_t InternColor(uint32_t color);
+        uint32_t InternFormat(const void* format);
+        void WriteCoordinates(float a, float b, float c, float d);
+
+    public:
+        explicit DrawCommandWriter(const DrawFormatPolicy& policy = DrawFormatPolicy());
+        ~DrawCommandWriter();
+        DrawCommandWriter(const DrawCommandWriter&) = delete;
+        DrawCommandWriter& operator=(const DrawCommandWriter&) = delete;
+
+        // 清空编号表，下一帧开头通知接收方一并清空；新的接收方连接或丢弃了已编码的帧时调用
+        void Reset();
+        size_t GetStringCount() const { return m_strings.size(); }
+
+        // 坐标差分和变换每帧从头开始，接收方丢掉的帧不会影响后续帧的坐标
+        void BeginFrame(uint32_t width, uint32_t height, const ViewRect& damage);
+        // 与当前变换相同时不写入
+        void SetTransform(const Transform2D& transform);
+        void FillRectangle(uint32_t color, const ViewRect& rect);
+        void DrawRectangle(uint32_t color, float strokeWidth, const ViewRect& rect);
+        void DrawLine(uint32_t color, float strokeWidth, float x1, float y1, float x2, float y2);
+        void DrawString(const wchar_t* text, size_t length, const void* format, uint32_t color, uint32_t options,
+            const ViewRect& rect);
+        void PushClip(const ViewRect& rect);
+        void PopClip();
+        void PushLayer(float opacity);
+        void PopLayer();
+        // 结束本帧并计入统计；返回的帧在下次 BeginFrame 之前有效，可以取走其内容
+        std::string& EndFrame();
+
+        // 调用方只在编码调用内计时，累加到本帧和总计的编码耗时
+        void AddEncodeSeconds(double seconds);
+        const RemoteFrameStats& GetStats() const { return m_stats; }
+    };
+
+    // 回放命令流的接收方；坐标已还原为浮点数，颜色为 RGBA8，文本格式为 OnDefineFormat 的顺序编号
+    class DrawCommandSink {
+    public:
+        virtual ~DrawCommandSink() = default;
+
+        virtual void OnResetTables() {}
+        virtual void OnDefineFormat(const DrawTextFormat& /*desc*/) {}
+        // 接收方应把绘制限制在失效区域内，帧结束时通过 OnPopClip 弹出
+        virtual void OnBeginFrame(const ViewRect& /*damage*/) {}
+        virtual void OnSetTransform(const Transform2D& /*transform*/) {}
+        virtual void OnFillRectangle(uint32_t /*color*/, const ViewRect& /*rect*/) {}
+        virtual void OnDrawRectangle(uint32_t /*color*/, float /*strokeWidth*/, const ViewRect& /*rect*/) {}
+        virtual void OnDrawLine(uint32_t /*color*/, float /*strokeWidth*/, float /*x1*/, float /*y1*/, float /*x2*/, float /*y2*/) {}
+        virtual void OnDrawText(const std::wstring& /*text*/, size_t /*format*/, uint32_t /*color*/, uint32_t /*options*/, const ViewRect& /*rect*/) {}
+        virtual void OnPushClip(const ViewRect& /*rect*/) {}
+        virtual void OnPopClip() {}
+        // 返回 false 表示无法创建图层，回放以出错结束
+        virtual bool OnPushLayer(float /*opacity*/) { return true; }
+        virtual void OnPopLayer() {}
+    };
+
+    // 解码 DrawCommandWriter 编码的帧，维护与编码端一致的编号表
+    class DrawCommandReader {
+    private:
+        std::vector<std::wstring> m_strings;
+        std::vector<uint32_t> m_colors;
+        size_t m_formatCount;
+        int32_t m_last[4];
+
+    public:
+        DrawCommandReader();
+
+        void Reset();
+        size_t GetStringCount() const { return m_strings.size(); }
+        size_t GetCpuBytes() const;
+        // 读取帧开头的渲染目标尺寸，不改变解码状态
+        static bool ReadFrameSize(const std::string& frame, uint32_t* width, uint32_t* height);
+        // 解码一帧交给 sink，sink 为空时只更新编号表
+        // 数据不完整或格式错误时返回 false，已压入的裁剪和图层都会按相反顺序弹出
+        bool Read(const std::string& frame, DrawCommandSink* sink);
+    };
+
+    // 编码端的发送队列：查看端跟不上时不无限积压
+    class FrameSendQueue {
+    private:
+        std::deque<std::string> m_messages;
+        size_t m_bytes;
+        size_t m_limit;
+
+    public:
+        explicit FrameSendQueue(size_t limit) : m_bytes(0), m_limit(limit) {}
+
+        // 积压超过上限时清空队列并丢弃这条消息，返回 false
+        // 之后的帧引用了丢弃的定义，调用方要重置编码器并重绘整个窗口
+        bool Push(std::string message);
+        bool Pop(std::string* message);
+        void Clear();
+        bool IsEmpty() const { return m_messages.empty(); }
+        size_t GetBytes() const { return m_bytes; }
+    };
+
+} // namespace KroubleUI
@@ -0,0 +1,43 @@
+#pragma once
+
+namespace KroubleUI {
+
+    // 不依赖 Direct2D 的矩形，布局与 D2D1_RECT_F 相同
+    struct ViewRect {
+        float left, top, right, bottom;
+    };
+
+    // 二维仿射变换，布局与 D2D1_MATRIX_3X2_F 相同：x' = x * m11 + y * m21 + dx
+    struct Transform2D {
+        float m11, m12;
+        float m21, m22;
+        float dx, dy;
+
+        static Transform2D Identity() {
+            Transform2D transform = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+            return transform;
+        }
+
+        // 只有平移、缩放和 90 度的倍数旋转时，矩形变换后仍是轴对齐的矩形
+        bool IsAxisAligned() const {
+            return (m12 == 0.0f && m21 == 0.0f) || (m11 == 0.0f && m22 == 0.0f);
+        }
+
+        // 变换后的外接矩形
+        ViewRect TransformBounds(const ViewRect& rect) const {
+            float xs[4] = { rect.left, rect.right, rect.left, rect.right };
+            float ys[4] = { rect.top, rect.top, rect.bottom, rect.bottom };
+            ViewRect bounds = { 0, 0, 0, 0 };
+            for (int i = 0; i < 4; ++i) {
+                float x = xs[i] * m11 + ys[i] * m21 + dx;
+                float y = xs[i] * m12 + ys[i] * m22 + dy;
+                if (i == 0 || x < bounds.left) bounds.left = x;
+                if (i == 0 || x > bounds.right) bounds.right = x;
+                if (i == 0 || y < bounds.top) bounds.top = y;
+                if (i == 0 || y > bounds.bottom) bounds.bottom = y;
+            }
+            return bounds;
+        }
+    };
+
+} // namespace KroubleUI
@@ -0,0 +1,133 @@
+#include "KroubleUI.h"
+
+namespace KroubleUI {
+
+    namespace {
+        const size_t kGlyphBytes = 32;      // 每个字符的字形、簇信息估算
+        const size_t kMaxTextFormats = 256; // 字号动画等会产生大量一次性的格式，超出后淘汰最久未用的
+
+        IDWriteTextFormat* ToTextFormat(const void* format) {
+            return static_cast<IDWriteTextFormat*>(const_cast<void*>(format));
+        }
+    }
+
+    std::shared_ptr<TextRun> DirectWriteShaper::Shape(const wchar_t* text, uint32_t length, const void* format,
+        float width, float height) {
+        IDWriteTextLayout* layout = nullptr;
+        if (FAILED(m_factory->CreateTextLayout(text, length, ToTextFormat(format), width, height, &layout))) {
+            return nullptr;
+        }
+
+        // 在这里完成排版和断行，之后绘制（可能在别的线程上）只读取结果
+        DWRITE_TEXT_METRICS metrics = DWRITE_TEXT_METRICS();
+        layout->GetMetrics(&metrics);
+
+        size_t bytes = sizeof(DirectWriteTextRun) + EstimateDeviceBytes(layout) + length * kGlyphBytes;
+        return std::make_shared<DirectWriteTextRun>(layout, bytes, metrics);
+    }
+
+    TextFormatRefPolicy DirectWriteShaper::GetFormatPolicy() {
+        TextFormatRefPolicy policy;
+        policy.addRef = [](const void* format) { ToTextFormat(format)->AddRef(); };
+        policy.release = [](const void* format) { ToTextFormat(format)->Release(); };
+        return policy;
+    }
+
+    GraphicsContext::GraphicsContext(std::shared_ptr<TextShaper> shaper)
+        : m_d2dFactory(nullptr), m_dwriteFactory(nullptr), m_textFormats(kMaxTextFormats) {
+        // 多个 UI 线程可能同时使用同一个工厂，因此创建多线程工厂
+        D2D1_FACTORY_OPTIONS options;
+        ZeroMemory(&options, sizeof(D2D1_FACTORY_OPTIONS));
+
+        HRESULT hr = D2D1CreateFactory(
+            D2D1_FACTORY_TYPE_MULTI_THREADED,
+            __uuidof(ID2D1Factory),
+            &options,
+            reinterpret_cast<void**>(&m_d2dFactory)
+        );
+
+        if (FAILED(hr)) {
+            throw std::runtime_error("Failed to create D2D factory");
+        }
+
+        // 共享的 DirectWrite 工厂本身是线程安全的
+        hr = DWriteCreateFactory(
+            DWRITE_FACTORY_TYPE_SHARED,
+            __uuidof(IDWriteFactory),
+            reinterpret_cast<IUnknown**>(&m_dwriteFactory)
+        );
+
+        if (FAILED(hr)) {
+            SafeRelease(&m_d2dFactory);
+            throw std::runtime_error("Failed to create DirectWrite factory");
+        }
+
+        if (!shaper) {
+            shaper = std::make_shared<DirectWriteShaper>(m_dwriteFactory);
+        }
+        m_textRunCache.reset(new TextRunCache(shaper, DirectWriteShaper::GetFormatPolicy()));
+    }
+
+    GraphicsContext::~GraphicsContext() {
+        // 缓存项持有文本格式的引用，缓存持有的排版器使用 DirectWrite 工厂
+        m_textRunCache.reset();
+        m_textFormats.Clear([](IDWriteTextFormat* format) { format->Release(); });
+        SafeRelease(&m_dwriteFactory);
+        SafeRelease(&m_d2dFactory);
+    }
+
+    std::shared_ptr<GraphicsContext> GraphicsContext::GetDefault() {
+        static std::shared_ptr<GraphicsContext> context = std::make_shared<GraphicsContext>();
+        return context;
+    }
+
+    IDWriteTextFormat* GraphicsContext::GetTextFormat(const TextFormatDesc& desc) {
+        auto create = [this](const TextFormatDesc& desc) -> IDWriteTextFormat* {
+            IDWriteTextFormat* format = nullptr;
+            HRESULT hr = m_dwriteFactory->CreateTextFormat(
+                desc.family.c_str(),
+                nullptr,
+                static_cast<DWRITE_FONT_WEIGHT>(desc.weight),
+                static_cast<DWRITE_FONT_STYLE>(desc.style),
+                DWRITE_FONT_STRETCH_NORMAL,
+                desc.size,
+                desc.locale.c_str(),
+                &format
+            );
+            if (FAILED(hr)) {
+                return nullptr;
+            }
+
+            format->SetTextAlignment(static_cast<DWRITE_TEXT_ALIGNMENT>(desc.textAlignment));
+            format->SetParagraphAlignment(static_cast<DWRITE_PARAGRAPH_ALIGNMENT>(desc.paragraphAlignment));
+            format->SetWordWrapping(static_cast<DWRITE_WORD_WRAPPING>(desc.wordWrapping));
+            return format;
+        };
+        return m_textFormats.Acquire(desc, create,
+            [](IDWriteTextFormat* format) { format->AddRef(); },
+            [](IDWriteTextFormat* format) { format->Release(); });
+    }
+
+    std::shared_ptr<const TextRun> GraphicsContext::ShapeText(const wchar_t* text, UINT32 length, IDWriteTextFormat* format,
+        float width, float height) {
+        return m_textRunCache->Shape(text, length, format, width, height);
+    }
+
+    size_t GraphicsContext::GetTextFormatCount() {
+        return m_textFormats.GetCount();
+    }
+
+    ResourceUsage GraphicsContext::GetResourceUsage() {
+        ResourceUsage usage;
+        m_textFormats.ForEach([&usage](IDWriteTextFormat* format) {
+            usage.AddResource(ResourceKind::TextFormat, EstimateDeviceBytes(format));
+        });
+
+        // 缓存的排版结果按项计为文本布局，字节数使用缓存自己的估算
+        TextRunCacheStats stats = m_textRunCache->GetStats();
+        usage.AddResources(ResourceKind::TextLayout, static_cast<uint32_t>(stats.entries), stats.bytes);
+        usage.SetCpuBytes(sizeof(GraphicsContext));
+        return usage;
+    }
+
+} // namespace KroubleUI
@@ -1,4 +1,7 @@
 #pragma once
+// winsock2.h 必须先于 windows.h 包含，否则会与旧的 winsock.h 冲突
+#include <winsock2.h>
+#include <ws2tcpip.h>
 #include <windows.h>
 #include <d2d1.h>
 #include <dwrite.h>
@@ -7,13 +10,39 @@
 #include <memory>
 #include <functional>
 #include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <list>
 #include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
 #include <windowsx.h>
 #include <imm.h>
+#include "LogBuffer.h"
+#include "ScrollModel.h"
+#include "SharedCache.h"
+#include "TextFormatDesc.h"
+#include "OverdrawCounter.h"
+#include "ResourceUsage.h"
+#include "Animation.h"
+#include "TaskPool.h"
+#include "ChunkedText.h"
+#include "DataGridModel.h"
+#include "DrawCommands.h"
+#include "Signal.h"
+#include "StyleSheet.h"
+#include "TextRunCache.h"
 #pragma comment(lib, "imm32.lib")
 #pragma comment(lib, "d2d1.lib")
 #pragma comment(lib, "dwrite.lib")
 #pragma comment(lib, "windowscodecs.lib")
+#pragma comment(lib, "dwmapi.lib")
+#pragma comment(lib, "ws2_32.lib")
 
 namespace KroubleUI {
 
@@ -24,44 +53,364 @@ namespace KroubleUI {
 		}
 	}
 
-	// ǰ
+	// 前向声明
 	class Window;
 	class TextBox;
 
-	// ؼ
+	// 样式颜色与 Direct2D 颜色之间的转换，两者布局相同
+	inline D2D1_COLOR_F ToColorF(const StyleColor& color) {
+		return D2D1::ColorF(color.r, color.g, color.b, color.a);
+	}
+	inline StyleColor ToStyleColor(const D2D1_COLOR_F& color) {
+		StyleColor result = { color.r, color.g, color.b, color.a };
+		return result;
+	}
+	// 把样式的字体属性写入文本格式描述，对齐和换行保持不变
+	inline void ApplyFont(const ResolvedStyle& style, TextFormatDesc* desc) {
+		desc->family = style.fontFamily;
+		desc->size = style.fontSize;
+		desc->weight = style.fontWeight;
+	}
+
+	// DirectWrite 排版完成的一段文本，绘制时只需提交字形，不再重新排版
+	class DirectWriteTextRun : public TextRun {
+	private:
+		IDWriteTextLayout* m_layout;
+		DWRITE_TEXT_METRICS m_metrics;
+
+	public:
+		// 接管 layout 的引用
+		DirectWriteTextRun(IDWriteTextLayout* layout, size_t bytes, const DWRITE_TEXT_METRICS& metrics)
+			: TextRun(bytes), m_layout(layout), m_metrics(metrics) {}
+		~DirectWriteTextRun() { SafeRelease(&m_layout); }
+
+		IDWriteTextLayout* GetLayout() const { return m_layout; }
+		// 排版时测得的尺寸
+		const DWRITE_TEXT_METRICS& GetMetrics() const { return m_metrics; }
+	};
+
+	// 取出排版结果中的文本布局；run 为空或不是 DirectWrite 的排版结果（如测试用的排版器）时返回空
+	inline IDWriteTextLayout* GetTextLayout(const TextRun* run) {
+		const DirectWriteTextRun* directWrite = dynamic_cast<const DirectWriteTextRun*>(run);
+		return directWrite ? directWrite->GetLayout() : nullptr;
+	}
+
+	// 格式句柄为 IDWriteTextFormat*
+	class DirectWriteShaper : public TextShaper {
+	private:
+		IDWriteFactory* m_factory;
+
+	public:
+		// 不持有 factory 的引用，factory 必须比排版器存在得久
+		explicit DirectWriteShaper(IDWriteFactory* factory) : m_factory(factory) {}
+		std::shared_ptr<TextRun> Shape(const wchar_t* text, uint32_t length, const void* format,
+			float width, float height) override;
+
+		// 缓存项通过它持有 IDWriteTextFormat 的引用
+		static TextFormatRefPolicy GetFormatPolicy();
+	};
+
+	// 进程级图形上下文
+	// 持有 D2D/DirectWrite 工厂和共享的文本格式缓存，多个窗口（可在不同的 UI 线程上）共用一份
+	class GraphicsContext {
+	private:
+		ID2D1Factory* m_d2dFactory;
+		IDWriteFactory* m_dwriteFactory;
+		SharedCache<TextFormatDesc, IDWriteTextFormat, TextFormatDescHash> m_textFormats;
+		std::unique_ptr<TextRunCache> m_textRunCache;
+
+	public:
+		// shaper 为空时使用 DirectWriteShaper；换成别的排版器（如测试用的）时，绘制得不到文本布局而按 DrawTextW 绘制
+		explicit GraphicsContext(std::shared_ptr<TextShaper> shaper = nullptr);
+		~GraphicsContext();
+
+		GraphicsContext(const GraphicsContext&) = delete;
+		GraphicsContext& operator=(const GraphicsContext&) = delete;
+
+		// 未显式指定上下文的窗口都使用这一份
+		static std::shared_ptr<GraphicsContext> GetDefault();
+
+		ID2D1Factory* GetD2DFactory() const { return m_d2dFactory; }
+		IDWriteFactory* GetDWriteFactory() const { return m_dwriteFactory; }
+
+		// 返回的格式已 AddRef，由调用者 Release
+		// 格式在控件之间共享，调用者不能再修改它的对齐、换行等属性
+		// 缓存的格式数有上限，被淘汰的格式仍由持有它的调用者保持有效
+		IDWriteTextFormat* GetTextFormat(const TextFormatDesc& desc);
+		size_t GetTextFormatCount();
+		// 共享的文本格式和排版缓存的占用，所有窗口共用，不计入任何窗口
+		ResourceUsage GetResourceUsage();
+
+		// 使用这份上下文的所有窗口共用的短文本排版缓存
+		TextRunCache* GetTextRunCache() const { return m_textRunCache.get(); }
+		// 排版一段文本，短文本经过排版缓存；可以在任意线程上调用
+		std::shared_ptr<const TextRun> ShapeText(const wchar_t* text, UINT32 length, IDWriteTextFormat* format,
+			float width, float height);
+	};
+
+	// 设备资源的种类和估算大小
+	inline ResourceKind GetResourceKind(ID2D1Brush*) { return ResourceKind::Brush; }
+	inline ResourceKind GetResourceKind(IDWriteTextFormat*) { return ResourceKind::TextFormat; }
+	inline ResourceKind GetResourceKind(IDWriteTextLayout*) { return ResourceKind::TextLayout; }
+	inline ResourceKind GetResourceKind(ID2D1Bitmap*) { return ResourceKind::Bitmap; }
+	inline ResourceKind GetResourceKind(ID2D1BitmapRenderTarget*) { return ResourceKind::Bitmap; }
+	size_t EstimateDeviceBytes(ID2D1Brush* brush);
+	size_t EstimateDeviceBytes(IDWriteTextFormat* format);
+	size_t EstimateDeviceBytes(IDWriteTextLayout* layout);
+	size_t EstimateDeviceBytes(ID2D1Bitmap* bitmap);
+	size_t EstimateDeviceBytes(ID2D1BitmapRenderTarget* target);
+	// 控件登记的字节数；文本格式由 GraphicsContext 共享，字节数只计在上下文上，控件只登记持有的引用个数
+	template<class T> size_t EstimateTrackedBytes(T* resource) { return EstimateDeviceBytes(resource); }
+	inline size_t EstimateTrackedBytes(IDWriteTextFormat*) { return 0; }
+
+	// 输出超出预算的调试警告
+	void ReportBudgetExceeded(const char* owner, const void* address, const ResourceUsage& usage, const ResourceBudget& budget);
+
+	// Direct2D 类型按分量插值，其余动画类型见 Animation.h
+	template<> struct AnimationTraits<D2D1_COLOR_F> {
+		enum { kComponents = 4 };
+		static void ToArray(const D2D1_COLOR_F& value, float* out) {
+			out[0] = value.r; out[1] = value.g; out[2] = value.b; out[3] = value.a;
+		}
+		static D2D1_COLOR_F FromArray(const float* in) { return D2D1::ColorF(in[0], in[1], in[2], in[3]); }
+		static float RestThreshold() { return 0.002f; }
+	};
+
+	template<> struct AnimationTraits<D2D1_RECT_F> {
+		enum { kComponents = 4 };
+		static void ToArray(const D2D1_RECT_F& value, float* out) {
+			out[0] = value.left; out[1] = value.top; out[2] = value.right; out[3] = value.bottom;
+		}
+		static D2D1_RECT_F FromArray(const float* in) { return D2D1::RectF(in[0], in[1], in[2], in[3]); }
+		static float RestThreshold() { return 0.05f; }
+	};
+
+	template<> struct AnimationTraits<D2D1_MATRIX_3X2_F> {
+		enum { kComponents = 6 };
+		static void ToArray(const D2D1_MATRIX_3X2_F& value, float* out) {
+			out[0] = value._11; out[1] = value._12; out[2] = value._21;
+			out[3] = value._22; out[4] = value._31; out[5] = value._32;
+		}
+		static D2D1_MATRIX_3X2_F FromArray(const float* in) {
+			D2D1_MATRIX_3X2_F value;
+			value._11 = in[0]; value._12 = in[1]; value._21 = in[2];
+			value._22 = in[3]; value._31 = in[4]; value._32 = in[5];
+			return value;
+		}
+		static float RestThreshold() { return 0.001f; }
+	};
+
+	class Control;
+
+	// 绘制观察者：接收窗口每一帧的绘制通知，用于诊断、录制等，不影响实际绘制
+	class DrawObserver {
+	public:
+		virtual ~DrawObserver() = default;
+
+		// damage 为本帧需要重绘的区域
+		virtual void OnBeginFrame(ID2D1RenderTarget* target, const D2D1_RECT_F& damage) {}
+		// control 为空表示窗口背景；填充可能发生在离屏目标上，由观察者根据 target 自行取舍
+		virtual void OnFillRect(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color) {}
+		// 以下绘制调用只有经由 Control 的绘制辅助函数才会通知
+		virtual void OnDrawRect(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, float strokeWidth) {}
+		virtual void OnDrawLine(ID2D1RenderTarget* target, const Control* control, D2D1_POINT_2F from, D2D1_POINT_2F to, const D2D1_COLOR_F& color, float strokeWidth) {}
+		virtual void OnDrawText(ID2D1RenderTarget* target, const Control* control, const wchar_t* text, UINT32 length,
+			IDWriteTextFormat* format, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, D2D1_DRAW_TEXT_OPTIONS options) {}
+		virtual void OnPushClip(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect) {}
+		virtual void OnPopClip(ID2D1RenderTarget* target, const Control* control) {}
+		// 半透明控件整体绘制到图层上
+		virtual void OnPushLayer(ID2D1RenderTarget* target, const Control* control, float opacity) {}
+		virtual void OnPopLayer(ID2D1RenderTarget* target, const Control* control) {}
+		// 在 EndDraw 之前调用，观察者可以在此绘制叠加层
+		virtual void OnEndFrame(ID2D1RenderTarget* target) {}
+	};
+
+	// 基础控件类
 	class Control {
 	protected:
 		Window* m_parent;
+		Control* m_container;       // 所在的容器控件，直接放在窗口上时为空
 		D2D1_RECT_F m_rect;
 		bool m_visible;
+		float m_opacity;
+		D2D1_MATRIX_3X2_F m_transform;  // 以控件中心为原点，只影响绘制，不影响命中测试
+
+		// 控件事件，由派生类在对应状态变化时发出；位置变化由 Control 自己发出
+		Signal<> m_clicked;
+		Signal<bool> m_hoverChanged;
+		Signal<bool> m_focusChanged;
+		Signal<> m_textChanged;
+		Signal<const D2D1_RECT_F&> m_rectChanged;
+
+		// 当前样式在指定状态下的属性，按需向样式表查询并保存在控件上
+		const ResolvedStyle& GetStyle(StyleState state = StyleState::Normal);
+		// 样式名变化或样式表更新后调用（后者在下一次绘制前），派生类据此更新颜色和字体
+		// 用 Set 方法单独设置的颜色等会被样式覆盖
+		virtual void OnStyleChanged() {}
+		virtual void OnEnabledChanged() {}
+
+		// 填充矩形并通知窗口的绘制观察者，控件绘制背景等填充时应使用它
+		void FillRectangle(ID2D1RenderTarget* renderTarget, const D2D1_RECT_F& rect, ID2D1SolidColorBrush* brush);
+		// 控件用其他方式覆盖了一块区域（如绘制位图）时，由控件自己通知观察者
+		void NotifyFill(ID2D1RenderTarget* renderTarget, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color);
+		// 其他常用绘制调用的对应版本，同样会通知绘制观察者
+		void DrawRectangleOutline(ID2D1RenderTarget* renderTarget, const D2D1_RECT_F& rect, ID2D1SolidColorBrush* brush, float strokeWidth = 1.0f);
+		void DrawLineSegment(ID2D1RenderTarget* renderTarget, D2D1_POINT_2F from, D2D1_POINT_2F to, ID2D1SolidColorBrush* brush, float strokeWidth = 1.0f);
+		void DrawTextRun(ID2D1RenderTarget* renderTarget, const wchar_t* text, UINT32 length, IDWriteTextFormat* format,
+			const D2D1_RECT_F& rect, ID2D1SolidColorBrush* brush, D2D1_DRAW_TEXT_OPTIONS options = D2D1_DRAW_TEXT_OPTIONS_NONE);
+		// 绘制已经排版好的文本；prepared 为空（尚未排版或排版失败）或与要绘制的文本、格式、尺寸不符时按 DrawTextRun 绘制
+		void DrawPreparedText(ID2D1RenderTarget* renderTarget, const PreparedText* prepared, const wchar_t* text, UINT32 length,
+			IDWriteTextFormat* format, const D2D1_RECT_F& rect, ID2D1SolidColorBrush* brush,
+			D2D1_DRAW_TEXT_OPTIONS options = D2D1_DRAW_TEXT_OPTIONS_NONE);
+		void PushClip(ID2D1RenderTarget* renderTarget, const D2D1_RECT_F& rect);
+		void PopClip(ID2D1RenderTarget* renderTarget);
+		// 用文本布局绘制的控件自己通知观察者布局对应的文字
+		void NotifyText(ID2D1RenderTarget* renderTarget, const wchar_t* text, UINT32 length, IDWriteTextFormat* format,
+			const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, D2D1_DRAW_TEXT_OPTIONS options = D2D1_DRAW_TEXT_OPTIONS_NONE);
+		bool HasDrawObservers() const;
+
+		// 要绘制的文本、文本格式或排版尺寸变化后调用，之前的排版结果作废；窗口在下一帧绘制之前重新排版
+		// 只登记排版工作，不会引起重绘
+		void InvalidateText();
+		// 窗口收集排版工作时调用，派生类按绘制时使用的顺序加入需要排版的文本
+		virtual void OnCollectTextWork(std::vector<TextWork>* work) {}
+		// 第 index 段文本的排版结果，尚未排版时为空；只在界面线程上读取，不需要加锁
+		const PreparedText* GetPreparedText(size_t index) const {
+			return index < m_preparedText.size() ? &m_preparedText[index] : nullptr;
+		}
+
+		// 登记控件持有的设备资源；登记过的资源必须用 ReleaseResource 释放，未释放的资源会一直计入
+		template<class T> void TrackResource(T* resource) {
+			if (resource) {
+				OnResourceAdded(GetResourceKind(resource), EstimateTrackedBytes(resource));
+			}
+		}
+		template<class T> void ReleaseResource(T** resource) {
+			if (*resource) {
+				OnResourceRemoved(GetResourceKind(*resource), EstimateTrackedBytes(*resource));
+				SafeRelease(resource);
+			}
+		}
+
+	private:
+		ResourceTracker m_resources;
+
+		// 透明度、位置和变换的动画，第一次使用时才创建
+		struct PropertyAnimations;
+		std::unique_ptr<PropertyAnimations> m_animations;
+		PropertyAnimations& GetAnimations();
+		void ApplyRect(const D2D1_RECT_F& rect);
+		void ApplyTransform(const D2D1_MATRIX_3X2_F& transform);
+		D2D1_MATRIX_3X2_F GetCenteredTransform() const;
+		D2D1_RECT_F TransformBounds(const D2D1_RECT_F& rect) const;
+
+		std::wstring m_styleName;
+		UINT64 m_styleVersion;      // 取用样式时样式表的版本
+		std::shared_ptr<const ResolvedStyle> m_styles[static_cast<size_t>(StyleState::Count)];
+		bool m_enabled;
+		void RefreshStyle();
+		// 所在窗口的样式表，没有窗口时使用默认样式表
+		StyleSheet* GetStyleSheet() const;
+
+		std::vector<PreparedText> m_preparedText;  // 按 OnCollectTextWork 加入的顺序
+		bool m_textInvalid;         // 已在窗口中登记，等待下一帧排版
+
+		void OnResourceAdded(ResourceKind kind, size_t bytes);
+		void OnResourceRemoved(ResourceKind kind, size_t bytes);
 
 	public:
-        // 
+        // 添加这个方法
         virtual bool HitTest(float x, float y) const {
             return x >= m_rect.left && x <= m_rect.right &&
                 y >= m_rect.top && y <= m_rect.bottom;
         }
 
         virtual void Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory) = 0;
-		Control(Window* parent, const D2D1_RECT_F& rect)
-			: m_parent(parent), m_rect(rect), m_visible(true) {
-		}
-		virtual ~Control() = default;
+		Control(Window* parent, const D2D1_RECT_F& rect);
+		virtual ~Control();
 
 		virtual void Draw(ID2D1RenderTarget* renderTarget) = 0;
 		virtual void OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) {}
 		virtual void OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) {}
 
-		void SetRect(const D2D1_RECT_F& rect) { m_rect = rect; }
+		// 应用透明度和变换后调用 Draw，容器绘制子控件时应使用它
+		void Render(ID2D1RenderTarget* renderTarget);
+
+		// 标记需要重绘；rect 与 m_rect 使用相同的坐标系，省略时为整个控件
+		void Invalidate();
+		void Invalidate(const D2D1_RECT_F& rect);
+		// 子控件失效时由子控件调用，rect 为子控件所在的坐标系
+		virtual void OnChildInvalidated(const D2D1_RECT_F& rect) { Invalidate(rect); }
+		void SetContainer(Control* container) { m_container = container; }
+
+		// 所在窗口的动画调度器
+		AnimationScheduler* GetAnimationScheduler() const;
+		// 由窗口在绘制之前调用，加入本控件需要排版的文本
+		void CollectTextWork(std::vector<TextWork>* work);
+
+		// 事件；处理函数在界面线程上调用
+		Signal<>& Clicked() { return m_clicked; }
+		Signal<bool>& HoverChanged() { return m_hoverChanged; }
+		Signal<bool>& FocusChanged() { return m_focusChanged; }
+		Signal<>& TextChanged() { return m_textChanged; }
+		// 参数为新的位置，动画期间每帧都会发出
+		Signal<const D2D1_RECT_F&>& RectChanged() { return m_rectChanged; }
+
+		void SetRect(const D2D1_RECT_F& rect);
 		const D2D1_RECT_F& GetRect() const { return m_rect; }
-		void SetVisible(bool visible) { m_visible = visible; }
+		// 变换后实际绘制的范围
+		D2D1_RECT_F GetBounds() const;
+		void SetVisible(bool visible);
 		bool IsVisible() const { return m_visible; }
+		// 禁用的控件不接收鼠标和键盘事件，按 Disabled 状态的样式绘制
+		void SetEnabled(bool enabled);
+		bool IsEnabled() const { return m_enabled; }
+		// 使用窗口样式表中的指定样式，内置控件在构造时设置为自己的类名
+		void SetStyleName(const std::wstring& name);
+		const std::wstring& GetStyleName() const { return m_styleName; }
+		void SetOpacity(float opacity);
+		float GetOpacity() const { return m_opacity; }
+		void SetTransform(const D2D1_MATRIX_3X2_F& transform);
+		const D2D1_MATRIX_3X2_F& GetTransform() const { return m_transform; }
+
+		// 属性动画；直接调用对应的 Set 方法会停止进行中的动画
+		void AnimateOpacity(float opacity, double duration, EasingFunction easing = Easing::EaseOut);
+		void AnimateRect(const D2D1_RECT_F& rect, double duration, EasingFunction easing = Easing::EaseOut);
+		void SpringRect(const D2D1_RECT_F& rect, const SpringParams& params = SpringParams());
+		void AnimateTransform(const D2D1_MATRIX_3X2_F& transform, double duration, EasingFunction easing = Easing::EaseOut);
+		void SpringTransform(const D2D1_MATRIX_3X2_F& transform, const SpringParams& params = SpringParams());
+
+		// 控件自身占用的内存（含字符串、缓冲区等，不含子控件）
+		virtual size_t GetCpuBytes() const { return sizeof(Control); }
+		// 遍历直接子控件，容器控件需要重写
+		virtual void ForEachChild(const std::function<void(Control*)>& visit) {}
+
+		// 重新计算 CPU 内存后返回当前的资源占用
+		const ResourceUsage& UpdateResourceUsage();
+		const ResourceUsage& GetResourceUsage() const { return m_resources.GetUsage(); }
+		void SetResourceBudget(const ResourceBudget& budget) { m_resources.SetBudget(budget); }
 	};
 
-	// ı
+	// 文本输入框类
+	// 内容按块存放，追加和载入都不会复制已有文本；换行位置在线程池上增量查找，只为可见行排版
 	class TextBox : public Control {
 	private:
-		std::wstring m_text;
+		struct SharedState;
+		struct IndexRequest;
+
+		ChunkedText m_text;
+		LineIndex m_lines;
+		std::vector<size_t> m_tailLines;        // 后台查找期间跟随末尾时，从末尾向前找到的最后几行
+		std::shared_ptr<TaskPool> m_pool;
+		std::shared_ptr<SharedState> m_shared;
+		bool m_indexing;                        // 有尚未完成的后台任务
+		double m_lastIndexSeconds;
+		size_t m_firstLine;                     // 最上方显示的行
+		bool m_followTail;                      // 新内容到达时滚动到末尾
+		float m_lineHeight;
+		std::wstring m_lineText;                // 绘制时拼接跨块的行
+		mutable std::wstring m_flatText;        // GetText 拼接的全文
+		mutable bool m_flatValid;
 		bool m_hasFocus;
 		bool m_isComposing;
 		std::wstring m_compositionString;
@@ -70,73 +419,117 @@ namespace KroubleUI {
 		ID2D1SolidColorBrush* m_textBrush;
 		ID2D1SolidColorBrush* m_compositionBrush;
 		IDWriteTextFormat* m_textFormat;
+		float m_borderWidth;
+		float m_focusedBorderWidth;
+		std::vector<std::wstring> m_preparedLines;  // 交给窗口排版的可见行
+		size_t m_preparedFirstLine;
+		bool m_preparedTail;
+	protected:
+		void OnStyleChanged() override;
+		void OnEnabledChanged() override;
+		void OnCollectTextWork(std::vector<TextWork>* work) override;
 	public:
         TextBox(Window* parent, const D2D1_RECT_F& rect, const std::wstring& initialText = L"");
 			
 
-		~TextBox() {
-			SafeRelease(&m_borderBrush);
-			SafeRelease(&m_backgroundBrush);
-			SafeRelease(&m_textBrush);
-			SafeRelease(&m_compositionBrush);
-			SafeRelease(&m_textFormat);
-		}
+		~TextBox();
 
 
         virtual void Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory);
 
 		void Draw(ID2D1RenderTarget* renderTarget) override;
+		size_t GetCpuBytes() const override;
 
 		void OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
 
 		void OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
 
-		const std::wstring& GetText() const { return m_text; }
-		void SetText(const std::wstring& text);
+		// 拼接全部内容，代价与文本长度成正比；大文本应使用 GetLength、GetLineCount 等
+		const std::wstring& GetText() const;
+		void SetText(const std::wstring& text) { LoadText(text); }
+		// 取得 text 的所有权替换全部内容，不复制；首屏的换行立即查找，其余在后台完成
+		void LoadText(std::wstring text);
+		// 追加到末尾，耗时只与追加的长度有关；右值版本在文本较长时直接接管而不复制
+		void AppendText(const wchar_t* text, size_t length);
+		void AppendText(const std::wstring& text) { AppendText(text.data(), text.size()); }
+		void AppendText(std::wstring&& text);
+		// 追加剪贴板中的文本，获得焦点时 Ctrl+V 也会调用
+		bool Paste();
+
+		size_t GetLength() const { return m_text.GetLength(); }
+		// 后台查找尚未完成时只包含已找到的行
+		size_t GetLineCount() const { return m_lines.GetLineCount(); }
+		bool IsIndexing() const { return m_indexing; }
+		// 最近一次后台查找换行的耗时（秒）
+		double GetLastIndexSeconds() const { return m_lastIndexSeconds; }
 
 	private:
+		void OnTextAppended(size_t length);
+		void UpdateTextFormat(IDWriteFactory* dwriteFactory);
+		void UpdateTextColors();
+		void RemoveLastChar();
+		void CancelIndexing();
+		void ScheduleIndexing();
+		void IndexNow(size_t limit);
+		void OnLinesIndexed(const std::vector<size_t>& lineStarts, size_t end, double seconds);
+		void UpdateTail();
+		size_t GetRowCount() const;
+		void GetRowText(size_t row, std::wstring* out) const;
+		size_t GetVisibleLineCount() const;
+		void ScrollToLine(size_t line);
+		static void IndexLines(std::shared_ptr<SharedState> shared, std::shared_ptr<IndexRequest> request);
+
 		bool PtInRectF(const D2D1_RECT_F& rect, POINT pt) {
 			return pt.x >= rect.left && pt.x <= rect.right &&
 				pt.y >= rect.top && pt.y <= rect.bottom;
 		}	
 	};
 
-    //  KroubleUI ռ
+    // 在 KroubleUI 命名空间中添加
     class TextBlock : public Control {
     private:
         std::wstring m_text;
         ID2D1SolidColorBrush* m_textBrush;
-        ID2D1SolidColorBrush* m_backgroundBrush;  // 
+        ID2D1SolidColorBrush* m_backgroundBrush;  // 新增背景画笔
         IDWriteTextFormat* m_textFormat;
         bool m_wordWrap;
         DWRITE_TEXT_ALIGNMENT m_textAlignment;
         DWRITE_PARAGRAPH_ALIGNMENT m_paragraphAlignment;
-        IDWriteFactory* m_dwriteFactory;
+        float m_fontSize;
+
+    protected:
+        void OnStyleChanged() override;
+        void OnCollectTextWork(std::vector<TextWork>* work) override;
+
     public:
         TextBlock(Window* parent, const D2D1_RECT_F& rect, const std::wstring& text = L"");
 
         ~TextBlock() {
-            if (m_textBrush) m_textBrush->Release();
-            if (m_backgroundBrush) m_backgroundBrush->Release();  // ͷű
-            if (m_textFormat) m_textFormat->Release();
+            ReleaseResource(&m_textBrush);
+            ReleaseResource(&m_backgroundBrush);  // 释放背景画笔
+            ReleaseResource(&m_textFormat);
 
         }
 
         virtual void Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory);
 
         void Draw(ID2D1RenderTarget* renderTarget) override;
+        size_t GetCpuBytes() const override;
 
-        // ı
+        // 设置文本内容
         void SetText(const std::wstring& text) {
             m_text = text;
+            InvalidateText();
+            Invalidate();
+            m_textChanged.Emit();
         }
 
-        // ȡı
+        // 获取文本内容
         const std::wstring& GetText() const {
             return m_text;
         }
 
-        // ǷԶ
+        // 设置是否自动换行
         void SetWordWrap(bool wrap) {
             if (m_wordWrap != wrap) {
                 m_wordWrap = wrap;
@@ -144,7 +537,7 @@ namespace KroubleUI {
             }
         }
 
-        // ıˮƽ뷽ʽ
+        // 设置文本水平对齐方式
         void SetTextAlignment(DWRITE_TEXT_ALIGNMENT alignment) {
             if (m_textAlignment != alignment) {
                 m_textAlignment = alignment;
@@ -152,7 +545,7 @@ namespace KroubleUI {
             }
         }
 
-        // ıֱ뷽ʽ
+        // 设置文本垂直对齐方式
         void SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT alignment) {
             if (m_paragraphAlignment != alignment) {
                 m_paragraphAlignment = alignment;
@@ -160,41 +553,19 @@ namespace KroubleUI {
             }
         }
 
-        // ıɫ
+        // 设置文本颜色
         void SetTextColor(const D2D1_COLOR_F& color) {
             if (m_textBrush) {
                 m_textBrush->SetColor(color);
             }
+            Invalidate();
         }
         void SetBackgroundColor(const D2D1_COLOR_F& color);
-        // С
-        void SetFontSize(float size) {
-            if (m_textFormat) {
-                if (m_textFormat->GetFontSize() != size)
-                {
-                    // ıʽ
-                    m_dwriteFactory->CreateTextFormat(
-                        L"Microsoft YaHei", // ֧ĵ
-                        nullptr,
-                        DWRITE_FONT_WEIGHT_NORMAL,
-                        DWRITE_FONT_STYLE_NORMAL,
-                        DWRITE_FONT_STRETCH_NORMAL,
-                        size,
-                        L"zh-cn", // locale
-                        &m_textFormat
-                    );
-                }
-            }
-        }
+        // 设置字体大小
+        void SetFontSize(float size);
 
     private:
-        void UpdateTextFormat() {
-            if (m_textFormat) {
-                m_textFormat->SetWordWrapping(m_wordWrap ? DWRITE_WORD_WRAPPING_WRAP : DWRITE_WORD_WRAPPING_NO_WRAP);
-                m_textFormat->SetTextAlignment(m_textAlignment);
-                m_textFormat->SetParagraphAlignment(m_paragraphAlignment);
-            }
-        }
+        void UpdateTextFormat();
 
         template<class T> void SafeRelease(T** ppT) {
             if (*ppT) {
@@ -216,57 +587,574 @@ namespace KroubleUI {
         bool m_isHovered;
         bool m_isPressed;
 
-        std::function<void()> m_onClickHandler;
+        // 各状态的颜色，在画笔创建之前设置也会生效
+        D2D1_COLOR_F m_textColor;
+        D2D1_COLOR_F m_borderColor;
+        D2D1_COLOR_F m_normalColor;
+        D2D1_COLOR_F m_hoverColor;
+        D2D1_COLOR_F m_pressedColor;
+        D2D1_COLOR_F m_disabledColor;
+        D2D1_COLOR_F m_disabledTextColor;
+        float m_borderWidth;
+        AnimatedValue<D2D1_COLOR_F> m_fillColor;    // 当前背景色，状态切换时过渡到对应颜色
 
         virtual void Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory);
         void SafeReleaseResources();
+        const D2D1_COLOR_F& GetStateColor() const;
+        void UpdateVisualState();
+
+    protected:
+        void OnStyleChanged() override;
+        void OnEnabledChanged() override;
+        void OnCollectTextWork(std::vector<TextWork>* work) override;
 
     public:
         Button(Window* parent, const D2D1_RECT_F& rect, const std::wstring& text = L"Button");
         virtual ~Button();
 
-        // Control ӿʵ
+        // Control 接口实现
         void Draw(ID2D1RenderTarget* renderTarget) override;
         void OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
+        size_t GetCpuBytes() const override;
 
-        // Button з
+        // Button 特有方法
         void SetText(const std::wstring& text);
         const std::wstring& GetText() const;
 
-        void SetOnClickHandler(std::function<void()> handler);
-
-        // ʽ
+        // 样式设置
         void SetTextColor(const D2D1_COLOR_F& color);
+        // 同时把悬停和按下的颜色设为背景色调亮和调暗后的颜色
         void SetBackgroundColor(const D2D1_COLOR_F& color);
+        void SetHoverColor(const D2D1_COLOR_F& color);
+        void SetPressedColor(const D2D1_COLOR_F& color);
         void SetBorderColor(const D2D1_COLOR_F& color);
     };
 
-	// 
+    // 大文本只读查看器（日志尾随）
+    // 按行增量建立索引，只为可见行创建并缓存文本布局，可直接显示内存映射的文件
+    class LogViewer : public Control {
+    private:
+        static const size_t kIndexBudget = 8 << 20;    // 每次定时器回调最多建立索引的字节数
+
+        struct CachedLine {
+            IDWriteTextLayout* layout;
+            size_t length;      // 创建布局时该行的字节数（最后一行可能继续增长）
+        };
+
+        // 内存映射的文件内容（只读，不复制），作为 m_buffer 的外部数据
+        // 文件句柄保持打开，读取映射前用它确认文件没有被截短
+        HANDLE m_file;
+        HANDLE m_mapping;
+        const char* m_mappedData;
+        size_t m_mappedSize;
+
+        LogBuffer m_buffer;
+        bool m_indexing;                    // 索引定时器是否在运行
+
+        std::unordered_map<size_t, CachedLine> m_layoutCache;
+        float m_layoutWidth;                // 缓存的布局对应的排版宽度
+        std::wstring m_lineBuffer;          // 解码缓冲
+
+        double m_scrollY;                   // 当前滚动位置（像素）
+        double m_targetScrollY;             // 平滑滚动的目标位置
+        double m_lastScrollTime;            // 上一次推进滚动的时刻（调度器时间）
+        CallbackTrack m_scrollTrack;        // 滚动没有停下时由窗口的动画调度器逐帧推进
+        float m_lineHeight;
+        bool m_followTail;
+        bool m_hasFocus;
+
+        ID2D1SolidColorBrush* m_textBrush;
+        ID2D1SolidColorBrush* m_backgroundBrush;
+        ID2D1SolidColorBrush* m_scrollBarBrush;
+        IDWriteTextFormat* m_textFormat;
+        IDWriteFactory* m_dwriteFactory;
+
+    public:
+        LogViewer(Window* parent, const D2D1_RECT_F& rect);
+        ~LogViewer();
+
+        virtual void Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory);
+
+        void Draw(ID2D1RenderTarget* renderTarget) override;
+        void OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
+        void OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
+        size_t GetCpuBytes() const override;
+
+        // 追加 UTF-8 文本，耗时只与追加的长度有关
+        void AppendText(const char* utf8, size_t length);
+        void AppendText(const std::string& utf8) { AppendText(utf8.data(), utf8.size()); }
+        void AppendText(const std::wstring& text);
+
+        // 以只读内存映射的方式打开 UTF-8 文件，之后仍可继续追加
+        bool OpenFile(const std::wstring& path);
+        void Clear();
+
+        size_t GetLineCount() const;
+        void ScrollToLine(size_t line);
+
+        // 滚动到底部时自动跟随新追加的内容
+        void SetFollowTail(bool follow);
+        bool IsFollowingTail() const { return m_followTail; }
+
+        void SetTextColor(const D2D1_COLOR_F& color);
+        void SetBackgroundColor(const D2D1_COLOR_F& color);
+
+    private:
+        // 把一行解码到 m_lineBuffer
+        void DecodeLine(size_t begin, size_t end);
+        IDWriteTextLayout* GetLineLayout(size_t line);
+        void ReleaseLayouts(size_t firstKept, size_t lastKept);
+        void ReleaseAllLayouts();
+        void CloseFile();
+        // 文件被截短时放弃映射的内容，返回映射是否仍然可读
+        bool CheckMappedFile();
+
+        // 映射文件的索引由窗口定时器分摊到多次回调完成，避免打开大文件时卡住界面
+        void StartIndexing();
+        void StopIndexing();
+        void IndexStep();
+        static void CALLBACK IndexTimerProc(HWND hwnd, UINT message, UINT_PTR id, DWORD time);
+
+        double GetMaxScroll() const;
+        void ScrollBy(double delta);
+        // 设置滚动目标；从静止开始滚动时重新计时，空闲的时间不计入第一帧
+        void SetScrollTarget(double target);
+        // 控件大小变化后把目标限制在可滚动范围内
+        void ClampScrollTarget();
+        // 推进到 time 时刻，返回是否还没停下
+        bool StepScroll(double time);
+    };
+
+    // 滚动容器
+    // 内容保存在离屏位图中，滚动时平移已有像素，只重绘新露出的区域和内容有变化的区域
+    class ScrollViewer : public Control {
+    private:
+        std::vector<std::unique_ptr<Control>> m_children;  // 子控件的矩形使用内容坐标
+        Control* m_hoveredChild;
+        Control* m_focusedChild;                // 最近一次按下的子控件，接收键盘输入
+        D2D1_SIZE_F m_contentSize;
+
+        // 双缓冲离屏表面：滚动时把前缓冲平移复制到后缓冲，补画露出的区域后交换
+        ID2D1BitmapRenderTarget* m_frontSurface;
+        ID2D1BitmapRenderTarget* m_backSurface;
+        D2D1_SIZE_U m_surfaceSize;
+        bool m_surfaceValid;
+        std::vector<D2D1_RECT_F> m_dirtyRects;  // 需要重绘的内容区域（内容坐标）
+
+        ScrollMotion m_motion;                  // 滚动位置和惯性
+        CallbackTrack m_scrollTrack;            // 惯性滚动没有停下时由窗口的动画调度器逐帧推进
+        int m_renderedX, m_renderedY;           // 离屏表面当前内容对应的滚动位置（整像素）
+        float m_lastPaintedArea;
+
+        D2D1_COLOR_F m_backgroundColor;
+        ID2D1SolidColorBrush* m_scrollBarBrush;
+
+    protected:
+        void OnStyleChanged() override;
+
+    public:
+        ScrollViewer(Window* parent, const D2D1_RECT_F& rect);
+        ~ScrollViewer();
+
+        virtual void Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory);
+
+        void Draw(ID2D1RenderTarget* renderTarget) override;
+        void OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
+        void OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
+        size_t GetCpuBytes() const override;
+        void ForEachChild(const std::function<void(Control*)>& visit) override;
+        void OnChildInvalidated(const D2D1_RECT_F& rect) override;
+
+        // 添加子控件（接管所有权），内容尺寸会扩展到能容纳该控件
+        void AddChild(Control* control);
+
+        void SetContentSize(float width, float height);
+        D2D1_SIZE_F GetContentSize() const { return m_contentSize; }
+
+        // 立即跳转到指定位置
+        void ScrollTo(double x, double y);
+        // 施加一次惯性滚动，总位移约为 (dx, dy)
+        void ScrollBy(double dx, double dy);
+        double GetOffsetX() const { return m_motion.GetOffsetX(); }
+        double GetOffsetY() const { return m_motion.GetOffsetY(); }
+
+        // 子控件内容变化后调用，标记需要重绘的区域（内容坐标）
+        void InvalidateContent(const D2D1_RECT_F& rect);
+        void InvalidateContent();
+
+        void SetBackgroundColor(const D2D1_COLOR_F& color);
+
+        // 上一帧实际重绘的面积（不含平移复制的部分），用于衡量滚动开销
+        float GetLastPaintedArea() const { return m_lastPaintedArea; }
+
+    private:
+        bool EnsureSurfaces(ID2D1RenderTarget* renderTarget);
+        void ReleaseSurfaces();
+        void PaintRegion(ID2D1RenderTarget* target, const D2D1_RECT_F& viewRect, int offsetX, int offsetY);
+        // 推进惯性滚动到 time 时刻，返回是否还没停下
+        bool StepScroll(double time);
+        void SyncViewSize();
+    };
+
+    // 数据网格：行和列都只绘制可见部分
+    // 排序和筛选在线程池上生成新的显示顺序，完成后整体替换，界面线程不会等待
+    class DataGrid : public Control {
+    public:
+        // 在后台线程上调用，需要线程安全
+        typedef DataGridRowFilter RowFilter;
+
+    private:
+        struct SharedState;
+        struct ViewRequest;
+
+        std::shared_ptr<DataGridSource> m_source;
+        std::shared_ptr<TaskPool> m_pool;
+        std::shared_ptr<SharedState> m_shared;
+        std::shared_ptr<const DataGridRowView> m_view;   // 只在界面线程上读写
+
+        int m_sortColumn;           // -1 表示不排序
+        bool m_sortAscending;
+        RowFilter m_filter;
+        bool m_updating;            // 有尚未完成的后台任务
+        bool m_appendPending;       // 后台任务期间又追加了新行
+        double m_lastUpdateSeconds;
+
+        std::vector<float> m_columnOffsets;     // 每列的左边界（内容坐标），末尾为总宽度
+        std::vector<float> m_columnWidths;
+        double m_scrollX, m_scrollY;
+        float m_rowHeight;
+        float m_headerHeight;
+        bool m_hasFocus;
+        std::wstring m_cellText;
+
+        ID2D1SolidColorBrush* m_textBrush;
+        ID2D1SolidColorBrush* m_backgroundBrush;
+        ID2D1SolidColorBrush* m_headerBrush;
+        ID2D1SolidColorBrush* m_gridLineBrush;
+        ID2D1SolidColorBrush* m_scrollBarBrush;
+        IDWriteTextFormat* m_textFormat;
+        IDWriteTextFormat* m_headerFormat;
+
+    public:
+        DataGrid(Window* parent, const D2D1_RECT_F& rect);
+        ~DataGrid();
+
+        virtual void Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory);
+
+        void Draw(ID2D1RenderTarget* renderTarget) override;
+        void OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
+        void OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
+        size_t GetCpuBytes() const override;
+
+        void SetSource(std::shared_ptr<DataGridSource> source);
+        const std::shared_ptr<DataGridSource>& GetSource() const { return m_source; }
+        // 默认使用进程共享的线程池
+        void SetTaskPool(std::shared_ptr<TaskPool> pool);
+
+        // column 为 -1 时恢复数据源原有顺序
+        void SortBy(int column, bool ascending = true);
+        int GetSortColumn() const { return m_sortColumn; }
+        bool IsSortAscending() const { return m_sortAscending; }
+        // 传入空函数取消筛选
+        void SetFilter(RowFilter filter);
+        // 数据源追加新行后调用；已排序时只对新行排序再与现有顺序合并
+        void NotifyRowsAppended();
+
+        void SetColumnWidth(size_t column, float width);
+        float GetColumnWidth(size_t column) const;
+
+        size_t GetVisibleRowCount() const { return m_view ? m_view->GetCount() : 0; }
+        size_t GetSourceRow(size_t displayRow) const { return m_view->GetRow(displayRow); }
+        bool IsUpdating() const { return m_updating; }
+        // 最近一次后台排序或筛选的耗时（秒）
+        double GetLastUpdateSeconds() const { return m_lastUpdateSeconds; }
+
+        void ScrollToRow(size_t row);
+
+    private:
+        void StartUpdate(bool incremental);
+        void OnViewReady(std::shared_ptr<const DataGridRowView> view, double seconds);
+        static void BuildView(std::shared_ptr<SharedState> shared, std::shared_ptr<ViewRequest> request);
+        void UpdateColumnOffsets();
+        void ClampScroll();
+        void ScrollBy(double dx, double dy);
+    };
+
+    // 重绘诊断：逐像素统计填充次数，计算重绘比例和被完全遮挡的控件，可选绘制热力图叠加层
+    // 统计由 OverdrawCounter 完成，这里只把 Direct2D 的目标、变换和裁剪换算成像素
+    class OverdrawAnalyzer : public DrawObserver {
+    private:
+        Window* m_window;
+        ID2D1RenderTarget* m_target;
+        D2D1_MATRIX_3X2_F m_targetTransform;
+        float m_pixelScale;
+        OverdrawCounter m_counter;
+        OverdrawStats m_stats;
+
+        bool m_heatmapEnabled;
+        ID2D1Bitmap* m_heatmap;
+        ID2D1RenderTarget* m_heatmapOwner;
+        D2D1_SIZE_U m_heatmapSize;
+        std::vector<UINT32> m_heatmapPixels;
+
+    public:
+        // 构造时加入窗口的绘制观察者，析构时移除；不能比窗口存在得久
+        explicit OverdrawAnalyzer(Window* window);
+        ~OverdrawAnalyzer();
+
+        // 开关热力图叠加层；叠加层只覆盖每帧的失效区域，其余部分保留上次重绘时的叠加
+        void SetHeatmapEnabled(bool enabled);
+        bool IsHeatmapEnabled() const { return m_heatmapEnabled; }
+
+        // 最近一帧的统计结果
+        const OverdrawStats& GetStats() const { return m_stats; }
+
+        void OnBeginFrame(ID2D1RenderTarget* target, const D2D1_RECT_F& damage) override;
+        void OnFillRect(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color) override;
+        void OnPushClip(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect) override;
+        void OnPopClip(ID2D1RenderTarget* target, const Control* control) override;
+        void OnPushLayer(ID2D1RenderTarget* target, const Control* control, float opacity) override;
+        void OnPopLayer(ID2D1RenderTarget* target, const Control* control) override;
+        void OnEndFrame(ID2D1RenderTarget* target) override;
+
+    private:
+        Transform2D GetPixelTransform(ID2D1RenderTarget* target) const;
+        void DrawHeatmap(ID2D1RenderTarget* target);
+    };
+
+	// 把窗口的绘制调用交给 DrawCommandWriter 编码为紧凑的命令流
+	// 窗口每帧只重绘失效区域，所以每帧的命令本身就是相对上一帧的增量
+	// 只记录窗口渲染目标上的绘制，离屏表面上的内容（如 ScrollViewer 的缓存）在命令流中只是一块背景色
+	class DrawCommandEncoder : public DrawObserver {
+	public:
+		typedef std::function<void(std::string& frame)> FrameHandler;
+
+	private:
+		class EncodeTimer;
+
+		ID2D1RenderTarget* m_target;        // 正在编码的帧所在的渲染目标
+		DrawCommandWriter m_writer;         // 文本格式表持有 IDWriteTextFormat 的引用，避免指针被复用
+		SystemClock m_clock;
+		FrameHandler m_onFrame;
+
+	public:
+		DrawCommandEncoder();
+
+		DrawCommandEncoder(const DrawCommandEncoder&) = delete;
+		DrawCommandEncoder& operator=(const DrawCommandEncoder&) = delete;
+
+		// 每帧编码完成后调用，可以取走 frame 的内容
+		void SetFrameHandler(FrameHandler handler) { m_onFrame = handler; }
+		// 清空编号表，下一帧开头通知接收方一并清空；新的接收方连接或丢弃了已编码的帧时调用
+		void Reset() { m_writer.Reset(); }
+		// 编码耗时只统计各个通知内的编码，不包括控件在两次通知之间的实际绘制
+		const RemoteFrameStats& GetStats() const { return m_writer.GetStats(); }
+
+		void OnBeginFrame(ID2D1RenderTarget* target, const D2D1_RECT_F& damage) override;
+		void OnFillRect(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color) override;
+		void OnDrawRect(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, float strokeWidth) override;
+		void OnDrawLine(ID2D1RenderTarget* target, const Control* control, D2D1_POINT_2F from, D2D1_POINT_2F to, const D2D1_COLOR_F& color, float strokeWidth) override;
+		void OnDrawText(ID2D1RenderTarget* target, const Control* control, const wchar_t* text, UINT32 length,
+			IDWriteTextFormat* format, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, D2D1_DRAW_TEXT_OPTIONS options) override;
+		void OnPushClip(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect) override;
+		void OnPopClip(ID2D1RenderTarget* target, const Control* control) override;
+		void OnPushLayer(ID2D1RenderTarget* target, const Control* control, float opacity) override;
+		void OnPopLayer(ID2D1RenderTarget* target, const Control* control) override;
+		void OnEndFrame(ID2D1RenderTarget* target) override;
+
+	private:
+		bool BeginCommand(ID2D1RenderTarget* target);
+	};
+
+	// 在本地渲染目标上回放 DrawCommandEncoder 编码的帧，解码由 DrawCommandReader 完成
+	class DrawCommandPlayer {
+	private:
+		class Sink;
+
+		GraphicsContext* m_context;
+		DrawCommandReader m_reader;
+		std::vector<IDWriteTextFormat*> m_formats;
+
+	public:
+		explicit DrawCommandPlayer(GraphicsContext* context);
+		~DrawCommandPlayer();
+
+		DrawCommandPlayer(const DrawCommandPlayer&) = delete;
+		DrawCommandPlayer& operator=(const DrawCommandPlayer&) = delete;
+
+		void Reset();
+		size_t GetCpuBytes() const;
+		// 读取帧开头的渲染目标尺寸，不改变回放状态
+		static bool ReadFrameSize(const std::string& frame, D2D1_SIZE_U* size);
+		// 在 BeginDraw 之后调用；brush 用于所有绘制，回放时改变其颜色
+		// target 为空时只更新编号表，不绘制
+		// 数据不完整或格式错误时返回 false，已压入的裁剪和图层都会弹出
+		bool Play(ID2D1RenderTarget* target, ID2D1SolidColorBrush* brush, const std::string& frame, D2D1_RECT_F* damage);
+
+	private:
+		void ReleaseFormats();
+	};
+
+	// 远程界面服务端：在本机 TCP 端口上等待一个查看端，发送窗口的绘制命令流，并把收到的输入事件交给窗口
+	// 在窗口线程上创建和销毁，必须先于窗口销毁
+	class RemoteUIServer {
+	private:
+		struct Client;
+
+		Window* m_window;
+		DrawCommandEncoder m_encoder;
+		std::shared_ptr<RemoteUIServer*> m_self;    // 投递到窗口线程的任务据此判断服务端是否还在
+		SOCKET m_listenSocket;
+		unsigned short m_port;
+		std::shared_ptr<Client> m_client;           // 接收线程上最新接受的连接
+		std::shared_ptr<Client> m_streamClient;     // 编码器已为其重置过的连接，只在窗口线程上读写
+		std::mutex m_mutex;                         // 保护 m_client、发送队列和 m_stopping
+		std::condition_variable m_wake;
+		FrameSendQueue m_outgoing;
+		bool m_stopping;
+		std::thread m_acceptThread;                 // 接受连接并读取输入事件
+		std::thread m_sendThread;
+
+	public:
+		// port 为 0 时由系统分配，用 GetPort 查询
+		RemoteUIServer(Window* window, unsigned short port = 0);
+		~RemoteUIServer();
+
+		RemoteUIServer(const RemoteUIServer&) = delete;
+		RemoteUIServer& operator=(const RemoteUIServer&) = delete;
+
+		unsigned short GetPort() const { return m_port; }
+		bool IsConnected();
+		// 连接期间每帧的字节数和编码耗时
+		const RemoteFrameStats& GetStats() const { return m_encoder.GetStats(); }
+
+	private:
+		void AcceptLoop();
+		void SendLoop();
+		void OnConnected(std::shared_ptr<Client> client);
+		void OnDisconnected(std::shared_ptr<Client> client);
+		void OnFrame(std::string& frame);
+		void DispatchInput(UINT message, WPARAM wParam, LPARAM lParam);
+	};
+
+	// 显示远程窗口的控件：连接 RemoteUIServer 并回放收到的帧，把自身收到的鼠标和键盘事件发回服务端
+	class RemoteView : public Control {
+	private:
+		struct Connection;
+
+		std::shared_ptr<Connection> m_connection;
+		DrawCommandPlayer m_player;
+		ID2D1BitmapRenderTarget* m_surface;     // 保留远程窗口的画面，每帧只回放失效区域
+		D2D1_SIZE_U m_surfaceSize;
+		UINT64 m_receivedFrames;
+		UINT64 m_receivedBytes;
+		bool m_hasFocus;
+		bool m_isHovered;
+
+		ID2D1SolidColorBrush* m_backgroundBrush;
+		ID2D1SolidColorBrush* m_playerBrush;
+
+	public:
+		RemoteView(Window* parent, const D2D1_RECT_F& rect);
+		~RemoteView();
+
+		virtual void Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory);
+
+		void Draw(ID2D1RenderTarget* renderTarget) override;
+		void OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
+		void OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) override;
+		size_t GetCpuBytes() const override;
+
+		// host 为 IPv4 地址，如 "127.0.0.1"
+		bool Connect(const std::string& host, unsigned short port);
+		void Disconnect();
+		bool IsConnected() const;
+
+		UINT64 GetReceivedFrames() const { return m_receivedFrames; }
+		UINT64 GetReceivedBytes() const { return m_receivedBytes; }
+
+	private:
+		void OnFrameReceived(const std::string& frame);
+		bool EnsureSurface(const D2D1_SIZE_U& size);
+		void SendInput(UINT message, WPARAM wParam, LPARAM lParam);
+	};
+
+	// 资源报告中的一项
+	struct ControlResourceEntry {
+		const Control* control;
+		std::string typeName;
+		int depth;              // 在控件树中的层级，窗口的直接子控件为 0
+		ResourceUsage usage;
+	};
+
+	// 窗口类
 	class Window {
 	private:
 		HWND m_hwnd;
-		ID2D1Factory* m_d2dFactory;
-		IDWriteFactory* m_dwriteFactory;
+		std::shared_ptr<GraphicsContext> m_context;
 		ID2D1HwndRenderTarget* m_renderTarget;
+		AnimationScheduler m_animations;    // 先于控件构造，控件析构时动画可以安全地停止
+		D2D1_RECT_F m_damage;               // 下一帧需要重绘的区域
+		bool m_hasDamage;
 		std::vector<std::unique_ptr<Control>> m_controls;
+		std::vector<DrawObserver*> m_drawObservers;
+		ResourceTracker m_resources;        // 每帧统计一次，峰值跨多次统计保留
+		std::mutex m_taskMutex;             // 保护 m_postedTasks 和跨线程读取的 m_hwnd
+		std::vector<std::function<void()>> m_postedTasks;
+		std::shared_ptr<StyleSheet> m_styleSheet;
+		UINT64 m_styleVersion;              // 上次重绘时样式表的版本
+		size_t m_styleListener;             // 在样式表上登记的监听编号
+		std::atomic<bool> m_styleCheckPosted;   // 已投递尚未执行的样式检查，多次修改只投递一次
+		std::vector<Control*> m_textInvalidControls;    // 自上一帧以来文本需要重新排版的控件
+		std::vector<TextWork> m_textWork;
+		size_t m_lastTextWorkCount;
+		double m_lastTextWorkSeconds;
 
 	public:
-		Window(HINSTANCE hInstance, const std::wstring& title, int width, int height);
+		// context 为空时使用进程共享的图形上下文
+		Window(HINSTANCE hInstance, const std::wstring& title, int width, int height,
+			std::shared_ptr<GraphicsContext> context = nullptr);
 
-		~Window() {
-			SafeRelease(&m_renderTarget);
-			SafeRelease(&m_dwriteFactory);
-			SafeRelease(&m_d2dFactory);
-			DestroyWindow(m_hwnd);
-		}
+		~Window();
 
 		ID2D1HwndRenderTarget* GetRenderTarget() const { return m_renderTarget; }
-		IDWriteFactory* GetDWriteFactory() const { return m_dwriteFactory; }
+		IDWriteFactory* GetDWriteFactory() const { return m_context->GetDWriteFactory(); }
+		GraphicsContext* GetGraphicsContext() const { return m_context.get(); }
+
+		// 默认使用进程共享的样式表；换用后整体重绘
+		void SetStyleSheet(std::shared_ptr<StyleSheet> styleSheet);
+		StyleSheet* GetStyleSheet() const { return m_styleSheet.get(); }
 
 		void AddControl(Control* control);
 
+		// 绘制观察者不由窗口接管所有权
+		void AddDrawObserver(DrawObserver* observer);
+		void RemoveDrawObserver(DrawObserver* observer);
+		const std::vector<DrawObserver*>& GetDrawObservers() const { return m_drawObservers; }
+
+		// 汇总所有控件和渲染目标的资源占用；渲染目标的缓冲计入 targetBytes
+		// 控件持有的文本格式只计个数，格式的字节数由 GraphicsContext 统计
+		const ResourceUsage& UpdateResourceUsage();
+		// 逐个控件的资源占用（按树的先序排列）
+		std::vector<ControlResourceEntry> CollectResourceUsage();
+		// 按占用从大到小排序的文本报告
+		std::string GetResourceReport();
+		// 每帧渲染结束时统计并检查一次
+		void SetResourceBudget(const ResourceBudget& budget) { m_resources.SetBudget(budget); }
+
+		AnimationScheduler* GetAnimationScheduler() { return &m_animations; }
+
+		// 标记需要重绘的区域（窗口坐标），在下一帧统一绘制
+		void Invalidate();
+		void Invalidate(const D2D1_RECT_F& rect);
+		// 有待重绘的区域或进行中的动画
+		bool NeedsFrame() const { return m_hasDamage || m_animations.IsAnimating(); }
+
+		// 处理消息，按显示器刷新率为需要出帧的窗口推进动画并重绘；没有窗口需要出帧时等待消息
+		// 线程上的窗口全部关闭后返回
 		void RunMessageLoop();
 
+		// 只重绘失效区域，没有失效区域时什么也不做
 		void Render();
 
 		void OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam);
@@ -275,8 +1163,23 @@ namespace KroubleUI {
 
 		HWND GetHwnd() const { return m_hwnd; }
 
+		// 可以在任意线程调用，任务在窗口所在的线程上执行；窗口关闭后提交的任务会被丢弃
+		void PostTask(std::function<void()> task);
+
+		// 由 Control::InvalidateText 和控件析构时调用
+		void QueueTextWork(Control* control);
+		void CancelTextWork(Control* control);
+		// 上一次绘制前排版的文本段数和耗时（秒），包括在线程池上等待的时间
+		size_t GetLastTextWorkCount() const { return m_lastTextWorkCount; }
+		double GetLastTextWorkSeconds() const { return m_lastTextWorkSeconds; }
+
 	private:
-		void InitializeDirect2D();
+		void RunPostedTasks();
+		void CheckStyleSheet();
+		void ListenToStyleSheet();
+		void PrepareText();
+		void CreateGraphicsResources();
+		void UpdateFrameInterval();
 
 		void DiscardGraphicsResources();
 		static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
@@ -0,0 +1,157 @@
+#include "LogBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace KroubleUI {
+
+    LogBuffer::LogBuffer()
+        : m_externalData(nullptr),
+        m_externalSize(0),
+        m_appendedSize(0),
+        m_lineStartCount(0),
+        m_indexedSize(0) {
+        AddLineStart(0);
+    }
+
+    void LogBuffer::SetExternalData(const char* data, size_t size) {
+        Clear();
+        m_externalData = data;
+        m_externalSize = data ? size : 0;
+
+        // 跳过 UTF-8 BOM
+        if (m_externalSize >= 3 && memcmp(m_externalData, "\xEF\xBB\xBF", 3) == 0) {
+            m_lineBlocks[0][0] = 3;
+        }
+    }
+
+    void LogBuffer::Append(const char* data, size_t length) {
+        if (length == 0) return;
+
+        bool caughtUp = IsIndexed();
+
+        // 拷贝到尾部的块中，写满后再分配新块
+        while (length > 0) {
+            if (m_appendedSize == m_chunks.size() * kChunkSize) {
+                m_chunks.emplace_back(new char[kChunkSize]);
+            }
+            size_t used = m_appendedSize % kChunkSize;
+            size_t count = (std::min)(kChunkSize - used, length);
+            memcpy(m_chunks.back().get() + used, data, count);
+            m_appendedSize += count;
+            data += count;
+            length -= count;
+        }
+
+        // 没有积压的索引工作时只扫描新追加的部分
+        if (caughtUp) {
+            IndexPending(GetTotalSize() - m_indexedSize);
+        }
+    }
+
+    void LogBuffer::IndexPending(size_t budget) {
+        size_t end = (std::min)(GetTotalSize(), m_indexedSize + budget);
+
+        while (m_indexedSize < end) {
+            size_t length = 0;
+            const char* data = GetSegment(m_indexedSize, end, &length);
+            const char* cursor = data;
+            const char* segmentEnd = data + length;
+
+            while (cursor < segmentEnd) {
+                cursor = static_cast<const char*>(memchr(cursor, '\n', segmentEnd - cursor));
+                if (!cursor) break;
+                ++cursor;
+                AddLineStart(m_indexedSize + (cursor - data));
+            }
+            m_indexedSize += length;
+        }
+    }
+
+    void LogBuffer::Clear() {
+        m_externalData = nullptr;
+        m_externalSize = 0;
+        m_chunks.clear();
+        m_appendedSize = 0;
+        m_lineBlocks.clear();
+        m_lineStartCount = 0;
+        AddLineStart(0);
+        m_indexedSize = 0;
+    }
+
+    void LogBuffer::AddLineStart(size_t offset) {
+        if (m_lineStartCount == m_lineBlocks.size() * kLineBlockSize) {
+            m_lineBlocks.emplace_back(new size_t[kLineBlockSize]);
+        }
+        m_lineBlocks.back()[m_lineStartCount % kLineBlockSize] = offset;
+        ++m_lineStartCount;
+    }
+
+    size_t LogBuffer::GetLineCount() const {
+        if (GetTotalSize() == 0) return 0;
+
+        size_t count = m_lineStartCount;
+        if (count > 1 && GetLineStart(count - 1) == GetTotalSize()) {
+            --count;
+        }
+        return count;
+    }
+
+    void LogBuffer::GetLineRange(size_t line, size_t* begin, size_t* end) const {
+        *begin = GetLineStart(line);
+        // 不包含行尾的 '\n'；最后一行延伸到已索引的位置
+        *end = line + 1 < m_lineStartCount ? GetLineStart(line + 1) - 1 : m_indexedSize;
+        if (*end - *begin > kMaxLineBytes) {
+            // 退到字符的起始字节，不把多字节字符截成两半
+            *end = *begin + kMaxLineBytes;
+            while (*end > *begin && (GetByte(*end) & 0xC0) == 0x80) {
+                --*end;
+            }
+        }
+    }
+
+    const char* LogBuffer::ReadBytes(size_t begin, size_t end) {
+        size_t length = 0;
+        const char* data = GetSegment(begin, end, &length);
+        if (length == end - begin) {
+            return data;
+        }
+
+        // 行跨越了外部数据与追加块（或两个追加块）的边界，拼接后返回
+        m_byteBuffer.assign(data, length);
+        for (size_t offset = begin + length; offset < end; offset += length) {
+            data = GetSegment(offset, end, &length);
+            m_byteBuffer.append(data, length);
+        }
+        return m_byteBuffer.data();
+    }
+
+    size_t LogBuffer::GetCpuBytes() const {
+        return sizeof(LogBuffer) + m_chunks.size() * kChunkSize +
+            m_lineBlocks.size() * kLineBlockSize * sizeof(size_t) + m_byteBuffer.capacity();
+    }
+
+    const char* LogBuffer::GetSegment(size_t offset, size_t limit, size_t* length) const {
+        if (offset >= limit) {
+            *length = 0;
+            return nullptr;
+        }
+
+        if (offset < m_externalSize) {
+            *length = (std::min)(limit, m_externalSize) - offset;
+            return m_externalData + offset;
+        }
+
+        // 追加区域：返回 offset 所在块内的连续部分
+        size_t local = offset - m_externalSize;
+        size_t within = local % kChunkSize;
+        *length = (std::min)(kChunkSize - within, limit - offset);
+        return m_chunks[local / kChunkSize].get() + within;
+    }
+
+    unsigned char LogBuffer::GetByte(size_t offset) const {
+        size_t length = 0;
+        const char* data = GetSegment(offset, offset + 1, &length);
+        return static_cast<unsigned char>(*data);
+    }
+
+} // namespace KroubleUI
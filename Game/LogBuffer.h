@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace KroubleUI {
+
+    // 日志查看器的内容存储，LogViewer 绘制时只从这里解码可见的行
+    // 由一段只读的外部数据（如内存映射的文件，不复制）和分块追加的内容组成，按行增量建立索引
+    class LogBuffer {
+    public:
+        static const size_t kChunkSize = 1 << 20;      // 追加内容的分块大小
+        static const size_t kMaxLineBytes = 16384;     // 单行最多读取的字节数
+        static const size_t kLineBlockSize = 1 << 16;  // 行索引的分块大小（项数）
+
+    private:
+        const char* m_externalData;
+        size_t m_externalSize;
+
+        // 追加的内容按块存放，追加时不搬移已有数据
+        std::vector<std::unique_ptr<char[]>> m_chunks;
+        size_t m_appendedSize;
+
+        // 每行的起始偏移，分块存放，索引增长时不搬移已有的项，避免一次追加卡顿
+        std::vector<std::unique_ptr<size_t[]>> m_lineBlocks;
+        size_t m_lineStartCount;
+        size_t m_indexedSize;               // 已建立索引的字节数
+        std::string m_byteBuffer;           // 跨块行的拼接缓冲
+
+        const char* GetSegment(size_t offset, size_t limit, size_t* length) const;
+        unsigned char GetByte(size_t offset) const;
+        size_t GetLineStart(size_t line) const { return m_lineBlocks[line / kLineBlockSize][line % kLineBlockSize]; }
+        void AddLineStart(size_t offset);
+
+    public:
+        LogBuffer();
+        LogBuffer(const LogBuffer&) = delete;
+        LogBuffer& operator=(const LogBuffer&) = delete;
+
+        // 使用外部数据作为开头的内容，清除已有内容；data 在 Clear 或下次设置之前必须有效
+        void SetExternalData(const char* data, size_t size);
+        // 追加 UTF-8 文本；没有积压的索引工作时立即索引，耗时只与追加的长度有关
+        void Append(const char* data, size_t length);
+        // 最多再索引 budget 字节，用于把大文件的索引分摊到多帧
+        void IndexPending(size_t budget);
+        void Clear();
+
+        size_t GetTotalSize() const { return m_externalSize + m_appendedSize; }
+        size_t GetIndexedSize() const { return m_indexedSize; }
+        bool IsIndexed() const { return m_indexedSize == GetTotalSize(); }
+        // 末尾换行之后的空行不计入
+        size_t GetLineCount() const;
+        // 行的字节范围，不含换行符；超过 kMaxLineBytes 的行在字符边界处截断
+        void GetLineRange(size_t line, size_t* begin, size_t* end) const;
+        // 返回连续的字节，跨块时拼接到内部缓冲，下次调用前有效
+        const char* ReadBytes(size_t begin, size_t end);
+        // 追加块、行索引和缓冲占用的内存，外部数据不计入
+        size_t GetCpuBytes() const;
+    };
+
+} // namespace KroubleUI
@@ -0,0 +1,452 @@
+#include "KroubleUI.h"
+#include <algorithm>
+#include <cmath>
+
+namespace KroubleUI {
+
+    namespace {
+        const float kTextPadding = 4.0f;
+        const double kScrollSmoothing = 18.0;   // 平滑滚动的收敛速度（每秒）
+        const int kWheelLines = 3;
+    }
+
+    LogViewer::LogViewer(Window* parent, const D2D1_RECT_F& rect)
+        : Control(parent, rect),
+        m_file(INVALID_HANDLE_VALUE),
+        m_mapping(nullptr),
+        m_mappedData(nullptr),
+        m_mappedSize(0),
+        m_indexing(false),
+        m_layoutWidth(0.0f),
+        m_scrollY(0.0),
+        m_targetScrollY(0.0),
+        m_lastScrollTime(0.0),
+        m_scrollTrack([this](double time) { return StepScroll(time); }),
+        m_lineHeight(18.0f),
+        m_followTail(true),
+        m_hasFocus(false),
+        m_textBrush(nullptr),
+        m_backgroundBrush(nullptr),
+        m_scrollBarBrush(nullptr),
+        m_textFormat(nullptr),
+        m_dwriteFactory(nullptr) {
+        Initialize(parent->GetRenderTarget(), parent->GetDWriteFactory());
+    }
+
+    LogViewer::~LogViewer() {
+        Clear();
+        ReleaseResource(&m_textBrush);
+        ReleaseResource(&m_backgroundBrush);
+        ReleaseResource(&m_scrollBarBrush);
+        ReleaseResource(&m_textFormat);
+    }
+
+    void LogViewer::Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory) {
+        // 创建画笔
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black), &m_textBrush);
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_backgroundBrush);
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Gray, 0.6f), &m_scrollBarBrush);
+        TrackResource(m_textBrush);
+        TrackResource(m_backgroundBrush);
+        TrackResource(m_scrollBarBrush);
+        m_dwriteFactory = dwriteFactory;
+
+        // 文本格式使用等宽字体且不换行，保证每行高度一致
+        TextFormatDesc desc;
+        desc.family = L"Consolas";
+        desc.wordWrapping = DWRITE_WORD_WRAPPING_NO_WRAP;
+        m_textFormat = m_parent->GetGraphicsContext()->GetTextFormat(desc);
+        TrackResource(m_textFormat);
+
+        if (m_textFormat) {
+            // 用一行样本文字测量行高
+            IDWriteTextLayout* probe = nullptr;
+            dwriteFactory->CreateTextLayout(L"Ag", 2, m_textFormat, 1000.0f, 1000.0f, &probe);
+            if (probe) {
+                DWRITE_TEXT_METRICS metrics;
+                if (SUCCEEDED(probe->GetMetrics(&metrics)) && metrics.height > 0) {
+                    m_lineHeight = std::ceil(metrics.height);
+                }
+                probe->Release();
+            }
+        }
+    }
+
+    void LogViewer::Draw(ID2D1RenderTarget* renderTarget) {
+        if (!m_visible) return;
+
+        CheckMappedFile();
+        ClampScrollTarget();
+
+        // 宽度变化后按新的宽度重新排版
+        float layoutWidth = (std::max)(0.0f, m_rect.right - m_rect.left - 2 * kTextPadding);
+        if (layoutWidth != m_layoutWidth) {
+            ReleaseAllLayouts();
+            m_layoutWidth = layoutWidth;
+        }
+
+        FillRectangle(renderTarget, m_rect, m_backgroundBrush);
+        PushClip(renderTarget, m_rect);
+
+        // 只处理落在可见区域内的行
+        size_t count = GetLineCount();
+        float viewHeight = m_rect.bottom - m_rect.top;
+        size_t first = static_cast<size_t>(m_scrollY / m_lineHeight);
+        size_t last = first;
+        float y = m_rect.top + static_cast<float>(first * static_cast<double>(m_lineHeight) - m_scrollY);
+
+        for (size_t line = first; line < count && y < m_rect.bottom; ++line, y += m_lineHeight) {
+            IDWriteTextLayout* layout = GetLineLayout(line);
+            if (layout) {
+                renderTarget->DrawTextLayout(D2D1::Point2F(m_rect.left + kTextPadding, y), layout, m_textBrush);
+                // 缓存的布局不保留文字，有观察者时重新解码
+                if (HasDrawObservers()) {
+                    size_t begin = 0, end = 0;
+                    m_buffer.GetLineRange(line, &begin, &end);
+                    DecodeLine(begin, end);
+                    NotifyText(renderTarget, m_lineBuffer.c_str(), static_cast<UINT32>(m_lineBuffer.size()), m_textFormat,
+                        D2D1::RectF(m_rect.left + kTextPadding, y, m_rect.right - kTextPadding, y + m_lineHeight),
+                        m_textBrush->GetColor());
+                }
+            }
+            last = line;
+        }
+
+        // 保留上下各一屏的布局，小幅滚动时无需重新排版
+        size_t margin = static_cast<size_t>(viewHeight / m_lineHeight) + 1;
+        ReleaseLayouts(first > margin ? first - margin : 0, last + margin);
+
+        // 滚动条
+        double contentHeight = count * static_cast<double>(m_lineHeight);
+        if (contentHeight > viewHeight) {
+            float thumbHeight = (std::max)(20.0f, static_cast<float>(viewHeight * viewHeight / contentHeight));
+            double maxScroll = GetMaxScroll();
+            float thumbTop = m_rect.top + static_cast<float>((viewHeight - thumbHeight) * (maxScroll > 0 ? m_scrollY / maxScroll : 0.0));
+            FillRectangle(renderTarget,
+                D2D1::RectF(m_rect.right - 6.0f, thumbTop, m_rect.right - 2.0f, thumbTop + thumbHeight),
+                m_scrollBarBrush);
+        }
+
+        PopClip(renderTarget);
+    }
+
+    void LogViewer::OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) {
+        switch (message) {
+        case WM_LBUTTONDOWN: {
+            bool focused = HitTest(static_cast<float>(GET_X_LPARAM(lParam)), static_cast<float>(GET_Y_LPARAM(lParam)));
+            if (focused != m_hasFocus) {
+                m_hasFocus = focused;
+                m_focusChanged.Emit(focused);
+            }
+            break;
+        }
+
+        case WM_MOUSEWHEEL: {
+            double notches = GET_WHEEL_DELTA_WPARAM(wParam) / static_cast<double>(WHEEL_DELTA);
+            ScrollBy(-notches * kWheelLines * m_lineHeight);
+            break;
+        }
+        }
+    }
+
+    void LogViewer::OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) {
+        if (!m_hasFocus || message != WM_KEYDOWN) return;
+
+        double page = (std::max)(static_cast<double>(m_lineHeight), m_rect.bottom - m_rect.top - static_cast<double>(m_lineHeight));
+        switch (wParam) {
+        case VK_UP:    ScrollBy(-m_lineHeight); break;
+        case VK_DOWN:  ScrollBy(m_lineHeight); break;
+        case VK_PRIOR: ScrollBy(-page); break;
+        case VK_NEXT:  ScrollBy(page); break;
+        case VK_HOME:  ScrollToLine(0); break;
+        case VK_END:   SetFollowTail(true); break;
+        }
+    }
+
+    size_t LogViewer::GetCpuBytes() const {
+        // 映射的文件内容由系统缓存，不计入
+        size_t bytes = sizeof(LogViewer) - sizeof(LogBuffer) + m_buffer.GetCpuBytes();
+        bytes += m_layoutCache.size() * (sizeof(size_t) + sizeof(CachedLine) + 2 * sizeof(void*));
+        bytes += m_lineBuffer.capacity() * sizeof(wchar_t);
+        return bytes;
+    }
+
+    void LogViewer::AppendText(const char* utf8, size_t length) {
+        if (length == 0) return;
+
+        m_buffer.Append(utf8, length);
+        StartIndexing();
+        if (m_followTail) {
+            SetScrollTarget(GetMaxScroll());
+        }
+        Invalidate();
+    }
+
+    void LogViewer::AppendText(const std::wstring& text) {
+        if (text.empty()) return;
+
+        int bytes = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+        if (bytes <= 0) return;
+
+        std::string utf8(bytes, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), &utf8[0], bytes, nullptr, nullptr);
+        AppendText(utf8.data(), utf8.size());
+    }
+
+    bool LogViewer::OpenFile(const std::wstring& path) {
+        Clear();
+
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            return false;
+        }
+        m_file = file;
+
+        // 空文件无法创建映射，当作空内容处理
+        if (size.QuadPart > 0) {
+            m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping) {
+                m_mappedData = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+            }
+        }
+
+        if (size.QuadPart > 0 && !m_mappedData) {
+            CloseFile();
+            return false;
+        }
+        m_mappedSize = static_cast<size_t>(size.QuadPart);
+        m_buffer.SetExternalData(m_mappedData, m_mappedSize);
+        StartIndexing();
+        return true;
+    }
+
+    void LogViewer::Clear() {
+        StopIndexing();
+        ReleaseAllLayouts();
+        // 先清空存储，它引用着映射的内容
+        m_buffer.Clear();
+        CloseFile();
+        m_scrollTrack.Stop();
+        m_scrollY = 0.0;
+        m_targetScrollY = 0.0;
+        Invalidate();
+    }
+
+    size_t LogViewer::GetLineCount() const {
+        return m_buffer.GetLineCount();
+    }
+
+    void LogViewer::ScrollToLine(size_t line) {
+        SetScrollTarget((std::min)(line * static_cast<double>(m_lineHeight), GetMaxScroll()));
+        m_followTail = m_targetScrollY >= GetMaxScroll();
+        Invalidate();
+    }
+
+    void LogViewer::SetFollowTail(bool follow) {
+        m_followTail = follow;
+        if (follow) {
+            SetScrollTarget(GetMaxScroll());
+        }
+        Invalidate();
+    }
+
+    void LogViewer::SetTextColor(const D2D1_COLOR_F& color) {
+        if (m_textBrush) {
+            m_textBrush->SetColor(color);
+        }
+        Invalidate();
+    }
+
+    void LogViewer::SetBackgroundColor(const D2D1_COLOR_F& color) {
+        if (m_backgroundBrush) {
+            m_backgroundBrush->SetColor(color);
+        }
+        Invalidate();
+    }
+
+    IDWriteTextLayout* LogViewer::GetLineLayout(size_t line) {
+        size_t begin = 0, end = 0;
+        m_buffer.GetLineRange(line, &begin, &end);
+
+        // 最后一行在追加时可能变长，长度不一致时重新排版
+        auto it = m_layoutCache.find(line);
+        if (it != m_layoutCache.end()) {
+            if (it->second.length == end - begin) {
+                return it->second.layout;
+            }
+            ReleaseResource(&it->second.layout);
+            m_layoutCache.erase(it);
+        }
+
+        if (!m_dwriteFactory || !m_textFormat) return nullptr;
+
+        DecodeLine(begin, end);
+        IDWriteTextLayout* layout = nullptr;
+        m_dwriteFactory->CreateTextLayout(
+            m_lineBuffer.c_str(),
+            static_cast<UINT32>(m_lineBuffer.size()),
+            m_textFormat,
+            m_layoutWidth,
+            m_lineHeight,
+            &layout
+        );
+        TrackResource(layout);
+
+        CachedLine cached = { layout, end - begin };
+        m_layoutCache[line] = cached;
+        return layout;
+    }
+
+    void LogViewer::DecodeLine(size_t begin, size_t end) {
+        m_lineBuffer.clear();
+        if (end > begin) {
+            const char* bytes = m_buffer.ReadBytes(begin, end);
+            int length = static_cast<int>(end - begin);
+            int chars = MultiByteToWideChar(CP_UTF8, 0, bytes, length, nullptr, 0);
+            if (chars > 0) {
+                m_lineBuffer.resize(chars);
+                MultiByteToWideChar(CP_UTF8, 0, bytes, length, &m_lineBuffer[0], chars);
+            }
+            if (!m_lineBuffer.empty() && m_lineBuffer.back() == L'\r') {
+                m_lineBuffer.pop_back();
+            }
+        }
+    }
+
+    void LogViewer::ReleaseLayouts(size_t firstKept, size_t lastKept) {
+        for (auto it = m_layoutCache.begin(); it != m_layoutCache.end();) {
+            if (it->first < firstKept || it->first > lastKept) {
+                ReleaseResource(&it->second.layout);
+                it = m_layoutCache.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    void LogViewer::ReleaseAllLayouts() {
+        for (auto& entry : m_layoutCache) {
+            ReleaseResource(&entry.second.layout);
+        }
+        m_layoutCache.clear();
+    }
+
+    void LogViewer::CloseFile() {
+        if (m_mappedData) {
+            UnmapViewOfFile(m_mappedData);
+            m_mappedData = nullptr;
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+        m_mappedSize = 0;
+    }
+
+    bool LogViewer::CheckMappedFile() {
+        if (!m_mappedData) return true;
+
+        // 其他进程以共享写方式打开了文件；映射中超出文件末尾的页在读取时会产生页错误
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(m_file, &size) && static_cast<UINT64>(size.QuadPart) >= m_mappedSize) {
+            return true;
+        }
+        // 文件被截短（如日志轮转）后不再显示映射的内容，追加的文本一并清除
+        Clear();
+        return false;
+    }
+
+    void LogViewer::StartIndexing() {
+        if (m_indexing || m_buffer.IsIndexed()) return;
+
+        // 定时器消息的优先级低于输入和绘制，索引期间界面仍能响应；定时器标识使用控件地址
+        HWND hwnd = m_parent->GetHwnd();
+        m_indexing = hwnd && SetTimer(hwnd, reinterpret_cast<UINT_PTR>(this), USER_TIMER_MINIMUM, &LogViewer::IndexTimerProc);
+        if (!m_indexing) {
+            m_buffer.IndexPending(m_buffer.GetTotalSize());
+        }
+    }
+
+    void LogViewer::StopIndexing() {
+        if (!m_indexing) return;
+        KillTimer(m_parent->GetHwnd(), reinterpret_cast<UINT_PTR>(this));
+        m_indexing = false;
+    }
+
+    void CALLBACK LogViewer::IndexTimerProc(HWND hwnd, UINT message, UINT_PTR id, DWORD time) {
+        reinterpret_cast<LogViewer*>(id)->IndexStep();
+    }
+
+    void LogViewer::IndexStep() {
+        if (!CheckMappedFile()) return;
+
+        m_buffer.IndexPending(kIndexBudget);
+        if (m_buffer.IsIndexed()) {
+            StopIndexing();
+        }
+        if (m_followTail) {
+            SetScrollTarget(GetMaxScroll());
+        }
+        Invalidate();
+    }
+
+    double LogViewer::GetMaxScroll() const {
+        double contentHeight = GetLineCount() * static_cast<double>(m_lineHeight);
+        return (std::max)(0.0, contentHeight - (m_rect.bottom - m_rect.top));
+    }
+
+    void LogViewer::ScrollBy(double delta) {
+        double maxScroll = GetMaxScroll();
+        SetScrollTarget((std::min)((std::max)(m_targetScrollY + delta, 0.0), maxScroll));
+        // 手动滚回底部时恢复跟随
+        m_followTail = m_targetScrollY >= maxScroll;
+        Invalidate();
+    }
+
+    void LogViewer::SetScrollTarget(double target) {
+        AnimationScheduler* scheduler = m_parent->GetAnimationScheduler();
+        if (!m_scrollTrack.IsAnimating()) {
+            m_lastScrollTime = scheduler->Now();
+        }
+        m_targetScrollY = target;
+        if (m_scrollY != m_targetScrollY) {
+            scheduler->Start(&m_scrollTrack);
+        }
+    }
+
+    void LogViewer::ClampScrollTarget() {
+        // 控件大小可能在两帧之间改变
+        double maxScroll = GetMaxScroll();
+        SetScrollTarget(m_followTail ? maxScroll : (std::min)(m_targetScrollY, maxScroll));
+    }
+
+    bool LogViewer::StepScroll(double time) {
+        double elapsed = (std::min)((std::max)(time - m_lastScrollTime, 0.0), 0.1);
+        m_lastScrollTime = time;
+
+        // 按帧间隔指数逼近目标位置；跨度超过几屏时直接跳转
+        double distance = m_targetScrollY - m_scrollY;
+        double viewHeight = m_rect.bottom - m_rect.top;
+        if (std::fabs(distance) < 0.5 || std::fabs(distance) > 4 * viewHeight) {
+            m_scrollY = m_targetScrollY;
+        }
+        else {
+            m_scrollY += distance * (1.0 - std::exp(-elapsed * kScrollSmoothing));
+        }
+        Invalidate();
+        return m_scrollY != m_targetScrollY;
+    }
+
+} // namespace KroubleUI
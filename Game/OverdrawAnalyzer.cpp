@@ -0,0 +1,149 @@
+#include "KroubleUI.h"
+#include <algorithm>
+
+namespace KroubleUI {
+
+    namespace {
+        const float kHeatmapAlpha = 0.45f;
+
+        // 预乘 alpha 的 BGRA 像素
+        UINT32 HeatmapColor(UINT32 rgb) {
+            UINT32 a = static_cast<UINT32>(kHeatmapAlpha * 255.0f);
+            UINT32 r = ((rgb >> 16) & 0xFF) * a / 255;
+            UINT32 g = ((rgb >> 8) & 0xFF) * a / 255;
+            UINT32 b = (rgb & 0xFF) * a / 255;
+            return (a << 24) | (r << 16) | (g << 8) | b;
+        }
+
+        ViewRect ToViewRect(const D2D1_RECT_F& rect) {
+            ViewRect result = { rect.left, rect.top, rect.right, rect.bottom };
+            return result;
+        }
+    }
+
+    OverdrawAnalyzer::OverdrawAnalyzer(Window* window)
+        : m_window(window),
+        m_target(nullptr),
+        m_targetTransform(D2D1::Matrix3x2F::Identity()),
+        m_pixelScale(1.0f),
+        m_heatmapEnabled(false),
+        m_heatmap(nullptr),
+        m_heatmapOwner(nullptr),
+        m_heatmapSize(D2D1::SizeU()) {
+        m_window->AddDrawObserver(this);
+    }
+
+    OverdrawAnalyzer::~OverdrawAnalyzer() {
+        m_window->RemoveDrawObserver(this);
+        SafeRelease(&m_heatmap);
+    }
+
+    void OverdrawAnalyzer::SetHeatmapEnabled(bool enabled) {
+        if (m_heatmapEnabled == enabled) return;
+        m_heatmapEnabled = enabled;
+        // 叠加层只画在失效区域内，开关时整个窗口重绘，避免留下上一次的叠加像素
+        m_window->Invalidate();
+    }
+
+    void OverdrawAnalyzer::OnBeginFrame(ID2D1RenderTarget* target, const D2D1_RECT_F& damage) {
+        m_target = target;
+        target->GetTransform(&m_targetTransform);
+
+        D2D1_SIZE_U pixels = target->GetPixelSize();
+        D2D1_SIZE_F size = target->GetSize();
+        m_pixelScale = size.width > 0 ? pixels.width / size.width : 1.0f;
+
+        ViewRect damagePixels = {
+            damage.left * m_pixelScale, damage.top * m_pixelScale,
+            damage.right * m_pixelScale, damage.bottom * m_pixelScale
+        };
+        m_counter.BeginFrame(pixels.width, pixels.height, damagePixels);
+    }
+
+    void OverdrawAnalyzer::OnFillRect(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color) {
+        // 离屏目标上的填充不会直接出现在窗口上
+        if (target != m_target) return;
+        m_counter.Fill(control, ToViewRect(rect), GetPixelTransform(target), color.a >= 1.0f);
+    }
+
+    void OverdrawAnalyzer::OnPushClip(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect) {
+        if (target != m_target) return;
+        m_counter.PushClip(ToViewRect(rect), GetPixelTransform(target));
+    }
+
+    void OverdrawAnalyzer::OnPopClip(ID2D1RenderTarget* target, const Control* control) {
+        if (target != m_target) return;
+        m_counter.PopClip();
+    }
+
+    void OverdrawAnalyzer::OnPushLayer(ID2D1RenderTarget* target, const Control* control, float opacity) {
+        if (target != m_target) return;
+        m_counter.PushLayer(opacity);
+    }
+
+    void OverdrawAnalyzer::OnPopLayer(ID2D1RenderTarget* target, const Control* control) {
+        if (target != m_target) return;
+        m_counter.PopLayer();
+    }
+
+    void OverdrawAnalyzer::OnEndFrame(ID2D1RenderTarget* target) {
+        if (target != m_target) return;
+
+        m_counter.EndFrame(&m_stats);
+        if (m_heatmapEnabled) {
+            DrawHeatmap(target);
+        }
+    }
+
+    Transform2D OverdrawAnalyzer::GetPixelTransform(ID2D1RenderTarget* target) const {
+        // 目标的当前变换再换算到物理像素
+        D2D1_MATRIX_3X2_F m;
+        target->GetTransform(&m);
+        Transform2D transform = {
+            m._11 * m_pixelScale, m._12 * m_pixelScale,
+            m._21 * m_pixelScale, m._22 * m_pixelScale,
+            m._31 * m_pixelScale, m._32 * m_pixelScale
+        };
+        return transform;
+    }
+
+    void OverdrawAnalyzer::DrawHeatmap(ID2D1RenderTarget* target) {
+        UINT32 width = m_counter.GetWidth();
+        UINT32 height = m_counter.GetHeight();
+        if (width == 0 || height == 0) return;
+
+        // 位图属于具体的渲染目标，目标或尺寸变化时重新创建
+        if (!m_heatmap || m_heatmapOwner != target ||
+            m_heatmapSize.width != width || m_heatmapSize.height != height) {
+            SafeRelease(&m_heatmap);
+            m_heatmapSize = D2D1::SizeU(width, height);
+            target->CreateBitmap(m_heatmapSize,
+                D2D1::BitmapProperties(D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED)),
+                &m_heatmap);
+            m_heatmapOwner = target;
+            if (!m_heatmap) return;
+        }
+
+        // 只填充一次不着色；之后依次为蓝、绿、粉、红
+        static const UINT32 palette[] = {
+            0, 0, HeatmapColor(0x3060FF), HeatmapColor(0x30C030), HeatmapColor(0xFF70C0), HeatmapColor(0xFF2020)
+        };
+        const UINT16 maxLevel = sizeof(palette) / sizeof(palette[0]) - 1;
+
+        const std::vector<UINT16>& depth = m_counter.GetDepth();
+        m_heatmapPixels.resize(depth.size());
+        for (size_t i = 0; i < depth.size(); ++i) {
+            m_heatmapPixels[i] = palette[(std::min)(depth[i], maxLevel)];
+        }
+        m_heatmap->CopyFromMemory(nullptr, m_heatmapPixels.data(), width * sizeof(UINT32));
+
+        D2D1_MATRIX_3X2_F transform;
+        target->GetTransform(&transform);
+        target->SetTransform(m_targetTransform);
+        D2D1_SIZE_F size = target->GetSize();
+        target->DrawBitmap(m_heatmap, D2D1::RectF(0, 0, size.width, size.height), 1.0f,
+            D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR);
+        target->SetTransform(transform);
+    }
+
+} // namespace KroubleUI
@@ -0,0 +1,150 @@
+#include "OverdrawCounter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace KroubleUI {
+
+    OverdrawCounter::OverdrawCounter()
+        : m_width(0),
+        m_height(0),
+        m_damage(),
+        m_rejectedFills(0) {
+    }
+
+    OverdrawCounter::PixelBox OverdrawCounter::ToPixels(const ViewRect& rect) const {
+        // 按像素中心取整，并限制在表面之内
+        auto clamp = [](float value, uint32_t limit) {
+            return static_cast<int32_t>((std::min)((std::max)(std::lround(value), 0L), static_cast<long>(limit)));
+        };
+        PixelBox box = {
+            clamp((std::min)(rect.left, rect.right), m_width), clamp((std::min)(rect.top, rect.bottom), m_height),
+            clamp((std::max)(rect.left, rect.right), m_width), clamp((std::max)(rect.top, rect.bottom), m_height)
+        };
+        return box;
+    }
+
+    void OverdrawCounter::BeginFrame(uint32_t width, uint32_t height, const ViewRect& damage) {
+        m_width = width;
+        m_height = height;
+        m_depth.assign(static_cast<size_t>(m_width) * m_height, 0);
+        m_owner.assign(static_cast<size_t>(m_width) * m_height, 0);
+
+        ControlCoverage background = { nullptr, 0, 0, false };
+        m_coverage.assign(1, background);
+        m_controlIds.clear();
+        m_rejectedFills = 0;
+
+        // 窗口在失效区域的裁剪下绘制，其外的填充不会落到屏幕上
+        m_damage = ToPixels(damage);
+        m_clips.assign(1, m_damage);
+        m_layers.assign(1, 1.0f);
+    }
+
+    void OverdrawCounter::PushClip(const ViewRect& rect, const Transform2D& transform) {
+        PixelBox box = ToPixels(transform.TransformBounds(rect));
+        const PixelBox& outer = m_clips.back();
+        box.left = (std::max)(box.left, outer.left);
+        box.top = (std::max)(box.top, outer.top);
+        box.right = (std::max)(box.left, (std::min)(box.right, outer.right));
+        box.bottom = (std::max)(box.top, (std::min)(box.bottom, outer.bottom));
+        m_clips.push_back(box);
+    }
+
+    void OverdrawCounter::PopClip() {
+        // 栈底的失效区域不出栈，多余的 Pop 忽略
+        if (m_clips.size() > 1) {
+            m_clips.pop_back();
+        }
+    }
+
+    void OverdrawCounter::PushLayer(float opacity) {
+        m_layers.push_back(m_layers.back() * opacity);
+    }
+
+    void OverdrawCounter::PopLayer() {
+        if (m_layers.size() > 1) {
+            m_layers.pop_back();
+        }
+    }
+
+    bool OverdrawCounter::Fill(const Control* control, const ViewRect& rect, const Transform2D& transform, bool opaque) {
+        if (m_width == 0 || m_height == 0) return true;
+
+        // 旋转或斜切后的矩形按外接矩形计数会把没有画到的像素算进去，宁可不计
+        if (!transform.IsAxisAligned()) {
+            ++m_rejectedFills;
+            return false;
+        }
+
+        PixelBox box = ToPixels(transform.TransformBounds(rect));
+        const PixelBox& clip = m_clips.back();
+        int32_t left = (std::max)(box.left, clip.left);
+        int32_t top = (std::max)(box.top, clip.top);
+        int32_t right = (std::min)(box.right, clip.right);
+        int32_t bottom = (std::min)(box.bottom, clip.bottom);
+        if (left >= right || top >= bottom) return true;
+
+        opaque = opaque && m_layers.back() >= 1.0f;
+        uint16_t id = GetControlId(control);
+        for (int32_t y = top; y < bottom; ++y) {
+            size_t row = static_cast<size_t>(y) * m_width;
+            for (int32_t x = left; x < right; ++x) {
+                uint16_t& depth = m_depth[row + x];
+                if (depth < 0xFFFF) ++depth;
+                if (opaque) m_owner[row + x] = id;
+            }
+        }
+
+        ControlCoverage& coverage = m_coverage[id];
+        coverage.paintedPixels += static_cast<uint64_t>(right - left) * (bottom - top);
+        coverage.hasOpaqueFill = coverage.hasOpaqueFill || opaque;
+        return true;
+    }
+
+    void OverdrawCounter::EndFrame(OverdrawStats* result) {
+        OverdrawStats stats;
+        stats.damagedPixels = static_cast<uint64_t>(m_damage.right - m_damage.left) * (m_damage.bottom - m_damage.top);
+        stats.rejectedFills = m_rejectedFills;
+
+        for (size_t i = 0; i < m_depth.size(); ++i) {
+            if (m_depth[i] == 0) continue;
+            ++stats.coveredPixels;
+            stats.maxDepth = (std::max)(stats.maxDepth, static_cast<uint32_t>(m_depth[i]));
+            ++m_coverage[m_owner[i]].visiblePixels;
+        }
+
+        for (const ControlCoverage& coverage : m_coverage) {
+            stats.paintedPixels += coverage.paintedPixels;
+        }
+        stats.overdrawRatio = stats.coveredPixels > 0
+            ? static_cast<double>(stats.paintedPixels) / stats.coveredPixels : 0.0;
+
+        // 编号 0 是窗口背景，不计入控件列表
+        stats.controls.assign(m_coverage.begin() + 1, m_coverage.end());
+        std::sort(stats.controls.begin(), stats.controls.end(),
+            [](const ControlCoverage& a, const ControlCoverage& b) { return a.paintedPixels > b.paintedPixels; });
+        for (const ControlCoverage& coverage : stats.controls) {
+            if (coverage.hasOpaqueFill && coverage.visiblePixels == 0) {
+                stats.occludedControls.push_back(coverage.control);
+            }
+        }
+        *result = std::move(stats);
+    }
+
+    uint16_t OverdrawCounter::GetControlId(const Control* control) {
+        if (!control) return 0;
+
+        auto it = m_controlIds.find(control);
+        if (it != m_controlIds.end()) return it->second;
+
+        // 编号用完时归入背景
+        if (m_coverage.size() >= 0xFFFF) return 0;
+
+        uint16_t id = static_cast<uint16_t>(m_coverage.size());
+        ControlCoverage coverage = { control, 0, 0, false };
+        m_coverage.push_back(coverage);
+        m_controlIds[control] = id;
+        return id;
+    }
+
+} // namespace KroubleUI
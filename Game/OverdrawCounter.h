@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Geometry.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace KroubleUI {
+
+    class Control;
+
+    // 单个控件在一帧中的填充统计（像素）
+    struct ControlCoverage {
+        const Control* control;
+        uint64_t paintedPixels;     // 累计填充的像素数（重复填充重复计数）
+        uint64_t visiblePixels;     // 帧结束时该控件的不透明填充仍处于最上层的像素数
+        bool hasOpaqueFill;         // 只有不透明填充才参与遮挡判断
+    };
+
+    // 一帧的重绘统计
+    struct OverdrawStats {
+        uint64_t paintedPixels = 0; // 所有填充累计的像素数
+        uint64_t coveredPixels = 0; // 至少被填充过一次的像素数
+        uint64_t damagedPixels = 0; // 本帧需要重绘的区域
+        uint32_t maxDepth = 0;      // 单个像素被填充的最多次数
+        uint32_t rejectedFills = 0; // 变换不是轴对齐的填充，无法逐像素统计，没有计入
+        double overdrawRatio = 0.0; // paintedPixels / coveredPixels
+        std::vector<ControlCoverage> controls;          // 按填充面积从大到小排序
+        std::vector<const Control*> occludedControls;   // 有填充但完全被遮挡的控件
+    };
+
+    // 逐像素统计填充次数，不依赖 Direct2D，坐标和变换都以像素为单位
+    // 填充被裁剪到当前的裁剪栈内，栈底为本帧的失效区域
+    class OverdrawCounter {
+    private:
+        struct PixelBox {
+            int32_t left, top, right, bottom;
+        };
+
+        uint32_t m_width, m_height;
+        std::vector<uint16_t> m_depth;      // 每个像素被填充的次数
+        std::vector<uint16_t> m_owner;      // 每个像素最上层不透明填充的来源编号，0 为窗口背景
+        std::vector<ControlCoverage> m_coverage;   // 按来源编号索引，0 为窗口背景
+        std::unordered_map<const Control*, uint16_t> m_controlIds;
+        std::vector<PixelBox> m_clips;      // 每一层都已与下一层求交
+        std::vector<float> m_layers;        // 每一层都已乘上下一层的不透明度，栈底为 1
+        PixelBox m_damage;
+        uint32_t m_rejectedFills;
+
+        PixelBox ToPixels(const ViewRect& rect) const;
+        uint16_t GetControlId(const Control* control);
+
+    public:
+        OverdrawCounter();
+
+        void BeginFrame(uint32_t width, uint32_t height, const ViewRect& damage);
+        // 轴对齐裁剪与 Direct2D 相同：变换不是轴对齐时使用变换后的外接矩形
+        void PushClip(const ViewRect& rect, const Transform2D& transform);
+        void PopClip();
+        // 半透明图层内的填充即使本身不透明也透出下面的内容，不参与遮挡判断
+        void PushLayer(float opacity);
+        void PopLayer();
+        // control 为空表示窗口背景；变换不是轴对齐时不统计，返回 false
+        bool Fill(const Control* control, const ViewRect& rect, const Transform2D& transform, bool opaque);
+        void EndFrame(OverdrawStats* stats);
+
+        uint32_t GetWidth() const { return m_width; }
+        uint32_t GetHeight() const { return m_height; }
+        // 每个像素被填充的次数，按行存放
+        const std::vector<uint16_t>& GetDepth() const { return m_depth; }
+    };
+
+} // namespace KroubleUI
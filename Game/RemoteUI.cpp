@@ -0,0 +1,819 @@
+#include "KroubleUI.h"
+#include <cmath>
+#include <cstring>
+
+namespace KroubleUI {
+
+    namespace {
+        const UINT32 kMaxMessageBytes = 64 << 20;   // 单条消息的上限，超出视为数据错误
+        const size_t kMaxQueuedBytes = 8 << 20;     // 查看端跟不上时最多积压的字节数
+
+        // 套接字上的消息：1 字节类型 + 4 字节长度（小端）+ 内容
+        const UINT8 kFrameMessage = 1;
+        const UINT8 kInputMessage = 2;
+
+        void WriteByte(std::string& out, UINT8 value) {
+            out.push_back(static_cast<char>(value));
+        }
+
+        UINT32 PackColor(const D2D1_COLOR_F& color) {
+            auto channel = [](float value) {
+                return static_cast<UINT32>(std::lround((std::max)(0.0f, (std::min)(value, 1.0f)) * 255.0f));
+            };
+            return channel(color.r) | channel(color.g) << 8 | channel(color.b) << 16 | channel(color.a) << 24;
+        }
+
+        D2D1_COLOR_F UnpackColor(UINT32 packed) {
+            return D2D1::ColorF(
+                (packed & 0xFF) / 255.0f,
+                ((packed >> 8) & 0xFF) / 255.0f,
+                ((packed >> 16) & 0xFF) / 255.0f,
+                ((packed >> 24) & 0xFF) / 255.0f);
+        }
+
+        ViewRect ToViewRect(const D2D1_RECT_F& rect) {
+            ViewRect result = { rect.left, rect.top, rect.right, rect.bottom };
+            return result;
+        }
+
+        D2D1_RECT_F ToRect(const ViewRect& rect) {
+            return D2D1::RectF(rect.left, rect.top, rect.right, rect.bottom);
+        }
+
+        // 命令流中的文本格式句柄是 IDWriteTextFormat*
+        IDWriteTextFormat* ToFormat(const void* format) {
+            return static_cast<IDWriteTextFormat*>(const_cast<void*>(format));
+        }
+
+        void RetainFormat(const void* format) {
+            ToFormat(format)->AddRef();
+        }
+
+        void ReleaseFormat(const void* format) {
+            ToFormat(format)->Release();
+        }
+
+        void DescribeFormat(const void* handle, DrawTextFormat* desc) {
+            IDWriteTextFormat* format = ToFormat(handle);
+            desc->family.assign(format->GetFontFamilyNameLength() + 1, L'\0');
+            format->GetFontFamilyName(&desc->family[0], static_cast<UINT32>(desc->family.size()));
+            desc->family.resize(wcslen(desc->family.c_str()));
+            desc->locale.assign(format->GetLocaleNameLength() + 1, L'\0');
+            format->GetLocaleName(&desc->locale[0], static_cast<UINT32>(desc->locale.size()));
+            desc->locale.resize(wcslen(desc->locale.c_str()));
+            desc->size = format->GetFontSize();
+            desc->weight = format->GetFontWeight();
+            desc->style = format->GetFontStyle();
+            desc->textAlignment = format->GetTextAlignment();
+            desc->paragraphAlignment = format->GetParagraphAlignment();
+            desc->wordWrapping = format->GetWordWrapping();
+        }
+
+        DrawFormatPolicy GetFormatPolicy() {
+            DrawFormatPolicy policy;
+            policy.retain = RetainFormat;
+            policy.release = ReleaseFormat;
+            policy.describe = DescribeFormat;
+            return policy;
+        }
+
+        // WSAStartup 按调用次数计数，每次成功都要对应一次 WSACleanup
+        bool StartWinsock() {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }
+
+        void DisableNagle(SOCKET socket) {
+            // 帧和输入事件都很小，立即发送
+            BOOL enabled = TRUE;
+            setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enabled), sizeof(enabled));
+        }
+
+        bool SendAll(SOCKET socket, const char* data, size_t size) {
+            while (size > 0) {
+                int sent = send(socket, data, static_cast<int>((std::min)(size, size_t(1) << 20)), 0);
+                if (sent <= 0) return false;
+                data += sent;
+                size -= sent;
+            }
+            return true;
+        }
+
+        bool ReceiveAll(SOCKET socket, char* data, size_t size) {
+            while (size > 0) {
+                int received = recv(socket, data, static_cast<int>((std::min)(size, size_t(1) << 20)), 0);
+                if (received <= 0) return false;
+                data += received;
+                size -= received;
+            }
+            return true;
+        }
+
+        std::string MakeMessage(UINT8 kind, const std::string& payload) {
+            std::string message;
+            message.reserve(5 + payload.size());
+            WriteByte(message, kind);
+            UINT32 length = static_cast<UINT32>(payload.size());
+            for (int i = 0; i < 4; ++i) {
+                WriteByte(message, static_cast<UINT8>(length >> (i * 8)));
+            }
+            message += payload;
+            return message;
+        }
+
+        bool ReceiveMessage(SOCKET socket, UINT8* kind, std::string* payload) {
+            unsigned char header[5];
+            if (!ReceiveAll(socket, reinterpret_cast<char*>(header), sizeof(header))) return false;
+
+            *kind = header[0];
+            UINT32 length = header[1] | header[2] << 8 | header[3] << 16 | static_cast<UINT32>(header[4]) << 24;
+            if (length > kMaxMessageBytes) return false;
+            payload->resize(length);
+            return length == 0 || ReceiveAll(socket, &(*payload)[0], length);
+        }
+    }
+
+    // ---- 编码 ----
+
+    // 只统计编码调用本身，控件在两次通知之间的实际绘制不计入
+    class DrawCommandEncoder::EncodeTimer {
+    private:
+        DrawCommandEncoder* m_encoder;
+        double m_start;
+
+    public:
+        explicit EncodeTimer(DrawCommandEncoder* encoder) : m_encoder(encoder), m_start(encoder->m_clock.Now()) {}
+        ~EncodeTimer() { m_encoder->m_writer.AddEncodeSeconds(m_encoder->m_clock.Now() - m_start); }
+    };
+
+    DrawCommandEncoder::DrawCommandEncoder()
+        : m_target(nullptr),
+        m_writer(GetFormatPolicy()) {
+    }
+
+    void DrawCommandEncoder::OnBeginFrame(ID2D1RenderTarget* target, const D2D1_RECT_F& damage) {
+        EncodeTimer timer(this);
+        m_target = target;
+        D2D1_SIZE_F size = target->GetSize();
+        m_writer.BeginFrame(static_cast<UINT32>(std::ceil(size.width)), static_cast<UINT32>(std::ceil(size.height)),
+            ToViewRect(damage));
+    }
+
+    bool DrawCommandEncoder::BeginCommand(ID2D1RenderTarget* target) {
+        // 离屏表面上的绘制不进入命令流
+        if (!m_target || target != m_target) return false;
+
+        D2D1_MATRIX_3X2_F matrix;
+        target->GetTransform(&matrix);
+        Transform2D transform = { matrix._11, matrix._12, matrix._21, matrix._22, matrix._31, matrix._32 };
+        m_writer.SetTransform(transform);
+        return true;
+    }
+
+    void DrawCommandEncoder::OnFillRect(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color) {
+        EncodeTimer timer(this);
+        if (!BeginCommand(target)) return;
+        m_writer.FillRectangle(PackColor(color), ToViewRect(rect));
+    }
+
+    void DrawCommandEncoder::OnDrawRect(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, float strokeWidth) {
+        EncodeTimer timer(this);
+        if (!BeginCommand(target)) return;
+        m_writer.DrawRectangle(PackColor(color), strokeWidth, ToViewRect(rect));
+    }
+
+    void DrawCommandEncoder::OnDrawLine(ID2D1RenderTarget* target, const Control* control, D2D1_POINT_2F from, D2D1_POINT_2F to, const D2D1_COLOR_F& color, float strokeWidth) {
+        EncodeTimer timer(this);
+        if (!BeginCommand(target)) return;
+        m_writer.DrawLine(PackColor(color), strokeWidth, from.x, from.y, to.x, to.y);
+    }
+
+    void DrawCommandEncoder::OnDrawText(ID2D1RenderTarget* target, const Control* control, const wchar_t* text, UINT32 length,
+        IDWriteTextFormat* format, const D2D1_RECT_F& rect, const D2D1_COLOR_F& color, D2D1_DRAW_TEXT_OPTIONS options) {
+        EncodeTimer timer(this);
+        if (!format || !BeginCommand(target)) return;
+        m_writer.DrawString(text, length, format, PackColor(color), options, ToViewRect(rect));
+    }
+
+    void DrawCommandEncoder::OnPushClip(ID2D1RenderTarget* target, const Control* control, const D2D1_RECT_F& rect) {
+        EncodeTimer timer(this);
+        if (!BeginCommand(target)) return;
+        m_writer.PushClip(ToViewRect(rect));
+    }
+
+    void DrawCommandEncoder::OnPopClip(ID2D1RenderTarget* target, const Control* control) {
+        EncodeTimer timer(this);
+        if (!BeginCommand(target)) return;
+        m_writer.PopClip();
+    }
+
+    void DrawCommandEncoder::OnPushLayer(ID2D1RenderTarget* target, const Control* control, float opacity) {
+        EncodeTimer timer(this);
+        if (!BeginCommand(target)) return;
+        m_writer.PushLayer(opacity);
+    }
+
+    void DrawCommandEncoder::OnPopLayer(ID2D1RenderTarget* target, const Control* control) {
+        EncodeTimer timer(this);
+        if (!BeginCommand(target)) return;
+        m_writer.PopLayer();
+    }
+
+    void DrawCommandEncoder::OnEndFrame(ID2D1RenderTarget* target) {
+        if (!m_target || target != m_target) return;
+
+        std::string* frame = nullptr;
+        {
+            EncodeTimer timer(this);
+            frame = &m_writer.EndFrame();
+            m_target = nullptr;
+        }
+
+        // 发送不计入编码耗时
+        if (m_onFrame) {
+            m_onFrame(*frame);
+        }
+    }
+
+    // ---- 回放 ----
+
+    // 把解码的命令画到渲染目标上；target 为空时只创建文本格式
+    class DrawCommandPlayer::Sink : public DrawCommandSink {
+    private:
+        DrawCommandPlayer* m_player;
+        ID2D1RenderTarget* m_target;
+        ID2D1SolidColorBrush* m_brush;
+        D2D1_RECT_F* m_damage;
+        std::vector<ID2D1Layer*> m_layers;
+
+    public:
+        Sink(DrawCommandPlayer* player, ID2D1RenderTarget* target, ID2D1SolidColorBrush* brush, D2D1_RECT_F* damage)
+            : m_player(player), m_target(target), m_brush(brush), m_damage(damage) {}
+
+        void OnResetTables() override {
+            m_player->ReleaseFormats();
+        }
+
+        void OnDefineFormat(const DrawTextFormat& format) override {
+            TextFormatDesc desc;
+            desc.family = format.family;
+            desc.size = format.size;
+            desc.weight = format.weight;
+            desc.style = format.style;
+            desc.textAlignment = format.textAlignment;
+            desc.paragraphAlignment = format.paragraphAlignment;
+            desc.wordWrapping = format.wordWrapping;
+            desc.locale = format.locale;
+            // 创建失败时保留空位，使用它的文字不绘制
+            m_player->m_formats.push_back(m_player->m_context->GetTextFormat(desc));
+        }
+
+        void OnBeginFrame(const ViewRect& damage) override {
+            if (m_damage) *m_damage = ToRect(damage);
+            if (m_target) m_target->PushAxisAlignedClip(ToRect(damage), D2D1_ANTIALIAS_MODE_ALIASED);
+        }
+
+        void OnSetTransform(const Transform2D& transform) override {
+            if (m_target) {
+                m_target->SetTransform(D2D1::Matrix3x2F(transform.m11, transform.m12, transform.m21, transform.m22,
+                    transform.dx, transform.dy));
+            }
+        }
+
+        void OnFillRectangle(uint32_t color, const ViewRect& rect) override {
+            if (!m_target) return;
+            m_brush->SetColor(UnpackColor(color));
+            m_target->FillRectangle(ToRect(rect), m_brush);
+        }
+
+        void OnDrawRectangle(uint32_t color, float strokeWidth, const ViewRect& rect) override {
+            if (!m_target) return;
+            m_brush->SetColor(UnpackColor(color));
+            m_target->DrawRectangle(ToRect(rect), m_brush, strokeWidth);
+        }
+
+        void OnDrawLine(uint32_t color, float strokeWidth, float x1, float y1, float x2, float y2) override {
+            if (!m_target) return;
+            m_brush->SetColor(UnpackColor(color));
+            m_target->DrawLine(D2D1::Point2F(x1, y1), D2D1::Point2F(x2, y2), m_brush, strokeWidth);
+        }
+
+        void OnDrawText(const std::wstring& text, size_t format, uint32_t color, uint32_t options, const ViewRect& rect) override {
+            if (!m_target || !m_player->m_formats[format]) return;
+            m_brush->SetColor(UnpackColor(color));
+            m_target->DrawTextW(text.c_str(), static_cast<UINT32>(text.size()), m_player->m_formats[format], ToRect(rect),
+                m_brush, static_cast<D2D1_DRAW_TEXT_OPTIONS>(options));
+        }
+
+        void OnPushClip(const ViewRect& rect) override {
+            if (m_target) m_target->PushAxisAlignedClip(ToRect(rect), D2D1_ANTIALIAS_MODE_ALIASED);
+        }
+
+        void OnPopClip() override {
+            if (m_target) m_target->PopAxisAlignedClip();
+        }
+
+        bool OnPushLayer(float opacity) override {
+            if (!m_target) return true;
+            ID2D1Layer* layer = nullptr;
+            if (FAILED(m_target->CreateLayer(nullptr, &layer))) return false;
+            m_target->PushLayer(
+                D2D1::LayerParameters(D2D1::InfiniteRect(), nullptr, D2D1_ANTIALIAS_MODE_PER_PRIMITIVE,
+                    D2D1::IdentityMatrix(), opacity),
+                layer);
+            m_layers.push_back(layer);
+            return true;
+        }
+
+        void OnPopLayer() override {
+            if (!m_target) return;
+            m_target->PopLayer();
+            m_layers.back()->Release();
+            m_layers.pop_back();
+        }
+    };
+
+    DrawCommandPlayer::DrawCommandPlayer(GraphicsContext* context) : m_context(context) {
+    }
+
+    DrawCommandPlayer::~DrawCommandPlayer() {
+        ReleaseFormats();
+    }
+
+    void DrawCommandPlayer::Reset() {
+        m_reader.Reset();
+        ReleaseFormats();
+    }
+
+    void DrawCommandPlayer::ReleaseFormats() {
+        for (IDWriteTextFormat*& format : m_formats) {
+            SafeRelease(&format);
+        }
+        m_formats.clear();
+    }
+
+    size_t DrawCommandPlayer::GetCpuBytes() const {
+        return sizeof(DrawCommandPlayer) + m_reader.GetCpuBytes() + m_formats.capacity() * sizeof(IDWriteTextFormat*);
+    }
+
+    bool DrawCommandPlayer::ReadFrameSize(const std::string& frame, D2D1_SIZE_U* size) {
+        return DrawCommandReader::ReadFrameSize(frame, &size->width, &size->height);
+    }
+
+    bool DrawCommandPlayer::Play(ID2D1RenderTarget* target, ID2D1SolidColorBrush* brush, const std::string& frame, D2D1_RECT_F* damage) {
+        Sink sink(this, target, brush, damage);
+        if (target) {
+            target->SetTransform(D2D1::IdentityMatrix());
+        }
+        bool ok = m_reader.Read(frame, &sink);
+        if (target) {
+            target->SetTransform(D2D1::IdentityMatrix());
+        }
+        return ok;
+    }
+
+    // ---- 服务端 ----
+
+    struct RemoteUIServer::Client {
+        SOCKET socket;
+
+        explicit Client(SOCKET s) : socket(s) {}
+        ~Client() { closesocket(socket); }
+    };
+
+    RemoteUIServer::RemoteUIServer(Window* window, unsigned short port)
+        : m_window(window),
+        m_self(std::make_shared<RemoteUIServer*>(this)),
+        m_listenSocket(INVALID_SOCKET),
+        m_port(0),
+        m_outgoing(kMaxQueuedBytes),
+        m_stopping(false) {
+        if (!StartWinsock()) {
+            throw std::runtime_error("Failed to initialize Winsock");
+        }
+
+        // 只监听本机回环地址
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int length = sizeof(address);
+
+        m_listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (m_listenSocket == INVALID_SOCKET ||
+            bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR ||
+            listen(m_listenSocket, 1) == SOCKET_ERROR ||
+            getsockname(m_listenSocket, reinterpret_cast<sockaddr*>(&address), &length) == SOCKET_ERROR) {
+            if (m_listenSocket != INVALID_SOCKET) {
+                closesocket(m_listenSocket);
+            }
+            WSACleanup();
+            throw std::runtime_error("Failed to listen for remote UI connections");
+        }
+        m_port = ntohs(address.sin_port);
+
+        m_encoder.SetFrameHandler([this](std::string& frame) { OnFrame(frame); });
+        m_acceptThread = std::thread(&RemoteUIServer::AcceptLoop, this);
+        m_sendThread = std::thread(&RemoteUIServer::SendLoop, this);
+    }
+
+    RemoteUIServer::~RemoteUIServer() {
+        *m_self = nullptr;
+        m_window->RemoveDrawObserver(&m_encoder);
+
+        std::shared_ptr<Client> client;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            client = m_client;
+            m_outgoing.Clear();
+        }
+        m_wake.notify_all();
+
+        // 关闭监听套接字让 accept 返回，关闭连接让接收线程返回
+        closesocket(m_listenSocket);
+        if (client) {
+            shutdown(client->socket, SD_BOTH);
+        }
+        m_acceptThread.join();
+        m_sendThread.join();
+        WSACleanup();
+    }
+
+    bool RemoteUIServer::IsConnected() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_client != nullptr;
+    }
+
+    void RemoteUIServer::AcceptLoop() {
+        std::shared_ptr<RemoteUIServer*> self = m_self;
+
+        for (;;) {
+            SOCKET socket = accept(m_listenSocket, nullptr, nullptr);
+            if (socket == INVALID_SOCKET) return;
+            DisableNagle(socket);
+
+            // 同一时间只服务一个查看端，新连接取代旧连接的发送队列
+            std::shared_ptr<Client> client = std::make_shared<Client>(socket);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_stopping) return;
+                m_client = client;
+                m_outgoing.Clear();
+            }
+            m_window->PostTask([self, client]() {
+                if (*self) (*self)->OnConnected(client);
+            });
+
+            UINT8 kind = 0;
+            std::string payload;
+            while (ReceiveMessage(socket, &kind, &payload)) {
+                if (kind != kInputMessage) continue;
+
+                StreamReader in(payload.data(), payload.size());
+                UINT message = static_cast<UINT>(in.ReadVarint());
+                WPARAM wParam = static_cast<WPARAM>(in.ReadVarint());
+                LPARAM lParam = static_cast<LPARAM>(in.ReadSigned());
+                if (!in.IsOk()) break;
+
+                m_window->PostTask([self, message, wParam, lParam]() {
+                    if (*self) (*self)->DispatchInput(message, wParam, lParam);
+                });
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_client == client) {
+                    m_client.reset();
+                    m_outgoing.Clear();
+                }
+            }
+            shutdown(socket, SD_BOTH);
+            m_window->PostTask([self, client]() {
+                if (*self) (*self)->OnDisconnected(client);
+            });
+        }
+    }
+
+    void RemoteUIServer::SendLoop() {
+        for (;;) {
+            std::string message;
+            std::shared_ptr<Client> client;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this]() { return m_stopping || !m_outgoing.IsEmpty(); });
+                if (m_stopping) return;
+                m_outgoing.Pop(&message);
+                client = m_client;
+            }
+
+            // 发送失败时关闭连接，接收线程会随之清理
+            if (client && !SendAll(client->socket, message.data(), message.size())) {
+                shutdown(client->socket, SD_BOTH);
+            }
+        }
+    }
+
+    void RemoteUIServer::OnConnected(std::shared_ptr<Client> client) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_client != client) return;
+        }
+
+        // 查看端从清空的编号表和完整的一帧开始
+        m_streamClient = client;
+        m_encoder.Reset();
+        m_window->RemoveDrawObserver(&m_encoder);
+        m_window->AddDrawObserver(&m_encoder);
+        m_window->Invalidate();
+    }
+
+    void RemoteUIServer::OnDisconnected(std::shared_ptr<Client> client) {
+        if (m_streamClient != client) return;
+
+        // 没有查看端时不再编码
+        m_streamClient.reset();
+        m_window->RemoveDrawObserver(&m_encoder);
+    }
+
+    void RemoteUIServer::OnFrame(std::string& frame) {
+        std::string message = MakeMessage(kFrameMessage, frame);
+        bool overflow = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_streamClient || m_client != m_streamClient) return;
+
+            // 查看端跟不上：丢弃积压的帧，从清空的编号表和完整的一帧重新开始
+            overflow = !m_outgoing.Push(std::move(message));
+        }
+
+        if (overflow) {
+            m_encoder.Reset();
+            m_window->Invalidate();
+        }
+        else {
+            m_wake.notify_one();
+        }
+    }
+
+    void RemoteUIServer::DispatchInput(UINT message, WPARAM wParam, LPARAM lParam) {
+        // 只接受查看端可能发送的消息
+        switch (message) {
+        case WM_MOUSEMOVE:
+        case WM_LBUTTONDOWN:
+        case WM_LBUTTONUP:
+        case WM_MOUSEWHEEL:
+        case WM_MOUSELEAVE:
+            m_window->OnMouseEvent(message, wParam, lParam);
+            break;
+
+        case WM_KEYDOWN:
+        case WM_KEYUP:
+        case WM_CHAR:
+            m_window->OnKeyboardEvent(message, wParam, lParam);
+            break;
+        }
+    }
+
+    // ---- 查看端 ----
+
+    struct RemoteView::Connection {
+        SOCKET socket;
+        RemoteView* owner;              // 只在界面线程上读写，断开时置空
+        std::atomic<bool> connected;
+        std::thread receiver;
+
+        Connection() : socket(INVALID_SOCKET), owner(nullptr), connected(true) {}
+    };
+
+    RemoteView::RemoteView(Window* parent, const D2D1_RECT_F& rect)
+        : Control(parent, rect),
+        m_player(parent->GetGraphicsContext()),
+        m_surface(nullptr),
+        m_surfaceSize(D2D1::SizeU(0, 0)),
+        m_receivedFrames(0),
+        m_receivedBytes(0),
+        m_hasFocus(false),
+        m_isHovered(false),
+        m_backgroundBrush(nullptr),
+        m_playerBrush(nullptr) {
+        Initialize(parent->GetRenderTarget(), parent->GetDWriteFactory());
+    }
+
+    RemoteView::~RemoteView() {
+        Disconnect();
+        ReleaseResource(&m_surface);
+        ReleaseResource(&m_backgroundBrush);
+        ReleaseResource(&m_playerBrush);
+    }
+
+    void RemoteView::Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory) {
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::DarkGray), &m_backgroundBrush);
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black), &m_playerBrush);
+        TrackResource(m_backgroundBrush);
+        TrackResource(m_playerBrush);
+    }
+
+    void RemoteView::Draw(ID2D1RenderTarget* renderTarget) {
+        if (!m_visible) return;
+
+        FillRectangle(renderTarget, m_rect, m_backgroundBrush);
+        if (!m_surface) return;
+
+        // 保留的远程画面，超出控件的部分裁掉
+        ID2D1Bitmap* bitmap = nullptr;
+        m_surface->GetBitmap(&bitmap);
+        if (bitmap) {
+            D2D1_RECT_F destination = D2D1::RectF(m_rect.left, m_rect.top,
+                m_rect.left + m_surfaceSize.width, m_rect.top + m_surfaceSize.height);
+            PushClip(renderTarget, m_rect);
+            renderTarget->DrawBitmap(bitmap, destination, 1.0f, D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR);
+            PopClip(renderTarget);
+            bitmap->Release();
+        }
+    }
+
+    void RemoteView::OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) {
+        // 换算成远程窗口的客户区坐标
+        int x = GET_X_LPARAM(lParam) - static_cast<int>(m_rect.left);
+        int y = GET_Y_LPARAM(lParam) - static_cast<int>(m_rect.top);
+
+        switch (message) {
+        case WM_LBUTTONDOWN: {
+            bool focused = HitTest(static_cast<float>(GET_X_LPARAM(lParam)), static_cast<float>(GET_Y_LPARAM(lParam)));
+            if (focused != m_hasFocus) {
+                m_hasFocus = focused;
+                m_focusChanged.Emit(focused);
+            }
+            SendInput(message, wParam, MAKELPARAM(x, y));
+            break;
+        }
+
+        case WM_MOUSEMOVE:
+            if (!m_isHovered) {
+                m_isHovered = true;
+                m_hoverChanged.Emit(true);
+            }
+            SendInput(message, wParam, MAKELPARAM(x, y));
+            break;
+
+        case WM_LBUTTONUP:
+        case WM_MOUSEWHEEL:
+            SendInput(message, wParam, MAKELPARAM(x, y));
+            break;
+
+        case WM_MOUSELEAVE:
+            // 窗口每次移动鼠标都会通知其他控件离开，只转发真正的离开
+            if (m_isHovered) {
+                m_isHovered = false;
+                SendInput(WM_MOUSELEAVE, 0, 0);
+                m_hoverChanged.Emit(false);
+            }
+            break;
+        }
+    }
+
+    void RemoteView::OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) {
+        if (!m_hasFocus) return;
+
+        if (message == WM_KEYDOWN || message == WM_KEYUP || message == WM_CHAR) {
+            SendInput(message, wParam, lParam);
+        }
+    }
+
+    size_t RemoteView::GetCpuBytes() const {
+        return sizeof(RemoteView) + m_player.GetCpuBytes();
+    }
+
+    bool RemoteView::Connect(const std::string& host, unsigned short port) {
+        Disconnect();
+        if (!StartWinsock()) return false;
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        SOCKET socket = INVALID_SOCKET;
+        if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1 ||
+            (socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) == INVALID_SOCKET ||
+            connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR) {
+            if (socket != INVALID_SOCKET) {
+                closesocket(socket);
+            }
+            WSACleanup();
+            return false;
+        }
+        DisableNagle(socket);
+
+        // 服务端会先发送清空编号表的完整一帧
+        m_player.Reset();
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>();
+        connection->socket = socket;
+        connection->owner = this;
+
+        Window* window = m_parent;
+        connection->receiver = std::thread([connection, window]() {
+            UINT8 kind = 0;
+            std::string payload;
+            while (ReceiveMessage(connection->socket, &kind, &payload)) {
+                if (kind != kFrameMessage) continue;
+
+                std::shared_ptr<std::string> frame = std::make_shared<std::string>();
+                frame->swap(payload);
+                window->PostTask([connection, frame]() {
+                    if (connection->owner) connection->owner->OnFrameReceived(*frame);
+                });
+            }
+            connection->connected = false;
+            window->PostTask([connection]() {
+                if (connection->owner) connection->owner->Invalidate();
+            });
+        });
+        m_connection = connection;
+        return true;
+    }
+
+    void RemoteView::Disconnect() {
+        if (!m_connection) return;
+
+        m_connection->owner = nullptr;
+        shutdown(m_connection->socket, SD_BOTH);
+        m_connection->receiver.join();
+        closesocket(m_connection->socket);
+        m_connection.reset();
+        WSACleanup();
+        Invalidate();
+    }
+
+    bool RemoteView::IsConnected() const {
+        return m_connection && m_connection->connected;
+    }
+
+    void RemoteView::OnFrameReceived(const std::string& frame) {
+        ++m_receivedFrames;
+        m_receivedBytes += frame.size();
+
+        D2D1_SIZE_U size;
+        if (!DrawCommandPlayer::ReadFrameSize(frame, &size)) {
+            Disconnect();
+            return;
+        }
+
+        // 没有可用的表面时也要回放，保持编号表与服务端一致
+        D2D1_RECT_F damage = D2D1::RectF(0, 0, 0, 0);
+        bool ok = false;
+        if (EnsureSurface(size)) {
+            m_surface->BeginDraw();
+            ok = m_player.Play(m_surface, m_playerBrush, frame, &damage);
+            m_surface->EndDraw();
+        }
+        else {
+            ok = m_player.Play(nullptr, nullptr, frame, &damage);
+        }
+
+        // 命令流出错后无法再与服务端保持同步
+        if (!ok) {
+            Disconnect();
+            return;
+        }
+        Invalidate(D2D1::RectF(m_rect.left + damage.left, m_rect.top + damage.top,
+            m_rect.left + damage.right, m_rect.top + damage.bottom));
+    }
+
+    bool RemoteView::EnsureSurface(const D2D1_SIZE_U& size) {
+        if (size.width == 0 || size.height == 0) return false;
+        if (m_surface && size.width == m_surfaceSize.width && size.height == m_surfaceSize.height) {
+            return true;
+        }
+
+        ReleaseResource(&m_surface);
+        ID2D1RenderTarget* renderTarget = m_parent->GetRenderTarget();
+        if (!renderTarget) return false;
+
+        D2D1_SIZE_F desired = D2D1::SizeF(static_cast<float>(size.width), static_cast<float>(size.height));
+        if (FAILED(renderTarget->CreateCompatibleRenderTarget(desired, &m_surface))) {
+            m_surface = nullptr;
+            return false;
+        }
+        TrackResource(m_surface);
+        m_surfaceSize = size;
+
+        // 服务端在尺寸变化时会整体重绘，这里先清成背景色
+        m_surface->BeginDraw();
+        m_surface->Clear(m_backgroundBrush->GetColor());
+        m_surface->EndDraw();
+        return true;
+    }
+
+    void RemoteView::SendInput(UINT message, WPARAM wParam, LPARAM lParam) {
+        if (!IsConnected()) return;
+
+        std::string payload;
+        WriteVarint(payload, message);
+        WriteVarint(payload, wParam);
+        WriteSigned(payload, lParam);
+        // 输入事件很小，直接在界面线程上发送
+        std::string data = MakeMessage(kInputMessage, payload);
+        SendAll(m_connection->socket, data.data(), data.size());
+    }
+
+} // namespace KroubleUI
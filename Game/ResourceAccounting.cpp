@@ -0,0 +1,40 @@
+#include "KroubleUI.h"
+
+namespace KroubleUI {
+
+    namespace {
+        // 无法直接查询的设备资源按经验值估算
+        const size_t kBrushBytes = 64;
+        const size_t kTextFormatBytes = 256;
+        const size_t kTextLayoutBytes = 1024;
+
+        size_t PixelBytes(D2D1_SIZE_U size) {
+            return static_cast<size_t>(size.width) * size.height * 4;
+        }
+    }
+
+    size_t EstimateDeviceBytes(ID2D1Brush*) {
+        return kBrushBytes;
+    }
+
+    size_t EstimateDeviceBytes(IDWriteTextFormat*) {
+        return kTextFormatBytes;
+    }
+
+    size_t EstimateDeviceBytes(IDWriteTextLayout*) {
+        return kTextLayoutBytes;
+    }
+
+    size_t EstimateDeviceBytes(ID2D1Bitmap* bitmap) {
+        return PixelBytes(bitmap->GetPixelSize());
+    }
+
+    size_t EstimateDeviceBytes(ID2D1BitmapRenderTarget* target) {
+        return PixelBytes(target->GetPixelSize());
+    }
+
+    void ReportBudgetExceeded(const char* owner, const void* address, const ResourceUsage& usage, const ResourceBudget& budget) {
+        OutputDebugStringA(FormatBudgetMessage(owner, address, usage, budget).c_str());
+    }
+
+} // namespace KroubleUI
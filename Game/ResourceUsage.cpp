@@ -0,0 +1,138 @@
+#include "ResourceUsage.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace KroubleUI {
+
+    namespace {
+        const char* const kKindNames[] = { "brush", "format", "layout", "bitmap" };
+        static_assert(sizeof(kKindNames) / sizeof(kKindNames[0]) == static_cast<size_t>(ResourceKind::Count),
+            "every resource kind needs a name");
+    }
+
+    uint32_t ResourceUsage::GetTotalLiveCount() const {
+        uint32_t total = 0;
+        for (uint32_t count : liveResources) {
+            total += count;
+        }
+        return total;
+    }
+
+    void ResourceUsage::AddResource(ResourceKind kind, size_t bytes) {
+        AddResources(kind, 1, bytes);
+    }
+
+    void ResourceUsage::AddResources(ResourceKind kind, uint32_t count, size_t bytes) {
+        size_t index = static_cast<size_t>(kind);
+        liveResources[index] += count;
+        peakResources[index] = (std::max)(peakResources[index], liveResources[index]);
+        deviceBytes += bytes;
+        peakDeviceBytes = (std::max)(peakDeviceBytes, deviceBytes);
+    }
+
+    void ResourceUsage::RemoveResource(ResourceKind kind, size_t bytes) {
+        size_t index = static_cast<size_t>(kind);
+        if (liveResources[index] > 0) --liveResources[index];
+        deviceBytes -= (std::min)(deviceBytes, bytes);
+    }
+
+    void ResourceUsage::SetCpuBytes(size_t bytes) {
+        cpuBytes = bytes;
+        peakCpuBytes = (std::max)(peakCpuBytes, cpuBytes);
+    }
+
+    void ResourceUsage::Merge(const ResourceUsage& other) {
+        SetCpuBytes(cpuBytes + other.cpuBytes);
+        deviceBytes += other.deviceBytes;
+        peakDeviceBytes = (std::max)(peakDeviceBytes, deviceBytes);
+        targetBytes += other.targetBytes;
+        for (size_t i = 0; i < static_cast<size_t>(ResourceKind::Count); ++i) {
+            liveResources[i] += other.liveResources[i];
+            peakResources[i] = (std::max)(peakResources[i], liveResources[i]);
+        }
+    }
+
+    void ResourceUsage::KeepPeaks(const ResourceUsage& previous) {
+        peakCpuBytes = (std::max)(peakCpuBytes, previous.peakCpuBytes);
+        peakDeviceBytes = (std::max)(peakDeviceBytes, previous.peakDeviceBytes);
+        for (size_t i = 0; i < static_cast<size_t>(ResourceKind::Count); ++i) {
+            peakResources[i] = (std::max)(peakResources[i], previous.peakResources[i]);
+        }
+    }
+
+    bool ResourceBudget::IsExceededBy(const ResourceUsage& usage) const {
+        return (maxCpuBytes > 0 && usage.cpuBytes > maxCpuBytes) ||
+            (maxDeviceBytes > 0 && usage.deviceBytes + usage.targetBytes > maxDeviceBytes) ||
+            (maxLiveResources > 0 && usage.GetTotalLiveCount() > maxLiveResources);
+    }
+
+    bool ResourceTracker::CheckBudget() {
+        bool exceeded = m_budget.IsExceededBy(m_usage);
+        bool newlyExceeded = exceeded && !m_exceeded;
+        m_exceeded = exceeded;
+        return newlyExceeded;
+    }
+
+    bool ResourceTracker::Add(ResourceKind kind, size_t bytes) {
+        m_usage.AddResource(kind, bytes);
+        return CheckBudget();
+    }
+
+    bool ResourceTracker::Remove(ResourceKind kind, size_t bytes) {
+        m_usage.RemoveResource(kind, bytes);
+        return CheckBudget();
+    }
+
+    bool ResourceTracker::SetCpuBytes(size_t bytes) {
+        m_usage.SetCpuBytes(bytes);
+        return CheckBudget();
+    }
+
+    bool ResourceTracker::Sample(const ResourceUsage& usage) {
+        ResourceUsage previous = m_usage;
+        m_usage = usage;
+        m_usage.KeepPeaks(previous);
+        return CheckBudget();
+    }
+
+    ResourceUsage SumResourceUsage(size_t cpuBytes, const std::vector<ResourceUsage>& controls, size_t targetBytes) {
+        ResourceUsage usage;
+        usage.SetCpuBytes(cpuBytes);
+        for (const ResourceUsage& control : controls) {
+            usage.Merge(control);
+        }
+        usage.targetBytes = targetBytes;
+        return usage;
+    }
+
+    std::string FormatBudgetMessage(const char* owner, const void* address, const ResourceUsage& usage, const ResourceBudget& budget) {
+        char message[256];
+        snprintf(message, sizeof(message),
+            "KroubleUI: %s %p exceeded its resource budget: cpu %zu/%zu bytes, device %zu/%zu bytes, resources %u/%u\n",
+            owner, address,
+            usage.cpuBytes, budget.maxCpuBytes,
+            usage.deviceBytes + usage.targetBytes, budget.maxDeviceBytes,
+            usage.GetTotalLiveCount(), budget.maxLiveResources);
+        return message;
+    }
+
+    std::string FormatLeakMessage(const char* owner, const void* address, const ResourceUsage& usage) {
+        uint32_t leaked = usage.GetTotalLiveCount();
+        if (leaked == 0) return std::string();
+
+        char message[256];
+        int length = snprintf(message, sizeof(message), "KroubleUI: %s %p destroyed with %u tracked resources still alive (",
+            owner, address, leaked);
+        bool first = true;
+        for (size_t i = 0; i < static_cast<size_t>(ResourceKind::Count); ++i) {
+            if (usage.liveResources[i] == 0 || length >= static_cast<int>(sizeof(message))) continue;
+            length += snprintf(message + length, sizeof(message) - length, "%s%s %u",
+                first ? "" : ", ", kKindNames[i], usage.liveResources[i]);
+            first = false;
+        }
+        std::string result(message, (std::min)(static_cast<size_t>(length), sizeof(message) - 1));
+        result += ")\n";
+        return result;
+    }
+
+} // namespace KroubleUI
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace KroubleUI {
+
+    // 设备资源种类
+    enum class ResourceKind { Brush, TextFormat, TextLayout, Bitmap, Count };
+
+    // 资源占用统计，设备资源的字节数按种类和尺寸估算
+    struct ResourceUsage {
+        size_t cpuBytes = 0;
+        size_t peakCpuBytes = 0;
+        size_t deviceBytes = 0;
+        size_t peakDeviceBytes = 0;
+        size_t targetBytes = 0;     // 窗口渲染目标（交换链缓冲）的字节数，不计入 deviceBytes 和资源个数
+        uint32_t liveResources[static_cast<size_t>(ResourceKind::Count)] = {};
+        uint32_t peakResources[static_cast<size_t>(ResourceKind::Count)] = {};
+
+        uint32_t GetLiveCount(ResourceKind kind) const { return liveResources[static_cast<size_t>(kind)]; }
+        uint32_t GetPeakCount(ResourceKind kind) const { return peakResources[static_cast<size_t>(kind)]; }
+        uint32_t GetTotalLiveCount() const;
+        void AddResource(ResourceKind kind, size_t bytes);
+        // 一次登记 count 个同类资源，共 bytes 字节
+        void AddResources(ResourceKind kind, uint32_t count, size_t bytes);
+        void RemoveResource(ResourceKind kind, size_t bytes);
+        void SetCpuBytes(size_t bytes);
+        // 累加另一份统计的当前值
+        void Merge(const ResourceUsage& other);
+        // 峰值取与之前统计的较大者
+        void KeepPeaks(const ResourceUsage& previous);
+    };
+
+    // 资源预算，0 表示不限制；超出时输出调试警告
+    struct ResourceBudget {
+        size_t maxCpuBytes = 0;
+        size_t maxDeviceBytes = 0;      // 与 deviceBytes + targetBytes 比较
+        uint32_t maxLiveResources = 0;
+
+        bool IsExceededBy(const ResourceUsage& usage) const;
+    };
+
+    // 一个控件或窗口登记的资源和预算，Control 和 Window 的统计都交给它
+    // 修改统计的方法返回是否刚刚超出预算：回到预算内之前只返回一次 true，调用者据此输出一次警告
+    class ResourceTracker {
+    private:
+        ResourceUsage m_usage;
+        ResourceBudget m_budget;
+        bool m_exceeded = false;
+
+        bool CheckBudget();
+
+    public:
+        bool Add(ResourceKind kind, size_t bytes);
+        bool Remove(ResourceKind kind, size_t bytes);
+        bool SetCpuBytes(size_t bytes);
+        // 用一次完整的统计替换当前值，峰值与之前的统计比较后保留
+        // 两次采样之间出现又消失的占用不会计入峰值，窗口因此每帧采样一次
+        bool Sample(const ResourceUsage& usage);
+
+        void SetBudget(const ResourceBudget& budget) { m_budget = budget; }
+        const ResourceBudget& GetBudget() const { return m_budget; }
+        const ResourceUsage& GetUsage() const { return m_usage; }
+    };
+
+    // 窗口一帧的合计：窗口自身的内存、各控件的当前值和渲染目标的缓冲
+    ResourceUsage SumResourceUsage(size_t cpuBytes, const std::vector<ResourceUsage>& controls, size_t targetBytes);
+
+    // 超出预算的警告文本
+    std::string FormatBudgetMessage(const char* owner, const void* address, const ResourceUsage& usage, const ResourceBudget& budget);
+    // 析构时仍有登记的资源未释放的警告文本，按种类列出个数；没有泄漏时返回空串
+    std::string FormatLeakMessage(const char* owner, const void* address, const ResourceUsage& usage);
+
+} // namespace KroubleUI
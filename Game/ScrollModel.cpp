@@ -0,0 +1,144 @@
+#include "ScrollModel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace KroubleUI {
+
+    namespace {
+        const double kFriction = 8.0;           // 惯性滚动的衰减系数（每秒）
+        const double kMinVelocity = 5.0;        // 低于该速度（像素/秒）时停止滚动
+        const double kMaxElapsed = 0.1;         // 单帧最多积分的时间，避免卡顿后跳得太远
+
+        ViewRect MakeRect(float left, float top, float right, float bottom) {
+            ViewRect rect = { left, top, right, bottom };
+            return rect;
+        }
+    }
+
+    float ScrollPlan::GetExposedArea() const {
+        float area = 0.0f;
+        for (int i = 0; i < exposedCount; ++i) {
+            area += (exposed[i].right - exposed[i].left) * (exposed[i].bottom - exposed[i].top);
+        }
+        return area;
+    }
+
+    ScrollPlan PlanScroll(int width, int height, int dx, int dy, bool surfaceValid) {
+        ScrollPlan plan = ScrollPlan();
+        float w = static_cast<float>(width);
+        float h = static_cast<float>(height);
+
+        if (!surfaceValid || std::abs(dx) >= width || std::abs(dy) >= height) {
+            plan.fullRepaint = true;
+            plan.exposed[plan.exposedCount++] = MakeRect(0, 0, w, h);
+            return plan;
+        }
+        if (dx == 0 && dy == 0) return plan;
+
+        plan.copy = true;
+        plan.copySource = MakeRect(
+            static_cast<float>((std::max)(0, dx)), static_cast<float>((std::max)(0, dy)),
+            w + (std::min)(0, dx), h + (std::min)(0, dy));
+        plan.copyDestination = MakeRect(
+            static_cast<float>((std::max)(0, -dx)), static_cast<float>((std::max)(0, -dy)),
+            w + (std::min)(0, -dx), h + (std::min)(0, -dy));
+
+        const ViewRect& destination = plan.copyDestination;
+        if (dy > 0) {
+            plan.exposed[plan.exposedCount++] = MakeRect(0, destination.bottom, w, h);
+        }
+        else if (dy < 0) {
+            plan.exposed[plan.exposedCount++] = MakeRect(0, 0, w, destination.top);
+        }
+        if (dx > 0) {
+            plan.exposed[plan.exposedCount++] = MakeRect(destination.right, destination.top, w, destination.bottom);
+        }
+        else if (dx < 0) {
+            plan.exposed[plan.exposedCount++] = MakeRect(0, destination.top, destination.left, destination.bottom);
+        }
+        return plan;
+    }
+
+    ViewRect ViewToContent(const ViewRect& view, int offsetX, int offsetY) {
+        return MakeRect(view.left + offsetX, view.top + offsetY, view.right + offsetX, view.bottom + offsetY);
+    }
+
+    bool RectsIntersect(const ViewRect& a, const ViewRect& b) {
+        return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+    }
+
+    ScrollMotion::ScrollMotion()
+        : m_offsetX(0.0),
+        m_offsetY(0.0),
+        m_velocityX(0.0),
+        m_velocityY(0.0),
+        m_contentWidth(0.0),
+        m_contentHeight(0.0),
+        m_viewWidth(0.0),
+        m_viewHeight(0.0),
+        m_lastTime(0.0) {
+    }
+
+    void ScrollMotion::SetViewSize(double width, double height) {
+        m_viewWidth = width;
+        m_viewHeight = height;
+        Clamp();
+    }
+
+    void ScrollMotion::SetContentSize(double width, double height) {
+        m_contentWidth = width;
+        m_contentHeight = height;
+        Clamp();
+    }
+
+    void ScrollMotion::ScrollTo(double x, double y) {
+        m_offsetX = x;
+        m_offsetY = y;
+        m_velocityX = 0.0;
+        m_velocityY = 0.0;
+        Clamp();
+    }
+
+    void ScrollMotion::ScrollBy(double dx, double dy, double time) {
+        if (!IsMoving()) {
+            m_lastTime = time;
+        }
+        // 速度按指数衰减，初速度 v 对应的总位移为 v / kFriction
+        m_velocityX += dx * kFriction;
+        m_velocityY += dy * kFriction;
+    }
+
+    void ScrollMotion::Advance(double time) {
+        double elapsed = time - m_lastTime;
+        m_lastTime = time;
+        if (!IsMoving()) return;
+        elapsed = (std::min)((std::max)(elapsed, 0.0), kMaxElapsed);
+
+        // 按帧间隔积分位移，速度指数衰减
+        m_offsetX += m_velocityX * elapsed;
+        m_offsetY += m_velocityY * elapsed;
+        double decay = std::exp(-kFriction * elapsed);
+        m_velocityX *= decay;
+        m_velocityY *= decay;
+        if (std::fabs(m_velocityX) < kMinVelocity) m_velocityX = 0.0;
+        if (std::fabs(m_velocityY) < kMinVelocity) m_velocityY = 0.0;
+        Clamp();
+    }
+
+    void ScrollMotion::Clamp() {
+        double maxX = (std::max)(0.0, m_contentWidth - m_viewWidth);
+        double maxY = (std::max)(0.0, m_contentHeight - m_viewHeight);
+
+        // 撞到边界时停止该方向的惯性
+        if (m_offsetX < 0.0 || m_offsetX > maxX) {
+            m_offsetX = (std::min)((std::max)(m_offsetX, 0.0), maxX);
+            m_velocityX = 0.0;
+        }
+        if (m_offsetY < 0.0 || m_offsetY > maxY) {
+            m_offsetY = (std::min)((std::max)(m_offsetY, 0.0), maxY);
+            m_velocityY = 0.0;
+        }
+    }
+
+} // namespace KroubleUI
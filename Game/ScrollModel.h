@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Geometry.h"
+
+namespace KroubleUI {
+
+    // 滚动一帧时离屏表面的更新方式
+    struct ScrollPlan {
+        bool fullRepaint;           // 表面失效或滚动超过一屏，整体重绘
+        bool copy;                  // 需要把前缓冲平移复制到后缓冲
+        ViewRect copySource;        // 前缓冲中仍然可见的部分
+        ViewRect copyDestination;   // 平移后在后缓冲中的位置
+        ViewRect exposed[2];        // 新露出的横条，以及除去横条之后的竖条
+        int exposedCount;
+
+        float GetExposedArea() const;
+    };
+
+    // 计算视口为 width x height 的表面滚动 (dx, dy) 整像素后需要复制和补画的区域
+    ScrollPlan PlanScroll(int width, int height, int dx, int dy, bool surfaceValid);
+
+    // 视口中的区域在滚动到整像素位置 (offsetX, offsetY) 时对应的内容区域
+    ViewRect ViewToContent(const ViewRect& view, int offsetX, int offsetY);
+    // 重绘一块区域时只绘制与之相交的子控件
+    bool RectsIntersect(const ViewRect& a, const ViewRect& b);
+
+    // 滚动位置和惯性，不依赖窗口系统，由调用者提供当前时刻
+    class ScrollMotion {
+    private:
+        double m_offsetX, m_offsetY;        // 当前滚动位置
+        double m_velocityX, m_velocityY;    // 惯性滚动速度（像素/秒）
+        double m_contentWidth, m_contentHeight;
+        double m_viewWidth, m_viewHeight;
+        double m_lastTime;                  // 上一次推进的时刻（秒）
+
+        void Clamp();
+
+    public:
+        ScrollMotion();
+
+        void SetViewSize(double width, double height);
+        void SetContentSize(double width, double height);
+
+        // 立即跳转到指定位置
+        void ScrollTo(double x, double y);
+        // 在 time 时刻（秒）施加一次惯性滚动，总位移约为 (dx, dy)
+        // 从静止开始时以 time 为计时起点，之前空闲的时间不计入第一帧
+        void ScrollBy(double dx, double dy, double time);
+        // 积分到 time 时刻的位移
+        void Advance(double time);
+
+        bool IsMoving() const { return m_velocityX != 0.0 || m_velocityY != 0.0; }
+        double GetOffsetX() const { return m_offsetX; }
+        double GetOffsetY() const { return m_offsetY; }
+    };
+
+} // namespace KroubleUI
@@ -0,0 +1,361 @@
+#include "KroubleUI.h"
+#include <algorithm>
+#include <cmath>
+
+namespace KroubleUI {
+
+    namespace {
+        const double kWheelStep = 60.0;         // 滚轮每格的滚动距离
+
+        D2D1_RECT_F ToRectF(const ViewRect& rect) {
+            return D2D1::RectF(rect.left, rect.top, rect.right, rect.bottom);
+        }
+
+        ViewRect ToViewRect(const D2D1_RECT_F& rect) {
+            ViewRect result = { rect.left, rect.top, rect.right, rect.bottom };
+            return result;
+        }
+    }
+
+    ScrollViewer::ScrollViewer(Window* parent, const D2D1_RECT_F& rect)
+        : Control(parent, rect),
+        m_hoveredChild(nullptr),
+        m_focusedChild(nullptr),
+        m_contentSize(D2D1::SizeF(rect.right - rect.left, rect.bottom - rect.top)),
+        m_frontSurface(nullptr),
+        m_backSurface(nullptr),
+        m_surfaceSize(D2D1::SizeU()),
+        m_surfaceValid(false),
+        m_scrollTrack([this](double time) { return StepScroll(time); }),
+        m_renderedX(0),
+        m_renderedY(0),
+        m_lastPaintedArea(0.0f),
+        m_backgroundColor(D2D1::ColorF(D2D1::ColorF::White)),
+        m_scrollBarBrush(nullptr) {
+        m_motion.SetViewSize(rect.right - rect.left, rect.bottom - rect.top);
+        m_motion.SetContentSize(m_contentSize.width, m_contentSize.height);
+        Initialize(parent->GetRenderTarget(), parent->GetDWriteFactory());
+    }
+
+    ScrollViewer::~ScrollViewer() {
+        // 子控件析构时可能回调 OnChildInvalidated，要在其余成员析构之前释放
+        m_children.clear();
+        ReleaseSurfaces();
+        ReleaseResource(&m_scrollBarBrush);
+    }
+
+    void ScrollViewer::Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory) {
+        renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Gray, 0.6f), &m_scrollBarBrush);
+        TrackResource(m_scrollBarBrush);
+    }
+
+    void ScrollViewer::Draw(ID2D1RenderTarget* renderTarget) {
+        if (!m_visible) return;
+
+        SyncViewSize();
+        m_lastPaintedArea = 0.0f;
+        if (!EnsureSurfaces(renderTarget)) return;
+
+        // 只按整像素平移，避免位图采样造成模糊
+        int offsetX = static_cast<int>(std::lround(m_motion.GetOffsetX()));
+        int offsetY = static_cast<int>(std::lround(m_motion.GetOffsetY()));
+        float width = static_cast<float>(m_surfaceSize.width);
+        float height = static_cast<float>(m_surfaceSize.height);
+        ScrollPlan plan = PlanScroll(static_cast<int>(m_surfaceSize.width), static_cast<int>(m_surfaceSize.height),
+            offsetX - m_renderedX, offsetY - m_renderedY, m_surfaceValid);
+
+        // 内容有变化的区域；绘制子控件时新产生的失效区域留到下一帧
+        std::vector<D2D1_RECT_F> dirtyRects;
+        dirtyRects.swap(m_dirtyRects);
+
+        if (plan.fullRepaint) {
+            m_frontSurface->BeginDraw();
+            PaintRegion(m_frontSurface, ToRectF(plan.exposed[0]), offsetX, offsetY);
+            m_frontSurface->EndDraw();
+            m_surfaceValid = true;
+        }
+        else if (plan.copy || !dirtyRects.empty()) {
+            ID2D1BitmapRenderTarget* target = m_frontSurface;
+
+            if (plan.copy) {
+                // 把仍然可见的像素平移复制到后缓冲，再补画新露出的区域
+                ID2D1Bitmap* front = nullptr;
+                m_frontSurface->GetBitmap(&front);
+                target = m_backSurface;
+                target->BeginDraw();
+
+                if (front) {
+                    D2D1_RECT_F source = ToRectF(plan.copySource);
+                    target->DrawBitmap(front, ToRectF(plan.copyDestination), 1.0f,
+                        D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR, &source);
+                    front->Release();
+                }
+                for (int i = 0; i < plan.exposedCount; ++i) {
+                    PaintRegion(target, ToRectF(plan.exposed[i]), offsetX, offsetY);
+                }
+            }
+            else {
+                target->BeginDraw();
+            }
+
+            for (const auto& dirty : dirtyRects) {
+                D2D1_RECT_F view = D2D1::RectF(
+                    (std::max)(dirty.left - offsetX, 0.0f), (std::max)(dirty.top - offsetY, 0.0f),
+                    (std::min)(dirty.right - offsetX, width), (std::min)(dirty.bottom - offsetY, height));
+                if (view.left < view.right && view.top < view.bottom) {
+                    PaintRegion(target, view, offsetX, offsetY);
+                }
+            }
+
+            target->EndDraw();
+            if (target == m_backSurface) {
+                std::swap(m_frontSurface, m_backSurface);
+            }
+        }
+        m_renderedX = offsetX;
+        m_renderedY = offsetY;
+
+        // 把离屏表面绘制到窗口
+        ID2D1Bitmap* bitmap = nullptr;
+        m_frontSurface->GetBitmap(&bitmap);
+        if (bitmap) {
+            D2D1_RECT_F destination = D2D1::RectF(m_rect.left, m_rect.top, m_rect.left + width, m_rect.top + height);
+            renderTarget->DrawBitmap(bitmap, destination, 1.0f, D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR);
+            bitmap->Release();
+            // 离屏表面以背景色整体覆盖视口，只有背景色不透明时才遮挡下面的内容
+            NotifyFill(renderTarget, destination, m_backgroundColor);
+        }
+
+        // 滚动条
+        float viewWidth = m_rect.right - m_rect.left;
+        float viewHeight = m_rect.bottom - m_rect.top;
+        if (m_contentSize.height > viewHeight) {
+            float thumbHeight = (std::max)(20.0f, viewHeight * viewHeight / m_contentSize.height);
+            float thumbTop = m_rect.top + (viewHeight - thumbHeight) * static_cast<float>(m_motion.GetOffsetY() / (m_contentSize.height - viewHeight));
+            FillRectangle(renderTarget,
+                D2D1::RectF(m_rect.right - 6.0f, thumbTop, m_rect.right - 2.0f, thumbTop + thumbHeight),
+                m_scrollBarBrush);
+        }
+        if (m_contentSize.width > viewWidth) {
+            float thumbWidth = (std::max)(20.0f, viewWidth * viewWidth / m_contentSize.width);
+            float thumbLeft = m_rect.left + (viewWidth - thumbWidth) * static_cast<float>(m_motion.GetOffsetX() / (m_contentSize.width - viewWidth));
+            FillRectangle(renderTarget,
+                D2D1::RectF(thumbLeft, m_rect.bottom - 6.0f, thumbLeft + thumbWidth, m_rect.bottom - 2.0f),
+                m_scrollBarBrush);
+        }
+    }
+
+    void ScrollViewer::OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) {
+        if (message == WM_MOUSEWHEEL) {
+            double step = -GET_WHEEL_DELTA_WPARAM(wParam) / static_cast<double>(WHEEL_DELTA) * kWheelStep;
+            if (GET_KEYSTATE_WPARAM(wParam) & MK_SHIFT) {
+                ScrollBy(step, 0.0);
+            }
+            else {
+                ScrollBy(0.0, step);
+            }
+            return;
+        }
+
+        // 转换为内容坐标后分发给子控件
+        POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
+        float x = pt.x - m_rect.left + m_renderedX;
+        float y = pt.y - m_rect.top + m_renderedY;
+        LPARAM contentParam = MAKELPARAM(static_cast<int>(x), static_cast<int>(y));
+
+        Control* hit = nullptr;
+        if (message != WM_MOUSELEAVE && HitTest(static_cast<float>(pt.x), static_cast<float>(pt.y))) {
+            for (auto it = m_children.rbegin(); it != m_children.rend(); ++it) {
+                if ((*it)->IsVisible() && (*it)->HitTest(x, y)) {
+                    hit = it->get();
+                    break;
+                }
+            }
+        }
+
+        switch (message) {
+        case WM_MOUSEMOVE:
+        case WM_MOUSELEAVE:
+            // 悬停的子控件变化时才需要重绘
+            if (m_hoveredChild && m_hoveredChild != hit) {
+                m_hoveredChild->OnMouseEvent(WM_MOUSELEAVE, wParam, contentParam);
+                InvalidateContent(m_hoveredChild->GetRect());
+            }
+            if (hit) {
+                hit->OnMouseEvent(WM_MOUSEMOVE, wParam, contentParam);
+                if (hit != m_hoveredChild) {
+                    InvalidateContent(hit->GetRect());
+                }
+            }
+            m_hoveredChild = hit;
+            break;
+
+        case WM_LBUTTONDOWN:
+            // 按下的子控件获得键盘输入，点在空白处时没有子控件获得
+            m_focusedChild = hit;
+            if (hit) {
+                hit->OnMouseEvent(message, wParam, contentParam);
+                InvalidateContent(hit->GetRect());
+            }
+            break;
+
+        case WM_LBUTTONUP:
+            // 子控件自己的变化经 OnChildInvalidated 报告，点击处理函数修改的其他控件同样如此
+            if (hit) {
+                hit->OnMouseEvent(message, wParam, contentParam);
+            }
+            break;
+        }
+    }
+
+    void ScrollViewer::OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) {
+        // 只交给获得焦点的子控件，还没有点击过时交给悬停的子控件；重绘范围由子控件报告
+        Control* target = m_focusedChild ? m_focusedChild : m_hoveredChild;
+        if (target && target->IsEnabled()) {
+            target->OnKeyboardEvent(message, wParam, lParam);
+        }
+    }
+
+    void ScrollViewer::AddChild(Control* control) {
+        m_children.push_back(std::unique_ptr<Control>(control));
+        control->SetContainer(this);
+
+        const D2D1_RECT_F& rect = control->GetRect();
+        if (rect.right > m_contentSize.width || rect.bottom > m_contentSize.height) {
+            SetContentSize((std::max)(m_contentSize.width, rect.right), (std::max)(m_contentSize.height, rect.bottom));
+        }
+        InvalidateContent(rect);
+    }
+
+    size_t ScrollViewer::GetCpuBytes() const {
+        // 子控件单独统计
+        return sizeof(ScrollViewer) +
+            m_children.capacity() * sizeof(std::unique_ptr<Control>) +
+            m_dirtyRects.capacity() * sizeof(D2D1_RECT_F);
+    }
+
+    void ScrollViewer::ForEachChild(const std::function<void(Control*)>& visit) {
+        for (auto& child : m_children) {
+            visit(child.get());
+        }
+    }
+
+    void ScrollViewer::SetContentSize(float width, float height) {
+        m_contentSize = D2D1::SizeF(width, height);
+        SyncViewSize();
+        m_motion.SetContentSize(width, height);
+        Invalidate();
+    }
+
+    void ScrollViewer::ScrollTo(double x, double y) {
+        SyncViewSize();
+        m_scrollTrack.Stop();
+        m_motion.ScrollTo(x, y);
+        Invalidate();
+    }
+
+    void ScrollViewer::ScrollBy(double dx, double dy) {
+        AnimationScheduler* scheduler = m_parent->GetAnimationScheduler();
+        m_motion.ScrollBy(dx, dy, scheduler->Now());
+        if (m_motion.IsMoving()) {
+            scheduler->Start(&m_scrollTrack);
+        }
+        Invalidate();
+    }
+
+    void ScrollViewer::InvalidateContent(const D2D1_RECT_F& rect) {
+        m_dirtyRects.push_back(rect);
+
+        // 只有落在视口内的部分需要窗口重绘
+        float dx = m_rect.left - static_cast<float>(std::lround(m_motion.GetOffsetX()));
+        float dy = m_rect.top - static_cast<float>(std::lround(m_motion.GetOffsetY()));
+        D2D1_RECT_F view = D2D1::RectF(
+            (std::max)(rect.left + dx, m_rect.left), (std::max)(rect.top + dy, m_rect.top),
+            (std::min)(rect.right + dx, m_rect.right), (std::min)(rect.bottom + dy, m_rect.bottom));
+        if (view.left < view.right && view.top < view.bottom) {
+            Invalidate(view);
+        }
+    }
+
+    void ScrollViewer::InvalidateContent() {
+        m_surfaceValid = false;
+        Invalidate();
+    }
+
+    void ScrollViewer::OnStyleChanged() {
+        // 子控件只在重绘离屏表面时才会发现样式表的变化
+        InvalidateContent();
+    }
+
+    void ScrollViewer::OnChildInvalidated(const D2D1_RECT_F& rect) {
+        InvalidateContent(rect);
+    }
+
+    void ScrollViewer::SetBackgroundColor(const D2D1_COLOR_F& color) {
+        m_backgroundColor = color;
+        InvalidateContent();
+    }
+
+    bool ScrollViewer::EnsureSurfaces(ID2D1RenderTarget* renderTarget) {
+        D2D1_SIZE_U size = D2D1::SizeU(
+            static_cast<UINT32>(std::ceil((std::max)(0.0f, m_rect.right - m_rect.left))),
+            static_cast<UINT32>(std::ceil((std::max)(0.0f, m_rect.bottom - m_rect.top))));
+        if (size.width == 0 || size.height == 0) return false;
+
+        if (m_frontSurface && m_backSurface &&
+            size.width == m_surfaceSize.width && size.height == m_surfaceSize.height) {
+            return true;
+        }
+
+        ReleaseSurfaces();
+        D2D1_SIZE_F desired = D2D1::SizeF(static_cast<float>(size.width), static_cast<float>(size.height));
+        if (FAILED(renderTarget->CreateCompatibleRenderTarget(desired, &m_frontSurface)) ||
+            FAILED(renderTarget->CreateCompatibleRenderTarget(desired, &m_backSurface))) {
+            SafeRelease(&m_frontSurface);
+            SafeRelease(&m_backSurface);
+            return false;
+        }
+        TrackResource(m_frontSurface);
+        TrackResource(m_backSurface);
+        m_surfaceSize = size;
+        m_surfaceValid = false;
+        return true;
+    }
+
+    void ScrollViewer::ReleaseSurfaces() {
+        ReleaseResource(&m_frontSurface);
+        ReleaseResource(&m_backSurface);
+        m_surfaceValid = false;
+    }
+
+    void ScrollViewer::PaintRegion(ID2D1RenderTarget* target, const D2D1_RECT_F& viewRect, int offsetX, int offsetY) {
+        target->PushAxisAlignedClip(viewRect, D2D1_ANTIALIAS_MODE_ALIASED);
+        target->Clear(m_backgroundColor);
+        target->SetTransform(D2D1::Matrix3x2F::Translation(static_cast<float>(-offsetX), static_cast<float>(-offsetY)));
+
+        // 只绘制与该区域相交的子控件
+        ViewRect contentRect = ViewToContent(ToViewRect(viewRect), offsetX, offsetY);
+        for (auto& child : m_children) {
+            if (child->IsVisible() && RectsIntersect(ToViewRect(child->GetBounds()), contentRect)) {
+                child->Render(target);
+            }
+        }
+
+        target->SetTransform(D2D1::Matrix3x2F::Identity());
+        target->PopAxisAlignedClip();
+        m_lastPaintedArea += (viewRect.right - viewRect.left) * (viewRect.bottom - viewRect.top);
+    }
+
+    bool ScrollViewer::StepScroll(double time) {
+        SyncViewSize();
+        m_motion.Advance(time);
+        Invalidate();
+        return m_motion.IsMoving();
+    }
+
+    void ScrollViewer::SyncViewSize() {
+        // 控件的矩形可能在两帧之间改变
+        m_motion.SetViewSize(m_rect.right - m_rect.left, m_rect.bottom - m_rect.top);
+    }
+
+} // namespace KroubleUI
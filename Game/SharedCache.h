@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace KroubleUI {
+
+    // 按描述共享的对象缓存，同一描述只创建一次，多个窗口（可在不同线程上）共用
+    // 缓存持有每个对象的一份引用；引用计数的增减由调用者提供，不依赖 COM
+    // 对象数超过上限时释放最久未取用的对象的引用，仍被调用者持有的对象在调用者释放后才销毁
+    template <typename Desc, typename Object, typename Hash = std::hash<Desc>>
+    class SharedCache {
+    private:
+        typedef std::list<std::pair<Desc, Object*>> EntryList;
+
+        mutable std::mutex m_mutex;
+        EntryList m_entries;        // 最近取用的在前
+        std::unordered_map<Desc, typename EntryList::iterator, Hash> m_index;
+        size_t m_capacity;
+        size_t m_created;
+        size_t m_evicted;
+
+    public:
+        // capacity 为 0 时不限制对象数
+        explicit SharedCache(size_t capacity = 0) : m_capacity(capacity), m_created(0), m_evicted(0) {}
+        SharedCache(const SharedCache&) = delete;
+        SharedCache& operator=(const SharedCache&) = delete;
+
+        // 返回 desc 对应的对象，没有时用 create(desc) 创建；create 失败时返回空
+        // 返回前调用 retain(object)，调用者负责释放这份引用；release 用于释放被淘汰的对象的引用
+        template <typename Create, typename Retain, typename Release>
+        Object* Acquire(const Desc& desc, Create create, Retain retain, Release release) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_index.find(desc);
+            if (it != m_index.end()) {
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+                retain(it->second->second);
+                return it->second->second;
+            }
+
+            Object* object = create(desc);
+            if (!object) return nullptr;
+            ++m_created;
+            m_entries.emplace_front(desc, object);
+            m_index.emplace(desc, m_entries.begin());
+            retain(object);
+
+            while (m_capacity && m_entries.size() > m_capacity) {
+                auto last = std::prev(m_entries.end());
+                m_index.erase(last->first);
+                release(last->second);
+                m_entries.erase(last);
+                ++m_evicted;
+            }
+            return object;
+        }
+
+        // 释放缓存持有的引用
+        template <typename Release>
+        void Clear(Release release) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& entry : m_entries) {
+                release(entry.second);
+            }
+            m_entries.clear();
+            m_index.clear();
+        }
+
+        // 在持有锁时依次访问缓存中的对象
+        template <typename Visit>
+        void ForEach(Visit visit) const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& entry : m_entries) {
+                visit(entry.second);
+            }
+        }
+
+        size_t GetCount() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_entries.size();
+        }
+
+        size_t GetCapacity() const { return m_capacity; }
+
+        // 累计创建的对象数，用于检查共享是否生效
+        size_t GetCreatedCount() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_created;
+        }
+
+        // 累计因超出上限而淘汰的对象数
+        size_t GetEvictedCount() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_evicted;
+        }
+    };
+
+} // namespace KroubleUI
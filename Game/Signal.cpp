@@ -0,0 +1,191 @@
+#include "Signal.h"
+#include <algorithm>
+
+namespace KroubleUI {
+
+    Connection::Connection(SignalBase* signal, uint32_t id) : m_signal(signal), m_id(id) {
+        m_signal->SetHandle(m_id, this);
+    }
+
+    Connection::Connection(Connection&& other) : m_signal(other.m_signal), m_id(other.m_id) {
+        other.m_signal = nullptr;
+        if (m_signal) {
+            m_signal->SetHandle(m_id, this);
+        }
+    }
+
+    Connection& Connection::operator=(Connection&& other) {
+        if (this != &other) {
+            Disconnect();
+            m_signal = other.m_signal;
+            m_id = other.m_id;
+            other.m_signal = nullptr;
+            if (m_signal) {
+                m_signal->SetHandle(m_id, this);
+            }
+        }
+        return *this;
+    }
+
+    void Connection::Disconnect() {
+        if (m_signal) {
+            SignalBase* signal = m_signal;
+            m_signal = nullptr;
+            signal->Disconnect(m_id);
+        }
+    }
+
+    void Connection::Release() {
+        if (m_signal) {
+            m_signal->SetHandle(m_id, nullptr);
+            m_signal = nullptr;
+        }
+    }
+
+    SignalBase::SignalBase() : m_inlineUsed(false), m_nextId(1), m_emitDepth(0), m_hasRemoved(false) {}
+
+    SignalBase::~SignalBase() {
+        // 仍然存在的句柄变为已断开
+        size_t count = 0;
+        Slot* slots = GetSlots(&count);
+        for (size_t i = 0; i < count; ++i) {
+            if (slots[i].handle) slots[i].handle->m_signal = nullptr;
+            DestroySlot(slots[i]);
+        }
+        if (m_pending) {
+            for (Slot& slot : *m_pending) {
+                if (slot.handle) slot.handle->m_signal = nullptr;
+                DestroySlot(slot);
+            }
+        }
+    }
+
+    Connection SignalBase::AddSlot(const Slot& slot) {
+        Slot added = slot;
+        added.id = m_nextId++;
+        added.handle = nullptr;
+        if (m_nextId == 0) m_nextId = 1;
+
+        if (m_emitDepth > 0) {
+            if (!m_pending) m_pending.reset(new std::vector<Slot>());
+            m_pending->push_back(added);
+        }
+        else {
+            PushSlot(added);
+        }
+        return Connection(this, added.id);
+    }
+
+    void SignalBase::PushSlot(const Slot& slot) {
+        if (m_heap.empty() && !m_inlineUsed) {
+            m_inline = slot;
+            m_inlineUsed = true;
+            return;
+        }
+        if (m_heap.empty()) {
+            // 第二个处理函数：连同内部的一个一起移到堆上，保持连接顺序
+            m_heap.reserve(4);
+            m_heap.push_back(m_inline);
+            m_inlineUsed = false;
+        }
+        m_heap.push_back(slot);
+    }
+
+    SignalBase::Slot* SignalBase::FindSlot(uint32_t id) {
+        size_t count = 0;
+        Slot* slots = GetSlots(&count);
+        for (size_t i = 0; i < count; ++i) {
+            if (slots[i].id == id) return &slots[i];
+        }
+        if (m_pending) {
+            for (Slot& slot : *m_pending) {
+                if (slot.id == id) return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    void SignalBase::Disconnect(uint32_t id) {
+        if (m_emitDepth > 0) {
+            // 发出期间只做标记，发出结束后再移除
+            if (Slot* slot = FindSlot(id)) {
+                slot->id = 0;
+                slot->handle = nullptr;
+                m_hasRemoved = true;
+            }
+            return;
+        }
+
+        if (m_heap.empty()) {
+            if (m_inlineUsed && m_inline.id == id) {
+                DestroySlot(m_inline);
+                m_inlineUsed = false;
+            }
+            return;
+        }
+        for (auto it = m_heap.begin(); it != m_heap.end(); ++it) {
+            if (it->id == id) {
+                DestroySlot(*it);
+                m_heap.erase(it);
+                break;
+            }
+        }
+        if (m_heap.size() == 1) {
+            // 回到信号内部的存储
+            m_inline = m_heap.front();
+            m_inlineUsed = true;
+            std::vector<Slot>().swap(m_heap);
+        }
+    }
+
+    void SignalBase::SetHandle(uint32_t id, Connection* handle) {
+        if (Slot* slot = FindSlot(id)) {
+            slot->handle = handle;
+        }
+    }
+
+    void SignalBase::EndEmit() {
+        if (m_hasRemoved) {
+            m_hasRemoved = false;
+            if (m_heap.empty()) {
+                if (m_inlineUsed && m_inline.id == 0) {
+                    DestroySlot(m_inline);
+                    m_inlineUsed = false;
+                }
+            }
+            else {
+                auto removed = std::remove_if(m_heap.begin(), m_heap.end(), [](Slot& slot) {
+                    if (slot.id != 0) return false;
+                    DestroySlot(slot);
+                    return true;
+                });
+                m_heap.erase(removed, m_heap.end());
+                if (m_heap.size() == 1) {
+                    m_inline = m_heap.front();
+                    m_inlineUsed = true;
+                    std::vector<Slot>().swap(m_heap);
+                }
+            }
+        }
+
+        if (m_pending) {
+            std::unique_ptr<std::vector<Slot>> pending = std::move(m_pending);
+            for (Slot& slot : *pending) {
+                if (slot.id != 0) {
+                    PushSlot(slot);
+                }
+                else {
+                    DestroySlot(slot);
+                }
+            }
+        }
+    }
+
+    void SignalBase::DestroySlot(Slot& slot) {
+        if (slot.destroy) {
+            slot.destroy(&slot.storage);
+            slot.destroy = nullptr;
+        }
+    }
+
+} // namespace KroubleUI
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace KroubleUI {
+
+    // 控件事件（点击、悬停、焦点、文本和位置变化）使用的信号和连接
+
+    class SignalBase;
+
+    // 信号与处理函数之间的连接，句柄析构或调用 Disconnect 时断开
+    // 可以在信号发出期间（包括处理函数内部）断开，断开后的处理函数不会再被调用
+    class Connection {
+    private:
+        friend class SignalBase;
+
+        SignalBase* m_signal;   // 已断开或信号已销毁时为空
+        uint32_t m_id;
+
+        Connection(SignalBase* signal, uint32_t id);
+
+    public:
+        Connection() : m_signal(nullptr), m_id(0) {}
+        Connection(Connection&& other);
+        Connection& operator=(Connection&& other);
+        ~Connection() { Disconnect(); }
+
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+
+        void Disconnect();
+        bool IsConnected() const { return m_signal != nullptr; }
+        // 放弃句柄，处理函数保持连接直到信号销毁
+        void Release();
+    };
+
+    // 信号的非模板部分：按连接顺序保存处理函数
+    // 第一个处理函数存放在信号内部；可平凡复制且不超过 kStorageSize 字节的处理函数（如只捕获指针的 lambda）不分配内存
+    // 只能在所属控件的界面线程上使用，不能在处理函数中销毁发出信号的对象
+    class SignalBase {
+    protected:
+        static const size_t kStorageSize = 3 * sizeof(void*);
+        typedef void (*Invoker)();
+        typedef void (*Destroyer)(void* storage);
+
+        struct Slot {
+            uint32_t id;            // 0 表示已在发出期间断开，发出结束后移除
+            Connection* handle;
+            Invoker invoke;         // 转换回 void (*)(void* storage, Args...) 后调用
+            Destroyer destroy;      // 处理函数在堆上时释放它，存放在 storage 内时为空
+            std::aligned_storage<kStorageSize>::type storage;
+        };
+
+        // 发出期间不移动和移除处理函数，新连接的处理函数暂存到发出结束
+        class EmitScope {
+        private:
+            SignalBase* m_signal;
+        public:
+            explicit EmitScope(SignalBase* signal) : m_signal(signal) { ++m_signal->m_emitDepth; }
+            // 发出期间没有断开和新连接时不需要整理，不离开头文件
+            ~EmitScope() {
+                if (--m_signal->m_emitDepth == 0 && (m_signal->m_hasRemoved || m_signal->m_pending)) {
+                    m_signal->EndEmit();
+                }
+            }
+            EmitScope(const EmitScope&) = delete;
+            EmitScope& operator=(const EmitScope&) = delete;
+        };
+
+        SignalBase();
+        ~SignalBase();
+
+        Connection AddSlot(const Slot& slot);
+        Slot* GetSlots(size_t* count) {
+            if (!m_heap.empty()) {
+                *count = m_heap.size();
+                return m_heap.data();
+            }
+            *count = m_inlineUsed ? 1 : 0;
+            return &m_inline;
+        }
+
+    private:
+        friend class Connection;
+
+        Slot m_inline;
+        bool m_inlineUsed;
+        std::vector<Slot> m_heap;                       // 超过一个处理函数时全部存放在这里
+        std::unique_ptr<std::vector<Slot>> m_pending;   // 发出期间新连接的处理函数
+        uint32_t m_nextId;
+        int m_emitDepth;
+        bool m_hasRemoved;
+
+        void PushSlot(const Slot& slot);
+        Slot* FindSlot(uint32_t id);
+        void Disconnect(uint32_t id);
+        void SetHandle(uint32_t id, Connection* handle);
+        void EndEmit();
+        static void DestroySlot(Slot& slot);
+
+    public:
+        SignalBase(const SignalBase&) = delete;
+        SignalBase& operator=(const SignalBase&) = delete;
+
+        size_t GetSlotCount() const { return (m_heap.empty() ? (m_inlineUsed ? 1 : 0) : m_heap.size()) + (m_pending ? m_pending->size() : 0); }
+    };
+
+    // 带类型的信号，Connect 返回的 Connection 决定连接的生命周期
+    template<class... Args> class Signal : public SignalBase {
+    private:
+        template<class F> struct Storage {
+            static const bool kInline = sizeof(F) <= kStorageSize &&
+                alignof(F) <= alignof(std::aligned_storage<kStorageSize>::type) &&
+                std::is_trivially_copyable<F>::value;
+
+            static F* Get(void* storage) {
+                return kInline ? static_cast<F*>(storage) : *static_cast<F**>(storage);
+            }
+            static void Invoke(void* storage, Args... args) {
+                (*Get(storage))(args...);
+            }
+            static void Destroy(void* storage) {
+                delete *static_cast<F**>(storage);
+            }
+            template<class T> static Destroyer Create(void* storage, T&& function, std::true_type) {
+                new (storage) F(std::forward<T>(function));
+                return nullptr;
+            }
+            template<class T> static Destroyer Create(void* storage, T&& function, std::false_type) {
+                *static_cast<F**>(storage) = new F(std::forward<T>(function));
+                return &Destroy;
+            }
+        };
+
+    public:
+        Signal() {}
+
+        template<class F> Connection Connect(F&& function) {
+            typedef typename std::decay<F>::type Function;
+            typedef Storage<Function> FunctionStorage;
+
+            Slot slot;
+            slot.invoke = reinterpret_cast<Invoker>(&FunctionStorage::Invoke);
+            slot.destroy = FunctionStorage::Create(&slot.storage, std::forward<F>(function),
+                std::integral_constant<bool, FunctionStorage::kInline>());
+            return AddSlot(slot);
+        }
+
+        // 按连接顺序调用处理函数；处理函数中新连接的处理函数从下一次发出开始生效
+        void Emit(Args... args) {
+            EmitScope scope(this);
+            size_t count = 0;
+            Slot* slots = GetSlots(&count);
+            for (size_t i = 0; i < count; ++i) {
+                if (slots[i].id != 0) {
+                    reinterpret_cast<void (*)(void*, Args...)>(slots[i].invoke)(&slots[i].storage, args...);
+                }
+            }
+        }
+    };
+
+} // namespace KroubleUI
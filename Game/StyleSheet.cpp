@@ -0,0 +1,208 @@
+#include "StyleSheet.h"
+#include <algorithm>
+
+namespace KroubleUI {
+
+    namespace {
+        const size_t kMaxInheritanceDepth = 32;    // 超过时视为循环继承，忽略更远的基样式
+
+        // 所有样式表共用的版本号来源，保证不同样式表的版本互不相同
+        std::atomic<uint64_t> g_nextStyleVersion(1);
+
+        // 内置默认样式用到的颜色，与 D2D1::ColorF 中的同名颜色相同
+        const uint32_t kBlack = 0x000000;
+        const uint32_t kWhite = 0xFFFFFF;
+        const uint32_t kGray = 0x808080;
+        const uint32_t kLightGray = 0xD3D3D3;
+        const uint32_t kDarkGray = 0xA9A9A9;
+
+        void Apply(const StyleDeclaration& declaration, bool fromState, ResolvedStyle* style) {
+            uint32_t mask = declaration.mask;
+            if (mask & StyleBackground) style->background = declaration.background;
+            if (mask & StyleForeground) style->foreground = declaration.foreground;
+            if (mask & StyleBorder) style->border = declaration.border;
+            if (mask & StyleBorderWidth) style->borderWidth = declaration.borderWidth;
+            if (mask & StyleFontFamily) style->fontFamily = declaration.fontFamily;
+            if (mask & StyleFontSize) style->fontSize = declaration.fontSize;
+            if (mask & StyleFontWeight) style->fontWeight = declaration.fontWeight;
+
+            if (fromState) {
+                style->stateMask |= mask;
+            }
+            else {
+                style->stateMask &= ~mask;
+            }
+        }
+    }
+
+    StyleSheet::StyleSheet()
+        : m_version(g_nextStyleVersion.fetch_add(1)),
+        m_resolveCount(0),
+        m_lookupCount(0),
+        m_nextListener(1) {
+    }
+
+    std::shared_ptr<StyleSheet> StyleSheet::GetDefault() {
+        static std::shared_ptr<StyleSheet> styleSheet = []() {
+            std::shared_ptr<StyleSheet> defaults = std::make_shared<StyleSheet>();
+            defaults->AddDefaultStyles();
+            return defaults;
+        }();
+        return styleSheet;
+    }
+
+    void StyleSheet::AddDefaultStyles() {
+        // 与各控件原先写死的外观一致
+        std::unordered_map<std::wstring, Style> styles;
+        Style control;
+        control.Normal()
+            .SetFontFamily(L"Microsoft YaHei")
+            .SetFontSize(14.0f)
+            .SetForeground(StyleColor::FromRgb(kBlack));
+        control.State(StyleState::Disabled).SetForeground(StyleColor::FromRgb(kGray));
+        styles[L"Control"] = control;
+
+        // 悬停和按下的背景由 Button 按常态背景调亮、调暗得出
+        Style button;
+        button.basedOn = L"Control";
+        button.Normal()
+            .SetBackground(StyleColor::FromRgb(kLightGray))
+            .SetBorder(StyleColor::FromRgb(kDarkGray))
+            .SetBorderWidth(1.0f);
+        styles[L"Button"] = button;
+
+        Style textBox;
+        textBox.basedOn = L"Control";
+        textBox.Normal()
+            .SetBackground(StyleColor::FromRgb(kWhite))
+            .SetBorder(StyleColor::FromRgb(kBlack))
+            .SetBorderWidth(1.0f);
+        textBox.State(StyleState::Focused).SetBorderWidth(2.0f);
+        styles[L"TextBox"] = textBox;
+
+        Style textBlock;
+        textBlock.basedOn = L"Control";
+        textBlock.Normal().SetBackground(StyleColor::FromRgb(0, 0.0f));
+        styles[L"TextBlock"] = textBlock;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& entry : styles) {
+                m_styles[entry.first] = entry.second;
+            }
+            Changed();
+        }
+        NotifyListeners();
+    }
+
+    void StyleSheet::SetStyle(const std::wstring& name, const Style& style) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_styles[name] = style;
+            Changed();
+        }
+        NotifyListeners();
+    }
+
+    bool StyleSheet::RemoveStyle(const std::wstring& name) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_styles.erase(name) == 0) return false;
+            Changed();
+        }
+        NotifyListeners();
+        return true;
+    }
+
+    bool StyleSheet::HasStyle(const std::wstring& name) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_styles.count(name) != 0;
+    }
+
+    void StyleSheet::SetStyles(std::unordered_map<std::wstring, Style> styles) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_styles.swap(styles);
+            Changed();
+        }
+        // 旧的样式在锁外析构
+        NotifyListeners();
+    }
+
+    void StyleSheet::Changed() {
+        // 已经取用的记录仍由控件持有，控件在版本变化后重新查询
+        for (auto& cache : m_cache) {
+            cache.clear();
+        }
+        m_version = g_nextStyleVersion.fetch_add(1);
+    }
+
+    void StyleSheet::NotifyListeners() {
+        std::lock_guard<std::mutex> lock(m_listenerMutex);
+        for (auto& listener : m_listeners) {
+            listener.second();
+        }
+    }
+
+    size_t StyleSheet::AddListener(Listener listener) {
+        std::lock_guard<std::mutex> lock(m_listenerMutex);
+        size_t id = m_nextListener++;
+        m_listeners.emplace_back(id, std::move(listener));
+        return id;
+    }
+
+    void StyleSheet::RemoveListener(size_t id) {
+        std::lock_guard<std::mutex> lock(m_listenerMutex);
+        m_listeners.erase(std::remove_if(m_listeners.begin(), m_listeners.end(),
+            [id](const std::pair<size_t, Listener>& listener) { return listener.first == id; }), m_listeners.end());
+    }
+
+    std::shared_ptr<const ResolvedStyle> StyleSheet::Resolve(const std::wstring& name, StyleState state) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_lookupCount;
+
+        auto& cache = m_cache[static_cast<size_t>(state)];
+        auto it = cache.find(name);
+        if (it != cache.end()) return it->second;
+
+        std::shared_ptr<const ResolvedStyle> resolved = ResolveUncached(name, state);
+        ++m_resolveCount;
+        cache.emplace(name, resolved);
+        return resolved;
+    }
+
+    std::shared_ptr<const ResolvedStyle> StyleSheet::ResolveUncached(const std::wstring& name, StyleState state) const {
+        // 从自身沿继承链向上收集，再从最远的基样式开始应用：先是整条链的常态声明，然后是整条链的状态声明
+        std::vector<const Style*> chain;
+        auto it = m_styles.find(name);
+        while (it != m_styles.end() && chain.size() < kMaxInheritanceDepth) {
+            const Style* style = &it->second;
+            if (std::find(chain.begin(), chain.end(), style) != chain.end()) break;
+            chain.push_back(style);
+            if (style->basedOn.empty()) break;
+            it = m_styles.find(style->basedOn);
+        }
+
+        std::shared_ptr<ResolvedStyle> resolved = std::make_shared<ResolvedStyle>();
+        for (auto style = chain.rbegin(); style != chain.rend(); ++style) {
+            Apply((*style)->declarations[static_cast<size_t>(StyleState::Normal)], false, resolved.get());
+        }
+        if (state != StyleState::Normal) {
+            for (auto style = chain.rbegin(); style != chain.rend(); ++style) {
+                Apply((*style)->declarations[static_cast<size_t>(state)], true, resolved.get());
+            }
+        }
+        return resolved;
+    }
+
+    uint64_t StyleSheet::GetResolveCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_resolveCount;
+    }
+
+    uint64_t StyleSheet::GetLookupCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lookupCount;
+    }
+
+} // namespace KroubleUI
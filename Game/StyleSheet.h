@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace KroubleUI {
+
+    // 样式和样式表：按名称和交互状态解析属性，每次修改递增版本号，控件据此刷新缓存的样式
+
+    // 控件的交互状态，样式可以为每种状态设置不同的属性
+    enum class StyleState : uint8_t { Normal, Hover, Pressed, Focused, Disabled, Count };
+
+    // 样式属性，用作掩码
+    enum StyleProperty : uint32_t {
+        StyleBackground = 1 << 0,
+        StyleForeground = 1 << 1,
+        StyleBorder = 1 << 2,
+        StyleBorderWidth = 1 << 3,
+        StyleFontFamily = 1 << 4,
+        StyleFontSize = 1 << 5,
+        StyleFontWeight = 1 << 6,
+    };
+
+    // 不依赖 Direct2D 的颜色，布局与 D2D1_COLOR_F 相同
+    struct StyleColor {
+        float r, g, b, a;
+
+        // 与 D2D1::ColorF(rgb, alpha) 相同，rgb 为 0xRRGGBB
+        static StyleColor FromRgb(uint32_t rgb, float alpha = 1.0f) {
+            StyleColor color = { ((rgb >> 16) & 0xFF) / 255.0f, ((rgb >> 8) & 0xFF) / 255.0f, (rgb & 0xFF) / 255.0f, alpha };
+            return color;
+        }
+        bool operator==(const StyleColor& other) const {
+            return r == other.r && g == other.g && b == other.b && a == other.a;
+        }
+        bool operator!=(const StyleColor& other) const { return !(*this == other); }
+    };
+
+    // 一组属性声明，只有设置过的属性才会覆盖继承来的值
+    // 字重与 DWRITE_FONT_WEIGHT 的取值相同
+    struct StyleDeclaration {
+        uint32_t mask = 0;
+        StyleColor background = {};
+        StyleColor foreground = {};
+        StyleColor border = {};
+        float borderWidth = 0.0f;
+        std::wstring fontFamily;
+        float fontSize = 0.0f;
+        uint32_t fontWeight = 400;
+
+        StyleDeclaration& SetBackground(const StyleColor& color) { background = color; mask |= StyleBackground; return *this; }
+        StyleDeclaration& SetForeground(const StyleColor& color) { foreground = color; mask |= StyleForeground; return *this; }
+        StyleDeclaration& SetBorder(const StyleColor& color) { border = color; mask |= StyleBorder; return *this; }
+        StyleDeclaration& SetBorderWidth(float width) { borderWidth = width; mask |= StyleBorderWidth; return *this; }
+        StyleDeclaration& SetFontFamily(const std::wstring& family) { fontFamily = family; mask |= StyleFontFamily; return *this; }
+        StyleDeclaration& SetFontSize(float size) { fontSize = size; mask |= StyleFontSize; return *this; }
+        StyleDeclaration& SetFontWeight(uint32_t weight) { fontWeight = weight; mask |= StyleFontWeight; return *this; }
+    };
+
+    // 命名样式：从 basedOn 继承
+    // 先从最远的基样式到自身依次应用常态的声明，再同样依次应用所求状态的声明
+    // 因此任何一层的状态声明都优先于常态声明，同类声明中越靠近自身的优先
+    struct Style {
+        std::wstring basedOn;   // 为空时从内置默认值开始
+        StyleDeclaration declarations[static_cast<size_t>(StyleState::Count)];
+
+        StyleDeclaration& Normal() { return declarations[0]; }
+        StyleDeclaration& State(StyleState state) { return declarations[static_cast<size_t>(state)]; }
+    };
+
+    // 解析后的扁平样式，不可变，由样式表缓存并在使用同一样式的控件之间共享
+    struct ResolvedStyle {
+        StyleColor background = { 0.0f, 0.0f, 0.0f, 0.0f };
+        StyleColor foreground = { 0.0f, 0.0f, 0.0f, 1.0f };
+        StyleColor border = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float borderWidth = 1.0f;
+        std::wstring fontFamily = L"Microsoft YaHei";
+        float fontSize = 14.0f;
+        uint32_t fontWeight = 400;
+        uint32_t stateMask = 0;     // 最终值来自状态声明的属性，控件可据此决定是否自行推算状态颜色
+
+        bool IsFromState(StyleProperty property) const { return (stateMask & property) != 0; }
+    };
+
+    // 样式表：按名称保存样式，解析结果按（名称，状态）缓存，任何修改都会清空缓存并更新版本号
+    // 可在多个窗口（包括不同 UI 线程上的窗口）之间共享；修改后通知监听者，窗口据此在自己的线程上整体重绘
+    class StyleSheet {
+    public:
+        typedef std::function<void()> Listener;
+
+    private:
+        mutable std::mutex m_mutex;
+        std::unordered_map<std::wstring, Style> m_styles;
+        std::unordered_map<std::wstring, std::shared_ptr<const ResolvedStyle>> m_cache[static_cast<size_t>(StyleState::Count)];
+        std::atomic<uint64_t> m_version;
+        uint64_t m_resolveCount;
+        uint64_t m_lookupCount;
+
+        std::mutex m_listenerMutex;     // 通知期间一直持有，RemoveListener 返回后回调不会再运行
+        std::vector<std::pair<size_t, Listener>> m_listeners;
+        size_t m_nextListener;
+
+        // 调用时持有 m_mutex
+        void Changed();
+        // 调用时不持有 m_mutex
+        void NotifyListeners();
+        std::shared_ptr<const ResolvedStyle> ResolveUncached(const std::wstring& name, StyleState state) const;
+
+    public:
+        StyleSheet();
+
+        StyleSheet(const StyleSheet&) = delete;
+        StyleSheet& operator=(const StyleSheet&) = delete;
+
+        // 进程共享的样式表，包含内置控件的默认样式；窗口默认使用它
+        static std::shared_ptr<StyleSheet> GetDefault();
+        // 向样式表添加内置控件的默认样式（Control、Button、TextBox、TextBlock）
+        void AddDefaultStyles();
+
+        void SetStyle(const std::wstring& name, const Style& style);
+        bool RemoveStyle(const std::wstring& name);
+        bool HasStyle(const std::wstring& name) const;
+        // 一次替换全部样式（如切换主题），只更新一次版本号、通知一次
+        void SetStyles(std::unordered_map<std::wstring, Style> styles);
+
+        // 未定义的样式解析为内置默认值
+        std::shared_ptr<const ResolvedStyle> Resolve(const std::wstring& name, StyleState state = StyleState::Normal);
+
+        // 进程内所有样式表的版本号互不相同，换用另一个样式表同样会被发现
+        uint64_t GetVersion() const { return m_version.load(); }
+        // 实际解析（未命中缓存）的次数和全部查询次数
+        uint64_t GetResolveCount() const;
+        uint64_t GetLookupCount() const;
+
+        // 每次修改后在修改方的线程上调用 listener，应只做投递之类的轻量工作，不能在其中修改样式表
+        // 返回的编号用于 RemoveListener；RemoveListener 返回后 listener 不会再被调用
+        size_t AddListener(Listener listener);
+        void RemoveListener(size_t id);
+    };
+
+} // namespace KroubleUI
@@ -0,0 +1,100 @@
+#include "TaskPool.h"
+#include <algorithm>
+#include <atomic>
+
+namespace KroubleUI {
+
+    TaskPool::TaskPool(size_t threadCount) : m_stopping(false) {
+        if (threadCount == 0) {
+            unsigned int cores = std::thread::hardware_concurrency();
+            threadCount = cores > 1 ? cores - 1 : 1;
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back(&TaskPool::WorkerLoop, this);
+        }
+    }
+
+    TaskPool::~TaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    std::shared_ptr<TaskPool> TaskPool::GetDefault() {
+        static std::shared_ptr<TaskPool> pool = std::make_shared<TaskPool>();
+        return pool;
+    }
+
+    void TaskPool::Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        m_wake.notify_one();
+    }
+
+    void TaskPool::WorkerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+                // 退出前先做完已经提交的任务
+                if (m_tasks.empty()) return;
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    void TaskPool::ParallelFor(size_t count, const std::function<void(size_t)>& body) {
+        if (count == 0) return;
+        if (count == 1) {
+            body(0);
+            return;
+        }
+
+        struct State {
+            std::atomic<size_t> next;
+            std::atomic<size_t> done;
+            size_t count;
+            const std::function<void(size_t)>* body;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto state = std::make_shared<State>();
+        state->next = 0;
+        state->done = 0;
+        state->count = count;
+        state->body = &body;
+
+        // 辅助任务可能在全部完成之后才开始执行，此时拿不到下标，不会再访问 body
+        auto run = [state]() {
+            for (;;) {
+                size_t index = state->next.fetch_add(1);
+                if (index >= state->count) return;
+                (*state->body)(index);
+                if (state->done.fetch_add(1) + 1 == state->count) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->finished.notify_all();
+                }
+            }
+        };
+
+        size_t helpers = (std::min)(m_threads.size(), count - 1);
+        for (size_t i = 0; i < helpers; ++i) {
+            Submit(run);
+        }
+        run();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&state]() { return state->done.load() == state->count; });
+    }
+
+} // namespace KroubleUI
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace KroubleUI {
+
+    // 固定线程数的后台任务队列，ParallelFor 让调用线程也一起执行
+    class TaskPool {
+    private:
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<std::function<void()>> m_tasks;
+        bool m_stopping;
+
+        void WorkerLoop();
+
+    public:
+        // threadCount 为 0 时按处理器数量减一创建，至少一个
+        explicit TaskPool(size_t threadCount = 0);
+        // 先执行完已经提交的任务再退出
+        ~TaskPool();
+        TaskPool(const TaskPool&) = delete;
+        TaskPool& operator=(const TaskPool&) = delete;
+
+        // 进程共享的线程池
+        static std::shared_ptr<TaskPool> GetDefault();
+
+        size_t GetThreadCount() const { return m_threads.size(); }
+        void Submit(std::function<void()> task);
+
+        // 由线程池和调用线程一起执行 body(0) 到 body(count - 1)，全部完成后返回
+        // 调用线程也参与执行，因此可以在线程池自己的任务中调用
+        void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+    };
+
+} // namespace KroubleUI
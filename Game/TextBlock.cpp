@@ -4,44 +4,83 @@ namespace KroubleUI {
 	TextBlock::TextBlock(Window* parent, const D2D1_RECT_F& rect, const std::wstring& text)
 		: Control(parent, rect), m_text(text), m_textBrush(nullptr), m_textFormat(nullptr),
 		m_wordWrap(true), m_textAlignment(DWRITE_TEXT_ALIGNMENT_LEADING),
-		m_paragraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR) {
-		m_dwriteFactory = nullptr; // ʼΪnullptr
+		m_paragraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR), m_fontSize(14.0f) {
+		SetStyleName(L"TextBlock");
 		Initialize(parent->GetRenderTarget(), parent->GetDWriteFactory());
 	}
 
 	void TextBlock::Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory) {
-		// ı
-		renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black), &m_textBrush);
-		// ʣĬ͸
-		renderTarget->CreateSolidColorBrush(D2D1::ColorF(0, 0), &m_backgroundBrush);
-		m_dwriteFactory = dwriteFactory;
-		// ıʽ
-		dwriteFactory->CreateTextFormat(
-			L"Microsoft YaHei", // ֧ĵ
-			nullptr,
-			DWRITE_FONT_WEIGHT_NORMAL,
-			DWRITE_FONT_STYLE_NORMAL,
-			DWRITE_FONT_STRETCH_NORMAL,
-			14.0f,
-			L"zh-cn", // locale
-			&m_textFormat
-		);
+		// 创建文本画笔和背景画笔，颜色来自样式
+		const ResolvedStyle& style = GetStyle();
+		renderTarget->CreateSolidColorBrush(ToColorF(style.foreground), &m_textBrush);
+		renderTarget->CreateSolidColorBrush(ToColorF(style.background), &m_backgroundBrush);
+		TrackResource(m_textBrush);
+		TrackResource(m_backgroundBrush);
 
-		// óʼʽ
+		// 获取初始文本格式
 		UpdateTextFormat();
 
 	}
 
+	void TextBlock::OnStyleChanged() {
+		// 样式变化会覆盖之前用 SetTextColor、SetFontSize 等单独设置的值
+		const ResolvedStyle& style = GetStyle();
+		m_fontSize = style.fontSize;
+		if (m_textBrush) m_textBrush->SetColor(ToColorF(style.foreground));
+		if (m_backgroundBrush) m_backgroundBrush->SetColor(ToColorF(style.background));
+		// 构造时样式先于资源设置，由 Initialize 创建文本格式
+		if (m_textBrush) {
+			UpdateTextFormat();
+		}
+	}
+
+	void TextBlock::SetFontSize(float size) {
+		if (m_fontSize != size) {
+			m_fontSize = size;
+			UpdateTextFormat();
+		}
+	}
+
+	void TextBlock::UpdateTextFormat() {
+		// 共享的文本格式不能修改，属性变化时换用缓存中对应的格式
+		TextFormatDesc desc;
+		ApplyFont(GetStyle(), &desc);
+		desc.size = m_fontSize;
+		desc.textAlignment = m_textAlignment;
+		desc.paragraphAlignment = m_paragraphAlignment;
+		desc.wordWrapping = m_wordWrap ? DWRITE_WORD_WRAPPING_WRAP : DWRITE_WORD_WRAPPING_NO_WRAP;
+
+		IDWriteTextFormat* format = m_parent->GetGraphicsContext()->GetTextFormat(desc);
+		ReleaseResource(&m_textFormat);
+		m_textFormat = format;
+		TrackResource(m_textFormat);
+		InvalidateText();
+		Invalidate();
+	}
+
+	void TextBlock::OnCollectTextWork(std::vector<TextWork>* work) {
+		if (!m_textFormat || m_text.empty()) return;
+		work->push_back({ m_text.c_str(), static_cast<UINT32>(m_text.length()), m_textFormat,
+			m_rect.right - m_rect.left, m_rect.bottom - m_rect.top, nullptr });
+	}
+
+	size_t TextBlock::GetCpuBytes() const {
+		return sizeof(TextBlock) + m_text.capacity() * sizeof(wchar_t);
+	}
+
 	void TextBlock::Draw(ID2D1RenderTarget* renderTarget) {
 		if (!m_visible || m_text.empty()) return;
-		// Ʊ
+		// 绘制背景
 		if (m_backgroundBrush) {
 			D2D1_COLOR_F bgColor = m_backgroundBrush->GetColor();
-			if (bgColor.a > 0) {  // ֻзȫ͸ʱŻ
-				renderTarget->FillRectangle(m_rect, m_backgroundBrush);
+			if (bgColor.a > 0) {  // 只有非完全透明时才绘制
+				FillRectangle(renderTarget, m_rect, m_backgroundBrush);
 			}
 		}
-		renderTarget->DrawTextW(
+		// 排版结果由窗口在绘制前准备好
+		DrawPreparedText(
+			renderTarget,
+			GetPreparedText(0),
 			m_text.c_str(),
 			static_cast<UINT32>(m_text.length()),
 			m_textFormat,
@@ -50,17 +89,19 @@ namespace KroubleUI {
 		);
 	}
 
-	// ɫ÷
+	// 新增背景色设置方法
 	void TextBlock::SetBackgroundColor(const D2D1_COLOR_F& color) {
 		if (m_backgroundBrush) {
 			m_backgroundBrush->SetColor(color);
 		}
 		else if (m_parent) {
-			// δʼӳٵDrawʱ
+			// 如果尚未初始化，延迟到Draw时处理
 			ID2D1RenderTarget* rt = m_parent->GetRenderTarget();
 			if (rt) {
 				rt->CreateSolidColorBrush(color, &m_backgroundBrush);
+				TrackResource(m_backgroundBrush);
 			}
 		}
+		Invalidate();
 	}
 }
\ No newline at end of file
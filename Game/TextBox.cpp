@@ -1,58 +1,199 @@
 #include "KroubleUI.h"
+#include <algorithm>
+#include <cmath>
 
 namespace KroubleUI {
+	namespace {
+		const size_t kSyncIndexChars = 65536;       // Pending text up to this size is indexed on the UI thread
+		const size_t kTailScanChars = 65536;        // Most text scanned backward to find the tail while indexing
+		const float kTextPadding = 5.0f;
+		const int kWheelLines = 3;
+	}
+
+	// State shared between the UI thread and background indexing tasks
+	struct TextBox::SharedState {
+		std::atomic<UINT64> generation;     // Bumped whenever the index is reset; stale tasks exit early
+		TextBox* owner;                     // Only touched on the UI thread, cleared on destruction
+		Window* window;
+		std::mutex mutex;
+		std::condition_variable idle;
+		int running;
+
+		SharedState() : generation(0), owner(nullptr), window(nullptr), running(0) {}
+	};
+
+	// Everything a background indexing task needs, fixed at submission
+	struct TextBox::IndexRequest {
+		UINT64 generation;
+		ChunkedText text;                   // Snapshot; the task's references keep the data alive and unmodified
+		std::shared_ptr<TaskPool> pool;
+		size_t begin;
+		size_t end;
+		size_t lastLineStart;
+	};
+
 	TextBox::TextBox(Window* parent, const D2D1_RECT_F& rect, const std::wstring& initialText)
-		: Control(parent, rect), m_text(initialText), m_hasFocus(false),
+		: Control(parent, rect), m_pool(TaskPool::GetDefault()),
+		m_shared(std::make_shared<SharedState>()), m_indexing(false), m_lastIndexSeconds(0.0),
+		m_firstLine(0), m_followTail(true), m_lineHeight(20.0f), m_flatValid(true), m_hasFocus(false),
 		m_isComposing(false), m_borderBrush(nullptr), m_backgroundBrush(nullptr),
-		m_textBrush(nullptr), m_compositionBrush(nullptr), m_textFormat(nullptr){
+		m_textBrush(nullptr), m_compositionBrush(nullptr), m_textFormat(nullptr),
+		m_borderWidth(1.0f), m_focusedBorderWidth(2.0f), m_preparedFirstLine(0), m_preparedTail(false) {
+		m_shared->owner = this;
+		m_shared->window = parent;
+		SetStyleName(L"TextBox");
 		Initialize(parent->GetRenderTarget(), parent->GetDWriteFactory());
+		LoadText(initialText);
+	}
+
+	TextBox::~TextBox() {
+		// Cancel background indexing and wait for it, so no task touches the window afterwards
+		m_shared->owner = nullptr;
+		m_shared->generation.fetch_add(1);
+		{
+			std::unique_lock<std::mutex> lock(m_shared->mutex);
+			m_shared->idle.wait(lock, [this]() { return m_shared->running == 0; });
+		}
+
+		ReleaseResource(&m_borderBrush);
+		ReleaseResource(&m_backgroundBrush);
+		ReleaseResource(&m_textBrush);
+		ReleaseResource(&m_compositionBrush);
+		ReleaseResource(&m_textFormat);
 	}
 
 	void TextBox::Initialize(ID2D1RenderTarget* renderTarget, IDWriteFactory* dwriteFactory) {
-		// Create brushes
+		// Create brushes; their colors come from the style
 		renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black), &m_borderBrush);
 		renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_backgroundBrush);
 		renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black), &m_textBrush);
 		renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Gray), &m_compositionBrush);
+		TrackResource(m_borderBrush);
+		TrackResource(m_backgroundBrush);
+		TrackResource(m_textBrush);
+		TrackResource(m_compositionBrush);
+		UpdateTextColors();
+		UpdateTextFormat(dwriteFactory);
+	}
+
+	void TextBox::UpdateTextFormat(IDWriteFactory* dwriteFactory) {
+		ReleaseResource(&m_textFormat);
+
+		// Get the shared text format from the graphics context.
+		// Each line is drawn on its own, so lines never wrap
+		TextFormatDesc desc;
+		ApplyFont(GetStyle(), &desc);
+		desc.textAlignment = DWRITE_TEXT_ALIGNMENT_LEADING;
+		desc.paragraphAlignment = DWRITE_PARAGRAPH_ALIGNMENT_CENTER;
+		desc.wordWrapping = DWRITE_WORD_WRAPPING_NO_WRAP;
+		m_textFormat = m_parent->GetGraphicsContext()->GetTextFormat(desc);
+		TrackResource(m_textFormat);
+
+		if (m_textFormat) {
+			// Measure the line height with a sample line
+			IDWriteTextLayout* probe = nullptr;
+			dwriteFactory->CreateTextLayout(L"Ag", 2, m_textFormat, 1000.0f, 1000.0f, &probe);
+			if (probe) {
+				DWRITE_TEXT_METRICS metrics;
+				if (SUCCEEDED(probe->GetMetrics(&metrics)) && metrics.height > 0) {
+					m_lineHeight = std::ceil(metrics.height);
+				}
+				probe->Release();
+			}
+		}
+		InvalidateText();
+	}
+
+	void TextBox::UpdateTextColors() {
+		const ResolvedStyle& style = GetStyle(IsEnabled() ? StyleState::Normal : StyleState::Disabled);
+		if (m_borderBrush) m_borderBrush->SetColor(ToColorF(style.border));
+		if (m_backgroundBrush) m_backgroundBrush->SetColor(ToColorF(style.background));
+		if (m_textBrush) m_textBrush->SetColor(ToColorF(style.foreground));
+	}
+
+	void TextBox::OnStyleChanged() {
+		m_borderWidth = GetStyle().borderWidth;
+		m_focusedBorderWidth = GetStyle(StyleState::Focused).borderWidth;
+		UpdateTextColors();
+		// The constructor sets the style before any resource exists; Initialize picks it up then
+		if (m_textBrush) {
+			UpdateTextFormat(m_parent->GetDWriteFactory());
+			if (m_followTail) {
+				ScrollToLine(m_lines.GetLineCount());
+			}
+		}
+		Invalidate();
+	}
 
-		// Create text format
-		dwriteFactory->CreateTextFormat(
-			L"Microsoft YaHei", // Use a font that supports Chinese characters
-			nullptr,
-			DWRITE_FONT_WEIGHT_NORMAL,
-			DWRITE_FONT_STYLE_NORMAL,
-			DWRITE_FONT_STRETCH_NORMAL,
-			14.0f,
-			L"zh-cn",          // Set locale to Chinese
-			&m_textFormat
-		);
+	void TextBox::OnEnabledChanged() {
+		if (!IsEnabled() && m_hasFocus) {
+			m_hasFocus = false;
+			m_isComposing = false;
+			m_compositionString.clear();
+			m_focusChanged.Emit(false);
+		}
+		UpdateTextColors();
+	}
 
-		m_textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_LEADING);
-		m_textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
+	size_t TextBox::GetCpuBytes() const {
+		size_t bytes = sizeof(TextBox) + sizeof(SharedState) + m_text.GetCpuBytes() + m_lines.GetCpuBytes();
+		bytes += m_tailLines.capacity() * sizeof(size_t);
+		bytes += (m_lineText.capacity() + m_flatText.capacity() + m_compositionString.capacity()) * sizeof(wchar_t);
+		for (const std::wstring& line : m_preparedLines) {
+			bytes += sizeof(std::wstring) + line.capacity() * sizeof(wchar_t);
+		}
+		return bytes;
 	}
 
 	void TextBox::Draw(ID2D1RenderTarget* renderTarget) {
 		if (!m_visible) return;
-		// Ʊͱ߿...
-		renderTarget->FillRectangle(m_rect, m_backgroundBrush);
-		renderTarget->DrawRectangle(m_rect, m_borderBrush, m_hasFocus ? 2.0f : 1.0f);
-		D2D1_RECT_F textRect = m_rect;
-		// ı
-		if (!m_text.empty()) {
-			textRect.left += 5.0f;
-			textRect.right -= 5.0f;
-			renderTarget->DrawTextW(
-				m_text.c_str(),
-				static_cast<UINT32>(m_text.length()),
-				m_textFormat,
-				textRect,
-				m_textBrush
-			);
+		// 绘制背景和边框...
+		FillRectangle(renderTarget, m_rect, m_backgroundBrush);
+		DrawRectangleOutline(renderTarget, m_rect, m_borderBrush, m_hasFocus ? m_focusedBorderWidth : m_borderWidth);
+
+		// A single line keeps the original vertically centered look; more lines start at the top
+		size_t lineCount = m_lines.GetLineCount();
+		float top = lineCount == 1 && !m_indexing
+			? (m_rect.top + m_rect.bottom - m_lineHeight) / 2
+			: m_rect.top + kTextPadding;
+		D2D1_RECT_F textRect = D2D1::RectF(m_rect.left + kTextPadding, top, m_rect.right - kTextPadding, top + m_lineHeight);
+
+		// 绘制文本，只处理可见的行
+		PushClip(renderTarget, m_rect);
+		size_t rowCount = GetRowCount();
+		bool showsTail = !m_tailLines.empty();
+		bool prepared = m_preparedTail == showsTail && (showsTail || m_preparedFirstLine == m_firstLine);
+		for (size_t row = 0; row < rowCount; ++row) {
+			// Lines laid out by the window before this frame are drawn as they are
+			const PreparedText* preparedRow = prepared && row < m_preparedLines.size() ? GetPreparedText(row) : nullptr;
+			if (preparedRow) {
+				const std::wstring& text = m_preparedLines[row];
+				DrawPreparedText(renderTarget, preparedRow, text.c_str(), static_cast<UINT32>(text.length()),
+					m_textFormat, textRect, m_textBrush);
+			}
+			else {
+				GetRowText(row, &m_lineText);
+				if (!m_lineText.empty()) {
+					DrawTextRun(
+						renderTarget,
+						m_lineText.c_str(),
+						static_cast<UINT32>(m_lineText.length()),
+						m_textFormat,
+						textRect,
+						m_textBrush
+					);
+				}
+			}
+			if (row + 1 < rowCount) {
+				textRect.top += m_lineHeight;
+				textRect.bottom += m_lineHeight;
+			}
 		}
 
 		// Draw composition string if in IME composition mode
 		if (m_isComposing && !m_compositionString.empty()) {
-			renderTarget->DrawTextW(
+			DrawTextRun(
+				renderTarget,
 				m_compositionString.c_str(),
 				static_cast<UINT32>(m_compositionString.length()),
 				m_textFormat,
@@ -60,9 +201,26 @@ namespace KroubleUI {
 				m_compositionBrush
 			);
 		}
+		PopClip(renderTarget);
+	}
+
+	void TextBox::OnCollectTextWork(std::vector<TextWork>* work) {
+		if (!m_textFormat) return;
+
+		// The strings must not move while the window lays them out, so size the vector first
+		m_preparedFirstLine = m_firstLine;
+		m_preparedTail = !m_tailLines.empty();
+		m_preparedLines.resize(GetRowCount());
+		float width = m_rect.right - m_rect.left - 2 * kTextPadding;
+		for (size_t i = 0; i < m_preparedLines.size(); ++i) {
+			std::wstring& text = m_preparedLines[i];
+			GetRowText(i, &text);
+			work->push_back({ text.c_str(), static_cast<UINT32>(text.length()), m_textFormat, width, m_lineHeight, nullptr });
+		}
 	}
 
 	void TextBox::OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) {
+		bool hadFocus = m_hasFocus;
 		if (message == WM_LBUTTONDOWN) {
 			POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
 			if (PtInRectF(m_rect, pt)) {
@@ -78,7 +236,16 @@ namespace KroubleUI {
 				m_hasFocus = false;
 			}
 		}
-		
+		else if (message == WM_MOUSEWHEEL) {
+			double notches = GET_WHEEL_DELTA_WPARAM(wParam) / static_cast<double>(WHEEL_DELTA);
+			double line = static_cast<double>(m_firstLine) - std::round(notches * kWheelLines);
+			ScrollToLine(static_cast<size_t>((std::max)(line, 0.0)));
+		}
+		// Focus changes the border width
+		if (m_hasFocus != hadFocus) {
+			Invalidate();
+			m_focusChanged.Emit(m_hasFocus);
+		}
 	}
 
 	void TextBox::OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) {
@@ -86,12 +253,20 @@ namespace KroubleUI {
 		
 		case WM_CHAR:
 			if (wParam == VK_BACK) {
-				if (!m_text.empty()) {
-					m_text.pop_back();
+				if (!m_text.IsEmpty()) {
+					RemoveLastChar();
 				}
 			}
+			else if (wParam == 0x16) { // Ctrl+V
+				if (m_hasFocus) {
+					Paste();
+				}
+				return;
+			}
 			else if (wParam >= 32) { // Accept any printable character
-				m_text += static_cast<wchar_t>(wParam);
+				wchar_t ch = static_cast<wchar_t>(wParam);
+				m_followTail = true;
+				AppendText(&ch, 1);
 
 			}
 			break;
@@ -102,16 +277,16 @@ namespace KroubleUI {
 		case WM_IME_COMPOSITION: {
 			HIMC hImc = ImmGetContext(m_parent->GetHwnd());
 			if (hImc) {
-				// 뷨λãڿؼ·
+				// 设置输入法窗口位置（在控件下方）
 				COMPOSITIONFORM cf = { 0 };
 				cf.dwStyle = CFS_POINT;
 				cf.ptCurrentPos.x = static_cast<LONG>(m_rect.left);
 				cf.ptCurrentPos.y = static_cast<LONG>(m_rect.bottom);
 				ImmSetCompositionWindow(hImc, &cf);
 
-				// ԭд߼...
+				// 原有处理逻辑...
 				if (lParam & GCS_COMPSTR) {
-					// ȡַ
+					// 获取组合字符串
 					LONG len = ImmGetCompositionStringW(hImc, GCS_COMPSTR, nullptr, 0);
 					if (len > 0) {
 						m_compositionString.resize(len / sizeof(wchar_t));
@@ -136,7 +311,8 @@ namespace KroubleUI {
 							std::wstring resultStr;
 							resultStr.resize(len / sizeof(wchar_t));
 							ImmGetCompositionStringW(hImc, GCS_RESULTSTR, &resultStr[0], len);
-							m_text += resultStr;
+							m_followTail = true;
+							AppendText(resultStr);
 						}
 						m_isComposing = false;
 						m_compositionString.clear();
@@ -152,10 +328,238 @@ namespace KroubleUI {
 			m_isComposing = false;
 			m_compositionString.clear();
 			break;
+
+		default:
+			return;
 		}
+		Invalidate();
 	}
 
-	void TextBox::SetText(const std::wstring& text) {
-		m_text = text;
+	const std::wstring& TextBox::GetText() const {
+		if (!m_flatValid) {
+			m_text.Flatten(&m_flatText);
+			m_flatValid = true;
+		}
+		return m_flatText;
+	}
+
+	void TextBox::LoadText(std::wstring text) {
+		CancelIndexing();
+		m_lines.Clear();
+		m_tailLines.clear();
+		m_firstLine = 0;
+		m_followTail = false;
+		m_flatValid = false;
+		std::wstring().swap(m_flatText);
+		m_text.Assign(std::move(text));
+
+		// Index the first screen right away so it appears in the next frame
+		IndexNow(kSyncIndexChars);
+		ScheduleIndexing();
+		// Show loaded text from the top; follow new text only if everything already fits
+		m_followTail = !m_indexing && m_lines.GetLineCount() <= GetVisibleLineCount();
+		InvalidateText();
+		Invalidate();
+		m_textChanged.Emit();
+	}
+
+	void TextBox::AppendText(const wchar_t* text, size_t length) {
+		if (length == 0) return;
+		m_text.Append(text, length);
+		OnTextAppended(length);
+	}
+
+	void TextBox::AppendText(std::wstring&& text) {
+		size_t length = text.size();
+		if (length == 0) return;
+		m_text.Append(std::move(text));
+		OnTextAppended(length);
+	}
+
+	bool TextBox::Paste() {
+		if (!OpenClipboard(m_parent->GetHwnd())) return false;
+
+		std::wstring text;
+		HANDLE data = GetClipboardData(CF_UNICODETEXT);
+		const wchar_t* locked = data ? static_cast<const wchar_t*>(GlobalLock(data)) : nullptr;
+		if (locked) {
+			// The clipboard block may be larger than the string it holds
+			size_t capacity = GlobalSize(data) / sizeof(wchar_t);
+			text.assign(locked, std::find(locked, locked + capacity, L'\0'));
+			GlobalUnlock(data);
+		}
+		CloseClipboard();
+
+		if (text.empty()) return false;
+		// A large paste is indexed in the background; OnTextAppended shows its tail right away
+		m_followTail = true;
+		AppendText(std::move(text));
+		return true;
+	}
+
+	void TextBox::OnTextAppended(size_t length) {
+		m_flatValid = false;
+		ScheduleIndexing();
+		UpdateTail();
+		InvalidateText();
+		Invalidate();
+		m_textChanged.Emit();
+	}
+
+	void TextBox::RemoveLastChar() {
+		m_text.RemoveLast();
+		m_flatValid = false;
+
+		// A running task may have scanned the removed character
+		if (m_indexing) {
+			CancelIndexing();
+		}
+		m_lines.Truncate(m_text, m_text.GetLength());
+		ScheduleIndexing();
+		ScrollToLine(m_firstLine);
+		UpdateTail();
+		InvalidateText();
+		m_textChanged.Emit();
+	}
+
+	void TextBox::CancelIndexing() {
+		m_shared->generation.fetch_add(1);
+		m_indexing = false;
+	}
+
+	void TextBox::ScheduleIndexing() {
+		size_t indexed = m_lines.GetIndexedLength();
+		if (m_indexing || indexed >= m_text.GetLength()) return;
+
+		// Typing and small appends are cheaper to index right here
+		if (m_text.GetLength() - indexed <= kSyncIndexChars) {
+			IndexNow(kSyncIndexChars);
+			return;
+		}
+
+		std::shared_ptr<IndexRequest> request = std::make_shared<IndexRequest>();
+		request->generation = m_shared->generation.fetch_add(1) + 1;
+		request->text = m_text;
+		request->pool = m_pool;
+		request->begin = indexed;
+		request->end = m_text.GetLength();
+		request->lastLineStart = m_lines.GetLastLineStart();
+
+		{
+			std::lock_guard<std::mutex> lock(m_shared->mutex);
+			++m_shared->running;
+		}
+		m_indexing = true;
+
+		std::shared_ptr<SharedState> shared = m_shared;
+		m_pool->Submit([shared, request]() { IndexLines(shared, request); });
+	}
+
+	void TextBox::IndexNow(size_t limit) {
+		size_t indexed = m_lines.GetIndexedLength();
+		if (indexed >= m_text.GetLength()) return;
+
+		m_lines.IndexTo(m_text, indexed + limit);
+		if (m_followTail) {
+			ScrollToLine(m_lines.GetLineCount());
+		}
+	}
+
+	void TextBox::OnLinesIndexed(const std::vector<size_t>& lineStarts, size_t end, double seconds) {
+		m_lines.Append(lineStarts, end);
+		m_indexing = false;
+		m_lastIndexSeconds = seconds;
+
+		// Text appended while the task was running
+		ScheduleIndexing();
+		if (m_followTail) {
+			ScrollToLine(m_lines.GetLineCount());
+		}
+		UpdateTail();
+		InvalidateText();
+		Invalidate();
+	}
+
+	void TextBox::UpdateTail() {
+		// Until the index reaches the end, the tail lines have no line numbers yet.
+		// Scanning backward from the end finds them without waiting for the background task
+		bool hadTail = !m_tailLines.empty();
+		if (m_followTail && m_lines.GetIndexedLength() < m_text.GetLength()) {
+			LineIndex::FindTailLines(m_text, m_lines.GetLastLineStart(), GetVisibleLineCount(), kTailScanChars, &m_tailLines);
+		}
+		else {
+			m_tailLines.clear();
+		}
+		if (hadTail || !m_tailLines.empty()) {
+			InvalidateText();
+			Invalidate();
+		}
+	}
+
+	size_t TextBox::GetRowCount() const {
+		if (!m_tailLines.empty()) return m_tailLines.size();
+		return (std::min)(m_lines.GetLineCount(), m_firstLine + GetVisibleLineCount()) - m_firstLine;
+	}
+
+	void TextBox::GetRowText(size_t row, std::wstring* out) const {
+		if (m_tailLines.empty()) {
+			m_lines.GetLineText(m_text, m_firstLine + row, out);
+			return;
+		}
+		size_t end = row + 1 < m_tailLines.size() ? m_tailLines[row + 1] : m_text.GetLength();
+		LineIndex::ReadLine(m_text, m_tailLines[row], end, out);
+	}
+
+	void TextBox::IndexLines(std::shared_ptr<SharedState> shared, std::shared_ptr<IndexRequest> request) {
+		// Let the destructor wait for the task however it ends
+		struct RunningGuard {
+			SharedState* shared;
+			~RunningGuard() {
+				std::lock_guard<std::mutex> lock(shared->mutex);
+				--shared->running;
+				shared->idle.notify_all();
+			}
+		} guard = { shared.get() };
+
+		SystemClock clock;
+		double start = clock.Now();
+		auto cancelled = [&shared, &request]() { return shared->generation.load() != request->generation; };
+
+		std::shared_ptr<std::vector<size_t>> lineStarts = std::make_shared<std::vector<size_t>>();
+		if (!LineIndex::Scan(request->text, request->begin, request->end, request->lastLineStart, *request->pool,
+			cancelled, lineStarts.get())) {
+			return;
+		}
+
+		double seconds = clock.Now() - start;
+		shared->window->PostTask([shared, request, lineStarts, seconds]() {
+			// Drop the result if the control is gone or the index was reset
+			if (shared->owner && shared->generation.load() == request->generation) {
+				shared->owner->OnLinesIndexed(*lineStarts, request->end, seconds);
+			}
+		});
+	}
+
+	size_t TextBox::GetVisibleLineCount() const {
+		float height = (std::max)(0.0f, m_rect.bottom - m_rect.top - 2 * kTextPadding);
+		return (std::max)(size_t(1), static_cast<size_t>(height / m_lineHeight));
+	}
+
+	void TextBox::ScrollToLine(size_t line) {
+		size_t visible = GetVisibleLineCount();
+		size_t lineCount = m_lines.GetLineCount();
+		size_t maxFirst = lineCount > visible ? lineCount - visible : 0;
+		size_t first = (std::min)(line, maxFirst);
+		bool wasFollowing = m_followTail;
+		m_followTail = first == maxFirst;
+		if (first != m_firstLine) {
+			m_firstLine = first;
+			InvalidateText();
+			Invalidate();
+		}
+		// Scrolling away from the end stops showing the tail; scrolling back shows it again
+		if (m_followTail != wasFollowing) {
+			UpdateTail();
+		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,22 @@
+#include "TextFormatDesc.h"
+
+#include <functional>
+
+namespace KroubleUI {
+
+    size_t TextFormatDescHash::operator()(const TextFormatDesc& desc) const {
+        size_t hash = std::hash<std::wstring>()(desc.family);
+        auto combine = [&hash](size_t value) {
+            hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        };
+        combine(std::hash<float>()(desc.size));
+        combine(desc.weight);
+        combine(desc.style);
+        combine(desc.textAlignment);
+        combine(desc.paragraphAlignment);
+        combine(desc.wordWrapping);
+        combine(std::hash<std::wstring>()(desc.locale));
+        return hash;
+    }
+
+} // namespace KroubleUI
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace KroubleUI {
+
+    // 文本格式描述，同时作为共享文本格式缓存的键
+    // 枚举字段的取值与 DirectWrite 相同，创建格式时再转换为对应的枚举类型
+    struct TextFormatDesc {
+        std::wstring family = L"Microsoft YaHei";
+        float size = 14.0f;
+        uint32_t weight = 400;              // DWRITE_FONT_WEIGHT_NORMAL
+        uint32_t style = 0;                 // DWRITE_FONT_STYLE_NORMAL
+        uint32_t textAlignment = 0;         // DWRITE_TEXT_ALIGNMENT_LEADING
+        uint32_t paragraphAlignment = 0;    // DWRITE_PARAGRAPH_ALIGNMENT_NEAR
+        uint32_t wordWrapping = 0;          // DWRITE_WORD_WRAPPING_WRAP
+        std::wstring locale = L"zh-cn";
+
+        bool operator==(const TextFormatDesc& other) const {
+            return family == other.family && size == other.size && weight == other.weight &&
+                style == other.style && textAlignment == other.textAlignment &&
+                paragraphAlignment == other.paragraphAlignment &&
+                wordWrapping == other.wordWrapping && locale == other.locale;
+        }
+    };
+
+    struct TextFormatDescHash {
+        size_t operator()(const TextFormatDesc& desc) const;
+    };
+
+} // namespace KroubleUI
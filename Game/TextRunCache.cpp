@@ -0,0 +1,200 @@
+#include "TextRunCache.h"
+#include "TaskPool.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace KroubleUI {
+
+    namespace {
+        // 少于这么多段文本时直接在调用线程上排版，分发到线程池得不偿失
+        const size_t kParallelTextWork = 32;
+
+        size_t HashKey(const wchar_t* text, uint32_t length, const void* format, float width, float height) {
+            // FNV-1a，查找时不必为文本构造字符串
+            size_t hash = static_cast<size_t>(14695981039346656037ULL);
+            for (uint32_t i = 0; i < length; ++i) {
+                hash ^= static_cast<size_t>(text[i]);
+                hash *= static_cast<size_t>(1099511628211ULL);
+            }
+            auto combine = [&hash](size_t value) {
+                hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            };
+            combine(std::hash<const void*>()(format));
+            combine(std::hash<float>()(width));
+            combine(std::hash<float>()(height));
+            return hash;
+        }
+    }
+
+    TextRunCache::TextRunCache(std::shared_ptr<TextShaper> shaper, const TextFormatRefPolicy& formatPolicy, size_t budget,
+        size_t shardCount)
+        : m_shaper(shaper), m_formatPolicy(formatPolicy), m_shardCount((std::max)(shardCount, size_t(1))), m_budget(budget) {
+        m_shards.reset(new Shard[m_shardCount]);
+        for (size_t i = 0; i < m_shardCount; ++i) {
+            m_shards[i].budget = budget / m_shardCount;
+        }
+    }
+
+    TextRunCache::~TextRunCache() {
+        Clear();
+    }
+
+    std::shared_ptr<const TextRun> TextRunCache::Acquire(const wchar_t* text, uint32_t length, const void* format,
+        float width, float height) {
+        if (length == 0 || length > kMaxTextLength || !format) return nullptr;
+
+        size_t hash = HashKey(text, length, format, width, height);
+        Shard& shard = GetShard(hash);
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            EntryIterator entry = Find(shard, hash, text, length, format, width, height);
+            if (entry != shard.entries.end()) {
+                ++shard.stats.hits;
+                shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+                return entry->run;
+            }
+            ++shard.stats.misses;
+        }
+
+        // 排版不持有锁，其他线程的命中不必等待
+        std::shared_ptr<const TextRun> run = m_shaper->Shape(text, length, format, width, height);
+        if (!run) return nullptr;
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        EntryIterator entry = Find(shard, hash, text, length, format, width, height);
+        if (entry != shard.entries.end()) {
+            // 另一个线程同时排版了同一段文本，使用先加入的结果
+            return entry->run;
+        }
+
+        Entry added;
+        added.text.assign(text, length);
+        added.format = format;
+        if (m_formatPolicy.addRef) m_formatPolicy.addRef(format);
+        added.width = width;
+        added.height = height;
+        added.hash = hash;
+        added.run = run;
+        shard.entries.push_front(std::move(added));
+        shard.index.emplace(hash, shard.entries.begin());
+        shard.stats.entries = shard.entries.size();
+        shard.stats.bytes += run->GetBytes() + length * sizeof(wchar_t);
+        EvictToBudget(shard);
+        return run;
+    }
+
+    std::shared_ptr<const TextRun> TextRunCache::Shape(const wchar_t* text, uint32_t length, const void* format,
+        float width, float height) {
+        if (length == 0 || !format) return nullptr;
+        if (length <= kMaxTextLength) {
+            return Acquire(text, length, format, width, height);
+        }
+        return m_shaper->Shape(text, length, format, width, height);
+    }
+
+    TextRunCache::EntryIterator TextRunCache::Find(Shard& shard, size_t hash, const wchar_t* text, uint32_t length,
+        const void* format, float width, float height) {
+        auto range = shard.index.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            const Entry& entry = *it->second;
+            if (entry.format == format && entry.width == width && entry.height == height &&
+                entry.text.size() == length && entry.text.compare(0, length, text, length) == 0) {
+                return it->second;
+            }
+        }
+        return shard.entries.end();
+    }
+
+    void TextRunCache::EvictToBudget(Shard& shard) {
+        // 至少保留刚加入的一项
+        while (shard.stats.bytes > shard.budget && shard.entries.size() > 1) {
+            Remove(shard, std::prev(shard.entries.end()));
+            ++shard.stats.evictions;
+        }
+    }
+
+    void TextRunCache::Remove(Shard& shard, EntryIterator entry) {
+        auto range = shard.index.equal_range(entry->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == entry) {
+                shard.index.erase(it);
+                break;
+            }
+        }
+
+        size_t bytes = entry->run->GetBytes() + entry->text.size() * sizeof(wchar_t);
+        shard.stats.bytes -= (std::min)(shard.stats.bytes, bytes);
+        if (m_formatPolicy.release) m_formatPolicy.release(entry->format);
+        shard.entries.erase(entry);
+        shard.stats.entries = shard.entries.size();
+    }
+
+    void TextRunCache::SetBudget(size_t bytes) {
+        m_budget = bytes;
+        for (size_t i = 0; i < m_shardCount; ++i) {
+            Shard& shard = m_shards[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.budget = bytes / m_shardCount;
+            EvictToBudget(shard);
+        }
+    }
+
+    size_t TextRunCache::GetBudget() const {
+        return m_budget.load();
+    }
+
+    void TextRunCache::Clear() {
+        for (size_t i = 0; i < m_shardCount; ++i) {
+            Shard& shard = m_shards[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            while (!shard.entries.empty()) {
+                Remove(shard, shard.entries.begin());
+            }
+        }
+    }
+
+    TextRunCacheStats TextRunCache::GetStats() const {
+        TextRunCacheStats total;
+        for (size_t i = 0; i < m_shardCount; ++i) {
+            Shard& shard = m_shards[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total.hits += shard.stats.hits;
+            total.misses += shard.stats.misses;
+            total.evictions += shard.stats.evictions;
+            total.entries += shard.stats.entries;
+            total.bytes += shard.stats.bytes;
+        }
+        return total;
+    }
+
+    void TextRunCache::ResetCounters() {
+        for (size_t i = 0; i < m_shardCount; ++i) {
+            Shard& shard = m_shards[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.stats.hits = 0;
+            shard.stats.misses = 0;
+            shard.stats.evictions = 0;
+        }
+    }
+
+    void ShapeTextWork(TextRunCache* cache, std::vector<TextWork>* work, TaskPool* pool) {
+        // 每段结果写入各自的槽位，返回之后调用线程直接读取，不需要加锁
+        std::vector<TextWork>& items = *work;
+        auto shape = [cache, &items](size_t index) {
+            TextWork& item = items[index];
+            *item.run = cache->Shape(item.text, item.length, item.format, item.width, item.height);
+        };
+        if (!pool || items.size() < kParallelTextWork) {
+            for (size_t i = 0; i < items.size(); ++i) {
+                shape(i);
+            }
+        }
+        else {
+            pool->ParallelFor(items.size(), shape);
+        }
+    }
+
+} // namespace KroubleUI
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace KroubleUI {
+
+    class TaskPool;
+
+    // 短文本的排版缓存，窗口在绘制前把各控件的文本交给它批量排版
+    // 文本格式和排版结果对缓存都是不透明的：格式只作为指针比较，排版结果只用到内存估算
+
+    // 排版完成的一段文本，具体内容由排版器的派生类保存（如 DirectWriteTextRun）
+    class TextRun {
+    private:
+        size_t m_bytes;
+
+    public:
+        explicit TextRun(size_t bytes) : m_bytes(bytes) {}
+        virtual ~TextRun() {}
+        TextRun(const TextRun&) = delete;
+        TextRun& operator=(const TextRun&) = delete;
+
+        // 估算的内存占用，用于缓存的淘汰
+        size_t GetBytes() const { return m_bytes; }
+    };
+
+    // 文本排版接口，TextRunCache 通过它创建缓存项，可以替换为不调用 DirectWrite 的实现
+    // format 是调用者传给缓存的格式句柄，可能在多个线程上同时调用
+    class TextShaper {
+    public:
+        virtual ~TextShaper() {}
+        // 失败时返回空
+        virtual std::shared_ptr<TextRun> Shape(const wchar_t* text, uint32_t length, const void* format,
+            float width, float height) = 0;
+    };
+
+    // 格式句柄的引用计数：缓存项存在期间持有格式的引用，保证作为键的指针不会被重用
+    // 为空时缓存不持有引用，调用者自己保证格式比缓存项存在得久
+    struct TextFormatRefPolicy {
+        void (*addRef)(const void* format) = nullptr;
+        void (*release)(const void* format) = nullptr;
+    };
+
+    struct TextRunCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+
+        double GetHitRate() const {
+            uint64_t lookups = hits + misses;
+            return lookups ? static_cast<double>(hits) / lookups : 0.0;
+        }
+    };
+
+    // 按（文本, 格式句柄, 布局尺寸）缓存排版结果，重复出现的标签直接使用缓存的排版结果
+    // 颜色和抗锯齿方式在绘制时才使用，不影响排版，因此不作为键；字形位图由 Direct2D 按渲染目标缓存
+    // 超出内存预算时淘汰最久未使用的项，正在被使用的项在使用者释放后才销毁；可在多个线程中使用
+    // 缓存按键的哈希分成若干片，每片有自己的锁、最近使用顺序和等分的预算，多个线程同时排版时命中不必排队
+    class TextRunCache {
+    private:
+        struct Entry {
+            std::wstring text;
+            const void* format;
+            float width;
+            float height;
+            size_t hash;
+            std::shared_ptr<const TextRun> run;
+        };
+        typedef std::list<Entry>::iterator EntryIterator;
+
+        struct Shard {
+            std::mutex mutex;
+            std::list<Entry> entries;       // 最近使用的在前
+            std::unordered_multimap<size_t, EntryIterator> index;
+            size_t budget = 0;
+            TextRunCacheStats stats;
+        };
+
+        std::shared_ptr<TextShaper> m_shaper;
+        TextFormatRefPolicy m_formatPolicy;
+        std::unique_ptr<Shard[]> m_shards;
+        size_t m_shardCount;
+        std::atomic<size_t> m_budget;
+
+        Shard& GetShard(size_t hash) const { return m_shards[hash % m_shardCount]; }
+        // 以下调用时持有 shard 的锁
+        static EntryIterator Find(Shard& shard, size_t hash, const wchar_t* text, uint32_t length, const void* format,
+            float width, float height);
+        void EvictToBudget(Shard& shard);
+        void Remove(Shard& shard, EntryIterator entry);
+
+    public:
+        static constexpr uint32_t kMaxTextLength = 64;          // 更长的文本不缓存
+        static constexpr size_t kDefaultBudget = 8 << 20;
+        static constexpr size_t kDefaultShards = 16;
+
+        // 预算在各片之间等分；shardCount 为 1 时整个缓存严格按最近使用淘汰
+        TextRunCache(std::shared_ptr<TextShaper> shaper, const TextFormatRefPolicy& formatPolicy,
+            size_t budget = kDefaultBudget, size_t shardCount = kDefaultShards);
+        ~TextRunCache();
+        TextRunCache(const TextRunCache&) = delete;
+        TextRunCache& operator=(const TextRunCache&) = delete;
+
+        // 命中时返回缓存的排版结果，否则排版并加入缓存；文本过长或排版失败时返回空
+        // 排版不持有锁；两个线程同时排版同一段文本时都返回先加入缓存的结果
+        std::shared_ptr<const TextRun> Acquire(const wchar_t* text, uint32_t length, const void* format,
+            float width, float height);
+        // 短文本经过缓存，更长的文本直接交给排版器、不加入缓存；空文本或没有格式时返回空
+        std::shared_ptr<const TextRun> Shape(const wchar_t* text, uint32_t length, const void* format,
+            float width, float height);
+
+        void SetBudget(size_t bytes);
+        size_t GetBudget() const;
+        size_t GetShardCount() const { return m_shardCount; }
+        void Clear();
+        // 各片统计之和
+        TextRunCacheStats GetStats() const;
+        void ResetCounters();
+    };
+
+    // 一段待排版的文本，由窗口在绘制之前统一排版
+    // text 指向控件自己的数据，在本帧绘制结束前保持不变；结果写入 run
+    struct TextWork {
+        const wchar_t* text;
+        uint32_t length;
+        const void* format;
+        float width;
+        float height;
+        std::shared_ptr<const TextRun>* run;
+    };
+
+    // 排版一批文本，结果写入各项的 run，全部完成后返回
+    // 段数较少或 pool 为空时在调用线程上依次排版，否则由 pool 和调用线程一起排版
+    void ShapeTextWork(TextRunCache* cache, std::vector<TextWork>* work, TaskPool* pool);
+
+    // 控件保存的一段排版结果，连同排版时的文本、格式和布局尺寸
+    // 绘制时用 Matches 检查这份结果是否仍对应要绘制的内容，不对应（已过期）时不能使用
+    struct PreparedText {
+        // 尺寸的比较允许这么多像素的误差，同一尺寸按不同顺序计算可能相差一点舍入
+        static constexpr float kSizeTolerance = 0.01f;
+
+        std::shared_ptr<const TextRun> run;
+        std::wstring text;
+        const void* format = nullptr;
+        float width = 0.0f;
+        float height = 0.0f;
+
+        bool Matches(const wchar_t* drawText, uint32_t length, const void* drawFormat, float drawWidth, float drawHeight) const {
+            return run && format == drawFormat &&
+                std::fabs(width - drawWidth) <= kSizeTolerance && std::fabs(height - drawHeight) <= kSizeTolerance &&
+                text.size() == length && text.compare(0, length, drawText, length) == 0;
+        }
+    };
+
+} // namespace KroubleUI
@@ -1,8 +1,66 @@
 #include "KroubleUI.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <typeinfo>
+#include <dwmapi.h>
 
 namespace KroubleUI {
 
-	Window::Window(HINSTANCE hInstance, const std::wstring& title, int width, int height) : m_hwnd(nullptr), m_d2dFactory(nullptr), m_dwriteFactory(nullptr), m_renderTarget(nullptr) {
+	namespace {
+		// 当前线程上创建的窗口，消息循环空闲时依次渲染
+		thread_local std::vector<Window*> t_threadWindows;
+
+		// PostTask 投递的任务由这条消息在窗口线程上执行
+		const UINT kRunPostedTasksMessage = WM_APP + 1;
+
+		bool HasOpenWindowOnThread() {
+			for (Window* window : t_threadWindows) {
+				if (window->GetHwnd()) return true;
+			}
+			return false;
+		}
+
+		// 去掉编译器给出的 "class " 前缀和命名空间
+		std::string ShortTypeName(const Control* control) {
+			std::string name = typeid(*control).name();
+			size_t pos = name.rfind(':');
+			if (pos == std::string::npos) pos = name.rfind(' ');
+			return pos == std::string::npos ? name : name.substr(pos + 1);
+		}
+
+		std::string FormatBytes(size_t bytes) {
+			char buffer[32];
+			if (bytes >= (1 << 20)) {
+				snprintf(buffer, sizeof(buffer), "%.1f MB", bytes / 1048576.0);
+			}
+			else if (bytes >= 1024) {
+				snprintf(buffer, sizeof(buffer), "%.1f KB", bytes / 1024.0);
+			}
+			else {
+				snprintf(buffer, sizeof(buffer), "%zu B", bytes);
+			}
+			return buffer;
+		}
+
+		void AppendUsageLine(std::string& report, const char* label, const ResourceUsage& usage) {
+			char line[256];
+			snprintf(line, sizeof(line), "%-32s cpu %10s (peak %10s)  device %10s (peak %10s)  target %10s  brush %u, format %u, layout %u, bitmap %u\n",
+				label,
+				FormatBytes(usage.cpuBytes).c_str(), FormatBytes(usage.peakCpuBytes).c_str(),
+				FormatBytes(usage.deviceBytes).c_str(), FormatBytes(usage.peakDeviceBytes).c_str(),
+				FormatBytes(usage.targetBytes).c_str(),
+				usage.GetLiveCount(ResourceKind::Brush), usage.GetLiveCount(ResourceKind::TextFormat),
+				usage.GetLiveCount(ResourceKind::TextLayout), usage.GetLiveCount(ResourceKind::Bitmap));
+			report += line;
+		}
+	}
+
+	Window::Window(HINSTANCE hInstance, const std::wstring& title, int width, int height, std::shared_ptr<GraphicsContext> context)
+		: m_hwnd(nullptr), m_context(context ? context : GraphicsContext::GetDefault()), m_renderTarget(nullptr),
+		m_damage(D2D1::RectF()), m_hasDamage(false),
+		m_styleSheet(StyleSheet::GetDefault()), m_styleVersion(m_styleSheet->GetVersion()),
+		m_styleListener(0), m_styleCheckPosted(false), m_lastTextWorkCount(0), m_lastTextWorkSeconds(0.0) {
 
 		// 注册窗口类
 		WNDCLASSEXW wcex = { sizeof(WNDCLASSEX) };
@@ -15,7 +73,8 @@ namespace KroubleUI {
 		wcex.lpszClassName = L"KroubleUIWindow";
 		wcex.hbrBackground = nullptr;
 
-		if (!RegisterClassExW(&wcex)) {
+		// 窗口类在进程内只需注册一次
+		if (!RegisterClassExW(&wcex) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
 			throw std::runtime_error("Failed to register window class");
 		}
 
@@ -36,75 +95,199 @@ namespace KroubleUI {
 			throw std::runtime_error("Failed to create window");
 		}
 
-		// 初始化Direct2D和DirectWrite
-		InitializeDirect2D();
+		// 工厂由图形上下文提供，窗口只创建自己的渲染目标
+		CreateGraphicsResources();
+		UpdateFrameInterval();
+		t_threadWindows.push_back(this);
+		ListenToStyleSheet();
 
 		ShowWindow(m_hwnd, SW_SHOW);
 		UpdateWindow(m_hwnd);
 	}
 
-	void Window::InitializeDirect2D() {
-		// 创建D2D工厂
-		D2D1_FACTORY_OPTIONS options;
-		ZeroMemory(&options, sizeof(D2D1_FACTORY_OPTIONS));
-
-		HRESULT hr = D2D1CreateFactory(
-			D2D1_FACTORY_TYPE_SINGLE_THREADED,
-			__uuidof(ID2D1Factory),
-			&options,
-			reinterpret_cast<void**>(&m_d2dFactory)
-		);
-
-		if (FAILED(hr)) {
-			throw std::runtime_error("Failed to create D2D factory");
-		}
-
-		// 创建DirectWrite工厂
-		hr = DWriteCreateFactory(
-			DWRITE_FACTORY_TYPE_SHARED,
-			__uuidof(IDWriteFactory),
-			reinterpret_cast<IUnknown**>(&m_dwriteFactory)
-		);
-
-		if (FAILED(hr)) {
-			throw std::runtime_error("Failed to create DirectWrite factory");
+	Window::~Window() {
+		// 返回后样式表不会再调用监听
+		m_styleSheet->RemoveListener(m_styleListener);
+		t_threadWindows.erase(std::remove(t_threadWindows.begin(), t_threadWindows.end(), this), t_threadWindows.end());
+		// 控件析构时不必再逐个从登记中移除
+		m_textInvalidControls.clear();
+		m_controls.clear();
+		SafeRelease(&m_renderTarget);
+		if (m_hwnd) {
+			DestroyWindow(m_hwnd);
 		}
+	}
 
+	void Window::CreateGraphicsResources() {
 		// 创建渲染目标
 		RECT rc;
 		GetClientRect(m_hwnd, &rc);
 
-		hr = m_d2dFactory->CreateHwndRenderTarget(
+		// 每帧只重绘失效区域，需要保留上一帧的内容
+		HRESULT hr = m_context->GetD2DFactory()->CreateHwndRenderTarget(
 			D2D1::RenderTargetProperties(),
-			D2D1::HwndRenderTargetProperties(m_hwnd, D2D1::SizeU(rc.right - rc.left, rc.bottom - rc.top)),
+			D2D1::HwndRenderTargetProperties(m_hwnd, D2D1::SizeU(rc.right - rc.left, rc.bottom - rc.top),
+				D2D1_PRESENT_OPTIONS_RETAIN_CONTENTS),
 			&m_renderTarget
 		);
 
 		if (FAILED(hr)) {
 			throw std::runtime_error("Failed to create render target");
 		}
+		Invalidate();
+	}
 
+	void Window::UpdateFrameInterval() {
+		// 按窗口所在显示器的刷新率出帧，取不到时按 60Hz
+		double interval = 1.0 / 60.0;
+		MONITORINFOEXW info;
+		info.cbSize = sizeof(info);
+		DEVMODEW mode = { 0 };
+		mode.dmSize = sizeof(mode);
+		HMONITOR monitor = MonitorFromWindow(m_hwnd, MONITOR_DEFAULTTONEAREST);
+		if (monitor && GetMonitorInfoW(monitor, &info) &&
+			EnumDisplaySettingsW(info.szDevice, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1) {
+			interval = 1.0 / mode.dmDisplayFrequency;
+		}
+		m_animations.SetFrameInterval(interval);
+	}
+
+	void Window::Invalidate() {
+		if (!m_renderTarget) return;
+		D2D1_SIZE_F size = m_renderTarget->GetSize();
+		Invalidate(D2D1::RectF(0, 0, size.width, size.height));
+	}
+
+	void Window::Invalidate(const D2D1_RECT_F& rect) {
+		if (!m_renderTarget) return;
+
+		// 扩展到整像素并裁剪到客户区
+		D2D1_SIZE_F size = m_renderTarget->GetSize();
+		D2D1_RECT_F clipped = D2D1::RectF(
+			(std::max)(std::floor(rect.left), 0.0f), (std::max)(std::floor(rect.top), 0.0f),
+			(std::min)(std::ceil(rect.right), size.width), (std::min)(std::ceil(rect.bottom), size.height));
+		if (clipped.left >= clipped.right || clipped.top >= clipped.bottom) return;
+
+		if (!m_hasDamage) {
+			m_damage = clipped;
+			m_hasDamage = true;
+		}
+		else {
+			m_damage.left = (std::min)(m_damage.left, clipped.left);
+			m_damage.top = (std::min)(m_damage.top, clipped.top);
+			m_damage.right = (std::max)(m_damage.right, clipped.right);
+			m_damage.bottom = (std::max)(m_damage.bottom, clipped.bottom);
+		}
 	}
 
 	void Window::Render() {
+		if (!m_renderTarget || !m_hasDamage) return;
+
+		PrepareText();
+
+		// 绘制过程中新产生的失效区域留到下一帧
+		D2D1_RECT_F damage = m_damage;
+		m_hasDamage = false;
+
 		m_renderTarget->BeginDraw();
-		m_renderTarget->Clear(D2D1::ColorF(D2D1::ColorF::LightGray));
+		for (DrawObserver* observer : m_drawObservers) {
+			observer->OnBeginFrame(m_renderTarget, damage);
+		}
+
+		// 失效区域以外保留上一帧的内容
+		m_renderTarget->PushAxisAlignedClip(damage, D2D1_ANTIALIAS_MODE_ALIASED);
+		D2D1_COLOR_F background = D2D1::ColorF(D2D1::ColorF::LightGray);
+		m_renderTarget->Clear(background);
+		for (DrawObserver* observer : m_drawObservers) {
+			observer->OnFillRect(m_renderTarget, nullptr, damage, background);
+		}
 
 		for (auto& control : m_controls) {
-			control->Draw(m_renderTarget);
+			D2D1_RECT_F bounds = control->GetBounds();
+			if (bounds.left < damage.right && damage.left < bounds.right &&
+				bounds.top < damage.bottom && damage.top < bounds.bottom) {
+				control->Render(m_renderTarget);
+			}
 		}
 
+		for (DrawObserver* observer : m_drawObservers) {
+			observer->OnEndFrame(m_renderTarget);
+		}
+		m_renderTarget->PopAxisAlignedClip();
+
 		HRESULT hr = m_renderTarget->EndDraw();
 		if (hr == D2DERR_RECREATE_TARGET) {
 			DiscardGraphicsResources();
-			InitializeDirect2D();
+			CreateGraphicsResources();
+		}
+
+		// 每帧统计一次，峰值不会漏掉只存在几帧的占用
+		UpdateResourceUsage();
+	}
+
+	const ResourceUsage& Window::UpdateResourceUsage() {
+		std::vector<ResourceUsage> controls;
+		for (const ControlResourceEntry& entry : CollectResourceUsage()) {
+			controls.push_back(entry.usage);
+		}
+
+		// 交换链的前后缓冲不是控件创建的位图，单独统计
+		size_t targetBytes = 0;
+		if (m_renderTarget) {
+			D2D1_SIZE_U size = m_renderTarget->GetPixelSize();
+			targetBytes = static_cast<size_t>(size.width) * size.height * 4 * 2;
+		}
+
+		ResourceUsage usage = SumResourceUsage(sizeof(Window) + m_controls.capacity() * sizeof(std::unique_ptr<Control>),
+			controls, targetBytes);
+		if (m_resources.Sample(usage)) {
+			ReportBudgetExceeded("window", this, m_resources.GetUsage(), m_resources.GetBudget());
 		}
+		return m_resources.GetUsage();
+	}
+
+	std::vector<ControlResourceEntry> Window::CollectResourceUsage() {
+		std::vector<ControlResourceEntry> entries;
+		std::function<void(Control*, int)> visit = [&](Control* control, int depth) {
+			ControlResourceEntry entry = { control, ShortTypeName(control), depth, control->UpdateResourceUsage() };
+			entries.push_back(entry);
+			control->ForEachChild([&](Control* child) { visit(child, depth + 1); });
+		};
+		for (auto& control : m_controls) {
+			visit(control.get(), 0);
+		}
+		return entries;
+	}
+
+	std::string Window::GetResourceReport() {
+		std::vector<ControlResourceEntry> entries = CollectResourceUsage();
+		std::sort(entries.begin(), entries.end(), [](const ControlResourceEntry& a, const ControlResourceEntry& b) {
+			return a.usage.cpuBytes + a.usage.deviceBytes > b.usage.cpuBytes + b.usage.deviceBytes;
+		});
+
+		std::string report;
+		AppendUsageLine(report, "Window (total)", UpdateResourceUsage());
+		AppendUsageLine(report, "GraphicsContext (shared)", m_context->GetResourceUsage());
+		for (const ControlResourceEntry& entry : entries) {
+			char label[64];
+			snprintf(label, sizeof(label), "  %s %p", entry.typeName.c_str(), static_cast<const void*>(entry.control));
+			AppendUsageLine(report, label, entry.usage);
+		}
+		return report;
 	}
 
 	void Window::AddControl(Control* control) {
 		auto tmp = std::unique_ptr<Control>(control);
 		m_controls.push_back(std::move(tmp));
-		Render();
+		control->Invalidate();
+	}
+
+	void Window::AddDrawObserver(DrawObserver* observer) {
+		m_drawObservers.push_back(observer);
+	}
+
+	void Window::RemoveDrawObserver(DrawObserver* observer) {
+		m_drawObservers.erase(std::remove(m_drawObservers.begin(), m_drawObservers.end(), observer), m_drawObservers.end());
 	}
 
 	void Window::DiscardGraphicsResources() {
@@ -126,6 +309,7 @@ namespace KroubleUI {
 		if (pThis) {
 			switch (message) {
 			case WM_PAINT:
+				pThis->Invalidate();
 				pThis->Render();
 				ValidateRect(hwnd, nullptr);
 				return DefWindowProc(hwnd, message, wParam, lParam);
@@ -135,13 +319,16 @@ namespace KroubleUI {
 					RECT rc;
 					GetClientRect(hwnd, &rc);
 					pThis->m_renderTarget->Resize(D2D1::SizeU(rc.right - rc.left, rc.bottom - rc.top));
+					// 拖动调整大小时不会回到消息循环，立即重绘
+					pThis->Invalidate();
 					pThis->Render();
 				}
 				return 0;
 			}
 
 			case WM_DISPLAYCHANGE:
-				pThis->Render();
+				pThis->UpdateFrameInterval();
+				pThis->Invalidate();
 				return 0;
 
 			case WM_LBUTTONDOWN:
@@ -149,6 +336,13 @@ namespace KroubleUI {
 			case WM_MOUSEMOVE:
 				pThis->OnMouseEvent(message, wParam, lParam);
 				return 0;
+			case WM_MOUSEWHEEL: {
+				// 滚轮消息的坐标是屏幕坐标，转换为客户区坐标后再分发
+				POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
+				ScreenToClient(hwnd, &pt);
+				pThis->OnMouseEvent(message, wParam, MAKELPARAM(pt.x, pt.y));
+				return 0;
+			}
 			case WM_IME_STARTCOMPOSITION:
 			case WM_IME_COMPOSITION:
 			case WM_IME_ENDCOMPOSITION:
@@ -166,15 +360,53 @@ namespace KroubleUI {
 				pThis->OnKeyboardEvent(message, wParam, lParam);
 				return 0;
 
-			case WM_DESTROY:
-				PostQuitMessage(0);
+			case kRunPostedTasksMessage:
+				pThis->RunPostedTasks();
+				return 0;
+
+			case WM_DESTROY: {
+				pThis->DiscardGraphicsResources();
+				// 之后投递的任务直接丢弃，已排队的任务也不再执行
+				std::vector<std::function<void()>> dropped;
+				{
+					std::lock_guard<std::mutex> lock(pThis->m_taskMutex);
+					pThis->m_hwnd = nullptr;
+					dropped.swap(pThis->m_postedTasks);
+				}
+				// 当前线程的窗口全部关闭后才退出消息循环
+				if (!HasOpenWindowOnThread()) {
+					PostQuitMessage(0);
+				}
 				return 0;
 			}
+			}
 		}
 
 		return DefWindowProc(hwnd, message, wParam, lParam);
 	}
 
+	void Window::PostTask(std::function<void()> task) {
+		std::lock_guard<std::mutex> lock(m_taskMutex);
+		if (!m_hwnd) return;
+		// 队列原本为空时才需要发消息，之前的消息还没处理时会一并执行
+		bool wake = m_postedTasks.empty();
+		m_postedTasks.push_back(std::move(task));
+		if (wake) {
+			PostMessage(m_hwnd, kRunPostedTasksMessage, 0, 0);
+		}
+	}
+
+	void Window::RunPostedTasks() {
+		std::vector<std::function<void()>> tasks;
+		{
+			std::lock_guard<std::mutex> lock(m_taskMutex);
+			tasks.swap(m_postedTasks);
+		}
+		for (auto& task : tasks) {
+			task();
+		}
+	}
+
 	void Window::OnMouseEvent(UINT message, WPARAM wParam, LPARAM lParam) {
 		POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
 		bool eventHandled = false;
@@ -185,7 +417,8 @@ namespace KroubleUI {
 
 			if (!control->IsVisible()) continue;
 
-			bool isInside = control->HitTest(static_cast<float>(pt.x), static_cast<float>(pt.y));
+			// 禁用的控件只会收到鼠标离开
+			bool isInside = control->IsEnabled() && control->HitTest(static_cast<float>(pt.x), static_cast<float>(pt.y));
 
 			switch (message) {
 			case WM_MOUSEMOVE:
@@ -202,6 +435,7 @@ namespace KroubleUI {
 
 			case WM_LBUTTONDOWN:
 			case WM_LBUTTONUP:
+			case WM_MOUSEWHEEL:
 				if (isInside && !eventHandled) {
 					control->OnMouseEvent(message, wParam, lParam);
 					eventHandled = true;
@@ -218,24 +452,106 @@ namespace KroubleUI {
 
 	void  Window::OnKeyboardEvent(UINT message, WPARAM wParam, LPARAM lParam) {
 		for (auto& control : m_controls) {
-			control->OnKeyboardEvent(message, wParam, lParam);
+			if (control->IsEnabled()) {
+				control->OnKeyboardEvent(message, wParam, lParam);
+			}
+		}
+	}
+
+	void Window::QueueTextWork(Control* control) {
+		m_textInvalidControls.push_back(control);
+	}
+
+	void Window::CancelTextWork(Control* control) {
+		m_textInvalidControls.erase(std::remove(m_textInvalidControls.begin(), m_textInvalidControls.end(), control),
+			m_textInvalidControls.end());
+	}
+
+	void Window::PrepareText() {
+		if (m_textInvalidControls.empty()) return;
+
+		SystemClock clock;
+		double start = clock.Now();
+
+		m_textWork.clear();
+		for (Control* control : m_textInvalidControls) {
+			control->CollectTextWork(&m_textWork);
+		}
+		m_textInvalidControls.clear();
+
+		// DirectWrite 的排版可以在多个线程上同时进行；每段结果写入各自控件的槽位，
+		// 返回之后界面线程直接读取，绘制时不需要加锁
+		ShapeTextWork(m_context->GetTextRunCache(), &m_textWork, TaskPool::GetDefault().get());
+
+		m_lastTextWorkCount = m_textWork.size();
+		m_lastTextWorkSeconds = clock.Now() - start;
+		m_textWork.clear();
+	}
+
+	void Window::SetStyleSheet(std::shared_ptr<StyleSheet> styleSheet) {
+		m_styleSheet->RemoveListener(m_styleListener);
+		m_styleSheet = styleSheet ? styleSheet : StyleSheet::GetDefault();
+		ListenToStyleSheet();
+		CheckStyleSheet();
+	}
+
+	void Window::ListenToStyleSheet() {
+		// 样式表可能在任何线程上修改：投递到窗口线程检查，停在 WaitMessage 中的窗口也会被唤醒
+		m_styleListener = m_styleSheet->AddListener([this]() {
+			if (!m_styleCheckPosted.exchange(true)) {
+				PostTask([this]() {
+					m_styleCheckPosted = false;
+					CheckStyleSheet();
+				});
+			}
+		});
+	}
+
+	void Window::CheckStyleSheet() {
+		// 控件在重绘时各自发现版本变化并重新取用样式
+		UINT64 version = m_styleSheet->GetVersion();
+		if (version != m_styleVersion) {
+			m_styleVersion = version;
+			Invalidate();
 		}
-		Render();
 	}
 
 	void Window::RunMessageLoop() {
 		MSG msg = { 0 };
 
-		while (msg.message != WM_QUIT) {
-			if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+		for (;;) {
+			while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+				if (msg.message == WM_QUIT) return;
 				TranslateMessage(&msg);
 				DispatchMessage(&msg);
 			}
-			else {
-				Render();
+
+			// 只为有失效区域或进行中动画的窗口出帧
+			bool needsFrame = false;
+			double interval = 1.0;
+			for (Window* window : t_threadWindows) {
+				if (!window->m_hwnd) continue;
+				if (!window->NeedsFrame()) continue;
+				window->m_animations.Tick();
+				window->Render();
+				if (window->NeedsFrame()) {
+					needsFrame = true;
+					interval = (std::min)(interval, window->m_animations.GetFrameInterval());
+				}
+			}
+
+			if (!needsFrame) {
+				// 完全空闲，直到有新消息
+				WaitMessage();
+				continue;
 			}
-		}
 
+			// 还有动画时等到下一次垂直同步；没有桌面合成时按刷新间隔等待，期间有消息立即返回
+			BOOL composition = FALSE;
+			if (FAILED(DwmIsCompositionEnabled(&composition)) || !composition || FAILED(DwmFlush())) {
+				MsgWaitForMultipleObjectsEx(0, nullptr, static_cast<DWORD>(interval * 1000.0), QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+			}
+		}
 	}
 
 } // namespace KroubleUI
@@ -0,0 +1,297 @@
+#include "Animation.h"
+#include "TestHarness.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace KroubleUI;
+
+namespace {
+
+    // 手动推进的时钟
+    class ManualClock : public AnimationClock {
+    public:
+        double time = 0.0;
+        double Now() override { return time; }
+    };
+
+    // 在指定时刻结束的动画，推进时可以执行额外的动作
+    class ScriptedTrack : public AnimationTrack {
+    public:
+        double endTime;
+        int advances = 0;
+        std::function<void()> onAdvance;
+
+        explicit ScriptedTrack(double end) : endTime(end) {}
+        bool Advance(double time) override {
+            ++advances;
+            if (onAdvance) onAdvance();
+            return time < endTime;
+        }
+    };
+
+    bool Near(float a, float b, float tolerance = 1e-4f) {
+        return std::fabs(a - b) <= tolerance;
+    }
+
+} // namespace
+
+TEST(TweenFollowsClock) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+
+    int changes = 0;
+    AnimatedValue<float> value(0.0f);
+    value.Attach(&scheduler, [&changes]() { ++changes; });
+    value.AnimateTo(100.0f, 1.0, Easing::Linear);
+    CHECK(value.IsAnimating());
+    CHECK_EQ(value.Get(), 0.0f);
+
+    clock.time = 0.25;
+    CHECK(scheduler.Tick());
+    CHECK(Near(value.Get(), 25.0f));
+    clock.time = 0.5;
+    scheduler.Tick();
+    CHECK(Near(value.Get(), 50.0f));
+
+    clock.time = 1.0;
+    CHECK(!scheduler.Tick());
+    CHECK_EQ(value.Get(), 100.0f);
+    CHECK(!value.IsAnimating());
+    CHECK_EQ(changes, 3);
+    CHECK_EQ(scheduler.GetFrameCount(), 3u);
+}
+
+TEST(EasingShapesProgress) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+
+    AnimatedValue<float> value(0.0f);
+    value.Attach(&scheduler, nullptr);
+    value.AnimateTo(1.0f, 1.0, Easing::EaseOut);
+    clock.time = 0.5;
+    scheduler.Tick();
+    CHECK(Near(value.Get(), Easing::EaseOut(0.5f)));
+    CHECK(value.Get() > 0.5f);
+}
+
+TEST(IdleSchedulerDoesNotCountFrames) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+    CHECK(!scheduler.Tick());
+    CHECK(!scheduler.IsAnimating());
+    CHECK_EQ(scheduler.GetFrameCount(), 0u);
+}
+
+TEST(DetachedValueJumpsToTarget) {
+    AnimatedValue<float> value(1.0f);
+    value.AnimateTo(5.0f, 1.0);
+    CHECK_EQ(value.Get(), 5.0f);
+    CHECK(!value.IsAnimating());
+}
+
+TEST(RetargetRestartsFromCurrentValue) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+
+    AnimatedValue<float> value(0.0f);
+    value.Attach(&scheduler, nullptr);
+    value.AnimateTo(100.0f, 1.0, Easing::Linear);
+    clock.time = 0.5;
+    scheduler.Tick();
+    value.AnimateTo(0.0f, 1.0, Easing::Linear);
+    CHECK_EQ(scheduler.GetActiveCount(), 1u);
+    clock.time = 1.0;
+    scheduler.Tick();
+    CHECK(Near(value.Get(), 25.0f));
+}
+
+TEST(RetargetFromChangeCallbackKeepsRunning) {
+    // 到达目标时在回调里设置下一段，动画应继续而不是被调度器移除
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+
+    AnimatedValue<float> value(0.0f);
+    int legs = 0;
+    value.Attach(&scheduler, [&]() {
+        if (value.Get() == value.GetTarget() && legs < 2) {
+            ++legs;
+            value.AnimateTo(value.Get() + 100.0f, 1.0, Easing::Linear);
+        }
+    });
+    value.AnimateTo(100.0f, 1.0, Easing::Linear);
+
+    clock.time = 1.0;
+    CHECK(scheduler.Tick());
+    CHECK_EQ(legs, 1);
+    CHECK(value.IsAnimating());
+    CHECK_EQ(value.GetTarget(), 200.0f);
+
+    clock.time = 1.5;
+    scheduler.Tick();
+    CHECK(Near(value.Get(), 150.0f));
+
+    clock.time = 2.0;
+    CHECK(scheduler.Tick());
+    CHECK_EQ(legs, 2);
+    clock.time = 3.0;
+    CHECK(!scheduler.Tick());
+    CHECK_EQ(value.Get(), 300.0f);
+    CHECK(!value.IsAnimating());
+}
+
+TEST(SpringRetargetFromChangeCallbackKeepsRunning) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+
+    AnimatedValue<float> value(0.0f);
+    bool retargeted = false;
+    value.Attach(&scheduler, [&]() {
+        if (!retargeted && value.Get() == 10.0f) {
+            retargeted = true;
+            value.SpringTo(0.0f);
+        }
+    });
+    value.SpringTo(10.0f);
+    int frames = 0;
+    while (!retargeted && frames < 600) {
+        clock.time += 1.0 / 60.0;
+        scheduler.Tick();
+        ++frames;
+    }
+    CHECK(retargeted);
+    CHECK(value.IsAnimating());
+    while (scheduler.Tick() && frames < 1200) {
+        clock.time += 1.0 / 60.0;
+        ++frames;
+    }
+    CHECK_EQ(value.Get(), 0.0f);
+}
+
+TEST(SpringSettlesOnTarget) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+
+    AnimatedValue<float> value(0.0f);
+    value.Attach(&scheduler, nullptr);
+    SpringParams params;
+    params.dampingRatio = 0.5f;
+    value.SpringTo(10.0f, params);
+
+    bool overshot = false;
+    int frames = 0;
+    while (scheduler.Tick() && frames < 600) {
+        clock.time += 1.0 / 60.0;
+        overshot = overshot || value.Get() > 10.0f;
+        ++frames;
+    }
+    CHECK(frames < 600);
+    CHECK(overshot);
+    CHECK_EQ(value.Get(), 10.0f);
+    CHECK(!value.IsAnimating());
+}
+
+TEST(SpringLongGapIsBounded) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+
+    AnimatedValue<float> value(0.0f);
+    value.Attach(&scheduler, nullptr);
+    value.SpringTo(1.0f);
+    // 一次跳过 10 秒也只模拟 0.1 秒
+    clock.time = 10.0;
+    scheduler.Tick();
+    CHECK(value.IsAnimating());
+    CHECK(value.Get() > 0.0f && value.Get() < 1.5f);
+}
+
+TEST(StopDuringTickSkipsTrack) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+
+    ScriptedTrack first(10.0);
+    ScriptedTrack second(10.0);
+    first.onAdvance = [&second]() { second.Stop(); };
+    scheduler.Start(&first);
+    scheduler.Start(&second);
+
+    scheduler.Tick();
+    CHECK_EQ(first.advances, 1);
+    CHECK_EQ(second.advances, 0);
+    CHECK_EQ(scheduler.GetActiveCount(), 1u);
+}
+
+TEST(StartDuringTickAdvancesSameFrame) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+
+    ScriptedTrack first(10.0);
+    ScriptedTrack added(10.0);
+    first.onAdvance = [&]() { scheduler.Start(&added); };
+    scheduler.Start(&first);
+
+    scheduler.Tick();
+    CHECK_EQ(added.advances, 1);
+    CHECK_EQ(scheduler.GetActiveCount(), 2u);
+}
+
+TEST(CallbackTrackRunsUntilSettled) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+
+    std::vector<double> times;
+    CallbackTrack track([&times](double time) {
+        times.push_back(time);
+        return times.size() < 3;
+    });
+    scheduler.Start(&track);
+    for (int frame = 1; frame <= 5; ++frame) {
+        clock.time = frame * 0.1;
+        scheduler.Tick();
+    }
+    CHECK_EQ(times.size(), 3u);
+    CHECK(Near(static_cast<float>(times[2]), 0.3f));
+    CHECK(!track.IsAnimating());
+}
+
+TEST(DestroyedTrackLeavesScheduler) {
+    ManualClock clock;
+    AnimationScheduler scheduler;
+    scheduler.SetClock(&clock);
+    {
+        ScriptedTrack track(10.0);
+        scheduler.Start(&track);
+        CHECK_EQ(scheduler.GetActiveCount(), 1u);
+    }
+    CHECK_EQ(scheduler.GetActiveCount(), 0u);
+    CHECK(!scheduler.Tick());
+}
+
+TEST(TrackOutlivesScheduler) {
+    ScriptedTrack track(10.0);
+    {
+        AnimationScheduler scheduler;
+        scheduler.Start(&track);
+        CHECK(track.IsAnimating());
+    }
+    CHECK(!track.IsAnimating());
+}
+
+TEST(SystemClockIsMonotonic) {
+    SystemClock clock;
+    double first = clock.Now();
+    double second = clock.Now();
+    CHECK(second >= first);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+// 基准程序共用的计时和参数解析
+namespace KroubleBenchmark {
+
+    class Stopwatch {
+    private:
+        std::chrono::steady_clock::time_point m_start;
+
+    public:
+        Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+        void Restart() { m_start = std::chrono::steady_clock::now(); }
+        double GetSeconds() const {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        }
+    };
+
+    // 读取 "--name value" 形式的整数参数
+    inline size_t GetArgument(int argc, char** argv, const char* name, size_t defaultValue) {
+        for (int i = 1; i + 1 < argc; ++i) {
+            if (std::strcmp(argv[i], name) == 0) {
+                return static_cast<size_t>(std::strtoull(argv[i + 1], nullptr, 10));
+            }
+        }
+        return defaultValue;
+    }
+
+} // namespace KroubleBenchmark
@@ -0,0 +1,189 @@
+#include "ChunkedText.h"
+#include "TaskPool.h"
+#include "TestHarness.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using KroubleUI::ChunkedText;
+using KroubleUI::LineIndex;
+using KroubleUI::TaskPool;
+
+namespace {
+
+    // 逐字符查找的参考实现
+    std::vector<size_t> ReferenceLineStarts(const std::wstring& text) {
+        std::vector<size_t> newlines;
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == L'\n') newlines.push_back(i + 1);
+        }
+        std::vector<size_t> starts(1, 0);
+        LineIndex::AppendLineStarts(0, newlines, text.size(), &starts);
+        return starts;
+    }
+
+    std::vector<size_t> GetLineStarts(const LineIndex& index) {
+        std::vector<size_t> starts;
+        for (size_t line = 0; line < index.GetLineCount(); ++line) {
+            starts.push_back(index.GetLineStart(line));
+        }
+        return starts;
+    }
+
+    // 长短不一的行，其中夹着超过 kMaxLineChars 的长行
+    std::wstring MakeText(size_t lines) {
+        std::wstring text;
+        for (size_t i = 0; i < lines; ++i) {
+            size_t length = i % 97 == 5 ? LineIndex::kMaxLineChars * 2 + 3 : i % 13;
+            text.append(length, static_cast<wchar_t>(L'a' + i % 26));
+            text.push_back(L'\n');
+        }
+        return text;
+    }
+
+} // namespace
+
+TEST(AppendPacksSmallWritesIntoChunks) {
+    ChunkedText text;
+    for (int i = 0; i < 1000; ++i) {
+        text.Append(L"0123456789", 10);
+    }
+    CHECK_EQ(text.GetLength(), size_t(10000));
+    CHECK_EQ(text.GetChunkCount(), size_t(1));
+
+    std::wstring large(ChunkedText::kChunkChars, L'x');
+    text.Append(std::move(large));
+    CHECK_EQ(text.GetChunkCount(), size_t(2));
+
+    std::wstring range;
+    text.CopyRange(9995, 10005, &range);
+    CHECK(range == L"56789xxxxx");
+}
+
+TEST(SnapshotIsNotModifiedByLaterEdits) {
+    ChunkedText text;
+    text.Append(L"abc", 3);
+    ChunkedText snapshot = text;
+    text.RemoveLast();
+    text.Append(L"XY", 2);
+
+    std::wstring flat;
+    snapshot.Flatten(&flat);
+    CHECK(flat == L"abc");
+    text.Flatten(&flat);
+    CHECK(flat == L"abXY");
+}
+
+TEST(IndexMatchesReferenceAcrossChunks) {
+    std::wstring source = MakeText(3000);
+    ChunkedText text;
+    // 不规则的追加长度让换行落在块边界两侧
+    for (size_t i = 0; i < source.size();) {
+        size_t length = (std::min)(source.size() - i, size_t(1 + (i * 7919) % 40000));
+        text.Append(source.data() + i, length);
+        i += length;
+    }
+
+    LineIndex index;
+    for (size_t end = 0; end < source.size(); end += 12345) {
+        index.IndexTo(text, end);
+    }
+    index.IndexTo(text, source.size());
+    CHECK(GetLineStarts(index) == ReferenceLineStarts(source));
+}
+
+TEST(ScanMatchesSynchronousIndex) {
+    std::wstring source = MakeText(40000);
+    ChunkedText text;
+    text.Assign(source);
+    LineIndex index;
+    index.IndexTo(text, 1000);
+
+    TaskPool pool(3);
+    std::vector<size_t> scanned;
+    CHECK(LineIndex::Scan(text, index.GetIndexedLength(), text.GetLength(), index.GetLastLineStart(), pool,
+        nullptr, &scanned));
+    index.Append(scanned, text.GetLength());
+    CHECK(GetLineStarts(index) == ReferenceLineStarts(source));
+
+    std::vector<size_t> cancelled;
+    CHECK(!LineIndex::Scan(text, 0, text.GetLength(), 0, pool, []() { return true; }, &cancelled));
+}
+
+TEST(TruncateDropsLinesPastTheEnd) {
+    ChunkedText text;
+    text.Append(L"one\ntwo\n", 8);
+    LineIndex index;
+    index.IndexTo(text, text.GetLength());
+    CHECK_EQ(index.GetLineCount(), size_t(3));
+
+    // 删掉结尾的换行后，最后的空行也不存在了
+    text.RemoveLast();
+    index.Truncate(text, text.GetLength());
+    CHECK_EQ(index.GetLineCount(), size_t(2));
+    text.RemoveLast();
+    index.Truncate(text, text.GetLength());
+    CHECK_EQ(index.GetLineCount(), size_t(2));
+
+    std::wstring line;
+    index.GetLineText(text, 1, &line);
+    CHECK(line == L"tw");
+}
+
+TEST(GetLineTextTrimsNewlinesAndLongLines) {
+    ChunkedText text;
+    std::wstring source = L"first\r\n" + std::wstring(LineIndex::kMaxLineChars + 10, L'z');
+    text.Assign(source);
+    LineIndex index;
+    index.IndexTo(text, text.GetLength());
+    CHECK_EQ(index.GetLineCount(), size_t(3));
+
+    std::wstring line;
+    index.GetLineText(text, 0, &line);
+    CHECK(line == L"first");
+    index.GetLineText(text, 1, &line);
+    CHECK_EQ(line.size(), LineIndex::kMaxLineChars);
+    index.GetLineText(text, 2, &line);
+    CHECK_EQ(line.size(), size_t(10));
+}
+
+TEST(TailLinesMatchFullIndex) {
+    std::wstring source = MakeText(5000);
+    ChunkedText text;
+    text.Append(source.data(), 100);
+    LineIndex index;
+    index.IndexTo(text, text.GetLength());
+    // 一次粘贴大量文本，此时索引只覆盖开头
+    text.Append(std::wstring(source, 100));
+
+    std::vector<size_t> expected = ReferenceLineStarts(source);
+    for (size_t count : { size_t(1), size_t(7), size_t(40) }) {
+        std::vector<size_t> tail;
+        LineIndex::FindTailLines(text, index.GetLastLineStart(), count, 65536, &tail);
+        CHECK(tail == std::vector<size_t>(expected.end() - count, expected.end()));
+    }
+}
+
+TEST(TailLinesReachBackToKnownLineStart) {
+    ChunkedText text;
+    text.Append(L"ab\ncd", 5);
+    LineIndex index;
+    index.IndexTo(text, 3);
+    text.Append(L"ef\ngh", 5);
+
+    // 窗口到达已知行首时，即使换行不够也是准确的
+    std::vector<size_t> tail;
+    LineIndex::FindTailLines(text, index.GetLastLineStart(), 5, 65536, &tail);
+    CHECK(tail == std::vector<size_t>({ 3, 8 }));
+}
+
+TEST(TailLinesWithoutNewlineUseWindowStart) {
+    ChunkedText text;
+    text.Assign(std::wstring(100000, L'q'));
+    std::vector<size_t> tail;
+    LineIndex::FindTailLines(text, 0, 3, 10000, &tail);
+    // 窗口内没有换行，从窗口开头按长度拆分
+    CHECK_EQ(tail.size(), size_t(3));
+    CHECK_EQ(tail.back(), size_t(90000 + 2 * LineIndex::kMaxLineChars));
+}
@@ -0,0 +1,253 @@
+#include "DataGridModel.h"
+#include "TaskPool.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+using KroubleUI::BuildRowView;
+using KroubleUI::ColumnStorage;
+using KroubleUI::ColumnTable;
+using KroubleUI::DataGridRowView;
+using KroubleUI::DataGridSource;
+using KroubleUI::RowViewRequest;
+using KroubleUI::TaskPool;
+
+namespace {
+
+    // 第 0 列是 row % 10，第 1 列是行号的文本
+    void AppendRows(ColumnTable& table, size_t count) {
+        size_t first = table.GetRowCount();
+        for (size_t row = first; row < first + count; ++row) {
+            table.AppendNumber(0, static_cast<double>(row % 10));
+            table.AppendText(1, std::to_wstring(row));
+        }
+        table.CommitRows();
+    }
+
+    std::unique_ptr<ColumnTable> MakeTable(size_t rows) {
+        std::unique_ptr<ColumnTable> table(new ColumnTable());
+        table->AddNumberColumn(L"Key", 0);
+        table->AddTextColumn(L"Name");
+        AppendRows(*table, rows);
+        return table;
+    }
+
+    bool IsEven(const DataGridSource& source, size_t row) {
+        (void)source;
+        return row % 2 == 0;
+    }
+
+    // 检查视图按第 0 列升序、相同值按行号排列，且每行只出现一次
+    bool IsSortedByKey(const ColumnTable& table, const DataGridRowView& view) {
+        for (size_t i = 1; i < view.GetCount(); ++i) {
+            int result = table.CompareCells(0, view.GetRow(i - 1), view.GetRow(i));
+            if (result > 0 || (result == 0 && view.GetRow(i - 1) >= view.GetRow(i))) return false;
+        }
+        return true;
+    }
+
+    // 转发到另一个数据源并统计比较次数
+    class CountingSource : public DataGridSource {
+    private:
+        const DataGridSource& m_source;
+
+    public:
+        mutable std::atomic<size_t> compares;
+
+        explicit CountingSource(const DataGridSource& source) : m_source(source), compares(0) {}
+
+        size_t GetRowCount() const override { return m_source.GetRowCount(); }
+        size_t GetColumnCount() const override { return m_source.GetColumnCount(); }
+        std::wstring GetColumnName(size_t column) const override { return m_source.GetColumnName(column); }
+        void FormatCell(size_t row, size_t column, std::wstring& text) const override { m_source.FormatCell(row, column, text); }
+        int CompareCells(size_t column, size_t a, size_t b) const override {
+            ++compares;
+            return m_source.CompareCells(column, a, b);
+        }
+    };
+
+} // namespace
+
+TEST(ColumnStorageCrossesChunks) {
+    ColumnStorage<double> storage;
+    for (size_t i = 0; i < 200000; ++i) storage.PushBack(static_cast<double>(i));
+    CHECK_EQ(storage.GetSize(), 200000u);
+    CHECK_EQ(storage[0], 0.0);
+    CHECK_EQ(storage[65535], 65535.0);
+    CHECK_EQ(storage[65536], 65536.0);
+    CHECK_EQ(storage[199999], 199999.0);
+}
+
+TEST(ColumnStorageKeepsElementAddresses) {
+    ColumnStorage<std::wstring> storage;
+    storage.PushBack(L"first");
+    const std::wstring* first = &storage[0];
+    for (size_t i = 0; i < 100000; ++i) storage.PushBack(L"x");
+    CHECK(first == &storage[0]);
+    CHECK(*first == L"first");
+}
+
+TEST(ColumnTableCommitsCompleteRowsOnly) {
+    ColumnTable table;
+    table.AddNumberColumn(L"A");
+    table.AddTextColumn(L"B");
+    table.AppendNumber(0, 1.5);
+    table.CommitRows();
+    CHECK_EQ(table.GetRowCount(), 0u);
+    table.AppendText(1, L"b");
+    table.CommitRows();
+    CHECK_EQ(table.GetRowCount(), 1u);
+
+    std::wstring text;
+    table.FormatCell(0, 0, text);
+    CHECK(text == L"1.50");
+    table.FormatCell(0, 1, text);
+    CHECK(text == L"b");
+}
+
+TEST(IdentityAppendOnlyUpdatesRowCount) {
+    TaskPool pool(2);
+    std::unique_ptr<ColumnTable> table = MakeTable(1000);
+    RowViewRequest request;
+    request.rowCount = table->GetRowCount();
+    std::shared_ptr<const DataGridRowView> view = BuildRowView(*table, pool, request, nullptr);
+
+    AppendRows(*table, 500);
+    request.base = view;
+    request.rowCount = table->GetRowCount();
+    view = BuildRowView(*table, pool, request, nullptr);
+    CHECK(view->identity);
+    CHECK(view->rows.empty());
+    CHECK_EQ(view->GetCount(), 1500u);
+    CHECK_EQ(view->GetRow(1499), 1499u);
+}
+
+TEST(FilterKeepsSourceOrder) {
+    TaskPool pool(2);
+    std::unique_ptr<ColumnTable> table = MakeTable(150000);
+    RowViewRequest request;
+    request.rowCount = table->GetRowCount();
+    request.filter = IsEven;
+    std::shared_ptr<const DataGridRowView> view = BuildRowView(*table, pool, request, nullptr);
+    CHECK(!view->identity);
+    CHECK_EQ(view->GetCount(), 75000u);
+    CHECK_EQ(view->GetRow(0), 0u);
+    CHECK_EQ(view->GetRow(74999), 149998u);
+}
+
+TEST(SortIsStableAcrossSegments) {
+    TaskPool pool(3);
+    std::unique_ptr<ColumnTable> table = MakeTable(100000);
+    RowViewRequest request;
+    request.rowCount = table->GetRowCount();
+    request.sortColumn = 0;
+    std::shared_ptr<const DataGridRowView> view = BuildRowView(*table, pool, request, nullptr);
+    CHECK_EQ(view->GetCount(), 100000u);
+    CHECK(IsSortedByKey(*table, *view));
+    CHECK_EQ(view->GetRow(0), 0u);
+    CHECK_EQ(view->GetRow(1), 10u);
+}
+
+TEST(IncrementalSortMatchesFullSort) {
+    TaskPool pool(2);
+    std::unique_ptr<ColumnTable> table = MakeTable(30000);
+    RowViewRequest request;
+    request.rowCount = table->GetRowCount();
+    request.sortColumn = 0;
+    request.filter = IsEven;
+    std::shared_ptr<const DataGridRowView> base = BuildRowView(*table, pool, request, nullptr);
+
+    AppendRows(*table, 7001);
+    request.rowCount = table->GetRowCount();
+    std::shared_ptr<const DataGridRowView> full = BuildRowView(*table, pool, request, nullptr);
+    request.base = base;
+    std::shared_ptr<const DataGridRowView> merged = BuildRowView(*table, pool, request, nullptr);
+    CHECK_EQ(merged->sourceRows, 37001u);
+    CHECK(merged->rows == full->rows);
+    CHECK(IsSortedByKey(*table, *merged));
+}
+
+TEST(SortMergesManySegments) {
+    // 超过每段最多行数时分成更多段，需要多层合并
+    TaskPool pool(1);
+    std::unique_ptr<ColumnTable> table = MakeTable(300001);
+    RowViewRequest request;
+    request.rowCount = table->GetRowCount();
+    request.sortColumn = 0;
+    std::shared_ptr<const DataGridRowView> view = BuildRowView(*table, pool, request, nullptr);
+    CHECK_EQ(view->GetCount(), 300001u);
+    CHECK(IsSortedByKey(*table, *view));
+    CHECK_EQ(view->GetRow(30001), 1u);
+
+    request.sortAscending = false;
+    std::shared_ptr<const DataGridRowView> descending = BuildRowView(*table, pool, request, nullptr);
+    CHECK_EQ(descending->GetRow(0), 9u);
+    CHECK_EQ(descending->GetRow(30000), 8u);
+    CHECK_EQ(descending->GetRow(300000), 300000u);
+}
+
+TEST(IncrementalMergeAcrossChunksMatchesFullSort) {
+    TaskPool pool(3);
+    std::unique_ptr<ColumnTable> table = MakeTable(200000);
+    RowViewRequest request;
+    request.rowCount = table->GetRowCount();
+    request.sortColumn = 0;
+    std::shared_ptr<const DataGridRowView> base = BuildRowView(*table, pool, request, nullptr);
+
+    AppendRows(*table, 50000);
+    request.rowCount = table->GetRowCount();
+    std::shared_ptr<const DataGridRowView> full = BuildRowView(*table, pool, request, nullptr);
+    request.base = base;
+    std::shared_ptr<const DataGridRowView> merged = BuildRowView(*table, pool, request, nullptr);
+    CHECK(merged->rows == full->rows);
+}
+
+TEST(CancelStopsIncrementalMergeBetweenChunks) {
+    // 在大视图上合并几行新数据，取消后只把已经开始的几段合并做完
+    TaskPool pool(1);
+    std::unique_ptr<ColumnTable> table = MakeTable(600000);
+    RowViewRequest request;
+    request.rowCount = table->GetRowCount();
+    request.sortColumn = 0;
+    request.base = BuildRowView(*table, pool, request, nullptr);
+    AppendRows(*table, 10);
+    request.rowCount = table->GetRowCount();
+
+    CountingSource uncancelled(*table);
+    CHECK(BuildRowView(uncancelled, pool, request, nullptr) != nullptr);
+    size_t total = uncancelled.compares.load();
+
+    CountingSource counting(*table);
+    std::shared_ptr<DataGridRowView> view = BuildRowView(counting, pool, request,
+        [&counting]() { return counting.compares.load() >= 1000; });
+    CHECK(view == nullptr);
+    CHECK(counting.compares.load() < total / 2);
+}
+
+TEST(IdentityBaseIsRebuiltWhenFiltering) {
+    TaskPool pool(2);
+    std::unique_ptr<ColumnTable> table = MakeTable(1000);
+    RowViewRequest request;
+    request.rowCount = table->GetRowCount();
+    std::shared_ptr<const DataGridRowView> base = BuildRowView(*table, pool, request, nullptr);
+
+    // 原有顺序的视图包含了所有行，在它上面合并会把不满足筛选的旧行也保留下来
+    AppendRows(*table, 10);
+    request.base = base;
+    request.rowCount = table->GetRowCount();
+    request.filter = IsEven;
+    std::shared_ptr<const DataGridRowView> view = BuildRowView(*table, pool, request, nullptr);
+    CHECK_EQ(view->GetCount(), 505u);
+    CHECK_EQ(view->GetRow(1), 2u);
+}
+
+TEST(CancelledBuildReturnsNull) {
+    TaskPool pool(2);
+    std::unique_ptr<ColumnTable> table = MakeTable(1000);
+    RowViewRequest request;
+    request.rowCount = table->GetRowCount();
+    request.sortColumn = 1;
+    CHECK(BuildRowView(*table, pool, request, []() { return true; }) == nullptr);
+}
@@ -0,0 +1,358 @@
+#include "DrawCommands.h"
+#include "TestHarness.h"
+
+#include <algorithm>
+#include <cwchar>
+#include <string>
+#include <vector>
+
+using KroubleUI::DrawCommandReader;
+using KroubleUI::DrawCommandSink;
+using KroubleUI::DrawCommandWriter;
+using KroubleUI::DrawFormatPolicy;
+using KroubleUI::DrawTextFormat;
+using KroubleUI::FrameSendQueue;
+using KroubleUI::Transform2D;
+using KroubleUI::ViewRect;
+
+namespace {
+
+    // 测试用的文本格式句柄，记录被编号表持有的次数
+    struct Format {
+        const wchar_t* family;
+        float size;
+        int references;
+    };
+
+    void RetainFormat(const void* format) { ++static_cast<Format*>(const_cast<void*>(format))->references; }
+    void ReleaseFormat(const void* format) { --static_cast<Format*>(const_cast<void*>(format))->references; }
+    void DescribeFormat(const void* handle, DrawTextFormat* desc) {
+        const Format* format = static_cast<const Format*>(handle);
+        desc->family = format->family;
+        desc->size = format->size;
+        desc->locale = L"zh-cn";
+    }
+
+    DrawFormatPolicy GetPolicy() {
+        DrawFormatPolicy policy;
+        policy.retain = RetainFormat;
+        policy.release = ReleaseFormat;
+        policy.describe = DescribeFormat;
+        return policy;
+    }
+
+    ViewRect Rect(float left, float top, float right, float bottom) {
+        ViewRect rect = { left, top, right, bottom };
+        return rect;
+    }
+
+    // 把回放的命令记录为文本，并检查压入和弹出是否配对
+    class RecordingSink : public DrawCommandSink {
+    public:
+        std::vector<std::wstring> commands;
+        std::vector<DrawTextFormat> formats;
+        int depth = 0;
+        int resets = 0;
+
+        void OnResetTables() override {
+            ++resets;
+            formats.clear();
+        }
+        void OnDefineFormat(const DrawTextFormat& desc) override { formats.push_back(desc); }
+        void OnBeginFrame(const ViewRect& damage) override {
+            ++depth;
+            Add(L"begin", damage);
+        }
+        void OnSetTransform(const Transform2D& transform) override {
+            commands.push_back(L"transform " + std::to_wstring(transform.dx) + L"," + std::to_wstring(transform.dy));
+        }
+        void OnFillRectangle(uint32_t color, const ViewRect& rect) override { Add(L"fill " + Hex(color), rect); }
+        void OnDrawRectangle(uint32_t color, float strokeWidth, const ViewRect& rect) override {
+            Add(L"rect " + Hex(color) + L" " + std::to_wstring(strokeWidth), rect);
+        }
+        void OnDrawLine(uint32_t color, float strokeWidth, float x1, float y1, float x2, float y2) override {
+            Add(L"line " + Hex(color) + L" " + std::to_wstring(strokeWidth), Rect(x1, y1, x2, y2));
+        }
+        void OnDrawText(const std::wstring& text, size_t format, uint32_t color, uint32_t options, const ViewRect& rect) override {
+            Add(L"text " + text + L" " + formats[format].family + L" " + Hex(color) + L" " + std::to_wstring(options), rect);
+        }
+        void OnPushClip(const ViewRect& rect) override {
+            ++depth;
+            Add(L"clip", rect);
+        }
+        void OnPopClip() override {
+            --depth;
+            commands.push_back(L"pop clip");
+        }
+        bool OnPushLayer(float opacity) override {
+            ++depth;
+            commands.push_back(L"layer " + std::to_wstring(opacity));
+            return true;
+        }
+        void OnPopLayer() override {
+            --depth;
+            commands.push_back(L"pop layer");
+        }
+
+        // 回放到第一个绘制命令为止的文字
+        std::wstring FindText() const {
+            for (const std::wstring& command : commands) {
+                if (command.compare(0, 5, L"text ") == 0) return command;
+            }
+            return std::wstring();
+        }
+
+    private:
+        static std::wstring Hex(uint32_t value) {
+            wchar_t buffer[16];
+            std::swprintf(buffer, 16, L"%08x", value);
+            return buffer;
+        }
+
+        void Add(const std::wstring& name, const ViewRect& rect) {
+            commands.push_back(name + L" " + std::to_wstring(rect.left) + L"," + std::to_wstring(rect.top) + L"," +
+                std::to_wstring(rect.right) + L"," + std::to_wstring(rect.bottom));
+        }
+    };
+
+    // 一个按钮：背景、边框和文字
+    void DrawButton(DrawCommandWriter& writer, Format* format, const std::wstring& label, float x, float y) {
+        writer.FillRectangle(0xFFEEEEEE, Rect(x, y, x + 80, y + 24));
+        writer.DrawRectangle(0xFF888888, 1.0f, Rect(x, y, x + 80, y + 24));
+        writer.DrawString(label.c_str(), label.size(), format, 0xFF000000, 4, Rect(x + 4, y, x + 76, y + 24));
+    }
+
+    std::string EncodeForm(DrawCommandWriter& writer, Format* format, int buttons, int firstLabel = 0) {
+        writer.BeginFrame(640, 480, Rect(0, 0, 640, 480));
+        writer.FillRectangle(0xFFFFFFFF, Rect(0, 0, 640, 480));
+        for (int i = 0; i < buttons; ++i) {
+            DrawButton(writer, format, L"Button " + std::to_wstring(firstLabel + i), 10.0f + (i % 6) * 100, 10.0f + (i / 6) * 30);
+        }
+        return writer.EndFrame();
+    }
+
+} // namespace
+
+TEST(RoundTripReproducesCommands) {
+    Format format = { L"Segoe UI", 14.0f, 0 };
+    DrawCommandWriter writer(GetPolicy());
+    writer.BeginFrame(300, 200, Rect(10, 20, 110, 70));
+    writer.FillRectangle(0x80FF0000, Rect(10.25f, 20.5f, 110, 70));
+    writer.PushClip(Rect(12, 22, 100, 60));
+    writer.PushLayer(0.5f);
+    Transform2D transform = Transform2D::Identity();
+    transform.dx = 5.0f;
+    transform.dy = -3.0f;
+    writer.SetTransform(transform);
+    writer.SetTransform(transform);
+    writer.DrawLine(0xFF00FF00, 2.0f, 0, 0, -4.75f, 8);
+    writer.DrawString(L"OK", 2, &format, 0xFF000000, 4, Rect(0, 0, 50, 20));
+    writer.PopLayer();
+    writer.PopClip();
+    std::string frame = writer.EndFrame();
+
+    uint32_t width = 0, height = 0;
+    CHECK(DrawCommandReader::ReadFrameSize(frame, &width, &height));
+    CHECK_EQ(width, 300u);
+    CHECK_EQ(height, 200u);
+
+    DrawCommandReader reader;
+    RecordingSink sink;
+    CHECK(reader.Read(frame, &sink));
+    std::vector<std::wstring> expected = {
+        L"begin 10.000000,20.000000,110.000000,70.000000",
+        L"fill 80ff0000 10.250000,20.500000,110.000000,70.000000",
+        L"clip 12.000000,22.000000,100.000000,60.000000",
+        L"layer 0.501961",
+        L"transform 5.000000,-3.000000",
+        L"line ff00ff00 2.000000 0.000000,0.000000,-4.750000,8.000000",
+        L"text OK Segoe UI ff000000 4 0.000000,0.000000,50.000000,20.000000",
+        L"pop layer",
+        L"pop clip",
+        L"pop clip",
+    };
+    CHECK(sink.commands == expected);
+    CHECK_EQ(sink.depth, 0);
+    CHECK_EQ(sink.formats.size(), 1u);
+    CHECK_EQ(sink.formats[0].size, 14.0f);
+}
+
+TEST(NonAsciiTextRoundTrips) {
+    Format format = { L"微软雅黑", 12.0f, 0 };
+    std::wstring text = L"你好 é ";
+    text += static_cast<wchar_t>(0x1F600);
+    if (sizeof(wchar_t) == 2) {
+        text.pop_back();
+        text += L"\xD83D\xDE00";
+    }
+
+    DrawCommandWriter writer(GetPolicy());
+    writer.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    writer.DrawString(text.c_str(), text.size(), &format, 0xFF000000, 0, Rect(0, 0, 100, 20));
+    std::string frame = writer.EndFrame();
+
+    DrawCommandReader reader;
+    RecordingSink sink;
+    CHECK(reader.Read(frame, &sink));
+    CHECK(sink.FindText() == L"text " + text + L" 微软雅黑 ff000000 0 0.000000,0.000000,100.000000,20.000000");
+}
+
+TEST(LaterFramesOnlySendIds) {
+    Format format = { L"Segoe UI", 14.0f, 0 };
+    DrawCommandWriter writer(GetPolicy());
+    DrawCommandReader reader;
+    std::string first = EncodeForm(writer, &format, 12);
+    std::string second = EncodeForm(writer, &format, 12);
+    CHECK(second.size() < first.size());
+
+    // 格式表跟编号表一样跨帧保留在接收方
+    RecordingSink sink;
+    CHECK(reader.Read(first, &sink));
+    size_t count = sink.commands.size();
+    CHECK(reader.Read(second, &sink));
+    CHECK_EQ(sink.commands.size(), 2 * count);
+    CHECK(std::equal(sink.commands.begin(), sink.commands.begin() + count, sink.commands.begin() + count));
+    CHECK_EQ(writer.GetStats().frames, 2u);
+    CHECK_EQ(writer.GetStats().totalBytes, first.size() + second.size());
+}
+
+TEST(TablesResetAtMaxStrings) {
+    Format format = { L"Segoe UI", 14.0f, 0 };
+    DrawCommandWriter writer(GetPolicy());
+    DrawCommandReader reader;
+    RecordingSink sink;
+
+    // 每帧 600 个不同的标签，第 7 帧超过上限
+    size_t labels = 0;
+    for (int frame = 0; frame < 9; ++frame) {
+        std::string data = EncodeForm(writer, &format, 600, frame * 600);
+        labels += 600;
+        CHECK(writer.GetStringCount() <= DrawCommandWriter::kMaxStrings);
+        CHECK(reader.Read(data, &sink));
+        CHECK_EQ(reader.GetStringCount(), writer.GetStringCount());
+    }
+    CHECK(sink.resets >= 1);
+    CHECK(labels > DrawCommandWriter::kMaxStrings);
+
+    // 清空后重新定义的格式仍能正确引用
+    CHECK(sink.commands[sink.commands.size() - 2].compare(0, 18, L"text Button 5399 S") == 0);
+    CHECK_EQ(format.references, 1);
+}
+
+TEST(OverflowResyncsAfterReset) {
+    Format format = { L"Segoe UI", 14.0f, 0 };
+    DrawCommandWriter writer(GetPolicy());
+    DrawCommandReader reader;
+    FrameSendQueue queue(4096);
+
+    // 查看端收到第一帧后停止读取，后面的帧只在队列中积压
+    CHECK(queue.Push(EncodeForm(writer, &format, 6)));
+    std::string message;
+    CHECK(queue.Pop(&message));
+    CHECK(reader.Read(message, nullptr));
+
+    int pushed = 0;
+    bool overflow = false;
+    for (int i = 1; i < 100 && !overflow; ++i) {
+        overflow = !queue.Push(EncodeForm(writer, &format, 6, i * 6));
+        if (!overflow) ++pushed;
+    }
+    CHECK(overflow);
+    CHECK(pushed > 0);
+    CHECK(queue.IsEmpty());
+    CHECK_EQ(queue.GetBytes(), 0u);
+
+    // 丢弃的帧里有新标签的定义：不重置编码器，下一帧引用的编号在查看端不存在
+    std::string stale = EncodeForm(writer, &format, 6, 1000);
+    RecordingSink rejected;
+    CHECK(!reader.Read(stale, &rejected));
+    CHECK_EQ(rejected.depth, 0);
+
+    // 重置后的一帧从清空的编号表开始，查看端不需要丢掉的帧也能解码
+    writer.Reset();
+    CHECK_EQ(format.references, 0);
+    CHECK(queue.Push(EncodeForm(writer, &format, 6, 2000)));
+    CHECK(queue.Pop(&message));
+    RecordingSink sink;
+    CHECK(reader.Read(message, &sink));
+    CHECK_EQ(sink.resets, 1);
+    CHECK(sink.FindText().compare(0, 16, L"text Button 2000") == 0);
+}
+
+TEST(MalformedStreamsAreRejected) {
+    Format format = { L"Segoe UI", 14.0f, 0 };
+    DrawCommandWriter writer(GetPolicy());
+    writer.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    writer.PushClip(Rect(0, 0, 50, 50));
+    writer.PushLayer(0.5f);
+    writer.DrawString(L"x", 1, &format, 0xFF000000, 0, Rect(0, 0, 10, 10));
+    writer.PopLayer();
+    writer.PopClip();
+    std::string frame = writer.EndFrame();
+
+    // 任何位置截断都要被拒绝，且已压入的裁剪和图层都已弹出
+    bool allRejected = true;
+    bool allBalanced = true;
+    for (size_t length = 0; length < frame.size(); ++length) {
+        DrawCommandReader reader;
+        RecordingSink sink;
+        allRejected = allRejected && !reader.Read(frame.substr(0, length), &sink);
+        allBalanced = allBalanced && sink.depth == 0;
+    }
+    CHECK(allRejected);
+    CHECK(allBalanced);
+
+    auto rejects = [](const std::string& data) {
+        DrawCommandReader reader;
+        RecordingSink sink;
+        bool ok = reader.Read(data, &sink);
+        return !ok && sink.depth == 0;
+    };
+    auto op = [](KroubleUI::DrawOp value) { return std::string(1, static_cast<char>(value)); };
+    std::string begin = op(KroubleUI::DrawOp::BeginFrame) + std::string("\x0a\x0a\x00\x00\x08\x08", 6);
+
+    // 未知的操作码
+    CHECK(rejects(begin + "\x7f" + op(KroubleUI::DrawOp::EndFrame)));
+    // 帧开始之前的绘制命令
+    CHECK(rejects(op(KroubleUI::DrawOp::PopClip) + begin + op(KroubleUI::DrawOp::EndFrame)));
+    // 弹出帧本身的裁剪
+    CHECK(rejects(begin + op(KroubleUI::DrawOp::PopClip) + op(KroubleUI::DrawOp::EndFrame)));
+    // 压入裁剪后弹出图层
+    CHECK(rejects(begin + op(KroubleUI::DrawOp::PushClip) + std::string(4, '\0') + op(KroubleUI::DrawOp::PopLayer) +
+        op(KroubleUI::DrawOp::EndFrame)));
+    // 未定义的颜色编号
+    CHECK(rejects(begin + op(KroubleUI::DrawOp::FillRectangle) + std::string(5, '\0') + op(KroubleUI::DrawOp::EndFrame)));
+    // 两次 BeginFrame
+    CHECK(rejects(begin + begin + op(KroubleUI::DrawOp::EndFrame)));
+    // 超长的变长整数
+    CHECK(rejects(begin + op(KroubleUI::DrawOp::DefineString) + std::string(11, '\xff')));
+    // 缺少 EndFrame
+    CHECK(rejects(begin));
+    // 作为对照，完整的帧可以解码
+    CHECK(!rejects(begin + op(KroubleUI::DrawOp::EndFrame)));
+}
+
+TEST(WriterReleasesFormats) {
+    Format a = { L"A", 10.0f, 0 };
+    Format b = { L"B", 12.0f, 0 };
+    {
+        DrawCommandWriter writer(GetPolicy());
+        writer.BeginFrame(10, 10, Rect(0, 0, 10, 10));
+        writer.DrawString(L"1", 1, &a, 0, 0, Rect(0, 0, 1, 1));
+        writer.DrawString(L"2", 1, &a, 0, 0, Rect(0, 0, 1, 1));
+        writer.DrawString(L"3", 1, &b, 0, 0, Rect(0, 0, 1, 1));
+        writer.EndFrame();
+        CHECK_EQ(a.references, 1);
+        CHECK_EQ(b.references, 1);
+    }
+    CHECK_EQ(a.references, 0);
+    CHECK_EQ(b.references, 0);
+}
+
+TEST(SendQueueKeepsOneOversizedMessage) {
+    FrameSendQueue queue(10);
+    CHECK(queue.Push(std::string(50, 'x')));
+    CHECK_EQ(queue.GetBytes(), 50u);
+    CHECK(!queue.Push("y"));
+    CHECK(queue.IsEmpty());
+}
@@ -0,0 +1,73 @@
+// 日志内容的追加和滚动基准：默认追加 1000 万行，统计吞吐、最慢的一次追加和一帧滚动读取的耗时
+#include "LogBuffer.h"
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+using KroubleUI::LogBuffer;
+using KroubleBenchmark::Stopwatch;
+
+int main(int argc, char** argv) {
+    const size_t lineCount = KroubleBenchmark::GetArgument(argc, argv, "--lines", 10000000);
+    const size_t batchLines = KroubleBenchmark::GetArgument(argc, argv, "--batch", 1000);
+    const size_t visibleLines = 60;
+
+    LogBuffer buffer;
+    std::string batch;
+    char line[64];
+
+    // 按批追加，模拟日志源每次写入多行
+    Stopwatch total;
+    double worstAppend = 0;
+    size_t appendedBytes = 0;
+    for (size_t i = 0; i < lineCount; i += batchLines) {
+        batch.clear();
+        size_t end = (std::min)(lineCount, i + batchLines);
+        for (size_t n = i; n < end; ++n) {
+            int length = std::snprintf(line, sizeof(line), "%010zu INFO worker: request done\n", n);
+            batch.append(line, length);
+        }
+
+        Stopwatch append;
+        buffer.Append(batch.data(), batch.size());
+        worstAppend = (std::max)(worstAppend, append.GetSeconds());
+        appendedBytes += batch.size();
+    }
+    double appendSeconds = total.GetSeconds();
+
+    if (buffer.GetLineCount() != lineCount) {
+        std::fprintf(stderr, "line count %zu, expected %zu\n", buffer.GetLineCount(), lineCount);
+        return 1;
+    }
+
+    // 滚动：每帧跳到一个新位置，读取一屏的行
+    const size_t frames = 10000;
+    size_t checksum = 0;
+    Stopwatch scroll;
+    double worstFrame = 0;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        Stopwatch one;
+        size_t first = (frame * 7919) % (lineCount - (std::min)(lineCount, visibleLines) + 1);
+        size_t last = (std::min)(lineCount, first + visibleLines);
+        for (size_t n = first; n < last; ++n) {
+            size_t begin = 0;
+            size_t stop = 0;
+            buffer.GetLineRange(n, &begin, &stop);
+            checksum += static_cast<unsigned char>(buffer.ReadBytes(begin, stop)[0]);
+        }
+        worstFrame = (std::max)(worstFrame, one.GetSeconds());
+    }
+    double scrollSeconds = scroll.GetSeconds();
+
+    std::printf("lines:            %zu (%.1f MB)\n", lineCount, appendedBytes / 1048576.0);
+    std::printf("append:           %.3f s, %.1f MB/s, %.2f M lines/s\n", appendSeconds,
+        appendedBytes / 1048576.0 / appendSeconds, lineCount / 1e6 / appendSeconds);
+    std::printf("worst append:     %.3f ms (%zu lines)\n", worstAppend * 1000, batchLines);
+    std::printf("scroll frame:     %.3f us average, %.3f us worst (%zu lines)\n",
+        scrollSeconds / frames * 1e6, worstFrame * 1e6, visibleLines);
+    std::printf("memory:           %.1f MB\n", buffer.GetCpuBytes() / 1048576.0);
+    std::printf("checksum:         %zu\n", checksum);
+    return 0;
+}
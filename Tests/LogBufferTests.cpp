@@ -0,0 +1,119 @@
+#include "LogBuffer.h"
+#include "TestHarness.h"
+
+#include <string>
+
+using KroubleUI::LogBuffer;
+
+namespace {
+
+    std::string GetLine(LogBuffer& buffer, size_t line) {
+        size_t begin = 0;
+        size_t end = 0;
+        buffer.GetLineRange(line, &begin, &end);
+        return std::string(buffer.ReadBytes(begin, end), end - begin);
+    }
+
+} // namespace
+
+TEST(EmptyBufferHasNoLines) {
+    LogBuffer buffer;
+    CHECK_EQ(buffer.GetLineCount(), 0u);
+    CHECK(buffer.IsIndexed());
+}
+
+TEST(AppendIndexesLines) {
+    LogBuffer buffer;
+    buffer.Append("first\nsecond\n", 13);
+    buffer.Append("thi", 3);
+    buffer.Append("rd", 2);
+    CHECK_EQ(buffer.GetLineCount(), 3u);
+    CHECK_EQ(GetLine(buffer, 0), "first");
+    CHECK_EQ(GetLine(buffer, 1), "second");
+    CHECK_EQ(GetLine(buffer, 2), "third");
+}
+
+TEST(TrailingNewlineDoesNotAddLine) {
+    LogBuffer buffer;
+    buffer.Append("a\nb\n", 4);
+    CHECK_EQ(buffer.GetLineCount(), 2u);
+}
+
+TEST(ExternalDataSkipsBom) {
+    const char data[] = "\xEF\xBB\xBFhello\nworld";
+    LogBuffer buffer;
+    buffer.SetExternalData(data, sizeof(data) - 1);
+    CHECK(!buffer.IsIndexed());
+    buffer.IndexPending(4);
+    CHECK(!buffer.IsIndexed());
+    buffer.IndexPending(1000);
+    CHECK(buffer.IsIndexed());
+    CHECK_EQ(buffer.GetLineCount(), 2u);
+    CHECK_EQ(GetLine(buffer, 0), "hello");
+    CHECK_EQ(GetLine(buffer, 1), "world");
+}
+
+TEST(AppendAfterExternalDataWaitsForBacklog) {
+    const char data[] = "one\ntwo\n";
+    LogBuffer buffer;
+    buffer.SetExternalData(data, sizeof(data) - 1);
+    buffer.Append("three\n", 6);
+    // 外部数据还没有索引完，追加的内容排在后面
+    CHECK_EQ(buffer.GetIndexedSize(), 0u);
+    buffer.IndexPending(buffer.GetTotalSize());
+    CHECK_EQ(buffer.GetLineCount(), 3u);
+    CHECK_EQ(GetLine(buffer, 2), "three");
+}
+
+TEST(LineSpanningChunksIsJoined) {
+    LogBuffer buffer;
+    std::string head(LogBuffer::kChunkSize - 3, 'x');
+    head += '\n';
+    buffer.Append(head.data(), head.size());
+    buffer.Append("abcdef\n", 7);
+    CHECK_EQ(buffer.GetLineCount(), 2u);
+    CHECK_EQ(GetLine(buffer, 1), "abcdef");
+}
+
+TEST(LineSpanningExternalAndAppendedIsJoined) {
+    const char data[] = "line\npart";
+    LogBuffer buffer;
+    buffer.SetExternalData(data, sizeof(data) - 1);
+    buffer.IndexPending(100);
+    buffer.Append("ial\n", 4);
+    CHECK_EQ(GetLine(buffer, 1), "partial");
+}
+
+TEST(LongLineIsCutOnCharacterBoundary) {
+    // "中" 是 3 字节，kMaxLineBytes 不是 3 的倍数时截断点落在字符中间
+    static_assert(LogBuffer::kMaxLineBytes % 3 != 0, "cut must fall inside a character");
+    std::string text;
+    while (text.size() < LogBuffer::kMaxLineBytes + 10) {
+        text += "\xE4\xB8\xAD";
+    }
+    LogBuffer buffer;
+    buffer.Append(text.data(), text.size());
+
+    std::string line = GetLine(buffer, 0);
+    CHECK(line.size() <= LogBuffer::kMaxLineBytes);
+    CHECK_EQ(line.size() % 3, 0u);
+    CHECK(LogBuffer::kMaxLineBytes - line.size() < 3);
+}
+
+TEST(LongAsciiLineIsCutAtLimit) {
+    std::string text(LogBuffer::kMaxLineBytes * 2, 'a');
+    text += '\n';
+    LogBuffer buffer;
+    buffer.Append(text.data(), text.size());
+    CHECK_EQ(GetLine(buffer, 0).size(), LogBuffer::kMaxLineBytes);
+}
+
+TEST(ClearResetsContent) {
+    LogBuffer buffer;
+    buffer.Append("a\nb\n", 4);
+    buffer.Clear();
+    CHECK_EQ(buffer.GetLineCount(), 0u);
+    CHECK_EQ(buffer.GetTotalSize(), 0u);
+    buffer.Append("c", 1);
+    CHECK_EQ(GetLine(buffer, 0), "c");
+}
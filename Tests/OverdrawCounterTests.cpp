@@ -0,0 +1,170 @@
+#include "OverdrawCounter.h"
+#include "TestHarness.h"
+
+using KroubleUI::Control;
+using KroubleUI::OverdrawCounter;
+using KroubleUI::OverdrawStats;
+using KroubleUI::Transform2D;
+using KroubleUI::ViewRect;
+
+namespace {
+
+    // 只用作编号，不会解引用
+    const Control* FakeControl(int id) {
+        return reinterpret_cast<const Control*>(static_cast<uintptr_t>(id) * 16);
+    }
+
+    ViewRect Rect(float left, float top, float right, float bottom) {
+        ViewRect rect = { left, top, right, bottom };
+        return rect;
+    }
+
+    Transform2D Translate(float dx, float dy) {
+        Transform2D transform = Transform2D::Identity();
+        transform.dx = dx;
+        transform.dy = dy;
+        return transform;
+    }
+
+} // namespace
+
+TEST(FillsAreCountedPerPixel) {
+    OverdrawCounter counter;
+    counter.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    counter.Fill(nullptr, Rect(0, 0, 100, 100), Transform2D::Identity(), true);
+    counter.Fill(FakeControl(1), Rect(10, 10, 20, 20), Transform2D::Identity(), true);
+
+    OverdrawStats stats;
+    counter.EndFrame(&stats);
+    CHECK_EQ(stats.paintedPixels, 10000u + 100u);
+    CHECK_EQ(stats.coveredPixels, 10000u);
+    CHECK_EQ(stats.maxDepth, 2u);
+    CHECK_EQ(stats.damagedPixels, 10000u);
+    CHECK_EQ(stats.controls.size(), 1u);
+    CHECK_EQ(stats.controls[0].visiblePixels, 100u);
+}
+
+TEST(FillsOutsideDamageAreClipped) {
+    OverdrawCounter counter;
+    counter.BeginFrame(100, 100, Rect(0, 0, 50, 100));
+    counter.Fill(FakeControl(1), Rect(0, 0, 100, 10), Transform2D::Identity(), true);
+
+    OverdrawStats stats;
+    counter.EndFrame(&stats);
+    CHECK_EQ(stats.damagedPixels, 5000u);
+    CHECK_EQ(stats.paintedPixels, 500u);
+}
+
+TEST(ClipStackIntersectsAndPops) {
+    OverdrawCounter counter;
+    counter.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    counter.PushClip(Rect(0, 0, 40, 40), Transform2D::Identity());
+    // 内层裁剪只能缩小，不能超出外层
+    counter.PushClip(Rect(20, 20, 80, 80), Transform2D::Identity());
+    counter.Fill(FakeControl(1), Rect(0, 0, 100, 100), Transform2D::Identity(), true);
+    counter.PopClip();
+    counter.Fill(FakeControl(2), Rect(0, 0, 100, 100), Transform2D::Identity(), false);
+    counter.PopClip();
+    counter.Fill(FakeControl(3), Rect(0, 0, 100, 100), Transform2D::Identity(), false);
+    // 多余的 Pop 不会弹出失效区域
+    counter.PopClip();
+    counter.Fill(FakeControl(4), Rect(0, 0, 200, 200), Transform2D::Identity(), false);
+
+    OverdrawStats stats;
+    counter.EndFrame(&stats);
+    CHECK_EQ(stats.controls.size(), 4u);
+    CHECK_EQ(stats.paintedPixels, 400u + 1600u + 10000u + 10000u);
+}
+
+TEST(ClipUsesTransformAtPushTime) {
+    OverdrawCounter counter;
+    counter.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    counter.PushClip(Rect(0, 0, 10, 10), Translate(50, 50));
+    counter.Fill(FakeControl(1), Rect(0, 0, 100, 100), Transform2D::Identity(), true);
+
+    OverdrawStats stats;
+    counter.EndFrame(&stats);
+    CHECK_EQ(stats.paintedPixels, 100u);
+}
+
+TEST(RotatedFillIsRejected) {
+    OverdrawCounter counter;
+    counter.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    Transform2D rotate = { 0.7071f, 0.7071f, -0.7071f, 0.7071f, 50, 0 };
+    CHECK(!counter.Fill(FakeControl(1), Rect(0, 0, 20, 20), rotate, true));
+
+    OverdrawStats stats;
+    counter.EndFrame(&stats);
+    CHECK_EQ(stats.rejectedFills, 1u);
+    CHECK_EQ(stats.paintedPixels, 0u);
+}
+
+TEST(QuarterTurnFillIsCounted) {
+    OverdrawCounter counter;
+    counter.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    // 旋转 90 度：(x, y) -> (-y, x)，再平移回可见区域
+    Transform2D rotate = { 0, 1, -1, 0, 50, 0 };
+    CHECK(counter.Fill(FakeControl(1), Rect(0, 0, 20, 10), rotate, true));
+
+    OverdrawStats stats;
+    counter.EndFrame(&stats);
+    CHECK_EQ(stats.rejectedFills, 0u);
+    CHECK_EQ(stats.paintedPixels, 200u);
+}
+
+TEST(RotatedClipUsesBounds) {
+    OverdrawCounter counter;
+    counter.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    // 与 Direct2D 的轴对齐裁剪相同，使用变换后的外接矩形
+    Transform2D rotate = { 0.7071f, 0.7071f, -0.7071f, 0.7071f, 50, 0 };
+    counter.PushClip(Rect(0, 0, 10, 10), rotate);
+    counter.Fill(FakeControl(1), Rect(0, 0, 100, 100), Transform2D::Identity(), true);
+
+    OverdrawStats stats;
+    counter.EndFrame(&stats);
+    // 外接矩形约为 x: 42.9..57.1, y: 0..14.1
+    CHECK(stats.paintedPixels >= 14u * 13u && stats.paintedPixels <= 15u * 15u);
+}
+
+TEST(OccludedControlIsReported) {
+    OverdrawCounter counter;
+    counter.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    counter.Fill(FakeControl(1), Rect(10, 10, 20, 20), Transform2D::Identity(), true);
+    counter.Fill(FakeControl(2), Rect(0, 0, 50, 50), Transform2D::Identity(), true);
+
+    OverdrawStats stats;
+    counter.EndFrame(&stats);
+    CHECK_EQ(stats.occludedControls.size(), 1u);
+    CHECK(stats.occludedControls[0] == FakeControl(1));
+}
+
+TEST(TranslucentFillDoesNotOcclude) {
+    OverdrawCounter counter;
+    counter.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    counter.Fill(FakeControl(1), Rect(10, 10, 20, 20), Transform2D::Identity(), true);
+    // 例如背景色半透明的 ScrollViewer
+    counter.Fill(FakeControl(2), Rect(0, 0, 50, 50), Transform2D::Identity(), false);
+
+    OverdrawStats stats;
+    counter.EndFrame(&stats);
+    CHECK(stats.occludedControls.empty());
+    CHECK_EQ(stats.maxDepth, 2u);
+}
+
+TEST(FillInTranslucentLayerDoesNotOcclude) {
+    OverdrawCounter counter;
+    counter.BeginFrame(100, 100, Rect(0, 0, 100, 100));
+    counter.Fill(FakeControl(1), Rect(10, 10, 20, 20), Transform2D::Identity(), true);
+    // 不透明度 0.5 的控件在图层中填充不透明的背景，下面的控件仍然可见
+    counter.PushLayer(0.5f);
+    counter.Fill(FakeControl(2), Rect(0, 0, 50, 50), Transform2D::Identity(), true);
+    counter.PopLayer();
+    // 图层出栈后的不透明填充恢复遮挡
+    counter.Fill(FakeControl(3), Rect(60, 60, 70, 70), Transform2D::Identity(), true);
+    counter.Fill(FakeControl(4), Rect(50, 50, 100, 100), Transform2D::Identity(), true);
+
+    OverdrawStats stats;
+    counter.EndFrame(&stats);
+    CHECK_EQ(stats.occludedControls.size(), 1u);
+    CHECK(stats.occludedControls[0] == FakeControl(3));
+}
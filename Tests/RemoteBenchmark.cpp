@@ -0,0 +1,176 @@
+// 远程界面命令流基准：一个示例表单在几种常见交互下每帧的字节数、编码和解码耗时
+// 表单包含标题栏、30 个标签、8 个按钮、10 行的文本框和 20 行的列表，窗口 800x600
+// 编码耗时只计编码调用本身，与 DrawCommandEncoder 在窗口中的统计口径相同
+#include "DrawCommands.h"
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <string>
+
+using KroubleUI::DrawCommandReader;
+using KroubleUI::DrawCommandSink;
+using KroubleUI::DrawCommandWriter;
+using KroubleUI::DrawFormatPolicy;
+using KroubleUI::DrawTextFormat;
+using KroubleUI::ViewRect;
+using KroubleBenchmark::Stopwatch;
+
+namespace {
+
+    struct Format {
+        const wchar_t* family;
+        float size;
+        uint32_t weight;
+    };
+
+    const Format kBodyFormat = { L"Microsoft YaHei", 14.0f, 400 };
+    const Format kTitleFormat = { L"Microsoft YaHei", 20.0f, 700 };
+    const Format kMonoFormat = { L"Consolas", 13.0f, 400 };
+
+    void DescribeFormat(const void* handle, DrawTextFormat* desc) {
+        const Format* format = static_cast<const Format*>(handle);
+        desc->family = format->family;
+        desc->size = format->size;
+        desc->weight = format->weight;
+        desc->locale = L"zh-cn";
+    }
+
+    ViewRect Rect(float left, float top, float right, float bottom) {
+        ViewRect rect = { left, top, right, bottom };
+        return rect;
+    }
+
+    void Text(DrawCommandWriter& writer, const std::wstring& text, const Format* format, uint32_t color, const ViewRect& rect) {
+        writer.DrawString(text.c_str(), text.size(), format, color, 4, rect);
+    }
+
+    void DrawButton(DrawCommandWriter& writer, int index, bool hovered) {
+        float x = 20.0f + index * 95.0f;
+        ViewRect rect = Rect(x, 540, x + 85, 570);
+        writer.FillRectangle(hovered ? 0xFFF0E0D0 : 0xFFEEEEEE, rect);
+        writer.DrawRectangle(0xFF888888, 1.0f, rect);
+        Text(writer, L"按钮 " + std::to_wstring(index + 1), &kBodyFormat, 0xFF000000, Rect(x + 8, 540, x + 77, 570));
+    }
+
+    void DrawTextBox(DrawCommandWriter& writer, int typed) {
+        writer.FillRectangle(0xFFFFFFFF, Rect(20, 300, 380, 520));
+        writer.DrawRectangle(0xFF3070C0, 1.0f, Rect(20, 300, 380, 520));
+        writer.PushClip(Rect(21, 301, 379, 519));
+        for (int line = 0; line < 10; ++line) {
+            std::wstring text = L"第 " + std::to_wstring(line + 1) + L" 行 int value = compute(x, y);";
+            if (line == 9) {
+                text = L"typed: " + std::wstring(typed % 40, L'x');
+            }
+            Text(writer, text, &kMonoFormat, 0xFF202020, Rect(26, 304.0f + line * 21, 374, 325.0f + line * 21));
+        }
+        writer.DrawLine(0xFF000000, 1.0f, 80.0f + (typed % 40) * 7, 493, 80.0f + (typed % 40) * 7, 512);
+        writer.PopClip();
+    }
+
+    void DrawList(DrawCommandWriter& writer, int scroll) {
+        writer.FillRectangle(0xFFFFFFFF, Rect(400, 300, 780, 520));
+        writer.PushClip(Rect(400, 300, 780, 520));
+        for (int row = 0; row < 20; ++row) {
+            int item = scroll + row;
+            float top = 300.0f + row * 11;
+            if (item % 7 == 3) {
+                writer.FillRectangle(0xFFCCE0FF, Rect(400, top, 780, top + 11));
+            }
+            Text(writer, L"项目 " + std::to_wstring(item) + L"  状态: 正常", &kBodyFormat, 0xFF000000, Rect(406, top, 774, top + 11));
+        }
+        writer.PopClip();
+    }
+
+    void DrawFullForm(DrawCommandWriter& writer) {
+        writer.FillRectangle(0xFFF5F5F5, Rect(0, 0, 800, 600));
+        writer.FillRectangle(0xFF2050A0, Rect(0, 0, 800, 40));
+        Text(writer, L"示例表单 - 远程界面", &kTitleFormat, 0xFFFFFFFF, Rect(16, 0, 500, 40));
+        for (int i = 0; i < 30; ++i) {
+            float x = 20.0f + (i % 3) * 260;
+            float y = 56.0f + (i / 3) * 24;
+            Text(writer, L"字段 " + std::to_wstring(i + 1) + L":", &kBodyFormat, 0xFF404040, Rect(x, y, x + 80, y + 22));
+            writer.DrawRectangle(0xFFBBBBBB, 1.0f, Rect(x + 84, y + 1, x + 240, y + 21));
+        }
+        DrawTextBox(writer, 0);
+        DrawList(writer, 0);
+        // 半透明的提示层
+        writer.PushLayer(0.85f);
+        writer.FillRectangle(0xFFFFFFE0, Rect(560, 48, 780, 90));
+        Text(writer, L"提示：数据已保存", &kBodyFormat, 0xFF000000, Rect(566, 48, 774, 90));
+        writer.PopLayer();
+        for (int i = 0; i < 8; ++i) {
+            DrawButton(writer, i, false);
+        }
+    }
+
+    // 只数命令，模拟查看端的解码开销
+    class CountingSink : public DrawCommandSink {
+    public:
+        size_t commands = 0;
+        void OnFillRectangle(uint32_t, const ViewRect&) override { ++commands; }
+        void OnDrawRectangle(uint32_t, float, const ViewRect&) override { ++commands; }
+        void OnDrawLine(uint32_t, float, float, float, float, float) override { ++commands; }
+        void OnDrawText(const std::wstring&, size_t, uint32_t, uint32_t, const ViewRect&) override { ++commands; }
+    };
+
+    struct Scenario {
+        const char* name;
+        ViewRect damage;
+        void (*draw)(DrawCommandWriter& writer, int frame);
+    };
+
+    void DrawFull(DrawCommandWriter& writer, int) { DrawFullForm(writer); }
+    void DrawHover(DrawCommandWriter& writer, int frame) { DrawButton(writer, frame % 8, true); }
+    void DrawTyping(DrawCommandWriter& writer, int frame) { DrawTextBox(writer, frame); }
+    void DrawScroll(DrawCommandWriter& writer, int frame) { DrawList(writer, frame); }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t frames = KroubleBenchmark::GetArgument(argc, argv, "--frames", 10000);
+
+    const Scenario scenarios[] = {
+        { "full redraw", Rect(0, 0, 800, 600), DrawFull },
+        { "button hover", Rect(20, 540, 780, 570), DrawHover },
+        { "typing", Rect(20, 300, 380, 520), DrawTyping },
+        { "list scroll", Rect(400, 300, 780, 520), DrawScroll },
+    };
+
+    DrawFormatPolicy policy;
+    policy.describe = DescribeFormat;
+    std::printf("800x600 sample form, %zu frames per scenario\n", frames);
+    std::printf("%-14s %12s %12s %14s %14s\n", "scenario", "first (B)", "avg (B)", "encode (us)", "decode (us)");
+
+    bool ok = true;
+    for (const Scenario& scenario : scenarios) {
+        // 每个场景都从新的连接开始：第一帧带上全部定义，之后的帧只发编号
+        DrawCommandWriter writer(policy);
+        DrawCommandReader reader;
+        CountingSink sink;
+        size_t firstBytes = 0;
+        double decodeSeconds = 0.0;
+
+        for (size_t frame = 0; frame < frames; ++frame) {
+            Stopwatch watch;
+            writer.BeginFrame(800, 600, scenario.damage);
+            scenario.draw(writer, static_cast<int>(frame));
+            std::string& data = writer.EndFrame();
+            writer.AddEncodeSeconds(watch.GetSeconds());
+            if (frame == 0) firstBytes = data.size();
+
+            watch.Restart();
+            ok = reader.Read(data, &sink) && ok;
+            decodeSeconds += watch.GetSeconds();
+        }
+
+        const KroubleUI::RemoteFrameStats& stats = writer.GetStats();
+        std::printf("%-14s %12zu %12.1f %14.2f %14.2f\n", scenario.name, firstBytes, stats.GetAverageBytes(),
+            stats.GetAverageEncodeSeconds() * 1e6, decodeSeconds / frames * 1e6);
+    }
+
+    if (!ok) {
+        std::fprintf(stderr, "decoding failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,261 @@
+#include "ResourceUsage.h"
+#include "SharedCache.h"
+#include "TextFormatDesc.h"
+#include "TestHarness.h"
+
+#include <string>
+#include <vector>
+
+using KroubleUI::FormatBudgetMessage;
+using KroubleUI::FormatLeakMessage;
+using KroubleUI::ResourceBudget;
+using KroubleUI::ResourceKind;
+using KroubleUI::ResourceTracker;
+using KroubleUI::ResourceUsage;
+using KroubleUI::SharedCache;
+using KroubleUI::TextFormatDesc;
+using KroubleUI::TextFormatDescHash;
+
+namespace {
+
+    // Control 和 Window 依赖 Direct2D，这里用替身按相同的方式使用 ResourceTracker
+    // 格式是带引用计数的占位对象，上下文与 GraphicsContext 一样用 SharedCache 共享格式
+    struct Format {
+        int references = 1;
+    };
+
+    class MockContext {
+    private:
+        SharedCache<TextFormatDesc, Format, TextFormatDescHash> m_formats;
+        size_t m_live = 0;
+
+    public:
+        explicit MockContext(size_t capacity) : m_formats(capacity) {}
+        ~MockContext() { m_formats.Clear([this](Format* format) { Release(format); }); }
+
+        Format* GetTextFormat(const TextFormatDesc& desc) {
+            return m_formats.Acquire(desc,
+                [this](const TextFormatDesc&) { ++m_live; return new Format(); },
+                [](Format* format) { ++format->references; },
+                [this](Format* format) { Release(format); });
+        }
+
+        void Release(Format* format) {
+            if (--format->references == 0) {
+                --m_live;
+                delete format;
+            }
+        }
+
+        // 尚未销毁的格式，包括缓存已淘汰但仍被控件持有的
+        size_t GetLiveFormats() const { return m_live; }
+    };
+
+    // 按 TextBlock::UpdateTextFormat 的做法换用格式：取用新格式，登记，释放旧格式
+    // leaky 为 true 时忘记释放旧格式
+    class MockLabel {
+    private:
+        MockContext* m_context;
+        ResourceTracker m_resources;
+        Format* m_format = nullptr;
+        bool m_leaky;
+        std::vector<Format*> m_leaked;  // 忘记释放的旧格式，只在测试结束时清理
+
+        void ReleaseFormat(Format** format) {
+            if (*format) {
+                m_resources.Remove(ResourceKind::TextFormat, 0);
+                m_context->Release(*format);
+                *format = nullptr;
+            }
+        }
+
+    public:
+        MockLabel(MockContext* context, bool leaky) : m_context(context), m_leaky(leaky) {}
+
+        void SetFontSize(float size) {
+            TextFormatDesc desc;
+            desc.size = size;
+            Format* format = m_context->GetTextFormat(desc);
+            if (m_leaky) {
+                if (m_format) m_leaked.push_back(m_format);
+            }
+            else {
+                ReleaseFormat(&m_format);
+            }
+            m_format = format;
+            m_resources.Add(ResourceKind::TextFormat, 0);
+        }
+
+        void Destroy() {
+            ReleaseFormat(&m_format);
+            for (Format*& format : m_leaked) {
+                ReleaseFormat(&format);
+            }
+            m_leaked.clear();
+        }
+
+        const ResourceUsage& GetUsage() const { return m_resources.GetUsage(); }
+    };
+
+} // namespace
+
+TEST(TrackAndReleaseBalance) {
+    ResourceUsage usage;
+    usage.AddResource(ResourceKind::Brush, 64);
+    usage.AddResource(ResourceKind::Brush, 64);
+    usage.AddResource(ResourceKind::Bitmap, 4000);
+    CHECK_EQ(usage.GetTotalLiveCount(), 3u);
+    CHECK_EQ(usage.deviceBytes, 4128u);
+
+    usage.RemoveResource(ResourceKind::Brush, 64);
+    usage.RemoveResource(ResourceKind::Bitmap, 4000);
+    usage.RemoveResource(ResourceKind::Brush, 64);
+    CHECK_EQ(usage.GetTotalLiveCount(), 0u);
+    CHECK_EQ(usage.deviceBytes, 0u);
+    CHECK_EQ(usage.GetPeakCount(ResourceKind::Brush), 2u);
+    CHECK_EQ(usage.peakDeviceBytes, 4128u);
+    CHECK(FormatLeakMessage("control", &usage, usage).empty());
+}
+
+TEST(ExtraReleaseDoesNotUnderflow) {
+    ResourceUsage usage;
+    usage.AddResource(ResourceKind::TextLayout, 100);
+    usage.RemoveResource(ResourceKind::TextLayout, 100);
+    usage.RemoveResource(ResourceKind::TextLayout, 100);
+    CHECK_EQ(usage.GetLiveCount(ResourceKind::TextLayout), 0u);
+    CHECK_EQ(usage.deviceBytes, 0u);
+}
+
+TEST(LeakMessageListsKinds) {
+    ResourceUsage usage;
+    usage.AddResource(ResourceKind::Brush, 64);
+    usage.AddResource(ResourceKind::Brush, 64);
+    usage.AddResource(ResourceKind::TextLayout, 1024);
+    std::string message = FormatLeakMessage("control", nullptr, usage);
+    CHECK(message.find("3 tracked resources") != std::string::npos);
+    CHECK(message.find("brush 2") != std::string::npos);
+    CHECK(message.find("layout 1") != std::string::npos);
+    CHECK(message.find("bitmap") == std::string::npos);
+    CHECK(message.back() == '\n');
+}
+
+TEST(FontSizeChangesKeepOneFormatPerControl) {
+    MockContext context(4);
+    {
+        MockLabel label(&context, false);
+        for (int i = 0; i < 50; ++i) {
+            label.SetFontSize(12.0f + i);
+            CHECK_EQ(label.GetUsage().GetLiveCount(ResourceKind::TextFormat), 1u);
+        }
+        // 缓存上限内的格式加上控件正在使用的一份
+        CHECK(context.GetLiveFormats() <= 5u);
+        label.Destroy();
+        CHECK(FormatLeakMessage("control", &label, label.GetUsage()).empty());
+    }
+}
+
+TEST(FontSizeLeakShowsAsRisingFormatCount) {
+    MockContext context(4);
+    MockLabel label(&context, true);
+    for (uint32_t i = 1; i <= 50; ++i) {
+        label.SetFontSize(12.0f + i);
+        CHECK_EQ(label.GetUsage().GetLiveCount(ResourceKind::TextFormat), i);
+    }
+    // 被泄漏的引用让淘汰出缓存的格式无法销毁
+    CHECK(context.GetLiveFormats() > 4u);
+    std::string message = FormatLeakMessage("control", &label, label.GetUsage());
+    CHECK(message.find("format 50") != std::string::npos);
+    label.Destroy();
+}
+
+TEST(SharedFormatsCountedPerControlWithoutBytes) {
+    // 两个控件持有同一个格式：窗口合计两份引用，字节数只在上下文上
+    MockContext context(0);
+    MockLabel first(&context, false);
+    MockLabel second(&context, false);
+    first.SetFontSize(14.0f);
+    second.SetFontSize(14.0f);
+    CHECK_EQ(context.GetLiveFormats(), 1u);
+
+    ResourceUsage window = KroubleUI::SumResourceUsage(0, { first.GetUsage(), second.GetUsage() }, 0);
+    CHECK_EQ(window.GetLiveCount(ResourceKind::TextFormat), 2u);
+    CHECK_EQ(window.deviceBytes, 0u);
+    first.Destroy();
+    second.Destroy();
+}
+
+TEST(TrackerWarnsOnceUntilBackWithinBudget) {
+    ResourceTracker tracker;
+    ResourceBudget budget;
+    budget.maxLiveResources = 2;
+    tracker.SetBudget(budget);
+    CHECK(!tracker.Add(ResourceKind::Brush, 64));
+    CHECK(!tracker.Add(ResourceKind::Brush, 64));
+    CHECK(tracker.Add(ResourceKind::Brush, 64));
+    CHECK(!tracker.Add(ResourceKind::Brush, 64));
+    CHECK(!tracker.Remove(ResourceKind::Brush, 64));
+    CHECK(!tracker.Remove(ResourceKind::Brush, 64));
+    CHECK(tracker.Add(ResourceKind::Brush, 64));
+}
+
+TEST(PerFrameSamplingKeepsShortLivedPeaks) {
+    // 一个控件在第二帧创建了 5 个布局，第三帧释放；只在最后统计时看不到这次峰值
+    std::vector<uint32_t> layoutsPerFrame = { 1, 5, 1 };
+    ResourceTracker everyFrame;
+    ResourceTracker onRequest;
+    ResourceUsage control;
+    for (uint32_t layouts : layoutsPerFrame) {
+        control = ResourceUsage();
+        control.AddResources(ResourceKind::TextLayout, layouts, layouts * 1024);
+        everyFrame.Sample(KroubleUI::SumResourceUsage(100, { control }, 0));
+    }
+    onRequest.Sample(KroubleUI::SumResourceUsage(100, { control }, 0));
+
+    CHECK_EQ(everyFrame.GetUsage().GetLiveCount(ResourceKind::TextLayout), 1u);
+    CHECK_EQ(everyFrame.GetUsage().GetPeakCount(ResourceKind::TextLayout), 5u);
+    CHECK_EQ(everyFrame.GetUsage().peakDeviceBytes, 5120u);
+    CHECK_EQ(onRequest.GetUsage().GetPeakCount(ResourceKind::TextLayout), 1u);
+}
+
+TEST(WindowSampleChecksBudget) {
+    ResourceTracker window;
+    ResourceBudget budget;
+    budget.maxDeviceBytes = 1000000;
+    window.SetBudget(budget);
+    ResourceUsage control;
+    control.AddResource(ResourceKind::Bitmap, 1000);
+    CHECK(!window.Sample(KroubleUI::SumResourceUsage(100, { control }, 0)));
+    // 渲染目标的缓冲计入预算
+    CHECK(window.Sample(KroubleUI::SumResourceUsage(100, { control }, 800 * 600 * 4 * 2)));
+    CHECK(!window.Sample(KroubleUI::SumResourceUsage(100, { control }, 800 * 600 * 4 * 2)));
+    CHECK_EQ(window.GetUsage().cpuBytes, 100u);
+}
+
+TEST(TargetBytesAreSeparate) {
+    ResourceUsage window;
+    window.AddResource(ResourceKind::Bitmap, 1000);
+    window.targetBytes = 800 * 600 * 4 * 2;
+    CHECK_EQ(window.GetLiveCount(ResourceKind::Bitmap), 1u);
+    CHECK_EQ(window.deviceBytes, 1000u);
+
+    // 预算按设备资源和渲染目标的总和检查
+    ResourceBudget budget;
+    budget.maxDeviceBytes = 1000000;
+    CHECK(!budget.IsExceededBy(ResourceUsage()));
+    CHECK(budget.IsExceededBy(window));
+    std::string message = FormatBudgetMessage("window", nullptr, window, budget);
+    CHECK(message.find("device 3841000/1000000") != std::string::npos);
+}
+
+TEST(KeepPeaksAcrossUpdates) {
+    ResourceUsage previous;
+    previous.AddResource(ResourceKind::Bitmap, 5000);
+    previous.SetCpuBytes(300);
+    ResourceUsage current;
+    current.SetCpuBytes(100);
+    current.KeepPeaks(previous);
+    CHECK_EQ(current.cpuBytes, 100u);
+    CHECK_EQ(current.peakCpuBytes, 300u);
+    CHECK_EQ(current.peakDeviceBytes, 5000u);
+    CHECK_EQ(current.GetPeakCount(ResourceKind::Bitmap), 1u);
+}
@@ -0,0 +1,110 @@
+// 无窗口的滚动基准：按 60 帧/秒模拟滚轮惯性滚动，统计每帧补画的面积、需要重绘的子控件数和规划耗时
+#include "ScrollModel.h"
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using KroubleUI::PlanScroll;
+using KroubleUI::RectsIntersect;
+using KroubleUI::ScrollMotion;
+using KroubleUI::ScrollPlan;
+using KroubleUI::ViewRect;
+using KroubleUI::ViewToContent;
+using KroubleBenchmark::Stopwatch;
+
+int main(int argc, char** argv) {
+    const size_t rows = KroubleBenchmark::GetArgument(argc, argv, "--rows", 20000);
+    const size_t frames = KroubleBenchmark::GetArgument(argc, argv, "--frames", 20000);
+    const int viewWidth = 1280;
+    const int viewHeight = 800;
+    const float rowHeight = 24.0f;
+    const int columns = 4;
+
+    // 每行 4 个子控件，使用内容坐标
+    std::vector<ViewRect> children;
+    children.reserve(rows * columns);
+    float columnWidth = static_cast<float>(viewWidth) / columns;
+    for (size_t row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            ViewRect rect = { column * columnWidth, row * rowHeight, (column + 1) * columnWidth, (row + 1) * rowHeight };
+            children.push_back(rect);
+        }
+    }
+
+    ScrollMotion motion;
+    motion.SetViewSize(viewWidth, viewHeight);
+    motion.SetContentSize(viewWidth, rows * rowHeight);
+
+    const double viewportArea = static_cast<double>(viewWidth) * viewHeight;
+    int renderedX = 0;
+    int renderedY = 0;
+    bool surfaceValid = false;
+    double paintedArea = 0;
+    double scrolledArea = 0;
+    size_t paintedChildren = 0;
+    size_t scrollFrames = 0;
+    size_t fullRepaints = 0;
+    double worstFrame = 0;
+
+    Stopwatch total;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        // 每 6 帧一格滚轮，每 600 帧换一次方向
+        double time = frame / 60.0;
+        if (frame % 6 == 0) {
+            motion.ScrollBy(0, (frame / 600) % 2 == 0 ? 60.0 : -60.0, time);
+        }
+
+        Stopwatch one;
+        motion.Advance(time + 1.0 / 60);
+        int offsetX = static_cast<int>(std::lround(motion.GetOffsetX()));
+        int offsetY = static_cast<int>(std::lround(motion.GetOffsetY()));
+        int dx = offsetX - renderedX;
+        int dy = offsetY - renderedY;
+        ScrollPlan plan = PlanScroll(viewWidth, viewHeight, dx, dy, surfaceValid);
+
+        // 与 ScrollViewer::PaintRegion 使用同一裁剪：只重绘与补画区域相交的子控件
+        for (int i = 0; i < plan.exposedCount; ++i) {
+            ViewRect content = ViewToContent(plan.exposed[i], offsetX, offsetY);
+            for (const ViewRect& child : children) {
+                if (RectsIntersect(child, content)) ++paintedChildren;
+            }
+        }
+        worstFrame = (std::max)(worstFrame, one.GetSeconds());
+
+        if (plan.fullRepaint) {
+            ++fullRepaints;
+        }
+        else if (plan.copy) {
+            ++scrollFrames;
+            scrolledArea += std::abs(dx) * static_cast<double>(viewHeight) + std::abs(dy) * static_cast<double>(viewWidth) -
+                static_cast<double>(std::abs(dx)) * std::abs(dy);
+        }
+        paintedArea += plan.GetExposedArea();
+        renderedX = offsetX;
+        renderedY = offsetY;
+        surfaceValid = true;
+    }
+    double seconds = total.GetSeconds();
+
+    size_t visibleChildren = static_cast<size_t>(std::ceil(viewHeight / rowHeight) + 1) * columns;
+    double incrementalArea = paintedArea - fullRepaints * viewportArea;
+    std::printf("children:             %zu, viewport %dx%d\n", children.size(), viewWidth, viewHeight);
+    std::printf("frames:               %zu (%zu scrolled, %zu full repaints)\n", frames, scrollFrames, fullRepaints);
+    std::printf("painted per scroll:   %.0f px (%.2f%% of viewport), exposed %.0f px\n",
+        incrementalArea / (std::max)(scrollFrames, size_t(1)),
+        incrementalArea / (std::max)(scrollFrames, size_t(1)) / viewportArea * 100,
+        scrolledArea / (std::max)(scrollFrames, size_t(1)));
+    std::printf("children per scroll:  %.1f (full repaint: %zu)\n",
+        static_cast<double>(paintedChildren) / (std::max)(scrollFrames, size_t(1)), visibleChildren);
+    std::printf("plan + cull:          %.2f us average, %.2f us worst\n", seconds / frames * 1e6, worstFrame * 1e6);
+
+    // 补画面积必须等于露出的面积，否则平移复制或条带计算有误
+    if (std::fabs(incrementalArea - scrolledArea) > 0.5) {
+        std::fprintf(stderr, "painted area %.0f differs from exposed area %.0f\n", incrementalArea, scrolledArea);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "ScrollModel.h"
+#include "TestHarness.h"
+
+using KroubleUI::PlanScroll;
+using KroubleUI::RectsIntersect;
+using KroubleUI::ScrollMotion;
+using KroubleUI::ScrollPlan;
+using KroubleUI::ViewRect;
+using KroubleUI::ViewToContent;
+
+TEST(InvalidSurfaceRepaintsViewport) {
+    ScrollPlan plan = PlanScroll(100, 50, 0, 0, false);
+    CHECK(plan.fullRepaint);
+    CHECK_EQ(plan.exposedCount, 1);
+    CHECK_EQ(plan.GetExposedArea(), 100.0f * 50.0f);
+}
+
+TEST(NoScrollPaintsNothing) {
+    ScrollPlan plan = PlanScroll(100, 50, 0, 0, true);
+    CHECK(!plan.fullRepaint);
+    CHECK(!plan.copy);
+    CHECK_EQ(plan.exposedCount, 0);
+}
+
+TEST(ScrollDownExposesBottomStrip) {
+    ScrollPlan plan = PlanScroll(100, 50, 0, 7, true);
+    CHECK(plan.copy);
+    CHECK_EQ(plan.copySource.top, 7.0f);
+    CHECK_EQ(plan.copyDestination.top, 0.0f);
+    CHECK_EQ(plan.copyDestination.bottom, 43.0f);
+    CHECK_EQ(plan.exposedCount, 1);
+    CHECK_EQ(plan.exposed[0].top, 43.0f);
+    CHECK_EQ(plan.exposed[0].bottom, 50.0f);
+    CHECK_EQ(plan.GetExposedArea(), 100.0f * 7.0f);
+}
+
+TEST(DiagonalScrollStripsDoNotOverlap) {
+    ScrollPlan plan = PlanScroll(100, 50, -3, -5, true);
+    CHECK_EQ(plan.exposedCount, 2);
+    // 横条 100x5，竖条 3x45
+    CHECK_EQ(plan.GetExposedArea(), 100.0f * 5.0f + 3.0f * 45.0f);
+    CHECK_EQ(plan.exposed[1].left, 0.0f);
+    CHECK_EQ(plan.exposed[1].right, 3.0f);
+}
+
+TEST(ScrollOverOneScreenRepaints) {
+    ScrollPlan plan = PlanScroll(100, 50, 0, 50, true);
+    CHECK(plan.fullRepaint);
+}
+
+TEST(InertiaTravelsAboutRequestedDistance) {
+    ScrollMotion motion;
+    motion.SetViewSize(100, 100);
+    motion.SetContentSize(100, 10000);
+    motion.ScrollBy(0, 300, 0.0);
+    for (int frame = 1; frame <= 600 && motion.IsMoving(); ++frame) {
+        motion.Advance(frame / 60.0);
+    }
+    CHECK(!motion.IsMoving());
+    // 按帧积分比连续的 v / kFriction 略多，60 帧/秒时约 320
+    CHECK(motion.GetOffsetY() > 270 && motion.GetOffsetY() < 330);
+    CHECK_EQ(motion.GetOffsetX(), 0.0);
+}
+
+TEST(InertiaStopsAtContentEdge) {
+    ScrollMotion motion;
+    motion.SetViewSize(100, 100);
+    motion.SetContentSize(100, 150);
+    motion.ScrollBy(0, 1000, 0.0);
+    motion.Advance(0.1);
+    CHECK_EQ(motion.GetOffsetY(), 50.0);
+    CHECK(!motion.IsMoving());
+}
+
+TEST(ScrollAfterIdleStartsFromInputTime) {
+    ScrollMotion motion;
+    motion.SetViewSize(100, 100);
+    motion.SetContentSize(100, 10000);
+    motion.Advance(1.0);
+    // 空闲 100 秒后滚动，第一帧只积分输入之后的 1/60 秒
+    motion.ScrollBy(0, 300, 101.0);
+    motion.Advance(101.0 + 1.0 / 60);
+    // 初速度 2400 像素/秒，约 40 像素；按上一帧计时会积分 0.1 秒，约 240 像素
+    CHECK(motion.GetOffsetY() > 30 && motion.GetOffsetY() < 50);
+    CHECK(motion.IsMoving());
+}
+
+TEST(CullingMatchesScrolledContent) {
+    // 视口 (0, 0)-(100, 10) 滚动到 y = 95 时对应内容 (0, 95)-(100, 105)
+    ViewRect content = ViewToContent(ViewRect{ 0, 0, 100, 10 }, 0, 95);
+    CHECK_EQ(content.top, 95.0f);
+    CHECK_EQ(content.bottom, 105.0f);
+    CHECK(RectsIntersect(ViewRect{ 0, 80, 100, 100 }, content));
+    CHECK(RectsIntersect(ViewRect{ 0, 100, 100, 120 }, content));
+    // 只接触边缘不算相交
+    CHECK(!RectsIntersect(ViewRect{ 0, 75, 100, 95 }, content));
+    CHECK(!RectsIntersect(ViewRect{ 0, 105, 100, 125 }, content));
+}
+
+TEST(ShrinkingContentClampsOffset) {
+    ScrollMotion motion;
+    motion.SetViewSize(100, 100);
+    motion.SetContentSize(100, 1000);
+    motion.ScrollTo(0, 800);
+    CHECK_EQ(motion.GetOffsetY(), 800.0);
+    motion.SetContentSize(100, 300);
+    CHECK_EQ(motion.GetOffsetY(), 200.0);
+}
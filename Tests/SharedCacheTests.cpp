@@ -0,0 +1,124 @@
+#include "SharedCache.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using KroubleUI::SharedCache;
+
+namespace {
+
+    struct Format {
+        std::string desc;
+        std::atomic<int> references;
+        explicit Format(const std::string& d) : desc(d), references(1) {}
+    };
+
+    typedef SharedCache<std::string, Format> FormatCache;
+
+    Format* Create(const std::string& desc) { return new Format(desc); }
+    void Retain(Format* format) { ++format->references; }
+    void Release(Format* format) {
+        if (--format->references == 0) delete format;
+    }
+
+} // namespace
+
+TEST(SameDescReturnsSameObject) {
+    FormatCache cache;
+    Format* a = cache.Acquire("yahei-14", Create, Retain, Release);
+    Format* b = cache.Acquire("yahei-14", Create, Retain, Release);
+    Format* c = cache.Acquire("yahei-20", Create, Retain, Release);
+    CHECK(a == b);
+    CHECK(a != c);
+    CHECK_EQ(a->references.load(), 3);
+    CHECK_EQ(cache.GetCount(), 2u);
+    CHECK_EQ(cache.GetCreatedCount(), 2u);
+    Release(a);
+    Release(b);
+    Release(c);
+    cache.Clear(Release);
+    CHECK_EQ(cache.GetCount(), 0u);
+}
+
+TEST(ObjectOutlivesClearWhileReferenced) {
+    FormatCache cache;
+    Format* format = cache.Acquire("mono-12", Create, Retain, Release);
+    cache.Clear(Release);
+    CHECK_EQ(format->references.load(), 1);
+    CHECK_EQ(format->desc, "mono-12");
+    Release(format);
+}
+
+TEST(FailedCreateIsNotCached) {
+    FormatCache cache;
+    int attempts = 0;
+    auto fail = [&attempts](const std::string&) -> Format* { ++attempts; return nullptr; };
+    CHECK(cache.Acquire("missing", fail, Retain, Release) == nullptr);
+    CHECK(cache.Acquire("missing", fail, Retain, Release) == nullptr);
+    CHECK_EQ(attempts, 2);
+    CHECK_EQ(cache.GetCount(), 0u);
+}
+
+TEST(OverCapacityEvictsLeastRecentlyAcquired) {
+    FormatCache cache(2);
+    Format* a = cache.Acquire("size-10", Create, Retain, Release);
+    Format* b = cache.Acquire("size-11", Create, Retain, Release);
+    Release(cache.Acquire("size-10", Create, Retain, Release));
+    // size-11 最久未取用，被淘汰；调用者仍持有的引用保持有效
+    Format* c = cache.Acquire("size-12", Create, Retain, Release);
+    CHECK_EQ(cache.GetCount(), 2u);
+    CHECK_EQ(cache.GetEvictedCount(), 1u);
+    CHECK_EQ(b->references.load(), 1);
+    CHECK_EQ(b->desc, "size-11");
+
+    // 再次取用被淘汰的描述时重新创建
+    Format* again = cache.Acquire("size-11", Create, Retain, Release);
+    CHECK(again != b);
+    CHECK_EQ(cache.GetCreatedCount(), 4u);
+    CHECK_EQ(cache.GetCount(), 2u);
+    Release(a);
+    Release(b);
+    Release(c);
+    Release(again);
+    cache.Clear(Release);
+}
+
+TEST(AnimatedSizesStayWithinCapacity) {
+    FormatCache cache(16);
+    for (int step = 0; step < 1000; ++step) {
+        Release(cache.Acquire("size-" + std::to_string(step), Create, Retain, Release));
+    }
+    CHECK_EQ(cache.GetCount(), 16u);
+    CHECK_EQ(cache.GetEvictedCount(), 984u);
+    cache.Clear(Release);
+}
+
+TEST(ConcurrentAcquireCreatesOnce) {
+    FormatCache cache;
+    std::atomic<int> created(0);
+    auto create = [&created](const std::string& desc) { ++created; return new Format(desc); };
+
+    std::vector<std::thread> threads;
+    std::vector<Format*> results(8);
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            for (int n = 0; n < 1000; ++n) {
+                Format* format = cache.Acquire("shared", create, Retain, Release);
+                if (n == 0) results[i] = format;
+                else Release(format);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    CHECK_EQ(created.load(), 1);
+    for (Format* format : results) {
+        CHECK(format == results[0]);
+    }
+    CHECK_EQ(results[0]->references.load(), 9);
+    for (Format* format : results) Release(format);
+    cache.Clear(Release);
+}
@@ -0,0 +1,113 @@
+// 信号的连接和发出基准：默认 1 万个信号（相当于 1 万个控件各有一个事件）
+// 与每个控件保存一个 std::function 的旧做法对比每次发出的耗时
+#include "Signal.h"
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using KroubleUI::Connection;
+using KroubleUI::Signal;
+using KroubleBenchmark::Stopwatch;
+
+namespace {
+
+    // 模拟控件对象：处理函数只捕获指针
+    struct Target {
+        long long sum = 0;
+    };
+
+    void Report(const char* name, double seconds, size_t count) {
+        std::printf("%-30s %10.2f\n", name, seconds / count * 1e9);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t signalCount = KroubleBenchmark::GetArgument(argc, argv, "--signals", 10000);
+    const size_t rounds = KroubleBenchmark::GetArgument(argc, argv, "--rounds", 1000);
+
+    std::vector<Target> targets(signalCount);
+    std::printf("%zu signals, %zu rounds\n", signalCount, rounds);
+    std::printf("%-30s %10s\n", "operation", "ns each");
+
+    // 连接：第一个处理函数存放在信号内部
+    std::vector<std::unique_ptr<Signal<int>>> signals;
+    std::vector<Connection> connections;
+    signals.reserve(signalCount);
+    connections.reserve(signalCount * 4);
+    for (size_t i = 0; i < signalCount; ++i) {
+        signals.emplace_back(new Signal<int>());
+    }
+    Stopwatch watch;
+    for (size_t i = 0; i < signalCount; ++i) {
+        Target* target = &targets[i];
+        connections.push_back(signals[i]->Connect([target](int value) { target->sum += value; }));
+    }
+    Report("connect (inline slot)", watch.GetSeconds(), signalCount);
+
+    watch.Restart();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < signalCount; ++i) {
+            signals[i]->Emit(1);
+        }
+    }
+    Report("emit, 1 slot", watch.GetSeconds(), signalCount * rounds);
+
+    // 对照：每个控件一个 std::function
+    std::vector<std::function<void(int)>> functions(signalCount);
+    for (size_t i = 0; i < signalCount; ++i) {
+        Target* target = &targets[i];
+        functions[i] = [target](int value) { target->sum += value; };
+    }
+    watch.Restart();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < signalCount; ++i) {
+            functions[i](1);
+        }
+    }
+    Report("std::function call (baseline)", watch.GetSeconds(), signalCount * rounds);
+
+    // 发出时没有处理函数，大多数控件的大多数事件都是这样
+    Signal<int> empty;
+    watch.Restart();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < signalCount; ++i) {
+            empty.Emit(1);
+        }
+    }
+    Report("emit, no slots", watch.GetSeconds(), signalCount * rounds);
+
+    // 每个信号再连接三个处理函数，全部移到堆上
+    watch.Restart();
+    for (size_t i = 0; i < signalCount; ++i) {
+        Target* target = &targets[i];
+        for (int n = 0; n < 3; ++n) {
+            connections.push_back(signals[i]->Connect([target](int value) { target->sum -= value; }));
+        }
+    }
+    Report("connect (heap slots)", watch.GetSeconds(), signalCount * 3);
+
+    watch.Restart();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < signalCount; ++i) {
+            signals[i]->Emit(1);
+        }
+    }
+    Report("emit, 4 slots", watch.GetSeconds(), signalCount * rounds);
+
+    watch.Restart();
+    connections.clear();
+    Report("disconnect", watch.GetSeconds(), signalCount * 4);
+
+    // 一个处理函数和 std::function 各加 rounds 次，四个处理函数时每次净减 2，合计为 0
+    for (const Target& target : targets) {
+        if (target.sum != 0) {
+            std::fprintf(stderr, "unexpected handler sum %lld\n", target.sum);
+            return 1;
+        }
+    }
+    return 0;
+}
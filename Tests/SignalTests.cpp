@@ -0,0 +1,187 @@
+#include "Signal.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using KroubleUI::Connection;
+using KroubleUI::Signal;
+
+// 统计全局 operator new 的调用次数，检查内部存放的处理函数不分配内存
+namespace {
+    std::atomic<size_t> g_allocations(0);
+}
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+TEST(EmitCallsHandlersInConnectionOrder) {
+    Signal<int> signal;
+    std::vector<int> calls;
+    std::vector<int>* log = &calls;
+    Connection a = signal.Connect([log](int value) { log->push_back(value); });
+    Connection b = signal.Connect([log](int value) { log->push_back(value * 10); });
+    Connection c = signal.Connect([log](int value) { log->push_back(value * 100); });
+    signal.Emit(2);
+    CHECK(calls == std::vector<int>({ 2, 20, 200 }));
+    CHECK_EQ(signal.GetSlotCount(), size_t(3));
+}
+
+TEST(DisconnectDuringEmitSkipsLaterHandler) {
+    Signal<> signal;
+    int first = 0, second = 0, third = 0;
+    Connection b;
+    Connection* handle = &b;
+    int* counter = &first;
+    Connection a = signal.Connect([counter, handle]() { ++*counter; handle->Disconnect(); });
+    b = signal.Connect([&second]() { ++second; });
+    Connection c = signal.Connect([&third]() { ++third; });
+
+    signal.Emit();
+    CHECK_EQ(first, 1);
+    CHECK_EQ(second, 0);
+    CHECK_EQ(third, 1);
+    CHECK(!b.IsConnected());
+    CHECK_EQ(signal.GetSlotCount(), size_t(2));
+}
+
+TEST(HandlerCanDisconnectItself) {
+    Signal<> signal;
+    int calls = 0;
+    Connection self;
+    Connection* handle = &self;
+    self = signal.Connect([&calls, handle]() { ++calls; handle->Disconnect(); });
+    signal.Emit();
+    signal.Emit();
+    CHECK_EQ(calls, 1);
+    CHECK_EQ(signal.GetSlotCount(), size_t(0));
+}
+
+TEST(ConnectDuringEmitTakesEffectNextTime) {
+    Signal<> signal;
+    int outer = 0, inner = 0;
+    std::vector<Connection> added;
+    Connection a = signal.Connect([&]() {
+        ++outer;
+        if (added.empty()) {
+            added.push_back(signal.Connect([&inner]() { ++inner; }));
+        }
+    });
+
+    signal.Emit();
+    CHECK_EQ(outer, 1);
+    CHECK_EQ(inner, 0);
+    signal.Emit();
+    CHECK_EQ(outer, 2);
+    CHECK_EQ(inner, 1);
+}
+
+TEST(ConnectAndDisconnectDuringEmit) {
+    // 发出期间新连接又断开的处理函数不会生效
+    Signal<> signal;
+    int inner = 0;
+    Connection a = signal.Connect([&]() {
+        Connection temporary = signal.Connect([&inner]() { ++inner; });
+    });
+    signal.Emit();
+    a.Disconnect();
+    signal.Emit();
+    CHECK_EQ(inner, 0);
+    CHECK_EQ(signal.GetSlotCount(), size_t(0));
+}
+
+TEST(MovedConnectionStillControlsSlot) {
+    Signal<> signal;
+    int calls = 0;
+    Connection first = signal.Connect([&calls]() { ++calls; });
+    Connection second(std::move(first));
+    CHECK(!first.IsConnected());
+    CHECK(second.IsConnected());
+
+    Connection third;
+    third = std::move(second);
+    signal.Emit();
+    CHECK_EQ(calls, 1);
+
+    // 被移动的句柄析构不影响连接
+    { Connection gone(std::move(first)); }
+    signal.Emit();
+    CHECK_EQ(calls, 2);
+
+    third.Disconnect();
+    signal.Emit();
+    CHECK_EQ(calls, 2);
+}
+
+TEST(MoveAssignDisconnectsPreviousSlot) {
+    Signal<> signal;
+    int a = 0, b = 0;
+    Connection handle = signal.Connect([&a]() { ++a; });
+    handle = signal.Connect([&b]() { ++b; });
+    signal.Emit();
+    CHECK_EQ(a, 0);
+    CHECK_EQ(b, 1);
+    CHECK_EQ(signal.GetSlotCount(), size_t(1));
+}
+
+TEST(SignalDestroyedBeforeHandle) {
+    Connection inlineHandle;
+    Connection heapHandle;
+    {
+        Signal<> signal;
+        std::string big(100, 'x');
+        inlineHandle = signal.Connect([]() {});
+        heapHandle = signal.Connect([big]() { (void)big; });
+        CHECK(inlineHandle.IsConnected());
+    }
+    CHECK(!inlineHandle.IsConnected());
+    CHECK(!heapHandle.IsConnected());
+    inlineHandle.Disconnect();
+}
+
+TEST(ReleasedHandlerLivesWithSignal) {
+    Signal<> signal;
+    int calls = 0;
+    signal.Connect([&calls]() { ++calls; }).Release();
+    signal.Emit();
+    CHECK_EQ(calls, 1);
+    CHECK_EQ(signal.GetSlotCount(), size_t(1));
+}
+
+TEST(InlineSlotDoesNotAllocate) {
+    int calls = 0;
+    int* counter = &calls;
+    size_t before = g_allocations.load();
+    {
+        Signal<int> signal;
+        Connection connection = signal.Connect([counter](int value) { *counter += value; });
+        for (int i = 0; i < 100; ++i) signal.Emit(1);
+        connection.Disconnect();
+    }
+    CHECK_EQ(g_allocations.load() - before, size_t(0));
+    CHECK_EQ(calls, 100);
+
+    // 超出内部存储的处理函数在堆上复制一份，第二个处理函数让全部处理函数移到堆上
+    Signal<> signal;
+    char payload[64] = {};
+    before = g_allocations.load();
+    Connection large = signal.Connect([payload]() { (void)payload; });
+    CHECK_EQ(g_allocations.load() - before, size_t(1));
+    before = g_allocations.load();
+    Connection small = signal.Connect([counter]() { ++*counter; });
+    CHECK_EQ(g_allocations.load() - before, size_t(1));
+}
@@ -0,0 +1,156 @@
+// 共享文本格式缓存的基准：GraphicsContext 使用的 SharedCache<TextFormatDesc, ...> 键路径
+// 只测量 TextFormatDesc 的哈希、比较和缓存的锁，格式用占位对象代替；窗口、设备和 DirectWrite 格式的创建不在这里测量
+// 启动：多个 UI 线程上的窗口为每个控件取用格式，统计每次取用的耗时和实际创建的格式数
+// 字号动画：每帧一个新字号，比较不设上限和设上限时缓存中留下的格式数
+#include "SharedCache.h"
+#include "TextFormatDesc.h"
+#include "Benchmark.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using KroubleUI::SharedCache;
+using KroubleUI::TextFormatDesc;
+using KroubleUI::TextFormatDescHash;
+using KroubleBenchmark::Stopwatch;
+
+namespace {
+
+    struct Format {
+        TextFormatDesc desc;
+        std::atomic<int> references;
+        explicit Format(const TextFormatDesc& d) : desc(d), references(1) {}
+    };
+
+    typedef SharedCache<TextFormatDesc, Format, TextFormatDescHash> FormatCache;
+
+    std::atomic<size_t> g_live(0);
+
+    Format* CreateFormat(const TextFormatDesc& desc) {
+        ++g_live;
+        return new Format(desc);
+    }
+
+    void Retain(Format* format) { ++format->references; }
+
+    void Release(Format* format) {
+        if (--format->references == 0) {
+            --g_live;
+            delete format;
+        }
+    }
+
+    // 各类控件按样式表取用的格式：与 Button、TextBox、DataGrid 等的 Initialize 相同的对齐和换行组合
+    std::vector<TextFormatDesc> MakeControlDescs(size_t count) {
+        static const wchar_t* families[] = { L"Microsoft YaHei", L"Segoe UI", L"Consolas" };
+        static const float sizes[] = { 12.0f, 14.0f, 16.0f, 20.0f };
+        std::vector<TextFormatDesc> descs(count);
+        for (size_t i = 0; i < count; ++i) {
+            TextFormatDesc& desc = descs[i];
+            desc.family = families[(i / 5) % 3];
+            desc.size = sizes[(i / 15) % 4];
+            switch (i % 5) {
+            case 0:     // 按钮：居中
+                desc.textAlignment = 2;
+                desc.paragraphAlignment = 2;
+                break;
+            case 1:     // 输入框：垂直居中、不换行
+                desc.paragraphAlignment = 2;
+                desc.wordWrapping = 1;
+                break;
+            case 2:     // 表头：加粗
+                desc.weight = 700;
+                desc.paragraphAlignment = 2;
+                desc.wordWrapping = 1;
+                break;
+            default:    // 文本块
+                break;
+            }
+        }
+        return descs;
+    }
+
+    struct StartupResult {
+        double seconds;
+        size_t lookups;
+        size_t created;
+    };
+
+    // 在 threadCount 个 UI 线程上创建 windowCount 个窗口，每个控件取用一次格式并持有到窗口关闭
+    StartupResult RunStartup(const std::vector<TextFormatDesc>& descs, size_t windowCount, size_t threadCount, size_t capacity) {
+        FormatCache cache(capacity);
+        std::vector<std::vector<Format*>> windows(windowCount);
+
+        Stopwatch watch;
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                for (size_t w = t; w < windowCount; w += threadCount) {
+                    windows[w].reserve(descs.size());
+                    for (const TextFormatDesc& desc : descs) {
+                        windows[w].push_back(cache.Acquire(desc, CreateFormat, Retain, Release));
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        StartupResult result = { watch.GetSeconds(), windowCount * descs.size(), cache.GetCreatedCount() };
+
+        for (auto& formats : windows) {
+            for (Format* format : formats) Release(format);
+        }
+        cache.Clear(Release);
+        return result;
+    }
+
+    // 字号在 14 到 28 之间往复，动画不断被打断重新开始，帧与帧的字号几乎不会重复
+    // 每帧取用一次新字号的格式，旧格式随即释放
+    size_t RunSizeAnimation(size_t frames, size_t capacity, size_t* evicted) {
+        FormatCache cache(capacity);
+        TextFormatDesc desc;
+        for (size_t frame = 0; frame < frames; ++frame) {
+            float phase = std::fmod(static_cast<float>(frame) * 0.01731f, 2.0f);
+            desc.size = 14.0f + 14.0f * (phase < 1.0f ? phase : 2.0f - phase);
+            Release(cache.Acquire(desc, CreateFormat, Retain, Release));
+        }
+        size_t count = cache.GetCount();
+        *evicted = cache.GetEvictedCount();
+        cache.Clear(Release);
+        return count;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t windowCount = KroubleBenchmark::GetArgument(argc, argv, "--windows", 20);
+    const size_t controls = KroubleBenchmark::GetArgument(argc, argv, "--controls", 200);
+    const size_t threadCount = KroubleBenchmark::GetArgument(argc, argv, "--threads", 4);
+    const size_t frames = KroubleBenchmark::GetArgument(argc, argv, "--frames", 100000);
+    const size_t capacity = KroubleBenchmark::GetArgument(argc, argv, "--capacity", 256);   // 与 GraphicsContext 相同
+
+    std::vector<TextFormatDesc> descs = MakeControlDescs(controls);
+    std::printf("startup: %zu windows x %zu controls, %zu UI threads\n", windowCount, controls, threadCount);
+    StartupResult startup = RunStartup(descs, windowCount, threadCount, capacity);
+    std::printf("  %zu lookups in %.3f ms, %.1f ns per lookup, %zu formats created\n", startup.lookups,
+        startup.seconds * 1000, startup.seconds / startup.lookups * 1e9, startup.created);
+
+    std::printf("size animation: %zu frames\n", frames);
+    size_t evicted = 0;
+    size_t unbounded = RunSizeAnimation(frames, 0, &evicted);
+    std::printf("  %-10s %8zu formats cached\n", "unbounded", unbounded);
+    size_t bounded = RunSizeAnimation(frames, capacity, &evicted);
+    std::printf("  %-10s %8zu formats cached, %zu evicted\n", "bounded", bounded, evicted);
+
+    if (g_live != 0) {
+        std::fprintf(stderr, "%zu formats leaked\n", g_live.load());
+        return 1;
+    }
+    if (capacity && bounded > capacity) {
+        std::fprintf(stderr, "cache grew past its capacity: %zu > %zu\n", bounded, capacity);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+// 换主题基准：默认 1 万个控件共用约 20 个样式，一次 SetStyles 后所有控件重新取用样式
+// 按 Control::RefreshStyle/GetStyle 的流程模拟控件：版本变化时丢弃已取用的记录，绘制时按状态重新取用
+// 检查每个（样式，状态）只解析一次，其余都命中样式表的缓存
+#include "StyleSheet.h"
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using KroubleUI::ResolvedStyle;
+using KroubleUI::Style;
+using KroubleUI::StyleColor;
+using KroubleUI::StyleSheet;
+using KroubleUI::StyleState;
+using KroubleBenchmark::Stopwatch;
+
+namespace {
+
+    // 每个控件绘制时取用的状态
+    const StyleState kDrawStates[] = { StyleState::Normal, StyleState::Hover, StyleState::Disabled };
+    const size_t kDrawStateCount = sizeof(kDrawStates) / sizeof(kDrawStates[0]);
+
+    // 与 Control 相同：按状态保存取用的记录和取用时样式表的版本
+    struct EmulatedControl {
+        std::wstring styleName;
+        std::shared_ptr<const ResolvedStyle> styles[static_cast<size_t>(StyleState::Count)];
+        uint64_t styleVersion = 0;
+
+        bool RefreshStyle(const StyleSheet& sheet) {
+            uint64_t version = sheet.GetVersion();
+            if (version == styleVersion) return false;
+            styleVersion = version;
+            for (auto& style : styles) {
+                style.reset();
+            }
+            return true;
+        }
+
+        const ResolvedStyle& GetStyle(StyleSheet& sheet, StyleState state) {
+            std::shared_ptr<const ResolvedStyle>& style = styles[static_cast<size_t>(state)];
+            if (!style) {
+                style = sheet.Resolve(styleName, state);
+            }
+            return *style;
+        }
+    };
+
+    // 一套主题：三个基样式，其余样式各自从其中之一继承，部分样式再多继承一层
+    std::unordered_map<std::wstring, Style> MakeTheme(size_t styleCount, uint32_t accent) {
+        std::unordered_map<std::wstring, Style> styles;
+        Style control;
+        control.Normal().SetForeground(StyleColor::FromRgb(0x000000)).SetFontSize(14.0f);
+        control.State(StyleState::Disabled).SetForeground(StyleColor::FromRgb(0x808080));
+        styles[L"Control"] = control;
+
+        Style button;
+        button.basedOn = L"Control";
+        button.Normal().SetBackground(StyleColor::FromRgb(accent)).SetBorderWidth(1.0f);
+        button.State(StyleState::Hover).SetBackground(StyleColor::FromRgb(accent ^ 0x202020));
+        styles[L"Button"] = button;
+
+        Style text;
+        text.basedOn = L"Control";
+        text.Normal().SetBackground(StyleColor::FromRgb(0xFFFFFF)).SetBorder(StyleColor::FromRgb(accent));
+        styles[L"TextBox"] = text;
+
+        const wchar_t* bases[] = { L"Control", L"Button", L"TextBox" };
+        for (size_t i = 3; i < styleCount; ++i) {
+            Style style;
+            style.basedOn = i % 4 == 0 && i > 3 ? L"Style" + std::to_wstring(i - 1) : bases[i % 3];
+            style.Normal().SetFontSize(12.0f + i % 5);
+            styles[L"Style" + std::to_wstring(i)] = style;
+        }
+        return styles;
+    }
+
+    std::wstring GetStyleName(size_t index) {
+        static const wchar_t* bases[] = { L"Control", L"Button", L"TextBox" };
+        return index < 3 ? bases[index] : L"Style" + std::to_wstring(index);
+    }
+
+    // 模拟一帧：每个控件检查版本并取用绘制所需的各状态样式
+    double DrawFrame(StyleSheet& sheet, std::vector<EmulatedControl>& controls, size_t* refreshed, double* checksum) {
+        Stopwatch watch;
+        for (EmulatedControl& control : controls) {
+            if (control.RefreshStyle(sheet)) ++*refreshed;
+            for (StyleState state : kDrawStates) {
+                *checksum += control.GetStyle(sheet, state).fontSize;
+            }
+        }
+        return watch.GetSeconds();
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t controlCount = KroubleBenchmark::GetArgument(argc, argv, "--controls", 10000);
+    const size_t styleCount = (std::max)(KroubleBenchmark::GetArgument(argc, argv, "--styles", 20), size_t(3));
+    const size_t themeCount = KroubleBenchmark::GetArgument(argc, argv, "--themes", 20);
+
+    StyleSheet sheet;
+    sheet.SetStyles(MakeTheme(styleCount, 0xD3D3D3));
+    std::vector<EmulatedControl> controls(controlCount);
+    for (size_t i = 0; i < controlCount; ++i) {
+        controls[i].styleName = GetStyleName(i % styleCount);
+    }
+
+    std::printf("%zu controls, %zu styles, %zu states per control\n", controlCount, styleCount, kDrawStateCount);
+    std::printf("%-16s %12s %12s %12s\n", "frame", "ms", "resolves", "lookups");
+
+    size_t refreshed = 0;
+    double checksum = 0;
+    double first = DrawFrame(sheet, controls, &refreshed, &checksum);
+    std::printf("%-16s %12.3f %12llu %12llu\n", "first draw", first * 1000,
+        (unsigned long long)sheet.GetResolveCount(), (unsigned long long)sheet.GetLookupCount());
+
+    // 没有变化的一帧：只比较版本号
+    uint64_t resolves = sheet.GetResolveCount();
+    uint64_t lookups = sheet.GetLookupCount();
+    double steady = DrawFrame(sheet, controls, &refreshed, &checksum);
+    std::printf("%-16s %12.3f %12llu %12llu\n", "unchanged", steady * 1000,
+        (unsigned long long)(sheet.GetResolveCount() - resolves), (unsigned long long)(sheet.GetLookupCount() - lookups));
+    if (sheet.GetLookupCount() != lookups) {
+        std::fprintf(stderr, "unchanged frame looked up styles\n");
+        return 1;
+    }
+
+    // 换主题：SetStyles 一次替换全部样式，下一帧所有控件重新取用
+    double total = 0;
+    double worst = 0;
+    for (size_t theme = 0; theme < themeCount; ++theme) {
+        std::unordered_map<std::wstring, Style> styles = MakeTheme(styleCount, theme % 2 ? 0xD3D3D3 : 0x3A7BD5);
+        Stopwatch watch;
+        sheet.SetStyles(std::move(styles));
+        double setSeconds = watch.GetSeconds();
+
+        resolves = sheet.GetResolveCount();
+        lookups = sheet.GetLookupCount();
+        refreshed = 0;
+        double frame = setSeconds + DrawFrame(sheet, controls, &refreshed, &checksum);
+        total += frame;
+        worst = (std::max)(worst, frame);
+
+        // 每个（样式，状态）解析一次，每个控件每个状态查询一次
+        uint64_t expectedResolves = (std::min)(styleCount, controlCount) * kDrawStateCount;
+        if (refreshed != controlCount || sheet.GetResolveCount() - resolves != expectedResolves ||
+            sheet.GetLookupCount() - lookups != controlCount * kDrawStateCount) {
+            std::fprintf(stderr, "re-theme %zu: %zu refreshed, %llu resolves (expected %llu)\n", theme, refreshed,
+                (unsigned long long)(sheet.GetResolveCount() - resolves), (unsigned long long)expectedResolves);
+            return 1;
+        }
+    }
+    std::printf("%-16s %12.3f %12llu %12llu\n", "re-theme (avg)", total / themeCount * 1000,
+        (unsigned long long)((std::min)(styleCount, controlCount) * kDrawStateCount), (unsigned long long)(controlCount * kDrawStateCount));
+    std::printf("%-16s %12.3f\n", "re-theme (worst)", worst * 1000);
+    std::printf("checksum %.0f\n", checksum);
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "StyleSheet.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <thread>
+
+using KroubleUI::ResolvedStyle;
+using KroubleUI::Style;
+using KroubleUI::StyleBackground;
+using KroubleUI::StyleBorderWidth;
+using KroubleUI::StyleColor;
+using KroubleUI::StyleSheet;
+using KroubleUI::StyleState;
+
+namespace {
+
+    const StyleColor kRed = StyleColor::FromRgb(0xFF0000);
+    const StyleColor kGreen = StyleColor::FromRgb(0x00FF00);
+    const StyleColor kBlue = StyleColor::FromRgb(0x0000FF);
+
+} // namespace
+
+TEST(UndefinedStyleResolvesToDefaults) {
+    StyleSheet sheet;
+    std::shared_ptr<const ResolvedStyle> style = sheet.Resolve(L"Missing");
+    ResolvedStyle defaults;
+    CHECK(style->background == defaults.background);
+    CHECK(style->fontFamily == defaults.fontFamily);
+    CHECK_EQ(style->stateMask, 0u);
+}
+
+TEST(DerivedStyleOverridesBase) {
+    StyleSheet sheet;
+    Style base;
+    base.Normal().SetBackground(kRed).SetFontSize(20.0f);
+    Style derived;
+    derived.basedOn = L"Base";
+    derived.Normal().SetBackground(kGreen);
+    sheet.SetStyle(L"Base", base);
+    sheet.SetStyle(L"Derived", derived);
+
+    std::shared_ptr<const ResolvedStyle> style = sheet.Resolve(L"Derived");
+    CHECK(style->background == kGreen);
+    CHECK_EQ(style->fontSize, 20.0f);
+}
+
+TEST(BaseStateDeclarationBeatsDerivedNormal) {
+    // 基样式的悬停背景在派生样式中仍然生效，即使派生样式改了常态背景
+    StyleSheet sheet;
+    Style base;
+    base.Normal().SetBackground(kRed);
+    base.State(StyleState::Hover).SetBackground(kBlue);
+    Style derived;
+    derived.basedOn = L"Base";
+    derived.Normal().SetBackground(kGreen).SetBorderWidth(3.0f);
+    sheet.SetStyle(L"Base", base);
+    sheet.SetStyle(L"Derived", derived);
+
+    std::shared_ptr<const ResolvedStyle> normal = sheet.Resolve(L"Derived");
+    std::shared_ptr<const ResolvedStyle> hover = sheet.Resolve(L"Derived", StyleState::Hover);
+    CHECK(normal->background == kGreen);
+    CHECK(!normal->IsFromState(StyleBackground));
+    CHECK(hover->background == kBlue);
+    CHECK(hover->IsFromState(StyleBackground));
+    CHECK_EQ(hover->borderWidth, 3.0f);
+    CHECK(!hover->IsFromState(StyleBorderWidth));
+}
+
+TEST(NearerStateDeclarationWins) {
+    StyleSheet sheet;
+    Style base;
+    base.State(StyleState::Pressed).SetBackground(kBlue);
+    Style derived;
+    derived.basedOn = L"Base";
+    derived.State(StyleState::Pressed).SetBackground(kRed);
+    sheet.SetStyle(L"Base", base);
+    sheet.SetStyle(L"Derived", derived);
+    CHECK(sheet.Resolve(L"Derived", StyleState::Pressed)->background == kRed);
+}
+
+TEST(InheritanceCycleIsCut) {
+    StyleSheet sheet;
+    Style a;
+    a.basedOn = L"B";
+    a.Normal().SetBackground(kRed);
+    Style b;
+    b.basedOn = L"A";
+    b.Normal().SetBackground(kGreen);
+    sheet.SetStyle(L"A", a);
+    sheet.SetStyle(L"B", b);
+    CHECK(sheet.Resolve(L"A")->background == kRed);
+    CHECK(sheet.Resolve(L"B")->background == kGreen);
+}
+
+TEST(ResolveIsCachedUntilChange) {
+    StyleSheet sheet;
+    Style button;
+    button.Normal().SetBackground(kRed);
+    sheet.SetStyle(L"Button", button);
+    uint64_t version = sheet.GetVersion();
+
+    std::shared_ptr<const ResolvedStyle> first = sheet.Resolve(L"Button");
+    std::shared_ptr<const ResolvedStyle> second = sheet.Resolve(L"Button");
+    CHECK(first == second);
+    CHECK_EQ(sheet.GetResolveCount(), uint64_t(1));
+    CHECK_EQ(sheet.GetLookupCount(), uint64_t(2));
+
+    button.Normal().SetBackground(kGreen);
+    sheet.SetStyle(L"Button", button);
+    CHECK(sheet.GetVersion() != version);
+    std::shared_ptr<const ResolvedStyle> third = sheet.Resolve(L"Button");
+    CHECK(third->background == kGreen);
+    // 控件仍持有的旧记录不受影响
+    CHECK(first->background == kRed);
+    CHECK_EQ(sheet.GetResolveCount(), uint64_t(2));
+}
+
+TEST(VersionsDifferAcrossSheets) {
+    StyleSheet a;
+    StyleSheet b;
+    CHECK(a.GetVersion() != b.GetVersion());
+}
+
+TEST(ListenersRunOncePerChange) {
+    StyleSheet sheet;
+    int calls = 0;
+    size_t id = sheet.AddListener([&calls]() { ++calls; });
+    sheet.SetStyle(L"A", Style());
+    sheet.SetStyles({ { L"B", Style() }, { L"C", Style() } });
+    CHECK(!sheet.RemoveStyle(L"A"));
+    CHECK(sheet.RemoveStyle(L"B"));
+    CHECK_EQ(calls, 3);
+
+    sheet.RemoveListener(id);
+    sheet.SetStyle(L"A", Style());
+    CHECK_EQ(calls, 3);
+}
+
+TEST(ChangeFromAnotherThreadNotifies) {
+    StyleSheet sheet;
+    std::atomic<int> calls(0);
+    std::atomic<uint64_t> seenVersion(0);
+    StyleSheet* target = &sheet;
+    sheet.AddListener([&]() {
+        seenVersion = target->GetVersion();
+        ++calls;
+    });
+    std::thread writer([&sheet]() { sheet.AddDefaultStyles(); });
+    writer.join();
+    CHECK_EQ(calls.load(), 1);
+    // 通知时新版本已经可见
+    CHECK_EQ(seenVersion.load(), sheet.GetVersion());
+    CHECK(sheet.HasStyle(L"Button"));
+}
@@ -0,0 +1,54 @@
+#include "TaskPool.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <vector>
+
+using KroubleUI::TaskPool;
+
+TEST(ParallelForRunsEveryIndexOnce) {
+    TaskPool pool(3);
+    std::vector<std::atomic<int>> counts(1000);
+    pool.ParallelFor(counts.size(), [&counts](size_t i) { ++counts[i]; });
+    bool once = true;
+    for (auto& count : counts) once = once && count.load() == 1;
+    CHECK(once);
+}
+
+TEST(ParallelForHandlesSmallCounts) {
+    TaskPool pool(2);
+    int calls = 0;
+    pool.ParallelFor(0, [&calls](size_t) { ++calls; });
+    CHECK_EQ(calls, 0);
+    pool.ParallelFor(1, [&calls](size_t) { ++calls; });
+    CHECK_EQ(calls, 1);
+}
+
+TEST(ParallelForInsidePoolTaskDoesNotDeadlock) {
+    // 只有一个线程时，任务内的 ParallelFor 全部由该线程自己执行
+    TaskPool pool(1);
+    std::atomic<int> sum(0);
+    std::atomic<bool> done(false);
+    pool.Submit([&]() {
+        pool.ParallelFor(100, [&sum](size_t i) { sum += static_cast<int>(i); });
+        done = true;
+    });
+    while (!done.load()) std::this_thread::yield();
+    CHECK_EQ(sum.load(), 4950);
+}
+
+TEST(DestructorRunsSubmittedTasks) {
+    std::atomic<int> ran(0);
+    {
+        TaskPool pool(2);
+        for (int i = 0; i < 50; ++i) {
+            pool.Submit([&ran]() { ++ran; });
+        }
+    }
+    CHECK_EQ(ran.load(), 50);
+}
+
+TEST(ZeroThreadCountCreatesAtLeastOne) {
+    TaskPool pool(0);
+    CHECK(pool.GetThreadCount() >= 1u);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// 最小的测试框架：TEST 定义用例，CHECK 失败时记录并继续执行
+namespace KroubleTest {
+
+    struct TestCase {
+        const char* name;
+        void (*run)();
+    };
+
+    inline std::vector<TestCase>& GetTests() {
+        static std::vector<TestCase> tests;
+        return tests;
+    }
+
+    inline int& GetFailureCount() {
+        static int failures = 0;
+        return failures;
+    }
+
+    struct Registrar {
+        Registrar(const char* name, void (*run)()) { GetTests().push_back({ name, run }); }
+    };
+
+} // namespace KroubleTest
+
+#define TEST(name) \
+    static void name(); \
+    static KroubleTest::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++KroubleTest::GetFailureCount(); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
@@ -0,0 +1,14 @@
+#include "TestHarness.h"
+
+int main() {
+    int failedTests = 0;
+    for (const KroubleTest::TestCase& test : KroubleTest::GetTests()) {
+        int before = KroubleTest::GetFailureCount();
+        test.run();
+        bool passed = KroubleTest::GetFailureCount() == before;
+        if (!passed) ++failedTests;
+        std::printf("[%s] %s\n", passed ? "PASS" : "FAIL", test.name);
+    }
+    std::printf("%zu tests, %d failed\n", KroubleTest::GetTests().size(), failedTests);
+    return failedTests == 0 ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+// 文本框大量文本的接收基准：吞吐和 UI 线程最长的一次阻塞
+// 按 TextBox 的流程模拟 UI 线程：追加、不超过 64K 的待查找文本就地查找、否则交给线程池，
+// 后台结果经消息队列回到 UI 线程；跟随末尾时从末尾向前找出最后一屏
+// 场景：整体载入、持续追加小批日志、一次粘贴大量文本
+#include "ChunkedText.h"
+#include "TaskPool.h"
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using KroubleUI::ChunkedText;
+using KroubleUI::LineIndex;
+using KroubleUI::TaskPool;
+using KroubleBenchmark::Stopwatch;
+
+namespace {
+
+    // 与 TextBox 相同
+    const size_t kSyncIndexChars = 65536;
+    const size_t kTailScanChars = 65536;
+    const size_t kVisibleLines = 40;
+
+    // TextBox 在 UI 线程上的状态，后台结果通过 Post 回到 UI 线程
+    class IngestModel {
+    private:
+        struct Result {
+            std::vector<size_t> lineStarts;
+            size_t end;
+        };
+
+        std::shared_ptr<TaskPool> m_pool;
+        ChunkedText m_text;
+        LineIndex m_lines;
+        std::vector<size_t> m_tailLines;
+        bool m_indexing = false;
+        std::mutex m_mutex;
+        std::vector<std::shared_ptr<Result>> m_posted;
+        std::atomic<int> m_running{ 0 };
+
+        void ScheduleIndexing() {
+            size_t indexed = m_lines.GetIndexedLength();
+            if (m_indexing || indexed >= m_text.GetLength()) return;
+            if (m_text.GetLength() - indexed <= kSyncIndexChars) {
+                m_lines.IndexTo(m_text, indexed + kSyncIndexChars);
+                return;
+            }
+
+            m_indexing = true;
+            ++m_running;
+            ChunkedText snapshot = m_text;
+            size_t lastStart = m_lines.GetLastLineStart();
+            size_t end = m_text.GetLength();
+            m_pool->Submit([this, snapshot, indexed, lastStart, end]() {
+                std::shared_ptr<Result> result = std::make_shared<Result>();
+                result->end = end;
+                LineIndex::Scan(snapshot, indexed, end, lastStart, *m_pool, nullptr, &result->lineStarts);
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_posted.push_back(result);
+                }
+                --m_running;
+            });
+        }
+
+        void UpdateTail() {
+            if (m_lines.GetIndexedLength() < m_text.GetLength()) {
+                LineIndex::FindTailLines(m_text, m_lines.GetLastLineStart(), kVisibleLines, kTailScanChars, &m_tailLines);
+            }
+            else {
+                m_tailLines.clear();
+            }
+        }
+
+    public:
+        explicit IngestModel(std::shared_ptr<TaskPool> pool) : m_pool(pool) {}
+        ~IngestModel() {
+            while (m_running.load() > 0) std::this_thread::yield();
+        }
+
+        void Load(std::wstring text) {
+            m_text.Assign(std::move(text));
+            m_lines.Clear();
+            m_lines.IndexTo(m_text, kSyncIndexChars);
+            ScheduleIndexing();
+        }
+
+        void Append(std::wstring&& text) {
+            m_text.Append(std::move(text));
+            ScheduleIndexing();
+            UpdateTail();
+        }
+
+        // 处理后台发回的结果，相当于窗口的消息循环执行 PostTask
+        void Pump() {
+            std::vector<std::shared_ptr<Result>> posted;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                posted.swap(m_posted);
+            }
+            for (const std::shared_ptr<Result>& result : posted) {
+                m_lines.Append(result->lineStarts, result->end);
+                m_indexing = false;
+                ScheduleIndexing();
+                UpdateTail();
+            }
+        }
+
+        bool IsIndexed() const { return !m_indexing && m_lines.GetIndexedLength() == m_text.GetLength(); }
+        size_t GetLineCount() const { return m_lines.GetLineCount(); }
+        size_t GetLength() const { return m_text.GetLength(); }
+        const std::vector<size_t>& GetTailLines() const { return m_tailLines; }
+        const LineIndex& GetLines() const { return m_lines; }
+    };
+
+    std::wstring MakeLines(size_t first, size_t count) {
+        std::wstring text;
+        wchar_t line[96];
+        for (size_t i = first; i < first + count; ++i) {
+            int length = std::swprintf(line, 96, L"%010zu INFO worker-%02zu: request finished in %zu ms\n", i, i % 16, i % 977);
+            text.append(line, length > 0 ? length : 0);
+        }
+        return text;
+    }
+
+    // UI 线程等待后台完成，每一步计入最长阻塞
+    void Drain(IngestModel& model, double* worst) {
+        while (!model.IsIndexed()) {
+            Stopwatch step;
+            model.Pump();
+            *worst = (std::max)(*worst, step.GetSeconds());
+            std::this_thread::yield();
+        }
+    }
+
+    void Report(const char* name, size_t chars, double seconds, double worst) {
+        std::printf("%-10s %10.1f %14.1f %16.3f\n", name, chars / 1e6, chars / 1e6 / seconds, worst * 1000);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t megaChars = KroubleBenchmark::GetArgument(argc, argv, "--mchars", 64);
+    const size_t batchLines = KroubleBenchmark::GetArgument(argc, argv, "--batch", 64);
+    const size_t threadCount = KroubleBenchmark::GetArgument(argc, argv, "--threads", 0);
+
+    std::shared_ptr<TaskPool> pool = std::make_shared<TaskPool>(threadCount);
+    // 每行约 50 个字符
+    const size_t lineCount = megaChars * 1000000 / 50;
+    std::wstring source = MakeLines(0, lineCount);
+    std::printf("%zu lines, %.1f M chars, %zu pool threads + caller\n", lineCount, source.size() / 1e6, pool->GetThreadCount());
+    std::printf("%-10s %10s %14s %16s\n", "scenario", "M chars", "M chars/s", "worst UI (ms)");
+
+    // 整体载入：首屏就地查找，其余在后台
+    {
+        IngestModel model(pool);
+        double worst = 0;
+        std::wstring copy = source;
+        Stopwatch total;
+        Stopwatch step;
+        model.Load(std::move(copy));
+        worst = step.GetSeconds();
+        Drain(model, &worst);
+        Report("load", model.GetLength(), total.GetSeconds(), worst);
+        if (model.GetLineCount() != lineCount + 1) {
+            std::fprintf(stderr, "load: %zu lines, expected %zu\n", model.GetLineCount(), lineCount + 1);
+            return 1;
+        }
+    }
+
+    // 持续追加：每批 batchLines 行，两批之间处理后台结果；生成日志的时间不计入
+    {
+        IngestModel model(pool);
+        double worst = 0;
+        double seconds = 0;
+        for (size_t line = 0; line < lineCount; line += batchLines) {
+            std::wstring batch = MakeLines(line, (std::min)(batchLines, lineCount - line));
+            Stopwatch step;
+            model.Append(std::move(batch));
+            model.Pump();
+            double stepSeconds = step.GetSeconds();
+            seconds += stepSeconds;
+            worst = (std::max)(worst, stepSeconds);
+        }
+        Stopwatch drain;
+        Drain(model, &worst);
+        Report("stream", model.GetLength(), seconds + drain.GetSeconds(), worst);
+        if (model.GetLineCount() != lineCount + 1) {
+            std::fprintf(stderr, "stream: %zu lines, expected %zu\n", model.GetLineCount(), lineCount + 1);
+            return 1;
+        }
+    }
+
+    // 粘贴：一次追加全部文本，末尾一屏立即可见
+    {
+        IngestModel model(pool);
+        model.Load(L"first line\n");
+        std::wstring copy = source;
+        Stopwatch total;
+        Stopwatch step;
+        model.Append(std::move(copy));
+        double worst = step.GetSeconds();
+        std::vector<size_t> tail = model.GetTailLines();
+        Drain(model, &worst);
+        Report("paste", source.size(), total.GetSeconds(), worst);
+
+        // 向后查找得到的末尾应与完整索引的最后几行一致
+        const LineIndex& lines = model.GetLines();
+        bool match = tail.size() == kVisibleLines;
+        for (size_t i = 0; match && i < tail.size(); ++i) {
+            match = tail[i] == lines.GetLineStart(lines.GetLineCount() - kVisibleLines + i);
+        }
+        if (!match) {
+            std::fprintf(stderr, "paste: tail lines differ from the full index\n");
+            return 1;
+        }
+    }
+    return 0;
+}
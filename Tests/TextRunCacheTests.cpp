@@ -0,0 +1,306 @@
+#include "TextRunCache.h"
+#include "TaskPool.h"
+#include "TestHarness.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cwchar>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using KroubleUI::TextFormatRefPolicy;
+using KroubleUI::TextRun;
+using KroubleUI::TextRunCache;
+using KroubleUI::TextRunCacheStats;
+using KroubleUI::TextShaper;
+
+namespace {
+
+    // 记录排版内容的排版结果，析构时计数，用于检查被淘汰但仍被持有的项
+    std::atomic<int> g_liveRuns(0);
+
+    class StubRun : public TextRun {
+    public:
+        std::wstring text;
+        const void* format;
+
+        StubRun(const wchar_t* text, uint32_t length, const void* format, size_t bytes)
+            : TextRun(bytes), text(text, length), format(format) {
+            ++g_liveRuns;
+        }
+        ~StubRun() { --g_liveRuns; }
+    };
+
+    // 每个排版结果固定 bytes 字节；gate 不为空时在排版中途等待，用于制造并发排版
+    class StubShaper : public TextShaper {
+    public:
+        size_t bytes;
+        std::atomic<int> calls;
+        std::function<void()> gate;
+
+        explicit StubShaper(size_t bytes) : bytes(bytes), calls(0) {}
+
+        std::shared_ptr<TextRun> Shape(const wchar_t* text, uint32_t length, const void* format,
+            float, float) override {
+            ++calls;
+            if (gate) gate();
+            return std::make_shared<StubRun>(text, length, format, bytes);
+        }
+    };
+
+    // 格式句柄的引用计数
+    std::atomic<int> g_formatRefs(0);
+
+    TextFormatRefPolicy CountingPolicy() {
+        TextFormatRefPolicy policy;
+        policy.addRef = [](const void*) { ++g_formatRefs; };
+        policy.release = [](const void*) { --g_formatRefs; };
+        return policy;
+    }
+
+    int g_formatA = 0;
+    int g_formatB = 0;
+
+    // 文本本身占用的字节也计入预算
+    size_t EntryBytes(size_t runBytes, size_t length) {
+        return runBytes + length * sizeof(wchar_t);
+    }
+
+    std::shared_ptr<const TextRun> Acquire(TextRunCache& cache, const std::wstring& text, const void* format = &g_formatA,
+        float width = 100.0f) {
+        return cache.Acquire(text.c_str(), static_cast<uint32_t>(text.size()), format, width, 20.0f);
+    }
+
+} // namespace
+
+TEST(HitsAndMissesAreCounted) {
+    std::shared_ptr<StubShaper> shaper = std::make_shared<StubShaper>(100);
+    TextRunCache cache(shaper, TextFormatRefPolicy());
+
+    std::shared_ptr<const TextRun> first = Acquire(cache, L"OK");
+    std::shared_ptr<const TextRun> second = Acquire(cache, L"OK");
+    CHECK(first == second);
+    CHECK_EQ(shaper->calls.load(), 1);
+
+    // 格式、尺寸不同都是不同的键
+    CHECK(Acquire(cache, L"OK", &g_formatB) != first);
+    CHECK(Acquire(cache, L"OK", &g_formatA, 50.0f) != first);
+    CHECK_EQ(shaper->calls.load(), 3);
+
+    TextRunCacheStats stats = cache.GetStats();
+    CHECK_EQ(stats.hits, uint64_t(1));
+    CHECK_EQ(stats.misses, uint64_t(3));
+    CHECK_EQ(stats.entries, size_t(3));
+    CHECK_EQ(stats.bytes, 3 * EntryBytes(100, 2));
+    CHECK_EQ(stats.GetHitRate(), 0.25);
+
+    cache.ResetCounters();
+    stats = cache.GetStats();
+    CHECK_EQ(stats.hits + stats.misses, uint64_t(0));
+    CHECK_EQ(stats.entries, size_t(3));
+}
+
+TEST(UncacheableTextIsNotShaped) {
+    std::shared_ptr<StubShaper> shaper = std::make_shared<StubShaper>(100);
+    TextRunCache cache(shaper, TextFormatRefPolicy());
+    std::wstring tooLong(TextRunCache::kMaxTextLength + 1, L'x');
+    CHECK(!Acquire(cache, tooLong));
+    CHECK(!Acquire(cache, L""));
+    CHECK(!Acquire(cache, L"OK", nullptr));
+    CHECK_EQ(shaper->calls.load(), 0);
+    CHECK_EQ(cache.GetStats().misses, uint64_t(0));
+}
+
+TEST(EvictsLeastRecentlyUsedFirst) {
+    std::shared_ptr<StubShaper> shaper = std::make_shared<StubShaper>(100);
+    // 刚好容纳三项
+    TextRunCache cache(shaper, TextFormatRefPolicy(), 3 * EntryBytes(100, 1), 1);
+    Acquire(cache, L"a");
+    Acquire(cache, L"b");
+    Acquire(cache, L"c");
+    // a 变为最近使用，加入 d 时淘汰 b
+    Acquire(cache, L"a");
+    Acquire(cache, L"d");
+    CHECK_EQ(cache.GetStats().evictions, uint64_t(1));
+    CHECK_EQ(cache.GetStats().entries, size_t(3));
+
+    int calls = shaper->calls.load();
+    Acquire(cache, L"a");
+    Acquire(cache, L"c");
+    Acquire(cache, L"d");
+    CHECK_EQ(shaper->calls.load(), calls);
+    Acquire(cache, L"b");
+    CHECK_EQ(shaper->calls.load(), calls + 1);
+}
+
+TEST(ByteBudgetBoundsTheCache) {
+    std::shared_ptr<StubShaper> shaper = std::make_shared<StubShaper>(1000);
+    const size_t entryBytes = EntryBytes(1000, 4);
+    TextRunCache cache(shaper, TextFormatRefPolicy(), 10 * entryBytes, 1);
+    for (int i = 0; i < 100; ++i) {
+        wchar_t text[8];
+        std::swprintf(text, 8, L"%04d", i);
+        Acquire(cache, text);
+        CHECK(cache.GetStats().bytes <= 10 * entryBytes);
+    }
+    TextRunCacheStats stats = cache.GetStats();
+    CHECK_EQ(stats.entries, size_t(10));
+    CHECK_EQ(stats.evictions, uint64_t(90));
+
+    // 降低预算立即淘汰，但至少保留一项
+    cache.SetBudget(4 * entryBytes);
+    CHECK_EQ(cache.GetStats().entries, size_t(4));
+    cache.SetBudget(0);
+    CHECK_EQ(cache.GetStats().entries, size_t(1));
+    CHECK_EQ(cache.GetStats().bytes, entryBytes);
+}
+
+TEST(ShardsSplitTheBudget) {
+    std::shared_ptr<StubShaper> shaper = std::make_shared<StubShaper>(1000);
+    const size_t entryBytes = EntryBytes(1000, 4);
+    TextRunCache cache(shaper, TextFormatRefPolicy(), 64 * entryBytes, 4);
+    CHECK_EQ(cache.GetShardCount(), size_t(4));
+    for (int i = 0; i < 1000; ++i) {
+        wchar_t text[8];
+        std::swprintf(text, 8, L"%04d", i);
+        Acquire(cache, text);
+    }
+    // 每片不超过自己的一份预算，合计不超过总预算
+    TextRunCacheStats stats = cache.GetStats();
+    CHECK(stats.bytes <= 64 * entryBytes);
+    CHECK(stats.entries > 32);
+    CHECK_EQ(stats.misses, uint64_t(1000));
+    CHECK_EQ(stats.evictions + stats.entries, size_t(1000));
+    CHECK_EQ(cache.GetBudget(), 64 * entryBytes);
+
+    cache.Clear();
+    CHECK_EQ(cache.GetStats().entries, size_t(0));
+    CHECK_EQ(cache.GetStats().bytes, size_t(0));
+}
+
+TEST(HeldRunOutlivesEviction) {
+    std::shared_ptr<StubShaper> shaper = std::make_shared<StubShaper>(100);
+    TextRunCache cache(shaper, TextFormatRefPolicy(), EntryBytes(100, 4), 1);
+    int live = g_liveRuns.load();
+    std::shared_ptr<const TextRun> held = Acquire(cache, L"held");
+    Acquire(cache, L"next");
+    CHECK_EQ(cache.GetStats().evictions, uint64_t(1));
+
+    // 被淘汰的项仍可使用，释放后才销毁
+    CHECK_EQ(g_liveRuns.load(), live + 2);
+    CHECK(static_cast<const StubRun*>(held.get())->text == L"held");
+    held.reset();
+    CHECK_EQ(g_liveRuns.load(), live + 1);
+    cache.Clear();
+    CHECK_EQ(g_liveRuns.load(), live);
+}
+
+TEST(FormatReferencesFollowEntries) {
+    std::shared_ptr<StubShaper> shaper = std::make_shared<StubShaper>(100);
+    {
+        TextRunCache cache(shaper, CountingPolicy(), 2 * EntryBytes(100, 1), 1);
+        Acquire(cache, L"a", &g_formatA);
+        Acquire(cache, L"a", &g_formatA);
+        Acquire(cache, L"b", &g_formatB);
+        CHECK_EQ(g_formatRefs.load(), 2);
+        Acquire(cache, L"c", &g_formatB);
+        CHECK_EQ(g_formatRefs.load(), 2);
+    }
+    CHECK_EQ(g_formatRefs.load(), 0);
+}
+
+TEST(ConcurrentShapeKeepsFirstResult) {
+    // 两个线程同时未命中同一段文本：都在锁外排版，后加入的一方在第二次查找时发现已有结果并使用它
+    std::shared_ptr<StubShaper> shaper = std::make_shared<StubShaper>(100);
+    TextRunCache cache(shaper, CountingPolicy());
+    int refs = g_formatRefs.load();
+    int live = g_liveRuns.load();
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    int shaping = 0;
+    shaper->gate = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        ++shaping;
+        changed.notify_all();
+        changed.wait(lock, [&shaping]() { return shaping == 2; });
+    };
+
+    std::shared_ptr<const TextRun> results[2];
+    std::thread first([&]() { results[0] = Acquire(cache, L"race"); });
+    std::thread second([&]() { results[1] = Acquire(cache, L"race"); });
+    first.join();
+    second.join();
+
+    CHECK_EQ(shaper->calls.load(), 2);
+    CHECK(results[0] && results[0] == results[1]);
+    TextRunCacheStats stats = cache.GetStats();
+    CHECK_EQ(stats.misses, uint64_t(2));
+    CHECK_EQ(stats.entries, size_t(1));
+    CHECK_EQ(stats.bytes, EntryBytes(100, 4));
+    CHECK_EQ(g_formatRefs.load(), refs + 1);
+    // 落后一方的排版结果已经丢弃
+    CHECK_EQ(g_liveRuns.load(), live + 1);
+
+    shaper->gate = nullptr;
+    CHECK(Acquire(cache, L"race") == results[0]);
+    CHECK_EQ(shaper->calls.load(), 2);
+}
+
+TEST(ShapeBypassesCacheForLongText) {
+    std::shared_ptr<StubShaper> shaper = std::make_shared<StubShaper>(100);
+    TextRunCache cache(shaper, TextFormatRefPolicy());
+    std::wstring text(TextRunCache::kMaxTextLength + 1, L'x');
+    std::shared_ptr<const TextRun> first = cache.Shape(text.c_str(), static_cast<uint32_t>(text.size()), &g_formatA, 100.0f, 20.0f);
+    std::shared_ptr<const TextRun> second = cache.Shape(text.c_str(), static_cast<uint32_t>(text.size()), &g_formatA, 100.0f, 20.0f);
+    CHECK(first && second && first != second);
+    CHECK_EQ(cache.GetStats().entries, size_t(0));
+    CHECK(cache.Shape(L"OK", 2, &g_formatA, 100.0f, 20.0f) == cache.Shape(L"OK", 2, &g_formatA, 100.0f, 20.0f));
+    CHECK_EQ(shaper->calls.load(), 3);
+}
+
+TEST(ShapeTextWorkFillsEverySlot) {
+    std::shared_ptr<StubShaper> shaper = std::make_shared<StubShaper>(100);
+    TextRunCache cache(shaper, TextFormatRefPolicy());
+    KroubleUI::TaskPool pool(3);
+    std::vector<std::wstring> texts;
+    for (int i = 0; i < 500; ++i) {
+        texts.push_back(L"label " + std::to_wstring(i % 50));
+    }
+    std::vector<std::shared_ptr<const TextRun>> runs(texts.size());
+    std::vector<KroubleUI::TextWork> work;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        work.push_back({ texts[i].c_str(), static_cast<uint32_t>(texts[i].size()), &g_formatA, 80.0f, 20.0f, &runs[i] });
+    }
+    KroubleUI::ShapeTextWork(&cache, &work, &pool);
+    for (size_t i = 0; i < texts.size(); ++i) {
+        CHECK(runs[i] && static_cast<const StubRun*>(runs[i].get())->text == texts[i]);
+    }
+    // 相同的文本共用一份缓存项；并发未命中时可能多排版几次，但只加入一项
+    CHECK_EQ(cache.GetStats().entries, size_t(50));
+    CHECK_EQ(cache.GetStats().hits + cache.GetStats().misses, uint64_t(500));
+}
+
+TEST(PreparedTextDetectsStaleResults) {
+    KroubleUI::PreparedText prepared;
+    CHECK(!prepared.Matches(L"OK", 2, &g_formatA, 80.0f, 20.0f));
+
+    prepared.run = std::make_shared<StubRun>(L"OK", 2, &g_formatA, 100);
+    prepared.text = L"OK";
+    prepared.format = &g_formatA;
+    prepared.width = 80.0f;
+    prepared.height = 20.0f;
+    CHECK(prepared.Matches(L"OK", 2, &g_formatA, 80.0f, 20.0f));
+    // 同一尺寸的舍入误差不算过期
+    CHECK(prepared.Matches(L"OK", 2, &g_formatA, 80.0f + 0.001f, 20.0f));
+
+    CHECK(!prepared.Matches(L"Ok", 2, &g_formatA, 80.0f, 20.0f));
+    CHECK(!prepared.Matches(L"OK!", 3, &g_formatA, 80.0f, 20.0f));
+    CHECK(!prepared.Matches(L"OK", 2, &g_formatB, 80.0f, 20.0f));
+    CHECK(!prepared.Matches(L"OK", 2, &g_formatA, 81.0f, 20.0f));
+    CHECK(!prepared.Matches(L"OK", 2, &g_formatA, 80.0f, 24.0f));
+}
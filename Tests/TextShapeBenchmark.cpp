@@ -0,0 +1,148 @@
+// 绘制前排版的扩展性基准：默认 2 万个标签的界面，1 到 N 个线程
+// 按 Window::PrepareText 的流程用 ShapeTextWork 排版整屏文本，排版器换成按固定耗时空转的替身，不依赖 DirectWrite
+// 冷帧：缓存为空，不同的文本各排版一次，重复的文本命中；热帧：同一屏再排一次，全部命中，只剩缓存的锁
+// 分别用单片缓存和默认分片的缓存运行，比较单把锁在多线程命中时的争用
+#include "TextRunCache.h"
+#include "TaskPool.h"
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using KroubleUI::TaskPool;
+using KroubleUI::TextFormatRefPolicy;
+using KroubleUI::TextRun;
+using KroubleUI::TextRunCache;
+using KroubleUI::TextShaper;
+using KroubleUI::TextWork;
+using KroubleBenchmark::Stopwatch;
+
+namespace {
+
+    const size_t kGlyphBytes = 32;      // 与 DirectWriteShaper 的估算相同
+
+    // 每次排版空转 shapeNs 纳秒，相当于 DirectWrite 为一个短标签创建布局的耗时
+    class SpinShaper : public TextShaper {
+    private:
+        std::chrono::nanoseconds m_cost;
+        std::atomic<size_t> m_calls;
+
+    public:
+        explicit SpinShaper(size_t shapeNs) : m_cost(shapeNs), m_calls(0) {}
+
+        std::shared_ptr<TextRun> Shape(const wchar_t*, uint32_t length, const void*, float, float) override {
+            ++m_calls;
+            auto end = std::chrono::steady_clock::now() + m_cost;
+            while (std::chrono::steady_clock::now() < end) {
+            }
+            return std::make_shared<TextRun>(sizeof(TextRun) + length * kGlyphBytes);
+        }
+
+        size_t GetCalls() const { return m_calls.load(); }
+    };
+
+    // 类似监控面板的一屏：每行十列，名称各不相同，数值、单位、状态大量重复
+    std::vector<std::wstring> MakeLabels(size_t count) {
+        static const wchar_t* states[] = { L"OK", L"WARN", L"FAIL", L"IDLE" };
+        std::vector<std::wstring> labels;
+        labels.reserve(count);
+        wchar_t text[32];
+        for (size_t i = 0; i < count; ++i) {
+            size_t row = i / 10;
+            switch (i % 10) {
+            case 0: std::swprintf(text, 32, L"node-%05zu", row); break;
+            case 1: case 2: case 3: std::swprintf(text, 32, L"%zu", (row * 7919 + i) % 1000); break;
+            case 4: std::swprintf(text, 32, L"ms"); break;
+            case 5: std::swprintf(text, 32, L"%ls", states[row % 4]); break;
+            default: std::swprintf(text, 32, L"%zu%%", (row + i) % 101); break;
+            }
+            labels.push_back(text);
+        }
+        return labels;
+    }
+
+    struct FrameResult {
+        double coldSeconds;
+        double warmSeconds;
+        size_t shapes;
+        bool complete;
+    };
+
+    FrameResult RunFrames(const std::vector<std::wstring>& labels, size_t threads, size_t shards, size_t shapeNs) {
+        static int format = 0;      // 格式句柄只作为指针比较
+        std::shared_ptr<SpinShaper> shaper = std::make_shared<SpinShaper>(shapeNs);
+        TextRunCache cache(shaper, TextFormatRefPolicy(), TextRunCache::kDefaultBudget, shards);
+        // 调用线程也参与排版，线程池只需 threads - 1 个线程
+        std::unique_ptr<TaskPool> pool(threads > 1 ? new TaskPool(threads - 1) : nullptr);
+
+        std::vector<std::shared_ptr<const TextRun>> runs(labels.size());
+        std::vector<TextWork> work;
+        auto collect = [&]() {
+            work.clear();
+            for (size_t i = 0; i < labels.size(); ++i) {
+                runs[i].reset();
+                work.push_back({ labels[i].c_str(), static_cast<uint32_t>(labels[i].size()), &format, 80.0f, 20.0f, &runs[i] });
+            }
+        };
+
+        FrameResult result;
+        collect();
+        Stopwatch watch;
+        KroubleUI::ShapeTextWork(&cache, &work, pool.get());
+        result.coldSeconds = watch.GetSeconds();
+        result.shapes = shaper->GetCalls();
+
+        collect();
+        watch.Restart();
+        KroubleUI::ShapeTextWork(&cache, &work, pool.get());
+        result.warmSeconds = watch.GetSeconds();
+
+        // 热帧不应再排版，每个槽位都有结果
+        result.complete = shaper->GetCalls() == result.shapes;
+        for (const std::shared_ptr<const TextRun>& run : runs) {
+            result.complete = result.complete && run;
+        }
+        return result;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t labelCount = KroubleBenchmark::GetArgument(argc, argv, "--labels", 20000);
+    const size_t maxThreads = (std::max)(KroubleBenchmark::GetArgument(argc, argv, "--threads",
+        std::thread::hardware_concurrency()), size_t(1));
+    const size_t shapeNs = KroubleBenchmark::GetArgument(argc, argv, "--shape-ns", 5000);
+    const size_t shards = KroubleBenchmark::GetArgument(argc, argv, "--shards", TextRunCache::kDefaultShards);
+
+    std::vector<std::wstring> labels = MakeLabels(labelCount);
+    std::printf("%zu labels, %zu ns per shape, %u hardware threads\n", labelCount, shapeNs, std::thread::hardware_concurrency());
+    std::printf("%-8s %-7s %10s %10s %10s %10s %8s\n", "threads", "shards", "shapes", "cold (ms)", "speedup", "warm (ms)", "speedup");
+
+    const size_t shardCounts[] = { 1, shards };
+    for (size_t shardCount : shardCounts) {
+        double coldBase = 0;
+        double warmBase = 0;
+        for (size_t threads = 1; threads <= maxThreads; threads = threads < maxThreads ? (std::min)(threads * 2, maxThreads) : threads + 1) {
+            FrameResult result = RunFrames(labels, threads, shardCount, shapeNs);
+            if (!result.complete) {
+                std::fprintf(stderr, "%zu threads, %zu shards: warm frame re-shaped or left a slot empty\n", threads, shardCount);
+                return 1;
+            }
+            if (threads == 1) {
+                coldBase = result.coldSeconds;
+                warmBase = result.warmSeconds;
+            }
+            std::printf("%-8zu %-7zu %10zu %10.2f %10.2f %10.3f %8.2f\n", threads, shardCount, result.shapes,
+                result.coldSeconds * 1000, coldBase / result.coldSeconds, result.warmSeconds * 1000, warmBase / result.warmSeconds);
+        }
+        if (shards == 1) break;
+    }
+    return 0;
+}